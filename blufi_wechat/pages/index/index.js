@@ -16,6 +16,7 @@ Page({
     
     // 设备WiFi状态
     deviceWifiStatus: null,  // {connected, ssid, password, opmode, ...}
+    statusReport: null,      // 扩展连接状态 {ip, gateway, rssi, channel, bssid, authmode, uptime, reconnectCount}
     
     // 存储的WiFi配置
     storedConfig: null,  // {exists, ssid, password}
@@ -70,6 +71,14 @@ Page({
       wx.hideLoading()
     })
     
+    this.blufi.on('onStatusReport', (report) => {
+      console.log('收到扩展连接状态:', report)
+      const authNames = ['OPEN', 'WEP', 'WPA', 'WPA2', 'WPA/WPA2', 'WPA2-ENT', 'WPA3', 'WPA2/WPA3']
+      report.authName = authNames[report.authmode] || ('类型' + report.authmode)
+      report.uptimeText = this.formatUptime(report.uptime)
+      this.setData({ statusReport: report })
+    })
+    
     this.blufi.on('onConfigDeleted', () => {
       console.log('配置已删除，刷新列表')
       // 删除成功后重新获取配置列表
@@ -101,6 +110,7 @@ Page({
           connected: false,
           connectedDevice: null,
           deviceWifiStatus: null,
+          statusReport: null,
           wifiList: [],
           selectedWifi: null,
           wifiPassword: '',
@@ -159,7 +169,7 @@ Page({
     wx.showLoading({ title: '扫描中...' })
 
     wx.startBluetoothDevicesDiscovery({
-      allowDuplicatesKey: false,
+      allowDuplicatesKey: true,   // 接收重复上报，以获取扫描响应和状态变化
       success: () => {
         console.log('开始扫描蓝牙设备')
         
@@ -167,17 +177,25 @@ Page({
           res.devices.forEach((device) => {
             const name = device.name || device.localName
             
-            // 只添加ESP32开头的设备，提高扫描效率
-            if (name && name.toUpperCase().startsWith('ESP32')) {
+            // 带设备状态的设备直接识别，其他设备只添加ESP32开头的
+            const state = BluFiProtocol.parseAdvertData(device.advertisData)
+            if (state || (name && name.toUpperCase().startsWith('ESP32'))) {
               const devices = this.data.devices
               const index = devices.findIndex(d => d.deviceId === device.deviceId)
               
+              device.name = name || ('ESP32_' + (state ? state.macSuffix.replace(/:/g, '') : ''))
+              device.state = state
+              device.stateText = state ? this.deviceStateText(state) : ''
               if (index === -1) {
-                device.name = name
                 devices.push(device)
-                this.setData({ devices })
-                console.log('发现ESP32设备:', name, device.deviceId)
+                console.log('发现ESP32设备:', device.name, device.deviceId, state)
+              } else if (devices[index].stateText !== device.stateText) {
+                // 扫描响应晚于广播到达，或设备状态变化
+                devices[index] = device
+              } else {
+                return
               }
+              this.setData({ devices: this.sortDevices(devices) })
             }
           })
         })
@@ -196,6 +214,23 @@ Page({
     })
   },
 
+  // 设备状态说明
+  deviceStateText(state) {
+    const wifiTexts = ['WiFi未连接', 'WiFi连接中', 'WiFi已连接', 'WiFi在线']
+    const wifiText = wifiTexts[state.wifiStatus] || 'WiFi未知'
+    return `${state.provisioned ? '已配网' : '待配网'} · ${wifiText} · v${state.fwVersion} · ${state.macSuffix}`
+  },
+
+  // 排序：待配网的在前，其次未联网的，同类按信号强度
+  sortDevices(devices) {
+    const rank = (d) => {
+      if (!d.state) return 1
+      if (!d.state.provisioned) return 0
+      return d.state.connected ? 2 : 1
+    }
+    return devices.slice().sort((a, b) => rank(a) - rank(b) || b.RSSI - a.RSSI)
+  },
+
   stopScan() {
     wx.stopBluetoothDevicesDiscovery()
     wx.hideLoading()
@@ -260,9 +295,10 @@ Page({
   refreshDeviceStatus() {
     wx.showLoading({ title: '获取状态...' })
     
-    // 同时获取WiFi状态和存储的配置
+    // 同时获取WiFi状态、扩展连接状态和存储的配置
     Promise.all([
       this.blufi.requestWifiStatus(),
+      this.blufi.requestStatusReport(),
       this.blufi.requestStoredConfig()
     ]).catch((err) => {
       console.error('获取状态失败:', err)
@@ -270,6 +306,14 @@ Page({
     })
   },
 
+  // 连接时长格式化
+  formatUptime(seconds) {
+    const h = Math.floor(seconds / 3600)
+    const m = Math.floor((seconds % 3600) / 60)
+    const s = seconds % 60
+    return h > 0 ? `${h}小时${m}分` : m > 0 ? `${m}分${s}秒` : `${s}秒`
+  },
+
   // 获取存储的WiFi配置
   getStoredConfig() {
     wx.showLoading({ title: '获取配置...' })
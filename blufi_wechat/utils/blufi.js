@@ -2,9 +2,11 @@
  * BluFi 协议处理模块
  * 基于 ESP-IDF BluFi 协议实现
  * 
- * ⚠️ 注意：本实现使用明文传输，仅适用于内网环境
+ * 连接后默认进行 DH 密钥协商，之后的数据帧使用 AES-128-CFB 加密并带 CRC16 校验
  */
 
+const BluFiCrypto = require('./blufi_crypto.js')
+
 // BluFi 服务和特征值 UUID
 const BLUFI_SERVICE_UUID = '0000FFFF-0000-1000-8000-00805F9B34FB'
 const BLUFI_WRITE_UUID = '0000FF01-0000-1000-8000-00805F9B34FB'
@@ -33,6 +35,20 @@ const BLUFI_CTRL_SUBTYPE_GET_VERSION = 0x07
 const BLUFI_CTRL_SUBTYPE_DISCONNECT_BLE = 0x08
 const BLUFI_CTRL_SUBTYPE_GET_WIFI_LIST = 0x09
 
+// 安全模式（SET_SEC_MODE 数据）
+const BLUFI_SEC_MODE_DATA_CHECK = 0x01
+const BLUFI_SEC_MODE_DATA_ENC = 0x02
+const BLUFI_SEC_MODE_CTRL_CHECK = 0x10
+const BLUFI_SEC_MODE_CTRL_ENC = 0x20
+
+// 协商数据类型
+const SEC_TYPE_DH_PARAM_LEN = 0x00
+const SEC_TYPE_DH_PARAM_DATA = 0x01
+
+// 帧头（类型、控制、序号、长度）+ 校验和 + 分片总长度
+const BLUFI_FRAME_OVERHEAD = 4 + 2 + 2
+const BLUFI_NEGOTIATE_TIMEOUT = 5000
+
 // BluFi 数据子类型
 const BLUFI_DATA_SUBTYPE_NEG = 0x00
 const BLUFI_DATA_SUBTYPE_STA_BSSID = 0x01
@@ -55,8 +71,14 @@ const BLUFI_DATA_SUBTYPE_WIFI_LIST = 0x11
 const BLUFI_DATA_SUBTYPE_ERROR = 0x12
 const BLUFI_DATA_SUBTYPE_CUSTOM_DATA = 0x13
 
+// 扫描响应中的厂商数据（设备状态）
+const ADV_COMPANY_ID = 0x02E5         // 乐鑫的蓝牙SIG公司ID
+const ADV_FRAME_VERSION = 0x01
+const ADV_DATA_LEN = 11
+const ADV_FLAG_PROVISIONED = 0x01
+
 class BluFiProtocol {
-  constructor() {
+  constructor(options = {}) {
     this.deviceId = null
     this.serviceId = BLUFI_SERVICE_UUID
     this.writeCharId = BLUFI_WRITE_UUID
@@ -68,6 +90,20 @@ class BluFiProtocol {
     // 分包重组缓冲区
     this.fragmentBuffer = null
     this.fragmentExpectedLength = 0
+    
+    // 安全传输
+    this.secure = options.secure !== false
+    this.mtu = 23
+    this.resetSecurity()
+  }
+
+  // 重置安全状态（每次连接重新协商）
+  resetSecurity() {
+    this.dh = null
+    this.aesKey = null
+    this.secMode = 0
+    this.negotiateResolve = null
+    this.dataFragments = null
   }
 
   // 连接设备
@@ -80,6 +116,8 @@ class BluFiProtocol {
       this.receiveBuffer = []
       this.fragmentBuffer = null
       this.fragmentExpectedLength = 0
+      this.mtu = 23
+      this.resetSecurity()
       console.log('✓ 序列号已重置为0')
       
       // 监听蓝牙连接状态变化
@@ -107,6 +145,9 @@ class BluFiProtocol {
             mtu: 512,
             success: (res) => {
               console.log('✓ MTU已设置为:', res.mtu)
+              if (res.mtu) {
+                this.mtu = res.mtu
+              }
             },
             fail: (err) => {
               console.log('MTU设置失败（iOS不支持）:', err.errMsg)
@@ -191,14 +232,21 @@ class BluFiProtocol {
         state: true,
         success: () => {
           console.log('通知已启用')
-          // 暂时禁用加密，直接完成连接
-          console.log('⚠️ 加密已禁用（调试模式）')
           
           // 延迟500ms，确保ESP32端完全准备好
           // 避免序列号不同步问题
           setTimeout(() => {
-            console.log('✓ BluFi连接完全建立，可以开始通信')
-            resolve()
+            if (!this.secure) {
+              console.log('⚠️ 未启用加密，使用明文传输')
+              console.log('✓ BluFi连接完全建立，可以开始通信')
+              resolve()
+              return
+            }
+            
+            this.negotiateSecurity().then(() => {
+              console.log('✓ BluFi加密连接已建立，可以开始通信')
+              resolve()
+            }).catch(reject)
           }, 500)
         },
         fail: reject
@@ -207,6 +255,66 @@ class BluFiProtocol {
   }
 
   // 开始密钥协商
+  negotiateSecurity() {
+    return new Promise(async (resolve, reject) => {
+      const start = Date.now()
+      const timer = setTimeout(() => {
+        this.negotiateResolve = null
+        reject(new Error('密钥协商超时'))
+      }, BLUFI_NEGOTIATE_TIMEOUT)
+      
+      this.negotiateResolve = (err) => {
+        clearTimeout(timer)
+        this.negotiateResolve = null
+        if (err) {
+          reject(err)
+          return
+        }
+        console.log('✓ 密钥协商完成，耗时', Date.now() - start, 'ms')
+        resolve()
+      }
+      
+      try {
+        this.dh = BluFiCrypto.createDH()
+        const param = BluFiCrypto.encodeDHParams(this.dh)
+        
+        // 先告知参数长度，再发送参数（超过MTU时自动分片）
+        await this.postData(BLUFI_TYPE_DATA, BLUFI_DATA_SUBTYPE_NEG,
+          [SEC_TYPE_DH_PARAM_LEN, (param.length >> 8) & 0xff, param.length & 0xff])
+        await this.postData(BLUFI_TYPE_DATA, BLUFI_DATA_SUBTYPE_NEG,
+          [SEC_TYPE_DH_PARAM_DATA].concat(param))
+      } catch (err) {
+        if (this.negotiateResolve) {
+          this.negotiateResolve(err)
+        }
+      }
+    })
+  }
+
+  // 处理密钥协商（设备公钥）
+  async handleNegotiate(payload) {
+    if (!this.dh || !this.negotiateResolve) {
+      console.warn('收到未预期的协商数据')
+      return
+    }
+    
+    try {
+      this.aesKey = BluFiCrypto.deriveKey(this.dh, payload)
+      this.dh = null
+      
+      // 设置安全模式：控制帧和数据帧都加密并校验（该帧本身仍为明文）
+      const secMode = BLUFI_SEC_MODE_CTRL_CHECK | BLUFI_SEC_MODE_CTRL_ENC |
+        BLUFI_SEC_MODE_DATA_CHECK | BLUFI_SEC_MODE_DATA_ENC
+      await this.sendData(this.buildFrame(BLUFI_TYPE_CTRL, BLUFI_CTRL_SUBTYPE_SET_SEC_MODE, [secMode]))
+      this.secMode = secMode
+      
+      this.negotiateResolve()
+    } catch (err) {
+      this.aesKey = null
+      this.negotiateResolve(err)
+    }
+  }
+
   // 处理通知数据
   handleNotify(buffer) {
     const data = new Uint8Array(buffer)
@@ -279,6 +387,25 @@ class BluFiProtocol {
     
     let payload = data.slice(4, 4 + dataLen)
     
+    // 解密
+    if (fc & BLUFI_FC_ENC) {
+      if (!this.aesKey) {
+        console.warn('收到加密帧但尚未完成密钥协商')
+        return null
+      }
+      payload = BluFiCrypto.aesCfb(this.aesKey, sequence, payload, false)
+    }
+    
+    // 校验（覆盖序号、长度和明文）
+    if (fc & BLUFI_FC_CHECK) {
+      const checksum = data[4 + dataLen] | (data[5 + dataLen] << 8)
+      const expected = BluFiCrypto.crc16([sequence, dataLen].concat(Array.from(payload)))
+      if (checksum !== expected) {
+        console.warn('帧校验失败，丢弃')
+        return null
+      }
+    }
+    
     console.log('Payload原始数据（前20字节）:', Array.from(payload.slice(0, 20)))
     
     return {
@@ -295,8 +422,22 @@ class BluFiProtocol {
   handleFrame(frame) {
     console.log('处理帧:', frame)
     
+    // BluFi层分片：每片前2字节为剩余总长度，最后一片不带分片标志
+    if (frame.fc & BLUFI_FC_FRAG) {
+      const chunk = frame.payload.slice(2)
+      this.dataFragments = this.dataFragments ? this.concatBytes(this.dataFragments, chunk) : chunk
+      return
+    }
+    if (this.dataFragments) {
+      frame.payload = this.concatBytes(this.dataFragments, frame.payload)
+      this.dataFragments = null
+    }
+    
     if (frame.type === BLUFI_TYPE_DATA) {
       switch (frame.subtype) {
+        case BLUFI_DATA_SUBTYPE_NEG:
+          this.handleNegotiate(frame.payload)
+          break
         case BLUFI_DATA_SUBTYPE_WIFI_LIST:
           this.handleWifiList(frame.payload)
           break
@@ -313,7 +454,6 @@ class BluFiProtocol {
     }
   }
 
-  // 处理密钥协商
   // 处理WiFi列表
   handleWifiList(payload) {
     console.log('=== 开始解析WiFi列表 ===')
@@ -571,30 +711,101 @@ class BluFiProtocol {
         console.error('✗ 配置删除失败')
       }
     }
+    // 类型 0x03: 扩展连接状态
+    else if (type === 0x03) {
+      if (status !== 0x00 || payload.length < 28) {
+        console.warn('扩展状态数据不完整')
+        return
+      }
+      const readU32 = (offset) => (payload[offset] | (payload[offset + 1] << 8) |
+        (payload[offset + 2] << 16) | (payload[offset + 3] << 24)) >>> 0
+      const hex = (b) => ('0' + b.toString(16)).slice(-2)
+      
+      const report = {
+        wifiStatus: payload[2],   // 0未连接 1连接中 2已连接 3已获取IP
+        connected: payload[2] === 3,
+        rssi: payload[3] > 127 ? payload[3] - 256 : payload[3],
+        channel: payload[4],
+        authmode: payload[5],
+        bssid: Array.from(payload.slice(6, 12)).map(hex).join(':'),
+        ip: Array.from(payload.slice(12, 16)).join('.'),
+        gateway: Array.from(payload.slice(16, 20)).join('.'),
+        uptime: readU32(20),
+        reconnectCount: readU32(24)
+      }
+      console.log('扩展连接状态:', report)
+      
+      if (this.callbacks.onStatusReport) {
+        this.callbacks.onStatusReport(report)
+      }
+    }
   }
 
-  // 构建帧
-  buildFrame(type, subtype, payload = []) {
+  // 构建帧（按安全模式加密并附加校验和）
+  buildFrame(type, subtype, payload = [], frag = false) {
+    const isData = type === BLUFI_TYPE_DATA
+    const encrypt = this.aesKey && (this.secMode & (isData ? BLUFI_SEC_MODE_DATA_ENC : BLUFI_SEC_MODE_CTRL_ENC))
+    const checksum = this.secMode & (isData ? BLUFI_SEC_MODE_DATA_CHECK : BLUFI_SEC_MODE_CTRL_CHECK)
+    const sequence = this.sequence & 0xff
+    
     let fc = 0
-    let actualPayload = payload
+    if (encrypt) fc |= BLUFI_FC_ENC
+    if (checksum) fc |= BLUFI_FC_CHECK
+    if (frag) fc |= BLUFI_FC_FRAG
+    
+    let actualPayload = Uint8Array.from(payload)
+    let crc = 0
+    if (checksum) {
+      crc = BluFiCrypto.crc16([sequence, actualPayload.length].concat(Array.from(actualPayload)))
+    }
+    if (encrypt) {
+      actualPayload = BluFiCrypto.aesCfb(this.aesKey, sequence, actualPayload, true)
+    }
     
-    const frameLen = 4 + actualPayload.length
+    const frameLen = 4 + actualPayload.length + (checksum ? 2 : 0)
     const frame = new Uint8Array(frameLen)
     
     frame[0] = (subtype << 2) | type
     frame[1] = fc
-    frame[2] = this.sequence  // 先使用当前序列号
+    frame[2] = sequence  // 先使用当前序列号
     frame[3] = actualPayload.length
     
     if (actualPayload.length > 0) {
       frame.set(actualPayload, 4)
     }
+    if (checksum) {
+      frame[4 + actualPayload.length] = crc & 0xff
+      frame[5 + actualPayload.length] = (crc >> 8) & 0xff
+    }
     
     this.sequence++  // 发送后再自增
     
     return frame.buffer
   }
 
+  // 发送数据帧，超过单次写入长度时按BluFi分片协议拆分
+  async postData(type, subtype, payload = []) {
+    const maxLen = Math.min(Math.max(this.mtu - 3 - BLUFI_FRAME_OVERHEAD, 1), 253)
+    let offset = 0
+    
+    while (payload.length - offset > maxLen + 2) {
+      const remain = payload.length - offset
+      const chunk = [remain & 0xff, (remain >> 8) & 0xff].concat(payload.slice(offset, offset + maxLen))
+      await this.sendData(this.buildFrame(type, subtype, chunk, true))
+      offset += maxLen
+    }
+    
+    return this.sendData(this.buildFrame(type, subtype, payload.slice(offset)))
+  }
+
+  // 拼接字节数组
+  concatBytes(a, b) {
+    const out = new Uint8Array(a.length + b.length)
+    out.set(a)
+    out.set(b, a.length)
+    return out
+  }
+
   // 发送数据
   sendData(buffer) {
     return new Promise((resolve, reject) => {
@@ -651,8 +862,15 @@ class BluFiProtocol {
     console.log('=== 请求存储的WiFi配置 ===')
     // 发送自定义数据请求：类型 0x01 = 获取存储的WiFi配置
     const customData = [0x01]
-    const frame = this.buildFrame(BLUFI_TYPE_DATA, BLUFI_DATA_SUBTYPE_CUSTOM_DATA, customData)
-    return this.sendData(frame)
+    return this.postData(BLUFI_TYPE_DATA, BLUFI_DATA_SUBTYPE_CUSTOM_DATA, customData)
+  }
+
+  // 请求扩展连接状态（IP、网关、RSSI、信道、BSSID、认证方式、连接时长、重连次数）
+  requestStatusReport() {
+    console.log('=== 请求扩展连接状态 ===')
+    // 发送自定义数据请求：类型 0x03 = 获取扩展连接状态
+    const customData = [0x03]
+    return this.postData(BLUFI_TYPE_DATA, BLUFI_DATA_SUBTYPE_CUSTOM_DATA, customData)
   }
 
   // 删除指定索引的WiFi配置
@@ -660,8 +878,7 @@ class BluFiProtocol {
     console.log('=== 请求删除WiFi配置，索引:', index, '===')
     // 发送自定义数据请求：类型 0x02 = 删除指定索引的WiFi配置
     const customData = [0x02, index]
-    const frame = this.buildFrame(BLUFI_TYPE_DATA, BLUFI_DATA_SUBTYPE_CUSTOM_DATA, customData)
-    return this.sendData(frame)
+    return this.postData(BLUFI_TYPE_DATA, BLUFI_DATA_SUBTYPE_CUSTOM_DATA, customData)
   }
 
   // 发送WiFi配置
@@ -670,15 +887,13 @@ class BluFiProtocol {
       try {
         // 发送 SSID
         const ssidBytes = this.stringToBytes(ssid)
-        const ssidFrame = this.buildFrame(BLUFI_TYPE_DATA, BLUFI_DATA_SUBTYPE_STA_SSID, ssidBytes)
-        await this.sendData(ssidFrame)
+        await this.postData(BLUFI_TYPE_DATA, BLUFI_DATA_SUBTYPE_STA_SSID, ssidBytes)
         await this.delay(100)
         
         // 发送密码
         if (password) {
           const passwdBytes = this.stringToBytes(password)
-          const passwdFrame = this.buildFrame(BLUFI_TYPE_DATA, BLUFI_DATA_SUBTYPE_STA_PASSWD, passwdBytes)
-          await this.sendData(passwdFrame)
+          await this.postData(BLUFI_TYPE_DATA, BLUFI_DATA_SUBTYPE_STA_PASSWD, passwdBytes)
           await this.delay(100)
         }
         
@@ -716,6 +931,27 @@ class BluFiProtocol {
     return new Promise(resolve => setTimeout(resolve, ms))
   }
 
+  // 解析扫描到的厂商数据：[公司ID(2，小端), 格式版本, 标志, 连接状态, 固件版本(3), MAC后3字节]
+  // 不是本设备的格式时返回null
+  static parseAdvertData(buffer) {
+    if (!buffer || buffer.byteLength < ADV_DATA_LEN) {
+      return null
+    }
+    const data = new Uint8Array(buffer)
+    if ((data[0] | (data[1] << 8)) !== ADV_COMPANY_ID || data[2] !== ADV_FRAME_VERSION) {
+      return null
+    }
+    const hex = (b) => ('0' + b.toString(16).toUpperCase()).slice(-2)
+    
+    return {
+      provisioned: (data[3] & ADV_FLAG_PROVISIONED) !== 0,
+      wifiStatus: data[4],      // 0未连接 1连接中 2已连接 3已获取IP
+      connected: data[4] === 3,
+      fwVersion: `${data[5]}.${data[6]}.${data[7]}`,
+      macSuffix: Array.from(data.slice(8, 11)).map(hex).join(':')
+    }
+  }
+
   // 注册回调
   on(event, callback) {
     this.callbacks[event] = callback
@@ -735,6 +971,7 @@ class BluFiProtocol {
             // 清空分包缓冲区
             this.fragmentBuffer = null
             this.fragmentExpectedLength = 0
+            this.resetSecurity()
             console.log('✓ 连接已断开，状态已重置')
             resolve()
           },
@@ -0,0 +1,330 @@
+/**
+ * BluFi 安全传输算法
+ * 与 ESP-IDF BluFi 安全模式一致：
+ * - DH 密钥协商（RFC 2409 1024位 MODP 组）
+ * - 共享密钥的 MD5 作为 AES-128 密钥
+ * - AES-128-CFB 加解密，IV 首字节为帧序号，其余为 0
+ * - CRC16（多项式 0x1021，初值/结果取反）校验序号、长度和明文
+ */
+
+// RFC 2409 第二组 1024位 MODP 素数，生成元为 2
+const DH_P_HEX =
+  'FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD1' +
+  '29024E088A67CC74020BBEA63B139B22514A08798E3404DD' +
+  'EF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245' +
+  'E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7ED' +
+  'EE386BFB5A899FA5AE9F24117C4B1FE649286651ECE65381' +
+  'FFFFFFFFFFFFFFFF'
+const DH_G = 2
+const DH_KEY_LEN = 128
+
+// ==================== 大数工具 ====================
+
+const ZERO = BigInt(0)
+const ONE = BigInt(1)
+
+// 字节数组转大数（大端）
+function bytesToBigInt(bytes) {
+  let hex = ''
+  for (let i = 0; i < bytes.length; i++) {
+    hex += bytes[i].toString(16).padStart(2, '0')
+  }
+  return hex ? BigInt('0x' + hex) : ZERO
+}
+
+// 大数转定长字节数组（大端，左侧补零）
+function bigIntToBytes(value, length) {
+  let hex = value.toString(16)
+  if (hex.length % 2) hex = '0' + hex
+  const bytes = new Uint8Array(length)
+  const count = Math.min(hex.length / 2, length)
+  for (let i = 0; i < count; i++) {
+    bytes[length - 1 - i] = parseInt(hex.substr(hex.length - 2 * (i + 1), 2), 16)
+  }
+  return bytes
+}
+
+// 模幂运算
+function modPow(base, exp, mod) {
+  let result = ONE
+  base = base % mod
+  while (exp > ZERO) {
+    if (exp & ONE) {
+      result = (result * base) % mod
+    }
+    exp = exp >> ONE
+    base = (base * base) % mod
+  }
+  return result
+}
+
+// 随机字节（优先使用系统安全随机数）
+function randomBytes(length) {
+  const bytes = new Uint8Array(length)
+  if (typeof wx !== 'undefined' && wx.getRandomValues) {
+    // 同步接口不可用时回退，调用方只需要一次性的私钥
+    try {
+      const res = wx.getRandomValues({ length: length })
+      if (res && res.randomValues) {
+        bytes.set(new Uint8Array(res.randomValues))
+        return bytes
+      }
+    } catch (e) {}
+  }
+  for (let i = 0; i < length; i++) {
+    bytes[i] = Math.floor(Math.random() * 256)
+  }
+  return bytes
+}
+
+// ==================== DH ====================
+
+// 生成DH密钥对
+function createDH() {
+  const p = BigInt('0x' + DH_P_HEX)
+  const g = BigInt(DH_G)
+  // 私钥取 [2, p-2] 范围内的随机数
+  const privateKey = bytesToBigInt(randomBytes(DH_KEY_LEN)) % (p - BigInt(3)) + BigInt(2)
+  const publicKey = modPow(g, privateKey, p)
+  return {
+    p: p,
+    g: g,
+    privateKey: privateKey,
+    publicKey: bigIntToBytes(publicKey, DH_KEY_LEN)
+  }
+}
+
+// 编码协商参数：P、G、公钥，各自带2字节大端长度（mbedtls_dhm_read_params格式）
+function encodeDHParams(dh) {
+  const fields = [
+    bigIntToBytes(dh.p, DH_KEY_LEN),
+    bigIntToBytes(dh.g, 1),
+    dh.publicKey
+  ]
+  const out = []
+  fields.forEach(field => {
+    out.push((field.length >> 8) & 0xff, field.length & 0xff)
+    for (let i = 0; i < field.length; i++) {
+      out.push(field[i])
+    }
+  })
+  return out
+}
+
+// 根据设备公钥计算AES密钥（共享密钥的MD5）
+function deriveKey(dh, devicePublicKey) {
+  const peer = bytesToBigInt(devicePublicKey)
+  if (peer <= ONE || peer >= dh.p - ONE) {
+    throw new Error('设备公钥无效')
+  }
+  const shared = modPow(peer, dh.privateKey, dh.p)
+  return aesExpandKey(md5(bigIntToBytes(shared, DH_KEY_LEN)))
+}
+
+// ==================== MD5 ====================
+
+const MD5_S = [
+  7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+  5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+  4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+  6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+]
+const MD5_K = []
+for (let i = 0; i < 64; i++) {
+  MD5_K.push(Math.floor(Math.abs(Math.sin(i + 1)) * 0x100000000) >>> 0)
+}
+
+// 计算MD5，返回16字节
+function md5(bytes) {
+  const bitLen = bytes.length * 8
+  const padLen = ((bytes.length + 8) >> 6) * 64 + 64
+  const msg = new Uint8Array(padLen)
+  msg.set(bytes)
+  msg[bytes.length] = 0x80
+  for (let i = 0; i < 4; i++) {
+    msg[padLen - 8 + i] = (bitLen >>> (8 * i)) & 0xff
+  }
+
+  let a0 = 0x67452301
+  let b0 = 0xefcdab89
+  let c0 = 0x98badcfe
+  let d0 = 0x10325476
+  const m = new Array(16)
+
+  for (let off = 0; off < padLen; off += 64) {
+    for (let i = 0; i < 16; i++) {
+      const j = off + i * 4
+      m[i] = msg[j] | (msg[j + 1] << 8) | (msg[j + 2] << 16) | (msg[j + 3] << 24)
+    }
+
+    let a = a0
+    let b = b0
+    let c = c0
+    let d = d0
+    for (let i = 0; i < 64; i++) {
+      let f
+      let g
+      if (i < 16) {
+        f = (b & c) | (~b & d)
+        g = i
+      } else if (i < 32) {
+        f = (d & b) | (~d & c)
+        g = (5 * i + 1) % 16
+      } else if (i < 48) {
+        f = b ^ c ^ d
+        g = (3 * i + 5) % 16
+      } else {
+        f = c ^ (b | ~d)
+        g = (7 * i) % 16
+      }
+      const tmp = d
+      d = c
+      c = b
+      const x = (a + f + MD5_K[i] + m[g]) | 0
+      b = (b + ((x << MD5_S[i]) | (x >>> (32 - MD5_S[i])))) | 0
+      a = tmp
+    }
+
+    a0 = (a0 + a) | 0
+    b0 = (b0 + b) | 0
+    c0 = (c0 + c) | 0
+    d0 = (d0 + d) | 0
+  }
+
+  const out = new Uint8Array(16)
+  ;[a0, b0, c0, d0].forEach((v, i) => {
+    for (let j = 0; j < 4; j++) {
+      out[i * 4 + j] = (v >>> (8 * j)) & 0xff
+    }
+  })
+  return out
+}
+
+// ==================== AES-128（仅加密方向，CFB模式只需要它） ====================
+
+// 在GF(2^8)上生成S盒
+const SBOX = (() => {
+  const sbox = new Uint8Array(256)
+  const rotl8 = (x, shift) => ((x << shift) | (x >> (8 - shift))) & 0xff
+  let p = 1
+  let q = 1
+  do {
+    p = (p ^ (p << 1) ^ (p & 0x80 ? 0x1b : 0)) & 0xff
+    q ^= q << 1
+    q ^= q << 2
+    q ^= q << 4
+    q &= 0xff
+    if (q & 0x80) q ^= 0x09
+    sbox[p] = (q ^ rotl8(q, 1) ^ rotl8(q, 2) ^ rotl8(q, 3) ^ rotl8(q, 4) ^ 0x63) & 0xff
+  } while (p !== 1)
+  sbox[0] = 0x63
+  return sbox
+})()
+
+const xtime = x => ((x << 1) ^ (x & 0x80 ? 0x1b : 0)) & 0xff
+
+// 密钥扩展，返回176字节轮密钥
+function aesExpandKey(key) {
+  const w = new Uint8Array(176)
+  w.set(key)
+  let rcon = 1
+  for (let i = 16; i < 176; i += 4) {
+    let t0 = w[i - 4]
+    let t1 = w[i - 3]
+    let t2 = w[i - 2]
+    let t3 = w[i - 1]
+    if (i % 16 === 0) {
+      const tmp = t0
+      t0 = SBOX[t1] ^ rcon
+      t1 = SBOX[t2]
+      t2 = SBOX[t3]
+      t3 = SBOX[tmp]
+      rcon = xtime(rcon)
+    }
+    w[i] = w[i - 16] ^ t0
+    w[i + 1] = w[i - 15] ^ t1
+    w[i + 2] = w[i - 14] ^ t2
+    w[i + 3] = w[i - 13] ^ t3
+  }
+  return w
+}
+
+// 加密单个16字节分组
+function aesEncryptBlock(roundKeys, input) {
+  const s = new Uint8Array(16)
+  for (let i = 0; i < 16; i++) {
+    s[i] = input[i] ^ roundKeys[i]
+  }
+
+  for (let round = 1; round <= 10; round++) {
+    // SubBytes + ShiftRows
+    const t = new Uint8Array(16)
+    for (let c = 0; c < 4; c++) {
+      for (let r = 0; r < 4; r++) {
+        t[c * 4 + r] = SBOX[s[((c + r) % 4) * 4 + r]]
+      }
+    }
+
+    // MixColumns（最后一轮没有）
+    if (round < 10) {
+      for (let c = 0; c < 4; c++) {
+        const a0 = t[c * 4]
+        const a1 = t[c * 4 + 1]
+        const a2 = t[c * 4 + 2]
+        const a3 = t[c * 4 + 3]
+        const all = a0 ^ a1 ^ a2 ^ a3
+        t[c * 4] = a0 ^ all ^ xtime(a0 ^ a1)
+        t[c * 4 + 1] = a1 ^ all ^ xtime(a1 ^ a2)
+        t[c * 4 + 2] = a2 ^ all ^ xtime(a2 ^ a3)
+        t[c * 4 + 3] = a3 ^ all ^ xtime(a3 ^ a0)
+      }
+    }
+
+    // AddRoundKey
+    for (let i = 0; i < 16; i++) {
+      s[i] = t[i] ^ roundKeys[round * 16 + i]
+    }
+  }
+  return s
+}
+
+// AES-128-CFB，IV首字节为帧序号
+function aesCfb(roundKeys, sequence, data, encrypt) {
+  const out = new Uint8Array(data.length)
+  const reg = new Uint8Array(16)
+  reg[0] = sequence & 0xff
+  let stream = null
+  for (let i = 0; i < data.length; i++) {
+    const n = i % 16
+    if (n === 0) {
+      stream = aesEncryptBlock(roundKeys, reg)
+    }
+    out[i] = data[i] ^ stream[n]
+    reg[n] = encrypt ? out[i] : data[i]
+  }
+  return out
+}
+
+// ==================== CRC16 ====================
+
+// 与设备端 esp_crc16_be(0, ...) 一致
+function crc16(bytes) {
+  let crc = 0xffff
+  for (let i = 0; i < bytes.length; i++) {
+    crc ^= bytes[i] << 8
+    for (let j = 0; j < 8; j++) {
+      crc = crc & 0x8000 ? ((crc << 1) ^ 0x1021) & 0xffff : (crc << 1) & 0xffff
+    }
+  }
+  return (~crc) & 0xffff
+}
+
+module.exports = {
+  createDH,
+  encodeDHParams,
+  deriveKey,
+  aesCfb,
+  crc16,
+  md5,
+  aesExpandKey
+}
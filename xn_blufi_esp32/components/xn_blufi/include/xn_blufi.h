@@ -24,10 +24,85 @@ extern "C" {
 // 引入WiFi管理器和存储层的类型定义
 #include "xn_wifi_manager.h"
 #include "xn_wifi_storage.h"
+#include "xn_boot_profile.h"
 
 /* BluFi配网组件类 */
 typedef struct xn_blufi_s xn_blufi_t;
 
+/* 蓝牙/WiFi共存调度策略（2.4GHz射频由两者共享） */
+typedef enum {
+    XN_BLUFI_COEX_AUTO = 0,         // 自动：WiFi关联/扫描时偏向WiFi，BLE突发发送时偏向蓝牙
+    XN_BLUFI_COEX_BALANCE,          // 固定均衡
+    XN_BLUFI_COEX_PREFER_WIFI,      // 固定偏向WiFi
+    XN_BLUFI_COEX_PREFER_BT,        // 固定偏向蓝牙
+} xn_blufi_coex_policy_t;
+
+/* 单个共存阶段的统计信息 */
+typedef struct {
+    uint32_t count;                 // 进入该阶段的次数
+    uint32_t max_us;                // 单次最长耗时（微秒）
+    uint64_t total_us;              // 累计耗时（微秒）
+} xn_blufi_coex_phase_stats_t;
+
+/* 共存调度统计信息 */
+typedef struct {
+    xn_blufi_coex_phase_stats_t wifi_connect;   // WiFi关联（含DHCP）阶段
+    xn_blufi_coex_phase_stats_t wifi_scan;      // WiFi扫描阶段
+    xn_blufi_coex_phase_stats_t ble_burst;      // BLE突发发送阶段
+    uint32_t prefer_switches;                   // 共存偏好切换次数
+} xn_blufi_coex_stats_t;
+
+/* BluFi安全层统计信息（密钥协商和逐帧加解密耗时） */
+typedef struct {
+    uint32_t negotiations;          // 成功的密钥协商次数
+    uint32_t negotiate_failures;    // 失败的密钥协商次数
+    uint32_t negotiate_us;          // 最近一次协商耗时（微秒）
+    uint32_t encrypt_frames;        // 加密帧数
+    uint32_t encrypt_us_max;        // 单帧加密最长耗时（微秒）
+    uint64_t encrypt_us_total;      // 加密累计耗时（微秒）
+    uint32_t decrypt_frames;        // 解密帧数
+    uint32_t decrypt_us_max;        // 单帧解密最长耗时（微秒）
+    uint64_t decrypt_us_total;      // 解密累计耗时（微秒）
+} xn_blufi_security_stats_t;
+
+/* 单个任务的运行配置和栈使用情况 */
+typedef struct {
+    bool running;                   // 任务是否在运行
+    int core;                       // 绑定的核心，-1表示不绑定
+    uint32_t priority;              // 优先级
+    uint32_t stack_size;            // 栈大小（字节）
+    uint32_t stack_high_water;      // 栈历史最小剩余（字节），越小越接近溢出
+} xn_blufi_task_info_t;
+
+/* 组件任务信息 */
+typedef struct {
+    xn_blufi_task_info_t ble_host;      // NimBLE主机任务（BluFi事件回调）
+    xn_blufi_task_info_t wifi_worker;   // WiFi工作任务（命令、事件分发、断线重连）
+} xn_blufi_task_stats_t;
+
+/* 蓝牙广播阶段 */
+typedef enum {
+    XN_BLUFI_ADV_OFF = 0,           // 未广播（超时停止或蓝牙已连接）
+    XN_BLUFI_ADV_FAST,              // 快速广播：启动、按键、WiFi断开或蓝牙断开后
+    XN_BLUFI_ADV_SLOW,              // 慢速广播：快速阶段超时后
+} xn_blufi_adv_phase_t;
+
+/* 蓝牙广播调度统计（射频占用和电流为按间隔估算的值） */
+typedef struct {
+    xn_blufi_adv_phase_t phase;     // 当前阶段
+    uint32_t interval_ms;           // 当前广播间隔，未广播时为0
+    uint32_t fast_ms;               // 累计快速广播时间（毫秒）
+    uint32_t slow_ms;               // 累计慢速广播时间（毫秒）
+    uint32_t idle_ms;               // 累计未广播时间（毫秒）
+    uint32_t adv_events;            // 估算的广播事件数
+    uint32_t radio_on_ms;           // 估算的广播射频占用时间（毫秒）
+    uint16_t duty_permille;         // 累计广播占空比（千分比）
+    uint16_t phase_duty_permille;   // 当前阶段的广播占空比（千分比）
+    uint32_t avg_current_ua;        // 广播带来的累计平均电流（微安）
+    uint32_t phase_current_ua;      // 当前阶段广播带来的平均电流（微安）
+    uint32_t fast_starts;           // 进入快速阶段的次数
+} xn_blufi_adv_stats_t;
+
 /**
  * @brief 创建BluFi配网组件实例
  * @param device_name 蓝牙设备名称，将显示在小程序中
@@ -55,6 +130,38 @@ esp_err_t xn_blufi_init(xn_blufi_t *blufi);
  */
 esp_err_t xn_blufi_deinit(xn_blufi_t *blufi);
 
+/**
+ * @brief 从深度睡眠快速唤醒（需开启CONFIG_XN_BLUFI_FAST_WAKE）
+ * 
+ * 用进入睡眠前保存在RTC内存中的凭据（含PMK）、AP和租约直接重连，
+ * 不读取NVS中的配置列表，不初始化蓝牙。返回ESP_OK后按正常方式等待获取IP；
+ * 快速重连失败时调用xn_blufi_fast_wake_clear()后重启，走完整的xn_blufi_init()。
+ * 
+ * @param blufi 组件实例指针
+ * @return ESP_OK已发起重连，ESP_ERR_NOT_FOUND不是深度睡眠唤醒或没有保存的状态（应改用xn_blufi_init），
+ *         ESP_ERR_NOT_SUPPORTED未开启快速唤醒，其他值失败
+ */
+esp_err_t xn_blufi_init_fast_wake(xn_blufi_t *blufi);
+
+/**
+ * @brief 保存当前连接状态到RTC内存，供下次唤醒时快速重连（在esp_deep_sleep_start()前调用）
+ * @param blufi 组件实例指针
+ * @return ESP_OK成功，ESP_ERR_INVALID_STATE未获取IP，ESP_ERR_NOT_SUPPORTED未开启快速唤醒，其他值失败
+ */
+esp_err_t xn_blufi_fast_wake_save(xn_blufi_t *blufi);
+
+/**
+ * @brief 清除RTC内存中的快速唤醒状态
+ */
+void xn_blufi_fast_wake_clear(void);
+
+/**
+ * @brief 是否由快速唤醒路径初始化（未初始化蓝牙和存储层，配网和配置读写接口不可用）
+ * @param blufi 组件实例指针
+ * @return true快速唤醒，false正常启动
+ */
+bool xn_blufi_is_fast_wake(xn_blufi_t *blufi);
+
 /**
  * @brief 连接到指定WiFi
  * @param blufi 组件实例指针
@@ -64,6 +171,22 @@ esp_err_t xn_blufi_deinit(xn_blufi_t *blufi);
  */
 esp_err_t xn_blufi_wifi_connect(xn_blufi_t *blufi, const char *ssid, const char *password);
 
+/**
+ * @brief 按带长度的凭据连接WiFi（支持32字节SSID、64字节PSK和非字符串SSID）
+ * @param blufi 组件实例指针
+ * @param cred WiFi凭据
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_wifi_connect_cred(xn_blufi_t *blufi, const xn_wifi_cred_t *cred);
+
+/**
+ * @brief 获取当前连接的凭据，WPA/WPA2-PSK网络上同时给出PMK（用于保存，下次连接跳过PBKDF2）
+ * @param blufi 组件实例指针
+ * @param cred 输出参数，保存凭据
+ * @return ESP_OK成功，ESP_ERR_INVALID_STATE未连接，其他值失败
+ */
+esp_err_t xn_blufi_wifi_get_connected_cred(xn_blufi_t *blufi, xn_wifi_cred_t *cred);
+
 /**
  * @brief 断开当前WiFi连接
  * @param blufi 组件实例指针
@@ -80,6 +203,34 @@ esp_err_t xn_blufi_wifi_disconnect(xn_blufi_t *blufi);
  */
 esp_err_t xn_blufi_wifi_save(xn_blufi_t *blufi, const char *ssid, const char *password);
 
+/**
+ * @brief 按带长度的凭据保存WiFi配置到NVS
+ * @param blufi 组件实例指针
+ * @param cred WiFi凭据
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_wifi_save_cred(xn_blufi_t *blufi, const xn_wifi_cred_t *cred);
+
+/**
+ * @brief 记录一次连接成功，用于调整已存储网络的连接优先顺序
+ * @param blufi 组件实例指针
+ * @param ssid WiFi名称（原始字节，可含'\0'）
+ * @param ssid_len SSID长度（1~32）
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_wifi_mark_connected(xn_blufi_t *blufi, const uint8_t *ssid, uint8_t ssid_len);
+
+/**
+ * @brief 设置已存储网络的用户优先级
+ * @param blufi 组件实例指针
+ * @param ssid WiFi名称（原始字节，可含'\0'）
+ * @param ssid_len SSID长度（1~32）
+ * @param priority 优先级（0~255，越大越优先）
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_wifi_set_priority(xn_blufi_t *blufi, const uint8_t *ssid, uint8_t ssid_len,
+                                     uint8_t priority);
+
 /**
  * @brief 从NVS删除WiFi配置
  * @param blufi 组件实例指针
@@ -88,7 +239,7 @@ esp_err_t xn_blufi_wifi_save(xn_blufi_t *blufi, const char *ssid, const char *pa
 esp_err_t xn_blufi_wifi_delete(xn_blufi_t *blufi);
 
 /**
- * @brief 从NVS加载WiFi配置
+ * @brief 从NVS加载WiFi配置（连接优先顺序最高的一个）
  * @param blufi 组件实例指针
  * @param config 输出参数，保存加载的配置
  * @return ESP_OK成功，其他值失败
@@ -110,6 +261,70 @@ esp_err_t xn_blufi_wifi_scan(xn_blufi_t *blufi, xn_wifi_scan_done_cb_t callback)
  */
 xn_wifi_status_t xn_blufi_wifi_get_status(xn_blufi_t *blufi);
 
+/**
+ * @brief 获取WiFi状态快照（含最近一次从发起连接到获取IP的耗时）
+ * @param blufi 组件实例指针
+ * @param snapshot 输出参数，保存快照
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_wifi_get_snapshot(xn_blufi_t *blufi, xn_wifi_snapshot_t *snapshot);
+
+/**
+ * @brief 切换WiFi功耗/性能档位（见xn_wifi_profile_id_t）
+ * @param blufi 组件实例指针
+ * @param id 档位
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_wifi_set_profile(xn_blufi_t *blufi, xn_wifi_profile_id_t id);
+
+/**
+ * @brief 使用自定义WiFi档位参数
+ * @param blufi 组件实例指针
+ * @param profile 档位参数
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_wifi_set_custom_profile(xn_blufi_t *blufi, const xn_wifi_profile_t *profile);
+
+/**
+ * @brief 获取当前WiFi档位及实际生效的设置和信号强度
+ * @param blufi 组件实例指针
+ * @param info 输出参数，保存档位状态
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_wifi_get_profile_info(xn_blufi_t *blufi, xn_wifi_profile_info_t *info);
+
+/**
+ * @brief 获取WiFi漫游统计（切换次数、切换耗时等）
+ * @param blufi 组件实例指针
+ * @param stats 输出参数，保存漫游统计
+ * @return ESP_OK成功，ESP_ERR_NOT_SUPPORTED未开启漫游，其他值失败
+ */
+esp_err_t xn_blufi_wifi_get_roam_stats(xn_blufi_t *blufi, xn_wifi_roam_stats_t *stats);
+
+/**
+ * @brief 获取当前WiFi连接的链路质量（平滑信号强度、beacon丢失等）
+ * @param blufi 组件实例指针
+ * @param info 输出参数，保存链路质量
+ * @return ESP_OK成功，ESP_ERR_NOT_SUPPORTED未开启链路监测，其他值失败
+ */
+esp_err_t xn_blufi_wifi_get_link_info(xn_blufi_t *blufi, xn_wifi_link_info_t *info);
+
+/**
+ * @brief 阻塞等待WiFi获取IP
+ * @param blufi 组件实例指针
+ * @param timeout 超时时间（tick），portMAX_DELAY表示一直等待
+ * @return ESP_OK已获取IP，ESP_ERR_TIMEOUT超时，其他值失败
+ */
+esp_err_t xn_blufi_wifi_wait_for_ip(xn_blufi_t *blufi, TickType_t timeout);
+
+/**
+ * @brief 阻塞等待WiFi断开
+ * @param blufi 组件实例指针
+ * @param timeout 超时时间（tick），portMAX_DELAY表示一直等待
+ * @return ESP_OK已断开，ESP_ERR_TIMEOUT超时，其他值失败
+ */
+esp_err_t xn_blufi_wifi_wait_for_disconnect(xn_blufi_t *blufi, TickType_t timeout);
+
 /**
  * @brief 注册WiFi状态变化回调
  * @param blufi 组件实例指针
@@ -117,6 +332,37 @@ xn_wifi_status_t xn_blufi_wifi_get_status(xn_blufi_t *blufi);
  */
 void xn_blufi_wifi_register_status_cb(xn_blufi_t *blufi, xn_wifi_status_cb_t callback);
 
+/**
+ * @brief 订阅WiFi事件，支持多个订阅者（MQTT、OTA、LED等模块各自订阅）
+ * @param blufi 组件实例指针
+ * @param callback 事件回调函数，在该订阅者自己的投递任务中按顺序调用
+ * @param user_ctx 用户上下文，原样传给回调
+ * @param event_mask 关注的事件掩码，见XN_WIFI_EVENT_MASK
+ * @param sub_id 输出参数，订阅ID，可为NULL
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_wifi_subscribe(xn_blufi_t *blufi, xn_wifi_event_cb_t callback,
+                                  void *user_ctx, uint32_t event_mask, int *sub_id);
+
+/**
+ * @brief 以队列方式订阅WiFi事件，耗时处理（保存配置、计算PMK等）在订阅者自己的任务中进行
+ * @param blufi 组件实例指针
+ * @param queue 接收事件的队列，元素大小必须为sizeof(xn_wifi_event_t)
+ * @param event_mask 关注的事件掩码，见XN_WIFI_EVENT_MASK
+ * @param sub_id 输出参数，订阅ID，可为NULL
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_wifi_subscribe_queue(xn_blufi_t *blufi, QueueHandle_t queue,
+                                        uint32_t event_mask, int *sub_id);
+
+/**
+ * @brief 取消订阅WiFi事件
+ * @param blufi 组件实例指针
+ * @param sub_id 订阅ID
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_wifi_unsubscribe(xn_blufi_t *blufi, int sub_id);
+
 /**
  * @brief 获取蓝牙连接状态
  * @param blufi 组件实例指针
@@ -124,6 +370,61 @@ void xn_blufi_wifi_register_status_cb(xn_blufi_t *blufi, xn_wifi_status_cb_t cal
  */
 bool xn_blufi_is_ble_connected(xn_blufi_t *blufi);
 
+/**
+ * @brief 设置蓝牙/WiFi共存调度策略
+ * @param blufi 组件实例指针
+ * @param policy 共存策略，默认XN_BLUFI_COEX_AUTO
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_set_coex_policy(xn_blufi_t *blufi, xn_blufi_coex_policy_t policy);
+
+/**
+ * @brief 获取共存调度统计信息（各阶段等待耗时）
+ * @param blufi 组件实例指针
+ * @param stats 输出参数，保存统计信息
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_get_coex_stats(xn_blufi_t *blufi, xn_blufi_coex_stats_t *stats);
+
+/**
+ * @brief 获取BluFi安全层统计信息（协商及逐帧加解密耗时）
+ * @param blufi 组件实例指针
+ * @param stats 输出参数，保存统计信息
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_get_security_stats(xn_blufi_t *blufi, xn_blufi_security_stats_t *stats);
+
+/**
+ * @brief 获取启动耗时分解（各阶段起止时间，需开启CONFIG_XN_BLUFI_BOOT_PROFILE）
+ * @param blufi 组件实例指针
+ * @param profile 输出参数，保存分解结果
+ * @return ESP_OK成功，ESP_ERR_NOT_SUPPORTED未开启，其他值失败
+ */
+esp_err_t xn_blufi_get_boot_profile(xn_blufi_t *blufi, xn_boot_profile_t *profile);
+
+/**
+ * @brief 重新开始快速广播（如按键唤醒），之后按调度转为慢速并超时停止
+ * @param blufi 组件实例指针
+ * @return ESP_OK成功，ESP_ERR_INVALID_STATE蓝牙未初始化，其他值失败
+ */
+esp_err_t xn_blufi_adv_wake(xn_blufi_t *blufi);
+
+/**
+ * @brief 获取蓝牙广播调度统计（各阶段时间、射频占空比和估算电流）
+ * @param blufi 组件实例指针
+ * @param stats 输出参数，保存统计信息
+ * @return ESP_OK成功，ESP_ERR_NOT_SUPPORTED未开启广播调度，其他值失败
+ */
+esp_err_t xn_blufi_get_adv_stats(xn_blufi_t *blufi, xn_blufi_adv_stats_t *stats);
+
+/**
+ * @brief 获取组件任务的核心、优先级和栈使用情况（栈高水位）
+ * @param blufi 组件实例指针
+ * @param stats 输出参数，保存任务信息
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_blufi_get_task_stats(xn_blufi_t *blufi, xn_blufi_task_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
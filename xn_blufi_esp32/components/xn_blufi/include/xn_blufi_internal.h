@@ -9,7 +9,10 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "host/ble_gatt.h"
+#include "esp_err.h"
+#include "xn_blufi.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,6 +27,48 @@ void xn_blufi_on_sync(void);
 /* NimBLE主机任务 */
 void xn_blufi_host_task(void *param);
 
+/* 初始化安全会话（BLE连接时调用） */
+esp_err_t xn_blufi_security_init(void);
+
+/* 释放安全会话（BLE断开时调用） */
+void xn_blufi_security_deinit(void);
+
+/* BluFi协商数据处理回调 */
+void xn_blufi_security_negotiate(uint8_t *data, int len, uint8_t **output_data, int *output_len, bool *need_free);
+
+/* BluFi帧加密回调 */
+int xn_blufi_security_encrypt(uint8_t iv8, uint8_t *crypt_data, int crypt_len);
+
+/* BluFi帧解密回调 */
+int xn_blufi_security_decrypt(uint8_t iv8, uint8_t *crypt_data, int crypt_len);
+
+/* BluFi帧校验和回调 */
+uint16_t xn_blufi_security_checksum(uint8_t iv8, uint8_t *data, int len);
+
+/* 获取安全层统计 */
+void xn_blufi_security_get_stats(xn_blufi_security_stats_t *stats);
+
+/* 初始化广播调度（启动NimBLE前调用） */
+esp_err_t xn_blufi_adv_init(void);
+
+/* 停止广播并释放广播调度资源 */
+void xn_blufi_adv_deinit(void);
+
+/* 从快速阶段开始广播（BluFi就绪、蓝牙断开、按键或WiFi断开时调用） */
+esp_err_t xn_blufi_adv_start_fast(void);
+
+/* 蓝牙连接状态变化：连接时停止广播，断开后重新快速广播 */
+void xn_blufi_adv_on_ble(bool connected);
+
+/* WiFi状态变化：已连上的网络断开时重新开始快速广播 */
+void xn_blufi_adv_on_wifi(bool got_ip);
+
+/* 更新扫描响应中的厂商数据（设备状态），蓝牙未初始化时忽略 */
+void xn_blufi_adv_set_mfg_data(const uint8_t *data, size_t len);
+
+/* 获取广播调度统计 */
+esp_err_t xn_blufi_adv_get_stats(xn_blufi_adv_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
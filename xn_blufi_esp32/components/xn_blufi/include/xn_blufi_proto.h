@@ -0,0 +1,145 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: BluFi自定义数据协议编解码 - 头文件
+ * 
+ * 功能说明：
+ * 1. 解析小程序发来的自定义数据命令
+ * 2. 构建设备回复的自定义数据
+ * 3. 复制对端发来的SSID/密码，长度由对端决定，必须先校验
+ * 4. 构建扫描响应中的厂商数据（设备状态），小程序不连接即可筛选设备
+ * 5. 只依赖esp_err.h和配置结构体，不调用任何ESP-IDF运行时接口，可在主机上单独编译
+ */
+
+#ifndef XN_BLUFI_PROTO_H
+#define XN_BLUFI_PROTO_H
+
+#include "esp_err.h"
+#include "xn_wifi_storage.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 自定义数据命令类型 */
+#define XN_BLUFI_CMD_GET_CONFIGS        0x01    // 获取存储的WiFi配置（所有）
+#define XN_BLUFI_CMD_DELETE_CONFIG      0x02    // 删除指定索引的WiFi配置
+#define XN_BLUFI_CMD_GET_STATUS         0x03    // 获取扩展连接状态
+
+/* 回复状态 */
+#define XN_BLUFI_STATUS_OK              0x00    // 成功
+#define XN_BLUFI_STATUS_FAIL            0x01    // 失败/未找到
+
+#define XN_BLUFI_PROTO_MAX_RESPONSE     512     // 单条回复的最大长度
+#define XN_BLUFI_PROTO_STATUS_REPORT_LEN 28     // 扩展状态回复的长度
+
+/* 扫描响应中的厂商数据 */
+#define XN_BLUFI_ADV_COMPANY_ID         0x02E5  // 乐鑫的蓝牙SIG公司ID
+#define XN_BLUFI_ADV_FRAME_VERSION      0x01    // 厂商数据格式版本
+#define XN_BLUFI_ADV_FLAG_PROVISIONED   0x01    // 标志位：已保存WiFi配置
+#define XN_BLUFI_PROTO_ADV_DATA_LEN     11      // 厂商数据长度（含公司ID）
+
+/* 解析后的命令 */
+typedef struct {
+    uint8_t type;           // 命令类型
+    uint8_t index;          // 配置索引（删除命令）
+} xn_blufi_cmd_t;
+
+/* 扩展连接状态，地址为网络字节序 */
+typedef struct {
+    uint8_t wifi_status;        // 连接状态，取值同xn_wifi_status_t
+    int8_t rssi;                // 信号强度（dBm），未知为0
+    uint8_t channel;            // 信道
+    uint8_t authmode;           // 认证方式，取值同wifi_auth_mode_t
+    uint8_t bssid[6];           // AP的BSSID
+    uint32_t ip;                // IP地址
+    uint32_t gw;                // 网关
+    uint32_t uptime_s;          // 当前连接已持续的秒数
+    uint32_t reconnect_count;   // 自动重连次数
+} xn_blufi_status_report_t;
+
+/* 广播中的设备状态 */
+typedef struct {
+    bool provisioned;           // 已保存WiFi配置
+    uint8_t wifi_status;        // 连接状态，取值同xn_wifi_status_t
+    uint8_t fw_version[3];      // 固件版本（主、次、修订）
+    uint8_t mac_suffix[3];      // 蓝牙MAC地址的后3字节（按显示顺序）
+} xn_blufi_adv_state_t;
+
+/**
+ * @brief 解析自定义数据命令
+ * @param data 收到的数据
+ * @param len 数据长度
+ * @param cmd 输出参数，保存解析结果
+ * @return ESP_OK成功，ESP_ERR_INVALID_SIZE数据不完整，ESP_ERR_NOT_SUPPORTED未知命令
+ */
+esp_err_t xn_blufi_proto_parse(const uint8_t *data, size_t len, xn_blufi_cmd_t *cmd);
+
+/**
+ * @brief 构建存储配置列表回复：[类型, 状态, 数量, [SSID长度, SSID, 密码长度, 密码]...]
+ * @param configs 配置数组，count为0时可为NULL
+ * @param count 配置数量，0表示未找到
+ * @param out 输出缓冲区
+ * @param out_size 输出缓冲区大小
+ * @return 回复长度，缓冲区不足返回0
+ */
+size_t xn_blufi_proto_build_config_list(const xn_wifi_config_t *configs, uint8_t count,
+                                        uint8_t *out, size_t out_size);
+
+/**
+ * @brief 构建扩展状态回复，共XN_BLUFI_PROTO_STATUS_REPORT_LEN字节：
+ *        [类型, 状态, 连接状态, RSSI, 信道, 认证方式, BSSID(6), IP(4), 网关(4),
+ *         连接时长秒(4，小端), 重连次数(4，小端)]，IP和网关按a.b.c.d顺序
+ * @param report 扩展状态
+ * @param out 输出缓冲区
+ * @param out_size 输出缓冲区大小
+ * @return 回复长度，缓冲区不足返回0
+ */
+size_t xn_blufi_proto_build_status_report(const xn_blufi_status_report_t *report,
+                                          uint8_t *out, size_t out_size);
+
+/**
+ * @brief 构建扫描响应中的厂商数据，共XN_BLUFI_PROTO_ADV_DATA_LEN字节：
+ *        [公司ID(2，小端), 格式版本, 标志, 连接状态, 固件版本(3), MAC后3字节]
+ * @param state 设备状态
+ * @param out 输出缓冲区
+ * @param out_size 输出缓冲区大小
+ * @return 数据长度，缓冲区不足返回0
+ */
+size_t xn_blufi_proto_build_adv_data(const xn_blufi_adv_state_t *state, uint8_t *out, size_t out_size);
+
+/**
+ * @brief 解析固件版本字符串（如"1.2.3"、"v1.2.3-4-gabcdef"），缺少的部分为0
+ * @param version 版本字符串
+ * @param out 输出参数，保存主、次、修订版本号（超过255的取255）
+ */
+void xn_blufi_proto_parse_version(const char *version, uint8_t out[3]);
+
+/**
+ * @brief 构建状态回复：[类型, 状态]
+ * @param type 命令类型
+ * @param status 状态
+ * @param out 输出缓冲区
+ * @param out_size 输出缓冲区大小
+ * @return 回复长度，缓冲区不足返回0
+ */
+size_t xn_blufi_proto_build_status(uint8_t type, uint8_t status, uint8_t *out, size_t out_size);
+
+/**
+ * @brief 复制对端发来的SSID/密码并补'\0'，超长或长度非法时拒绝
+ * @param dst 目标缓冲区
+ * @param dst_size 目标缓冲区大小（含结尾'\0'）
+ * @param src 收到的数据，len为0时可为NULL
+ * @param len 收到的数据长度
+ * @return ESP_OK成功，ESP_ERR_INVALID_SIZE长度超出缓冲区，其他值失败
+ */
+esp_err_t xn_blufi_proto_copy_field(uint8_t *dst, size_t dst_size, const uint8_t *src, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XN_BLUFI_PROTO_H
@@ -0,0 +1,66 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: 启动耗时分析 - 头文件
+ * 
+ * 功能说明：
+ * 1. 记录启动各阶段（NVS、网络接口、WiFi、蓝牙控制器、NimBLE、GATT、首次连接等）的起止时间
+ * 2. 启动完成后按耗时从大到小打印分解结果
+ * 3. 通过xn_blufi_get_boot_profile读取，便于发现启动耗时回退
+ * 
+ * 需要在menuconfig中开启CONFIG_XN_BLUFI_BOOT_PROFILE，未开启时记录接口为空操作。
+ */
+
+#ifndef XN_BOOT_PROFILE_H
+#define XN_BOOT_PROFILE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XN_BOOT_PROFILE_MAX_STAGES 24   // 最多记录的阶段数
+
+/* 启动阶段 */
+typedef struct {
+    const char *name;           // 阶段名称（字符串常量）
+    uint32_t start_us;          // 开始时间（自上电起，微秒）
+    uint32_t duration_us;       // 耗时（微秒）
+} xn_boot_stage_t;
+
+/* 启动耗时分解 */
+typedef struct {
+    uint8_t count;                                      // 已记录的阶段数
+    uint8_t dropped;                                    // 超出容量丢弃的阶段数
+    bool finished;                                      // 是否已结束记录
+    uint32_t end_us;                                    // 最后一个阶段的结束时间（自上电起）
+    xn_boot_stage_t stages[XN_BOOT_PROFILE_MAX_STAGES]; // 按记录顺序排列
+} xn_boot_profile_t;
+
+/**
+ * @brief 记录一个已完成的启动阶段（结束时间为当前时间）
+ * @param name 阶段名称，必须是字符串常量
+ * @param start_us 阶段开始时的esp_timer_get_time()
+ */
+void xn_boot_profile_record(const char *name, int64_t start_us);
+
+/**
+ * @brief 结束记录并打印按耗时排序的分解结果（只执行一次，之后的记录被忽略）
+ */
+void xn_boot_profile_finish(void);
+
+/**
+ * @brief 获取启动耗时分解
+ * @param profile 输出参数，保存分解结果
+ * @return ESP_OK成功，ESP_ERR_NOT_SUPPORTED未开启CONFIG_XN_BLUFI_BOOT_PROFILE，其他值失败
+ */
+esp_err_t xn_boot_profile_get(xn_boot_profile_t *profile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XN_BOOT_PROFILE_H
@@ -0,0 +1,59 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: 深度睡眠快速唤醒 - 头文件
+ *
+ * 功能说明：
+ * 1. 进入深度睡眠前把当前网络的凭据（含PMK）、AP（BSSID、信道）和IP租约保存在RTC内存中
+ * 2. 从深度睡眠唤醒时读回，直接重连，不读取NVS中的配置列表、不初始化蓝牙
+ * 3. RTC内存在上电、复位时清空，状态带校验，只在深度睡眠唤醒时有效
+ *
+ * 需要在menuconfig中开启CONFIG_XN_BLUFI_FAST_WAKE，未开启时不占用RTC内存，
+ * 保存/读取接口返回ESP_ERR_NOT_SUPPORTED。
+ */
+
+#ifndef XN_FAST_WAKE_H
+#define XN_FAST_WAKE_H
+
+#include "esp_err.h"
+#include "xn_wifi_cred.h"
+#include "xn_wifi_lease.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 快速唤醒状态 */
+typedef struct {
+    xn_wifi_cred_t cred;        // 凭据（口令和PMK）
+    xn_wifi_lease_t lease;      // AP和租约
+    uint32_t fresh_s;           // 读取时：租约距T1的剩余秒数，0表示已过T1或未知
+} xn_fast_wake_state_t;
+
+/**
+ * @brief 保存快速唤醒状态到RTC内存（进入深度睡眠前调用）
+ * @param state 快速唤醒状态，fresh_s为保存时距T1的剩余秒数
+ * @return ESP_OK成功，ESP_ERR_NOT_SUPPORTED未开启快速唤醒，其他值失败
+ */
+esp_err_t xn_fast_wake_save(const xn_fast_wake_state_t *state);
+
+/**
+ * @brief 读取快速唤醒状态
+ * @param state 输出参数，保存快速唤醒状态，fresh_s已扣除睡眠时间
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND不是深度睡眠唤醒或状态无效，
+ *         ESP_ERR_NOT_SUPPORTED未开启快速唤醒，其他值失败
+ */
+esp_err_t xn_fast_wake_load(xn_fast_wake_state_t *state);
+
+/**
+ * @brief 清除RTC内存中的快速唤醒状态（快速重连失败或删除配置时调用）
+ */
+void xn_fast_wake_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XN_FAST_WAKE_H
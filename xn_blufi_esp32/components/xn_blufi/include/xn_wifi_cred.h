@@ -0,0 +1,72 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: WiFi凭据 - 头文件
+ * 
+ * 功能说明：
+ * 1. 带长度的SSID/密码，BluFi接收、WiFi管理层连接、存储层统一使用
+ * 2. SSID按原始字节处理，允许包含'\0'；长度随结构体传递，无需反复strlen
+ * 3. 数组比最大长度多1字节并始终补'\0'，普通SSID可直接按字符串打印
+ * 4. 可携带预计算的PMK，WPA2-PSK连接时直接使用，省去每次4096轮PBKDF2
+ */
+
+#ifndef XN_WIFI_CRED_H
+#define XN_WIFI_CRED_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XN_WIFI_SSID_MAX_LEN        32  // 802.11 SSID最大长度
+#define XN_WIFI_PASSWORD_MAX_LEN    64  // WPA口令最长63字节，64字节为十六进制PSK
+#define XN_WIFI_PMK_LEN             32  // WPA2-PSK的PMK长度
+
+/* WiFi凭据 */
+typedef struct {
+    uint8_t ssid[XN_WIFI_SSID_MAX_LEN + 1];             // WiFi名称（原始字节）
+    uint8_t ssid_len;                                   // WiFi名称长度
+    uint8_t password[XN_WIFI_PASSWORD_MAX_LEN + 1];     // WiFi密码
+    uint8_t password_len;                               // WiFi密码长度
+    uint8_t pmk[XN_WIFI_PMK_LEN];                       // 预计算的PMK（PBKDF2-SHA1(口令, SSID, 4096)）
+    bool pmk_valid;                                     // PMK是否有效，修改SSID或密码后必须置false
+} xn_wifi_cred_t;
+
+/**
+ * @brief 按原始字节设置凭据
+ * @param cred 凭据
+ * @param ssid WiFi名称，ssid_len为0时可为NULL
+ * @param ssid_len WiFi名称长度（不超过32）
+ * @param password WiFi密码，password_len为0时可为NULL
+ * @param password_len WiFi密码长度（不超过64）
+ * @return ESP_OK成功，ESP_ERR_INVALID_SIZE长度超限，其他值失败
+ */
+esp_err_t xn_wifi_cred_set(xn_wifi_cred_t *cred,
+                           const uint8_t *ssid, size_t ssid_len,
+                           const uint8_t *password, size_t password_len);
+
+/**
+ * @brief 由字符串设置凭据（兼容字符串接口）
+ * @param cred 凭据
+ * @param ssid WiFi名称
+ * @param password WiFi密码，NULL表示开放网络
+ * @return ESP_OK成功，ESP_ERR_INVALID_SIZE长度超限，其他值失败
+ */
+esp_err_t xn_wifi_cred_from_str(xn_wifi_cred_t *cred, const char *ssid, const char *password);
+
+/**
+ * @brief 由口令和SSID计算PMK并写入凭据（4096轮PBKDF2-HMAC-SHA1，耗时较长）
+ * @param cred 凭据，口令长度必须为8~63字节
+ * @return ESP_OK成功，ESP_ERR_NOT_SUPPORTED口令不是WPA口令（开放网络或十六进制PSK），其他值失败
+ */
+esp_err_t xn_wifi_cred_derive_pmk(xn_wifi_cred_t *cred);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XN_WIFI_CRED_H
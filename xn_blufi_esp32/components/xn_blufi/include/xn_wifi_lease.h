@@ -0,0 +1,89 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: WiFi租约缓存 - 头文件
+ *
+ * 功能说明：
+ * 1. 按网络（SSID）记录上次连接的AP（BSSID、信道）和DHCP租约（IP、网关、子网掩码、DNS、租期）
+ * 2. 保存在NVS中，最多XN_WIFI_LEASE_MAX_ENTRIES个网络，满时替换最久未使用的记录
+ * 3. 内容未变化时不写Flash
+ *
+ * 只由WiFi管理器工作任务调用，内部不加锁。
+ */
+
+#ifndef XN_WIFI_LEASE_H
+#define XN_WIFI_LEASE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XN_WIFI_LEASE_MAX_ENTRIES   8   // 最多缓存的网络数
+
+/* 单个网络的租约记录，地址均为网络字节序 */
+typedef struct {
+    uint8_t bssid[6];           // 获得租约时连接的AP
+    uint8_t channel;            // AP所在信道
+    uint8_t reserved;
+    uint32_t ip;                // IP地址
+    uint32_t netmask;           // 子网掩码
+    uint32_t gw;                // 网关
+    uint32_t dns;               // 主DNS，0表示无
+    uint32_t lease_s;           // DHCP租期（秒），0表示未知
+    int64_t obtained_at;        // 获得租约时的系统时间（秒），0表示当时系统时间无效
+} xn_wifi_lease_t;
+
+/**
+ * @brief 读取网络的租约记录
+ * @param ssid WiFi名称（原始字节）
+ * @param ssid_len WiFi名称长度
+ * @param lease 输出参数，保存租约记录
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND没有记录，其他值失败
+ */
+esp_err_t xn_wifi_lease_get(const uint8_t *ssid, size_t ssid_len, xn_wifi_lease_t *lease);
+
+/**
+ * @brief 保存网络的租约记录（与已有记录相同时不写Flash）
+ * @param ssid WiFi名称（原始字节）
+ * @param ssid_len WiFi名称长度
+ * @param lease 租约记录
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_wifi_lease_put(const uint8_t *ssid, size_t ssid_len, const xn_wifi_lease_t *lease);
+
+/**
+ * @brief 删除网络的租约记录
+ * @param ssid WiFi名称（原始字节）
+ * @param ssid_len WiFi名称长度
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND没有记录，其他值失败
+ */
+esp_err_t xn_wifi_lease_remove(const uint8_t *ssid, size_t ssid_len);
+
+/**
+ * @brief 判断租约是否仍在续约时间（T1，租期的一半）之前
+ *
+ * 需要有效的系统时间（SNTP校时后，或深度睡眠/软件复位后RTC时间仍有效），
+ * 否则无法判断租约已过去多久，一律视为不新鲜。
+ *
+ * @param lease 租约记录
+ * @param remaining_s 输出参数，距T1的剩余秒数，可为NULL
+ * @return true租约新鲜，false已过T1或无法判断
+ */
+bool xn_wifi_lease_is_fresh(const xn_wifi_lease_t *lease, uint32_t *remaining_s);
+
+/**
+ * @brief 获取当前系统时间（秒），用于填写obtained_at
+ * @return 系统时间，系统时间无效（未校时）时返回0
+ */
+int64_t xn_wifi_lease_now(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XN_WIFI_LEASE_H
@@ -14,6 +14,10 @@
 
 #include "esp_err.h"
 #include "esp_wifi.h"
+#include "xn_wifi_cred.h"
+#include "xn_wifi_lease.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include <stdbool.h>
 
 #ifdef __cplusplus
@@ -28,12 +32,120 @@ typedef enum {
     XN_WIFI_GOT_IP              // 已连接并获取IP
 } xn_wifi_status_t;
 
+/* WiFi事件类型，状态类事件与xn_wifi_status_t取值一一对应，其后为链路质量事件 */
+typedef enum {
+    XN_WIFI_EVENT_DISCONNECTED = XN_WIFI_DISCONNECTED,  // 未连接
+    XN_WIFI_EVENT_CONNECTING = XN_WIFI_CONNECTING,      // 连接中
+    XN_WIFI_EVENT_CONNECTED = XN_WIFI_CONNECTED,        // 已连接但未获取IP
+    XN_WIFI_EVENT_GOT_IP = XN_WIFI_GOT_IP,              // 已连接并获取IP
+    XN_WIFI_EVENT_LINK_DEGRADED,                        // 链路变差（平滑信号强度低于门限或丢失beacon）
+    XN_WIFI_EVENT_LINK_RECOVERED,                       // 链路恢复（信号高于门限加迟滞且连续多次采样无beacon丢失）
+    XN_WIFI_EVENT_MAX
+} xn_wifi_event_t;
+
+/* 事件掩码 */
+#define XN_WIFI_EVENT_MASK(event)   (1UL << (event))
+#define XN_WIFI_EVENT_MASK_STATUS   (XN_WIFI_EVENT_MASK(XN_WIFI_EVENT_DISCONNECTED) | \
+                                     XN_WIFI_EVENT_MASK(XN_WIFI_EVENT_CONNECTING) | \
+                                     XN_WIFI_EVENT_MASK(XN_WIFI_EVENT_CONNECTED) | \
+                                     XN_WIFI_EVENT_MASK(XN_WIFI_EVENT_GOT_IP))
+#define XN_WIFI_EVENT_MASK_LINK     (XN_WIFI_EVENT_MASK(XN_WIFI_EVENT_LINK_DEGRADED) | \
+                                     XN_WIFI_EVENT_MASK(XN_WIFI_EVENT_LINK_RECOVERED))
+#define XN_WIFI_EVENT_MASK_ALL      0xFFFFFFFFUL
+                                     
+/* 订阅者表容量 */
+#define XN_WIFI_MAX_SUBSCRIBERS 8
+
 /* WiFi扫描结果回调函数类型 */
 typedef void (*xn_wifi_scan_done_cb_t)(uint16_t ap_count, wifi_ap_record_t *ap_list);
 
 /* WiFi状态变化回调函数类型 */
 typedef void (*xn_wifi_status_cb_t)(xn_wifi_status_t status);
 
+/* WiFi事件订阅回调函数类型 */
+typedef void (*xn_wifi_event_cb_t)(xn_wifi_event_t event, void *user_ctx);
+
+/* WiFi管理器状态快照（一致性副本，可在任意任务中读取） */
+typedef struct {
+    xn_wifi_status_t status;    // WiFi连接状态
+    bool is_connecting;         // 是否正在连接（含重连，获取IP后结束）
+    uint8_t retry_count;        // 当前重连计数
+    char ssid[33];              // 目标WiFi名称
+    uint32_t time_to_ip_ms;     // 最近一次从发起连接到获取IP的耗时（毫秒），0表示尚无数据
+    bool ip_from_lease;         // 当前地址来自缓存的租约（静态IP快速路径）
+    int8_t rssi;                // 平滑后的信号强度（dBm），未连接或未开启链路监测为0
+    bool link_degraded;         // 链路处于变差状态
+    uint8_t bssid[6];           // 已连接AP的BSSID，未连接为全0
+    uint8_t channel;            // 已连接AP的信道，未连接为0
+    wifi_auth_mode_t authmode;  // 已连接AP的认证方式
+    uint32_t ip;                // IP地址（网络字节序），未获取IP为0
+    uint32_t gw;                // 网关（网络字节序），未获取IP为0
+    int64_t connected_at;       // 连上当前AP的时间（esp_timer，us），未连接为0
+    uint32_t reconnect_count;   // 初始化以来自动重连的次数
+} xn_wifi_snapshot_t;
+
+/*
+ * WiFi功耗/性能档位
+ *
+ * 档位              省电模式    监听间隔  带宽   发射功率   预期取舍
+ * MAX_THROUGHPUT    不省电*     -         HT40   最大       吞吐最高、时延最低，电流最大（持续接收约百mA级）
+ * BALANCED          MIN_MODEM   3         HT20   最大       IDF默认；每个DTIM醒来，吞吐略降，平均电流明显下降
+ * LOW_POWER         MAX_MODEM   10        HT20   13dBm      平均电流最低，下行时延可达1秒，AP侧收到的信号约低8dB
+ *
+ * *开启蓝牙时WiFi必须保持Modem-sleep，MAX_THROUGHPUT自动退回MIN_MODEM，
+ *  实际生效的设置见xn_wifi_profile_info_t。
+ */
+typedef enum {
+    XN_WIFI_PROFILE_MAX_THROUGHPUT = 0,     // 最大吞吐（市电供电、批量上传）
+    XN_WIFI_PROFILE_BALANCED,               // 均衡（默认）
+    XN_WIFI_PROFILE_LOW_POWER,              // 低功耗（纽扣电池传感器）
+    XN_WIFI_PROFILE_CUSTOM,                 // 自定义
+} xn_wifi_profile_id_t;
+
+/* 档位参数 */
+typedef struct {
+    wifi_ps_type_t ps_type;         // 省电模式
+    uint16_t listen_interval;       // 监听间隔（beacon间隔数，MAX_MODEM时有效），0为默认值3
+    wifi_bandwidth_t bandwidth;     // 带宽HT20/HT40
+    uint8_t protocol;               // 协议位图，WIFI_PROTOCOL_11B/11G/11N组合
+    int8_t max_tx_power;            // 最大发射功率（单位0.25dBm，8~84），0表示不限制
+} xn_wifi_profile_t;
+
+/* 档位状态：配置值与实际生效/测得的值 */
+typedef struct {
+    xn_wifi_profile_id_t id;        // 当前档位
+    xn_wifi_profile_t config;       // 档位参数
+    wifi_ps_type_t ps_type;         // 实际生效的省电模式
+    wifi_bandwidth_t bandwidth;     // 实际生效的带宽
+    int8_t tx_power;                // 实际生效的最大发射功率（0.25dBm）
+    int8_t rssi;                    // 当前AP信号强度（dBm），未连接为0
+} xn_wifi_profile_info_t;
+
+/* 漫游统计（开启CONFIG_XN_BLUFI_ROAMING时有效） */
+typedef struct {
+    uint32_t rssi_low_count;        // 信号低于漫游门限的次数
+    uint32_t btm_queries;           // 发出的BSS切换查询（11v）数
+    uint32_t neighbor_reports;      // 收到的邻居报告（11k）数
+    uint32_t roam_count;            // 切换到其他AP的次数（含AP引导、驱动执行的切换）
+    uint32_t roam_failures;         // 连不上目标AP、退回扫描后连接的次数
+    uint32_t last_latency_ms;       // 最近一次切换耗时（断开旧AP到连上新AP）
+    uint32_t max_latency_ms;        // 最大切换耗时
+    uint32_t total_latency_ms;      // 累计切换耗时，除以roam_count为平均值
+} xn_wifi_roam_stats_t;
+
+/* 链路质量（开启CONFIG_XN_BLUFI_LINK_MONITOR时有效，统计按连接复位）
+ * 变差判断只依据信号强度和beacon丢失：驱动没有公开STA当前的PHY速率和发送重传率，
+ * 因此不统计这两项 */
+typedef struct {
+    int8_t rssi;                    // 最近一次采样的信号强度（dBm）
+    int8_t rssi_avg;                // 平滑后的信号强度（dBm）
+    bool degraded;                  // 当前是否处于变差状态
+    wifi_phy_mode_t phymode;        // 协商的PHY模式（11b/11g/HT20/HT40）
+    uint32_t samples;               // 采样次数
+    uint32_t beacon_timeouts;       // 丢失beacon（驱动上报beacon超时）的次数
+    uint32_t degraded_count;        // 进入变差状态的次数
+} xn_wifi_link_info_t;
+
 /* WiFi管理器实例 */
 typedef struct xn_wifi_manager_s xn_wifi_manager_t;
 
@@ -65,15 +177,42 @@ esp_err_t xn_wifi_manager_deinit(xn_wifi_manager_t *manager);
 
 /**
  * @brief 连接到指定WiFi
+ * 
+ * 连接、断开、扫描请求均投递到管理器的工作任务中串行执行，
+ * 本函数不阻塞等待连接结果，结果通过状态回调通知。
+ * 
  * @param manager 管理器实例指针
  * @param ssid WiFi名称
  * @param password WiFi密码
- * @return ESP_OK成功，其他值失败
+ * @return ESP_OK请求已提交，ESP_ERR_TIMEOUT命令队列已满，其他值失败
  */
 esp_err_t xn_wifi_manager_connect(xn_wifi_manager_t *manager, 
                                    const char *ssid, 
                                    const char *password);
 
+/**
+ * @brief 按带长度的凭据连接WiFi（SSID可含任意字节，支持32字节SSID和64字节PSK）
+ * @param manager 管理器实例指针
+ * @param cred WiFi凭据
+ * @return ESP_OK请求已提交，ESP_ERR_TIMEOUT命令队列已满，其他值失败
+ */
+esp_err_t xn_wifi_manager_connect_cred(xn_wifi_manager_t *manager, const xn_wifi_cred_t *cred);
+
+/**
+ * @brief 按给定的AP和租约连接WiFi（快速唤醒用，不读取NVS中的租约缓存）
+ * 
+ * 直接连接租约中的BSSID和信道；开启CONFIG_XN_BLUFI_LEASE_STATIC_IP且fresh_s不为0时，
+ * 连上同一BSSID后直接使用租约中的地址。
+ * 
+ * @param manager 管理器实例指针
+ * @param cred WiFi凭据
+ * @param lease AP和租约，NULL时与xn_wifi_manager_connect_cred相同
+ * @param fresh_s 租约距T1的剩余秒数，0表示按系统时间判断
+ * @return ESP_OK请求已提交，ESP_ERR_TIMEOUT命令队列已满，其他值失败
+ */
+esp_err_t xn_wifi_manager_connect_lease(xn_wifi_manager_t *manager, const xn_wifi_cred_t *cred,
+                                        const xn_wifi_lease_t *lease, uint32_t fresh_s);
+
 /**
  * @brief 断开当前WiFi连接
  * @param manager 管理器实例指针
@@ -91,20 +230,185 @@ esp_err_t xn_wifi_manager_scan(xn_wifi_manager_t *manager,
                                 xn_wifi_scan_done_cb_t callback);
 
 /**
- * @brief 获取当前WiFi连接状态
+ * @brief 获取当前WiFi连接状态（原子读取，不阻塞）
  * @param manager 管理器实例指针
  * @return WiFi连接状态
  */
 xn_wifi_status_t xn_wifi_manager_get_status(xn_wifi_manager_t *manager);
 
 /**
- * @brief 注册WiFi状态变化回调
+ * @brief 阻塞等待WiFi获取IP
+ * @param manager 管理器实例指针
+ * @param timeout 超时时间（tick），portMAX_DELAY表示一直等待
+ * @return ESP_OK已获取IP，ESP_ERR_TIMEOUT超时，其他值失败
+ */
+esp_err_t xn_wifi_manager_wait_for_ip(xn_wifi_manager_t *manager, TickType_t timeout);
+
+/**
+ * @brief 阻塞等待WiFi断开（重连次数用尽或主动断开）
+ * @param manager 管理器实例指针
+ * @param timeout 超时时间（tick），portMAX_DELAY表示一直等待
+ * @return ESP_OK已断开，ESP_ERR_TIMEOUT超时，其他值失败
+ */
+esp_err_t xn_wifi_manager_wait_for_disconnect(xn_wifi_manager_t *manager, TickType_t timeout);
+
+/**
+ * @brief 阻塞等待WiFi扫描完成（扫描回调执行完毕后返回）
+ * @param manager 管理器实例指针
+ * @param timeout 超时时间（tick），portMAX_DELAY表示一直等待
+ * @return ESP_OK无扫描进行中，ESP_ERR_TIMEOUT超时，其他值失败
+ */
+esp_err_t xn_wifi_manager_wait_for_scan_done(xn_wifi_manager_t *manager, TickType_t timeout);
+
+/**
+ * @brief 获取WiFi管理器状态快照
+ * @param manager 管理器实例指针
+ * @param snapshot 输出参数，保存一致性快照
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_wifi_manager_get_snapshot(xn_wifi_manager_t *manager, xn_wifi_snapshot_t *snapshot);
+
+/**
+ * @brief 注册WiFi状态变化回调（在管理器工作任务中调用）
+ * 
+ * 单一回调槽位，保留用于兼容旧接口，新代码请使用xn_wifi_manager_subscribe。
+ * 
  * @param manager 管理器实例指针
  * @param callback 状态变化回调函数
  */
 void xn_wifi_manager_register_status_cb(xn_wifi_manager_t *manager, 
                                          xn_wifi_status_cb_t callback);
 
+/**
+ * @brief 订阅WiFi事件（回调方式）
+ * 
+ * 每个订阅者的回调在自己的投递任务中按事件顺序调用，慢速回调不会延误工作任务和
+ * 其他订阅者；回调积压超过投递队列长度时新事件被丢弃并计数。
+ * 可在回调中取消本订阅；取消订阅返回后回调不会再被调用。
+ * 
+ * @param manager 管理器实例指针
+ * @param callback 事件回调函数
+ * @param user_ctx 用户上下文，原样传给回调
+ * @param event_mask 关注的事件掩码，见XN_WIFI_EVENT_MASK
+ * @param sub_id 输出参数，订阅ID，用于取消订阅，可为NULL
+ * @return ESP_OK成功，ESP_ERR_NO_MEM订阅者表已满或无法创建投递任务，其他值失败
+ */
+esp_err_t xn_wifi_manager_subscribe(xn_wifi_manager_t *manager,
+                                    xn_wifi_event_cb_t callback,
+                                    void *user_ctx,
+                                    uint32_t event_mask,
+                                    int *sub_id);
+
+/**
+ * @brief 订阅WiFi事件（队列方式）
+ * 
+ * 事件以xn_wifi_event_t形式非阻塞投递到队列，队列满时丢弃并计数，
+ * 慢速订阅者不会阻塞其他订阅者。
+ * 
+ * @param manager 管理器实例指针
+ * @param queue 接收事件的队列，元素大小必须为sizeof(xn_wifi_event_t)
+ * @param event_mask 关注的事件掩码，见XN_WIFI_EVENT_MASK
+ * @param sub_id 输出参数，订阅ID，用于取消订阅，可为NULL
+ * @return ESP_OK成功，ESP_ERR_NO_MEM订阅者表已满，其他值失败
+ */
+esp_err_t xn_wifi_manager_subscribe_queue(xn_wifi_manager_t *manager,
+                                          QueueHandle_t queue,
+                                          uint32_t event_mask,
+                                          int *sub_id);
+
+/**
+ * @brief 取消订阅WiFi事件
+ * 
+ * 返回时该槽位已静止：正在进行的回调已返回、正在进行的队列投递已完成，之后不再调用回调
+ * 或向队列投递，可以立即释放user_ctx或删除队列。为此会等待工作任务当前的发布结束，
+ * 不可在持有回调中也会请求的锁时调用；在订阅回调中取消订阅不等待（回调返回后不再访问该槽位）。
+ * 
+ * @param manager 管理器实例指针
+ * @param sub_id 订阅ID
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND该ID未订阅，其他值失败
+ */
+esp_err_t xn_wifi_manager_unsubscribe(xn_wifi_manager_t *manager, int sub_id);
+
+/**
+ * @brief 获取订阅者因队列满而丢弃的事件数
+ * @param manager 管理器实例指针
+ * @param sub_id 订阅ID
+ * @return 丢弃的事件数
+ */
+uint32_t xn_wifi_manager_get_dropped_events(xn_wifi_manager_t *manager, int sub_id);
+
+/**
+ * @brief 获取当前连接的凭据（口令形式，不含驱动中的十六进制PSK）
+ * 
+ * 已连接到纯WPA/WPA2-PSK网络且凭据还没有PMK时，在调用者任务中计算一次PMK
+ * （4096轮PBKDF2，数百毫秒），保存后下次连接即可跳过该计算。
+ * 
+ * @param manager 管理器实例指针
+ * @param cred 输出参数，保存凭据
+ * @return ESP_OK成功，ESP_ERR_INVALID_STATE未连接，其他值失败
+ */
+esp_err_t xn_wifi_manager_get_connected_cred(xn_wifi_manager_t *manager, xn_wifi_cred_t *cred);
+
+/**
+ * @brief 获取工作任务栈的历史最小剩余空间
+ * @param manager 管理器实例指针
+ * @return 剩余字节数，工作任务未运行返回0
+ */
+uint32_t xn_wifi_manager_get_stack_high_water(xn_wifi_manager_t *manager);
+
+/**
+ * @brief 获取当前地址对应的AP和租约
+ * @param manager 管理器实例指针
+ * @param lease 输出参数，保存AP和租约
+ * @param fresh_s 输出参数，距T1的剩余秒数（0表示已过T1或租期未知），可为NULL
+ * @return ESP_OK成功，ESP_ERR_INVALID_STATE未获取IP，其他值失败
+ */
+esp_err_t xn_wifi_manager_get_lease(xn_wifi_manager_t *manager, xn_wifi_lease_t *lease, uint32_t *fresh_s);
+
+/**
+ * @brief 切换功耗/性能档位
+ * 
+ * 可在初始化前调用（初始化时应用），也可运行时切换。省电模式和发射功率立即生效，
+ * 监听间隔、带宽和协议在下次连接时生效。
+ * 
+ * @param manager 管理器实例指针
+ * @param id 档位，XN_WIFI_PROFILE_CUSTOM请使用xn_wifi_manager_set_custom_profile
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_wifi_manager_set_profile(xn_wifi_manager_t *manager, xn_wifi_profile_id_t id);
+
+/**
+ * @brief 使用自定义档位参数
+ * @param manager 管理器实例指针
+ * @param profile 档位参数
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_wifi_manager_set_custom_profile(xn_wifi_manager_t *manager, const xn_wifi_profile_t *profile);
+
+/**
+ * @brief 获取当前档位及实际生效的设置和信号强度
+ * @param manager 管理器实例指针
+ * @param info 输出参数，保存档位状态
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_wifi_manager_get_profile_info(xn_wifi_manager_t *manager, xn_wifi_profile_info_t *info);
+
+/**
+ * @brief 获取漫游统计
+ * @param manager 管理器实例指针
+ * @param stats 输出参数，保存漫游统计
+ * @return ESP_OK成功，ESP_ERR_NOT_SUPPORTED未开启漫游，其他值失败
+ */
+esp_err_t xn_wifi_manager_get_roam_stats(xn_wifi_manager_t *manager, xn_wifi_roam_stats_t *stats);
+
+/**
+ * @brief 获取当前连接的链路质量
+ * @param manager 管理器实例指针
+ * @param info 输出参数，保存链路质量
+ * @return ESP_OK成功，ESP_ERR_NOT_SUPPORTED未开启链路监测，其他值失败
+ */
+esp_err_t xn_wifi_manager_get_link_info(xn_wifi_manager_t *manager, xn_wifi_link_info_t *info);
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,18 +13,41 @@
 #define XN_WIFI_STORAGE_H
 
 #include "esp_err.h"
+#include "xn_wifi_cred.h"
+#include <stdint.h>
 #include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define XN_WIFI_PRIORITY_DEFAULT 128   // 默认用户优先级（0~255，越大越优先）
+
 /* WiFi配置信息结构体 */
 typedef struct {
-    char ssid[32];          // WiFi名称
-    char password[64];      // WiFi密码
+    char ssid[XN_WIFI_SSID_MAX_LEN + 1];            // WiFi名称（原始字节，结尾补'\0'）
+    uint8_t ssid_len;                               // WiFi名称长度（SSID可含'\0'，以此为准）
+    char password[XN_WIFI_PASSWORD_MAX_LEN + 1];    // WiFi密码（结尾补'\0'）
+    uint8_t password_len;                           // WiFi密码长度
+    uint8_t pmk[XN_WIFI_PMK_LEN];                   // 预计算的PMK，SSID或密码变化时作废
+    bool pmk_valid;                                 // PMK是否有效
+    uint32_t last_connected;    // 最近一次连接成功的逻辑时间（单调递增序号，越大越新）
+    uint16_t success_count;     // 连接成功次数
+    uint8_t priority;           // 用户优先级
 } xn_wifi_config_t;
 
+/* WiFi配置存储写入统计 */
+typedef struct {
+    uint32_t save_requests;     // 保存请求次数
+    uint32_t save_skipped;      // 内容未变化而跳过写入的次数
+    uint32_t key_writes;        // 实际写入的NVS键数量
+    uint32_t commits;           // NVS提交次数
+    uint32_t key_derive_us;     // 存储密钥派生耗时（开启加密时，每次启动一次）
+    uint32_t decrypt_us;        // 启动时解密配置列表耗时
+    uint32_t encrypt_count;     // 加密写入次数
+    uint32_t encrypt_us_total;  // 加密写入累计耗时
+} xn_wifi_storage_stats_t;
+
 /**
  * @brief 初始化WiFi存储层
  * @return ESP_OK成功，其他值失败
@@ -40,14 +63,49 @@ esp_err_t xn_wifi_storage_init(void);
 esp_err_t xn_wifi_storage_save(const char *ssid, const char *password);
 
 /**
- * @brief 从NVS加载WiFi配置（加载第一个配置，兼容旧接口）
+ * @brief 按带长度的凭据保存WiFi配置（SSID可含任意字节）
+ * 
+ * cred->pmk_valid为true时一并保存PMK；密码或SSID变化时，未随凭据给出的旧PMK会被清除。
+ * 
+ * @param cred WiFi凭据
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_wifi_storage_save_cred(const xn_wifi_cred_t *cred);
+
+/**
+ * @brief 由存储的配置生成连接凭据（含预计算的PMK）
+ * @param config 存储的配置
+ * @param cred 输出参数，保存连接凭据
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_wifi_config_to_cred(const xn_wifi_config_t *config, xn_wifi_cred_t *cred);
+
+/**
+ * @brief 记录一次连接成功，更新最近连接时间和成功次数
+ * @param ssid WiFi名称（原始字节，可含'\0'）
+ * @param ssid_len SSID长度（1~32）
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND未存储该网络，其他值失败
+ */
+esp_err_t xn_wifi_storage_mark_connected(const uint8_t *ssid, uint8_t ssid_len);
+
+/**
+ * @brief 设置已存储网络的用户优先级
+ * @param ssid WiFi名称（原始字节，可含'\0'）
+ * @param ssid_len SSID长度（1~32）
+ * @param priority 优先级（0~255，越大越优先）
+ * @return ESP_OK成功，ESP_ERR_NOT_FOUND未存储该网络，其他值失败
+ */
+esp_err_t xn_wifi_storage_set_priority(const uint8_t *ssid, uint8_t ssid_len, uint8_t priority);
+
+/**
+ * @brief 从NVS加载WiFi配置（加载最优先的配置，兼容旧接口）
  * @param config 输出参数，保存加载的配置
  * @return ESP_OK成功，其他值失败
  */
 esp_err_t xn_wifi_storage_load(xn_wifi_config_t *config);
 
 /**
- * @brief 从NVS加载所有WiFi配置
+ * @brief 从NVS加载所有WiFi配置，按连接优先顺序排列（优先级 > 最近连接 > 成功次数）
  * @param configs 输出参数，保存加载的配置数组
  * @param count 输出参数，实际加载的配置数量
  * @param max_count 最大加载数量
@@ -57,7 +115,7 @@ esp_err_t xn_wifi_storage_load_all(xn_wifi_config_t *configs, uint8_t *count, ui
 
 /**
  * @brief 删除指定索引的WiFi配置
- * @param index 配置索引（从0开始）
+ * @param index 配置索引（从0开始，与load_all返回的顺序一致）
  * @return ESP_OK成功，其他值失败
  */
 esp_err_t xn_wifi_storage_delete_by_index(uint8_t index);
@@ -74,6 +132,13 @@ esp_err_t xn_wifi_storage_delete(void);
  */
 bool xn_wifi_storage_exists(void);
 
+/**
+ * @brief 获取写入统计（写放大计数）
+ * @param stats 输出参数，保存统计信息
+ * @return ESP_OK成功，其他值失败
+ */
+esp_err_t xn_wifi_storage_get_stats(xn_wifi_storage_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,9 @@
 
 #include "xn_blufi.h"
 #include "xn_blufi_internal.h"
+#include "xn_blufi_proto.h"
+#include "xn_boot_profile.h"
+#include "xn_fast_wake.h"
 #include "xn_wifi_manager.h"
 #include "xn_wifi_storage.h"
 #include "esp_log.h"
@@ -20,15 +23,212 @@
 #include "host/ble_store.h"
 #include "services/gap/ble_svc_gap.h"
 #include "services/gatt/ble_svc_gatt.h"
+#include "esp_coexist.h"
+#include "esp_app_desc.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <string.h>
 
 static const char *TAG = "XN_BLUFI";
 
+#define COEX_BURST_HOLD_MS 300  // 最后一次BLE发送后保持偏向蓝牙的时间
+#define COEX_LOCK_RETRY_MS 10   // 定时器回调中共存调度锁被占用时的重试间隔
+#define CONFIG_LIST_MAX 10      // 配置列表回复的最大条数，与存储层容量一致
+#define BLE_INIT_TASK_STACK_SIZE 4096   // 并行初始化时蓝牙初始化任务栈大小
+#define BLE_INIT_TASK_PRIORITY 5        // 蓝牙初始化任务优先级
+#define HOST_TASK_STACK_SIZE CONFIG_XN_BLUFI_HOST_TASK_STACK_SIZE   // NimBLE主机任务栈大小
+#define HOST_TASK_PRIORITY CONFIG_XN_BLUFI_HOST_TASK_PRIORITY       // NimBLE主机任务优先级
+// NimBLE主机任务运行核心，-1不绑定，单核芯片上统一为0
+#define HOST_TASK_CORE ((CONFIG_XN_BLUFI_HOST_TASK_CORE) < 0 ? tskNO_AFFINITY : \
+                        ((CONFIG_XN_BLUFI_HOST_TASK_CORE) < portNUM_PROCESSORS ? (CONFIG_XN_BLUFI_HOST_TASK_CORE) : 0))
+
+/* 共存调度阶段 */
+typedef enum {
+    COEX_PHASE_WIFI_CONNECT = 0,    // WiFi关联（含DHCP）
+    COEX_PHASE_WIFI_SCAN,           // WiFi扫描
+    COEX_PHASE_BLE_BURST,           // BLE突发发送
+    COEX_PHASE_MAX
+} coex_phase_t;
+
+/* 配置列表回复（含密码和PMK）：较大，不放在NimBLE主机任务栈上，用完清零 */
+typedef struct {
+    xn_wifi_config_t configs[CONFIG_LIST_MAX];
+    uint8_t response[XN_BLUFI_PROTO_MAX_RESPONSE];
+} config_reply_t;
+
+/* BluFi组件实例结构体 */
+struct xn_blufi_s {
+    char device_name[32];                   // 蓝牙设备名称
+    xn_wifi_manager_t *wifi_manager;        // WiFi管理器
+    bool ble_connected;                     // 蓝牙是否已连接
+    xn_wifi_cred_t pending;                 // 待连接的WiFi凭据（带长度）
+    xn_wifi_status_cb_t user_status_cb;     // 应用层状态回调
+    xn_wifi_scan_done_cb_t user_scan_cb;    // 应用层扫描完成回调
+    SemaphoreHandle_t coex_lock;            // 共存调度锁
+    xn_blufi_coex_policy_t coex_policy;     // 共存调度策略
+    esp_coex_prefer_t coex_prefer;          // 当前生效的共存偏好
+    int64_t coex_phase_start[COEX_PHASE_MAX];   // 各阶段开始时间，0表示未激活
+    xn_blufi_coex_stats_t coex_stats;       // 共存调度统计
+    esp_timer_handle_t coex_burst_timer;    // BLE突发阶段结束定时器
+    int64_t boot_connect_start;             // 开机自动连接发起时间，0表示未发起或已完成
+    bool fast_wake;                         // 由快速唤醒路径初始化（未初始化蓝牙和存储层）
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    StaticSemaphore_t coex_lock_buf;        // 共存调度锁存储
+    esp_blufi_ap_record_t scan_list[CONFIG_XN_BLUFI_SCAN_MAX_AP];   // 发送给小程序的AP列表
+    config_reply_t config_reply;            // 配置列表回复缓冲区
+#endif
+};
+
+static xn_blufi_t *g_blufi_instance = NULL;
+static TaskHandle_t s_host_task = NULL;     // NimBLE主机任务
+
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+static xn_blufi_t s_blufi;                  // 静态分配模式下唯一的实例
+static bool s_blufi_in_use = false;
+static StaticTask_t s_host_tcb;             // NimBLE主机任务控制块
+static StackType_t s_host_stack[HOST_TASK_STACK_SIZE];
+#if CONFIG_XN_BLUFI_PARALLEL_INIT
+static StaticTask_t s_ble_init_tcb;         // 并行初始化时蓝牙初始化任务控制块
+static StackType_t s_ble_init_stack[BLE_INIT_TASK_STACK_SIZE];
+#endif
+#endif
+
+/* 获取阶段对应的统计项 */
+static xn_blufi_coex_phase_stats_t *coex_phase_stats(xn_blufi_t *blufi, coex_phase_t phase)
+{
+    switch (phase) {
+        case COEX_PHASE_WIFI_CONNECT:
+            return &blufi->coex_stats.wifi_connect;
+        case COEX_PHASE_WIFI_SCAN:
+            return &blufi->coex_stats.wifi_scan;
+        default:
+            return &blufi->coex_stats.ble_burst;
+    }
+}
+
+/* 根据策略和当前活动阶段计算共存偏好（调用者需持有coex_lock） */
+static esp_coex_prefer_t coex_resolve(xn_blufi_t *blufi)
+{
+    switch (blufi->coex_policy) {
+        case XN_BLUFI_COEX_BALANCE:
+            return ESP_COEX_PREFER_BALANCE;
+        case XN_BLUFI_COEX_PREFER_WIFI:
+            return ESP_COEX_PREFER_WIFI;
+        case XN_BLUFI_COEX_PREFER_BT:
+            return ESP_COEX_PREFER_BT;
+        default:
+            break;
+    }
+    
+    // 关联/扫描对超时敏感，优先级高于BLE突发发送
+    if (blufi->coex_phase_start[COEX_PHASE_WIFI_CONNECT] != 0 ||
+        blufi->coex_phase_start[COEX_PHASE_WIFI_SCAN] != 0) {
+        return ESP_COEX_PREFER_WIFI;
+    }
+    if (blufi->coex_phase_start[COEX_PHASE_BLE_BURST] != 0) {
+        return ESP_COEX_PREFER_BT;
+    }
+    return ESP_COEX_PREFER_BALANCE;
+}
+
+/* 应用共存偏好（调用者需持有coex_lock） */
+static void coex_apply(xn_blufi_t *blufi)
+{
+    esp_coex_prefer_t prefer = coex_resolve(blufi);
+    if (prefer == blufi->coex_prefer) {
+        return;
+    }
+    
+    esp_err_t ret = esp_coex_preference_set(prefer);
+    if (ret == ESP_OK) {
+        blufi->coex_prefer = prefer;
+        blufi->coex_stats.prefer_switches++;
+        ESP_LOGD(TAG, "共存偏好切换为: %d", prefer);
+    } else {
+        ESP_LOGW(TAG, "设置共存偏好失败: %s", esp_err_to_name(ret));
+    }
+}
+
+/* 进入共存阶段 */
+static void coex_phase_begin(xn_blufi_t *blufi, coex_phase_t phase)
+{
+    if (blufi == NULL || blufi->coex_lock == NULL) {
+        return;
+    }
+    
+    xSemaphoreTake(blufi->coex_lock, portMAX_DELAY);
+    if (blufi->coex_phase_start[phase] == 0) {
+        blufi->coex_phase_start[phase] = esp_timer_get_time();
+        coex_apply(blufi);
+    }
+    xSemaphoreGive(blufi->coex_lock);
+}
+
+/* 退出共存阶段并累计耗时（调用者需持有coex_lock） */
+static void coex_phase_end_locked(xn_blufi_t *blufi, coex_phase_t phase)
+{
+    int64_t start = blufi->coex_phase_start[phase];
+    if (start != 0) {
+        uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+        xn_blufi_coex_phase_stats_t *stats = coex_phase_stats(blufi, phase);
+        stats->count++;
+        stats->total_us += elapsed;
+        if (elapsed > stats->max_us) {
+            stats->max_us = elapsed;
+        }
+        blufi->coex_phase_start[phase] = 0;
+        coex_apply(blufi);
+    }
+}
+
+/* 退出共存阶段并累计耗时 */
+static void coex_phase_end(xn_blufi_t *blufi, coex_phase_t phase)
+{
+    if (blufi == NULL || blufi->coex_lock == NULL) {
+        return;
+    }
+    
+    xSemaphoreTake(blufi->coex_lock, portMAX_DELAY);
+    coex_phase_end_locked(blufi, phase);
+    xSemaphoreGive(blufi->coex_lock);
+}
+
+/* BLE突发阶段结束定时器回调（在共用的esp_timer任务中执行，不能无限等锁） */
+static void coex_burst_timer_callback(void *arg)
+{
+    xn_blufi_t *blufi = (xn_blufi_t *)arg;
+    if (xSemaphoreTake(blufi->coex_lock, 0) != pdTRUE) {
+        // 锁被占用时稍后重试；期间又有BLE发送则定时器已被重新启动，这里启动失败无妨
+        esp_timer_start_once(blufi->coex_burst_timer, COEX_LOCK_RETRY_MS * 1000);
+        return;
+    }
+    coex_phase_end_locked(blufi, COEX_PHASE_BLE_BURST);
+    xSemaphoreGive(blufi->coex_lock);
+}
+
+/* 标记一次BLE帧发送：进入蓝牙优先阶段，最后一次发送后延时退出 */
+static void coex_ble_burst(xn_blufi_t *blufi)
+{
+    if (blufi == NULL || blufi->coex_burst_timer == NULL) {
+        return;
+    }
+    
+    coex_phase_begin(blufi, COEX_PHASE_BLE_BURST);
+    esp_timer_stop(blufi->coex_burst_timer);
+    esp_timer_start_once(blufi->coex_burst_timer, COEX_BURST_HOLD_MS * 1000);
+}
+
 /* WiFi扫描完成回调 */
 static void blufi_wifi_scan_callback(uint16_t ap_count, wifi_ap_record_t *ap_list)
 {
     ESP_LOGI(TAG, "WiFi扫描完成，发送%d个AP信息", ap_count);
     
+    coex_ble_burst(g_blufi_instance);
+    
     if (ap_count == 0 || ap_list == NULL) {
         // 发送空列表
         esp_blufi_send_wifi_list(0, NULL);
@@ -36,12 +236,20 @@ static void blufi_wifi_scan_callback(uint16_t ap_count, wifi_ap_record_t *ap_lis
     }
     
     // 转换为 BluFi AP 记录格式
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    // WiFi管理器已按容量截断，扫描回调只在其工作任务中调用
+    esp_blufi_ap_record_t *blufi_ap_list = g_blufi_instance->scan_list;
+    if (ap_count > CONFIG_XN_BLUFI_SCAN_MAX_AP) {
+        ap_count = CONFIG_XN_BLUFI_SCAN_MAX_AP;
+    }
+#else
     esp_blufi_ap_record_t *blufi_ap_list = malloc(sizeof(esp_blufi_ap_record_t) * ap_count);
     if (blufi_ap_list == NULL) {
         ESP_LOGE(TAG, "分配内存失败");
         return;
     }
-    
+#endif
+
     for (int i = 0; i < ap_count; i++) {
         // 复制 SSID，确保不包含结尾的 NULL
         size_t ssid_len = strlen((char*)ap_list[i].ssid);
@@ -53,33 +261,76 @@ static void blufi_wifi_scan_callback(uint16_t ap_count, wifi_ap_record_t *ap_lis
         
         blufi_ap_list[i].rssi = ap_list[i].rssi;
         
-        ESP_LOGI(TAG, "  AP[%d]: SSID=\"%s\" (len=%d), RSSI=%d", 
-                 i, blufi_ap_list[i].ssid, ssid_len, blufi_ap_list[i].rssi);
+        ESP_LOGI(TAG, "  AP[%d]: SSID=\"%s\" (len=%u), RSSI=%d", 
+                 i, blufi_ap_list[i].ssid, (unsigned)ssid_len, blufi_ap_list[i].rssi);
     }
     
     // 发送WiFi列表
     esp_blufi_send_wifi_list(ap_count, blufi_ap_list);
     
+#if !CONFIG_XN_BLUFI_STATIC_ALLOC
     free(blufi_ap_list);
+#endif
 }
 
-/* BluFi组件实例结构体 */
-struct xn_blufi_s {
-    char device_name[32];                   // 蓝牙设备名称
-    xn_wifi_manager_t *wifi_manager;        // WiFi管理器
-    bool ble_connected;                     // 蓝牙是否已连接
-    char pending_ssid[32];                  // 待连接的SSID
-    char pending_password[64];              // 待连接的密码
-};
+/* 更新扫描响应中的设备状态（配网状态、WiFi状态、固件版本、MAC后缀） */
+static void blufi_adv_update(xn_wifi_status_t status)
+{
+    xn_blufi_adv_state_t state = {0};
+    state.provisioned = xn_wifi_storage_exists();
+    state.wifi_status = (uint8_t)status;
+    xn_blufi_proto_parse_version(esp_app_get_description()->version, state.fw_version);
+    
+    uint8_t mac[6];
+    if (esp_read_mac(mac, ESP_MAC_BT) == ESP_OK) {
+        memcpy(state.mac_suffix, &mac[3], sizeof(state.mac_suffix));
+    }
+    
+    uint8_t data[XN_BLUFI_PROTO_ADV_DATA_LEN];
+    size_t len = xn_blufi_proto_build_adv_data(&state, data, sizeof(data));
+    if (len) {
+        xn_blufi_adv_set_mfg_data(data, len);
+    }
+}
 
-static xn_blufi_t *g_blufi_instance = NULL;
+/* WiFi状态事件处理：更新共存阶段后转发给应用层旧式回调 */
+static void blufi_wifi_event_handler(xn_wifi_event_t event, void *user_ctx)
+{
+    xn_blufi_t *blufi = (xn_blufi_t *)user_ctx;
+    
+    if (event == XN_WIFI_EVENT_CONNECTING) {
+        coex_phase_begin(blufi, COEX_PHASE_WIFI_CONNECT);
+    } else if (event == XN_WIFI_EVENT_GOT_IP || event == XN_WIFI_EVENT_DISCONNECTED) {
+        coex_phase_end(blufi, COEX_PHASE_WIFI_CONNECT);
+        // 已连上的网络断开时重新快速广播
+        xn_blufi_adv_on_wifi(event == XN_WIFI_EVENT_GOT_IP);
+    }
+    
+    // 状态类事件与xn_wifi_status_t取值一致
+    blufi_adv_update((xn_wifi_status_t)event);
+    
+    // 开机自动连接成功，启动过程到此结束
+    if (event == XN_WIFI_EVENT_GOT_IP && blufi->boot_connect_start) {
+        xn_boot_profile_record("first_connect", blufi->boot_connect_start);
+        blufi->boot_connect_start = 0;
+        xn_boot_profile_finish();
+    }
+    
+    if (blufi->user_status_cb) {
+        blufi->user_status_cb((xn_wifi_status_t)event);
+    }
+}
 
-/* 获取当前待连接的WiFi配置（内部使用） */
-static void xn_blufi_get_pending_config(xn_blufi_t *blufi, char *ssid, char *password)
+/* WiFi扫描完成处理：结束扫描阶段后转发给调用者 */
+static void blufi_wifi_scan_done_handler(uint16_t ap_count, wifi_ap_record_t *ap_list)
 {
-    if (blufi && ssid && password) {
-        strncpy(ssid, blufi->pending_ssid, 32);
-        strncpy(password, blufi->pending_password, 64);
+    xn_blufi_t *blufi = g_blufi_instance;
+    if (blufi == NULL) return;
+    
+    coex_phase_end(blufi, COEX_PHASE_WIFI_SCAN);
+    
+    if (blufi->user_scan_cb) {
+        blufi->user_scan_cb(ap_count, ap_list);
     }
 }
 
@@ -96,12 +347,134 @@ void xn_blufi_on_sync(void)
     esp_blufi_profile_init();
 }
 
-/* NimBLE主机任务 */
+/* NimBLE主机任务（由组件按任务配置创建，nimble_port_stop()后退出） */
 void xn_blufi_host_task(void *param)
 {
-    ESP_LOGI(TAG, "NimBLE主机任务启动");
+    ESP_LOGI(TAG, "NimBLE主机任务启动，核心%d", xPortGetCoreID());
     nimble_port_run();
-    nimble_port_freertos_deinit();
+    s_host_task = NULL;
+    vTaskDelete(NULL);
+}
+
+/* 发送所有存储的WiFi配置，回复缓冲区中的密码和PMK发送后立即清除 */
+static void blufi_send_config_list(xn_blufi_t *blufi)
+{
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    // 自定义数据只在NimBLE主机任务中处理，不会并发使用
+    config_reply_t *reply = &blufi->config_reply;
+#else
+    config_reply_t *reply = malloc(sizeof(config_reply_t));
+    if (reply == NULL) {
+        ESP_LOGE(TAG, "分配内存失败");
+        uint8_t empty[3];
+        size_t empty_len = xn_blufi_proto_build_config_list(NULL, 0, empty, sizeof(empty));
+        coex_ble_burst(blufi);
+        esp_blufi_send_custom_data(empty, empty_len);
+        return;
+    }
+#endif
+    
+    // 读取所有存储的配置
+    uint8_t count = 0;
+    if (xn_wifi_storage_load_all(reply->configs, &count, CONFIG_LIST_MAX) != ESP_OK) {
+        count = 0;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "  [%d] %s", i, reply->configs[i].ssid);
+    }
+    
+    size_t response_len = xn_blufi_proto_build_config_list(reply->configs, count,
+                                                           reply->response, sizeof(reply->response));
+    if (response_len == 0) {
+        ESP_LOGE(TAG, "配置列表超出回复缓冲区");
+        response_len = xn_blufi_proto_build_config_list(NULL, 0, reply->response, sizeof(reply->response));
+    }
+    if (count > 0) {
+        ESP_LOGI(TAG, "发送%d个存储的WiFi配置", count);
+    } else {
+        ESP_LOGI(TAG, "未找到存储的WiFi配置");
+    }
+    
+    // 发送自定义数据响应（协议栈复制数据后返回）
+    coex_ble_burst(blufi);
+    esp_blufi_send_custom_data(reply->response, response_len);
+    
+    memset(reply, 0, sizeof(config_reply_t));
+#if !CONFIG_XN_BLUFI_STATIC_ALLOC
+    free(reply);
+#endif
+}
+
+/* 处理小程序发来的自定义数据命令 */
+static void blufi_handle_custom_data(xn_blufi_t *blufi, const uint8_t *data, uint32_t len)
+{
+    xn_blufi_cmd_t cmd;
+    esp_err_t parse_ret = xn_blufi_proto_parse(data, len, &cmd);
+    if (parse_ret != ESP_OK) {
+        ESP_LOGW(TAG, "忽略无效的自定义数据（长度%lu）: %s", (unsigned long)len, esp_err_to_name(parse_ret));
+        return;
+    }
+    
+    switch (cmd.type) {
+        case XN_BLUFI_CMD_GET_CONFIGS:
+            ESP_LOGI(TAG, "请求获取所有存储的WiFi配置");
+            blufi_send_config_list(blufi);
+            break;
+        
+        case XN_BLUFI_CMD_GET_STATUS: {
+            // 从管理器的状态快照组装，不查询驱动，一帧回复
+            xn_wifi_snapshot_t snapshot;
+            xn_blufi_status_report_t report = {0};
+            if (blufi->wifi_manager && xn_wifi_manager_get_snapshot(blufi->wifi_manager, &snapshot) == ESP_OK) {
+                report.wifi_status = (uint8_t)snapshot.status;
+                report.rssi = snapshot.rssi;
+                report.channel = snapshot.channel;
+                report.authmode = (uint8_t)snapshot.authmode;
+                memcpy(report.bssid, snapshot.bssid, sizeof(report.bssid));
+                report.ip = snapshot.ip;
+                report.gw = snapshot.gw;
+                if (snapshot.connected_at) {
+                    report.uptime_s = (uint32_t)((esp_timer_get_time() - snapshot.connected_at) / 1000000);
+                }
+                report.reconnect_count = snapshot.reconnect_count;
+            }
+            
+            uint8_t response[XN_BLUFI_PROTO_STATUS_REPORT_LEN];
+            size_t response_len = xn_blufi_proto_build_status_report(&report, response, sizeof(response));
+            ESP_LOGI(TAG, "发送扩展连接状态，状态: %d", report.wifi_status);
+            
+            // 发送自定义数据响应
+            coex_ble_burst(blufi);
+            esp_blufi_send_custom_data(response, response_len);
+            break;
+        }
+        
+        case XN_BLUFI_CMD_DELETE_CONFIG: {
+            ESP_LOGI(TAG, "请求删除WiFi配置，索引: %d", cmd.index);
+            
+            esp_err_t ret = xn_wifi_storage_delete_by_index(cmd.index);
+            blufi_adv_update(xn_wifi_manager_get_status(blufi->wifi_manager));
+            
+            uint8_t response[2];
+            size_t response_len = xn_blufi_proto_build_status(XN_BLUFI_CMD_DELETE_CONFIG,
+                                                              ret == ESP_OK ? XN_BLUFI_STATUS_OK : XN_BLUFI_STATUS_FAIL,
+                                                              response, sizeof(response));
+            
+            // 发送自定义数据响应
+            esp_blufi_send_custom_data(response, response_len);
+            
+            if (ret == ESP_OK) {
+                ESP_LOGI(TAG, "WiFi配置已删除，索引: %d", cmd.index);
+            } else {
+                ESP_LOGE(TAG, "删除WiFi配置失败");
+            }
+            break;
+        }
+        
+        default:
+            break;
+    }
 }
 
 /* BluFi事件回调函数 */
@@ -116,7 +489,7 @@ static void blufi_event_callback(esp_blufi_cb_event_t event, esp_blufi_cb_param_
     switch (event) {
         case ESP_BLUFI_EVENT_INIT_FINISH:
             ESP_LOGI(TAG, "BluFi初始化完成");
-            esp_blufi_adv_start();
+            xn_blufi_adv_start_fast();
             break;
             
         case ESP_BLUFI_EVENT_DEINIT_FINISH:
@@ -126,34 +499,49 @@ static void blufi_event_callback(esp_blufi_cb_event_t event, esp_blufi_cb_param_
         case ESP_BLUFI_EVENT_BLE_CONNECT:
             ESP_LOGI(TAG, "蓝牙已连接");
             blufi->ble_connected = true;
-            esp_blufi_adv_stop();
+            xn_blufi_adv_on_ble(true);
+#if CONFIG_XN_BLUFI_SECURITY
+            xn_blufi_security_init();
+#endif
             break;
             
         case ESP_BLUFI_EVENT_BLE_DISCONNECT:
             ESP_LOGI(TAG, "蓝牙断开连接");
             blufi->ble_connected = false;
-            esp_blufi_adv_start();
+#if CONFIG_XN_BLUFI_SECURITY
+            xn_blufi_security_deinit();
+#endif
+            xn_blufi_adv_on_ble(false);
             break;
             
         case ESP_BLUFI_EVENT_RECV_STA_SSID:
-            strncpy(blufi->pending_ssid, (char*)param->sta_ssid.ssid, 
-                   param->sta_ssid.ssid_len);
-            blufi->pending_ssid[param->sta_ssid.ssid_len] = '\0';
-            ESP_LOGI(TAG, "接收到SSID: %s", blufi->pending_ssid);
+            // 长度由对端决定，超长直接拒绝，不截断成另一个SSID
+            if (xn_blufi_proto_copy_field(blufi->pending.ssid, sizeof(blufi->pending.ssid),
+                                          param->sta_ssid.ssid, param->sta_ssid.ssid_len) != ESP_OK) {
+                ESP_LOGW(TAG, "SSID长度非法: %d", param->sta_ssid.ssid_len);
+                blufi->pending.ssid_len = 0;
+                esp_blufi_send_error_info(ESP_BLUFI_DATA_FORMAT_ERROR);
+                break;
+            }
+            blufi->pending.ssid_len = param->sta_ssid.ssid_len;
+            ESP_LOGI(TAG, "接收到SSID: %.*s", blufi->pending.ssid_len, (const char *)blufi->pending.ssid);
             break;
             
         case ESP_BLUFI_EVENT_RECV_STA_PASSWD:
-            strncpy(blufi->pending_password, (char*)param->sta_passwd.passwd,
-                   param->sta_passwd.passwd_len);
-            blufi->pending_password[param->sta_passwd.passwd_len] = '\0';
+            if (xn_blufi_proto_copy_field(blufi->pending.password, sizeof(blufi->pending.password),
+                                          param->sta_passwd.passwd, param->sta_passwd.passwd_len) != ESP_OK) {
+                ESP_LOGW(TAG, "密码长度非法: %d", param->sta_passwd.passwd_len);
+                blufi->pending.password_len = 0;
+                esp_blufi_send_error_info(ESP_BLUFI_DATA_FORMAT_ERROR);
+                break;
+            }
+            blufi->pending.password_len = param->sta_passwd.passwd_len;
             ESP_LOGI(TAG, "接收到密码");
             break;
             
         case ESP_BLUFI_EVENT_REQ_CONNECT_TO_AP:
             ESP_LOGI(TAG, "请求连接WiFi");
-            xn_wifi_manager_connect(blufi->wifi_manager, 
-                                   blufi->pending_ssid, 
-                                   blufi->pending_password);
+            xn_wifi_manager_connect_cred(blufi->wifi_manager, &blufi->pending);
             break;
             
         case ESP_BLUFI_EVENT_REQ_DISCONNECT_FROM_AP:
@@ -173,10 +561,11 @@ static void blufi_event_callback(esp_blufi_cb_event_t event, esp_blufi_cb_param_
                 wifi_config_t wifi_config;
                 if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config) == ESP_OK) {
                     // 设置SSID
-                    info.sta_ssid_len = strlen((char*)wifi_config.sta.ssid);
+                    // 32字节SSID不以'\0'结尾
+                    info.sta_ssid_len = strnlen((char*)wifi_config.sta.ssid, sizeof(wifi_config.sta.ssid));
                     info.sta_ssid = wifi_config.sta.ssid;
                     
-                    ESP_LOGI(TAG, "当前连接的WiFi: %s", wifi_config.sta.ssid);
+                    ESP_LOGI(TAG, "当前连接的WiFi: %.*s", info.sta_ssid_len, (char*)wifi_config.sta.ssid);
                 }
                 esp_blufi_send_wifi_conn_report(mode, ESP_BLUFI_STA_CONN_SUCCESS, 0, &info);
             } else if (status == XN_WIFI_CONNECTING) {
@@ -195,82 +584,11 @@ static void blufi_event_callback(esp_blufi_cb_event_t event, esp_blufi_cb_param_
             break;
         }
         
-        case ESP_BLUFI_EVENT_RECV_CUSTOM_DATA: {
+        case ESP_BLUFI_EVENT_RECV_CUSTOM_DATA:
             ESP_LOGI(TAG, "收到自定义数据请求");
-            
-            if (param->custom_data.data_len > 0) {
-                uint8_t cmd_type = param->custom_data.data[0];
-                
-                // 类型 0x01: 请求获取存储的WiFi配置（所有）
-                if (cmd_type == 0x01) {
-                    ESP_LOGI(TAG, "请求获取所有存储的WiFi配置");
-                    
-                    // 读取所有存储的配置
-                    xn_wifi_config_t configs[10];
-                    uint8_t count = 0;
-                    esp_err_t ret = xn_wifi_storage_load_all(configs, &count, 10);
-                    
-                    // 构建响应数据：[类型(1字节), 状态(1字节), 数量(1字节), [SSID长度, SSID, 密码长度, 密码]...]
-                    uint8_t response[512];
-                    int offset = 0;
-                    
-                    response[offset++] = 0x01;  // 类型：存储的WiFi配置
-                    
-                    if (ret == ESP_OK && count > 0) {
-                        response[offset++] = 0x00;  // 状态：成功
-                        response[offset++] = count;  // 配置数量
-                        
-                        for (int i = 0; i < count; i++) {
-                            // SSID
-                            uint8_t ssid_len = strlen(configs[i].ssid);
-                            response[offset++] = ssid_len;
-                            memcpy(&response[offset], configs[i].ssid, ssid_len);
-                            offset += ssid_len;
-                            
-                            // 密码
-                            uint8_t pwd_len = strlen(configs[i].password);
-                            response[offset++] = pwd_len;
-                            memcpy(&response[offset], configs[i].password, pwd_len);
-                            offset += pwd_len;
-                            
-                            ESP_LOGI(TAG, "  [%d] %s", i, configs[i].ssid);
-                        }
-                        
-                        ESP_LOGI(TAG, "发送%d个存储的WiFi配置", count);
-                    } else {
-                        response[offset++] = 0x01;  // 状态：未找到
-                        response[offset++] = 0;     // 数量：0
-                        ESP_LOGI(TAG, "未找到存储的WiFi配置");
-                    }
-                    
-                    // 发送自定义数据响应
-                    esp_blufi_send_custom_data(response, offset);
-                }
-                // 类型 0x02: 请求删除指定索引的WiFi配置
-                else if (cmd_type == 0x02 && param->custom_data.data_len >= 2) {
-                    uint8_t index = param->custom_data.data[1];
-                    ESP_LOGI(TAG, "请求删除WiFi配置，索引: %d", index);
-                    
-                    esp_err_t ret = xn_wifi_storage_delete_by_index(index);
-                    
-                    // 构建响应数据：[类型(1字节), 状态(1字节)]
-                    uint8_t response[2];
-                    response[0] = 0x02;  // 类型：删除配置
-                    response[1] = (ret == ESP_OK) ? 0x00 : 0x01;  // 状态
-                    
-                    // 发送自定义数据响应
-                    esp_blufi_send_custom_data(response, 2);
-                    
-                    if (ret == ESP_OK) {
-                        ESP_LOGI(TAG, "WiFi配置已删除，索引: %d", index);
-                    } else {
-                        ESP_LOGE(TAG, "删除WiFi配置失败");
-                    }
-                }
-            }
+            blufi_handle_custom_data(blufi, param->custom_data.data, param->custom_data.data_len);
             break;
-        }
-        
+            
         default:
             break;
     }
@@ -279,29 +597,73 @@ static void blufi_event_callback(esp_blufi_cb_event_t event, esp_blufi_cb_param_
 /* BluFi回调函数结构体 */
 static esp_blufi_callbacks_t blufi_callbacks = {
     .event_cb = blufi_event_callback,
+#if CONFIG_XN_BLUFI_SECURITY
+    .negotiate_data_handler = xn_blufi_security_negotiate,
+    .encrypt_func = xn_blufi_security_encrypt,
+    .decrypt_func = xn_blufi_security_decrypt,
+    .checksum_func = xn_blufi_security_checksum,
+#else
     .negotiate_data_handler = NULL,
     .encrypt_func = NULL,
     .decrypt_func = NULL,
     .checksum_func = NULL,
+#endif
 };
 
 /* 创建BluFi实例 */
 xn_blufi_t* xn_blufi_create(const char *device_name)
 {
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    if (s_blufi_in_use) {
+        ESP_LOGE(TAG, "静态分配模式下只支持一个实例");
+        return NULL;
+    }
+    s_blufi_in_use = true;
+    xn_blufi_t *blufi = &s_blufi;
+#else
     xn_blufi_t *blufi = malloc(sizeof(xn_blufi_t));
     if (blufi == NULL) {
         ESP_LOGE(TAG, "分配内存失败");
         return NULL;
     }
-    
+#endif
+
     memset(blufi, 0, sizeof(xn_blufi_t));
     strncpy(blufi->device_name, device_name, sizeof(blufi->device_name) - 1);
+    blufi->coex_policy = XN_BLUFI_COEX_AUTO;
+    blufi->coex_prefer = ESP_COEX_PREFER_BALANCE;
+    
+    // 创建共存调度锁和BLE突发定时器
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    blufi->coex_lock = xSemaphoreCreateMutexStatic(&blufi->coex_lock_buf);
+#else
+    blufi->coex_lock = xSemaphoreCreateMutex();
+#endif
+    const esp_timer_create_args_t timer_args = {
+        .callback = coex_burst_timer_callback,
+        .arg = blufi,
+        .name = "xn_coex_burst",
+    };
+    if (blufi->coex_lock == NULL ||
+        esp_timer_create(&timer_args, &blufi->coex_burst_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "创建共存调度资源失败");
+        xn_blufi_destroy(blufi);
+        return NULL;
+    }
     
     // 创建WiFi管理器
     blufi->wifi_manager = xn_wifi_manager_create();
     if (blufi->wifi_manager == NULL) {
         ESP_LOGE(TAG, "创建WiFi管理器失败");
-        free(blufi);
+        xn_blufi_destroy(blufi);
+        return NULL;
+    }
+    
+    // 订阅状态事件，用于共存调度，再转发给应用层
+    if (xn_wifi_manager_subscribe(blufi->wifi_manager, blufi_wifi_event_handler, blufi,
+                                  XN_WIFI_EVENT_MASK_STATUS, NULL) != ESP_OK) {
+        ESP_LOGE(TAG, "订阅WiFi事件失败");
+        xn_blufi_destroy(blufi);
         return NULL;
     }
     
@@ -316,36 +678,29 @@ void xn_blufi_destroy(xn_blufi_t *blufi)
         if (blufi->wifi_manager) {
             xn_wifi_manager_destroy(blufi->wifi_manager);
         }
+        if (blufi->coex_burst_timer) {
+            esp_timer_stop(blufi->coex_burst_timer);
+            esp_timer_delete(blufi->coex_burst_timer);
+        }
+        if (blufi->coex_lock) {
+            vSemaphoreDelete(blufi->coex_lock);
+        }
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+        s_blufi_in_use = false;
+#else
         free(blufi);
+#endif
         ESP_LOGI(TAG, "BluFi实例已销毁");
     }
 }
 
-/* 初始化BluFi */
-esp_err_t xn_blufi_init(xn_blufi_t *blufi)
+/* 蓝牙控制器、NimBLE、GATT和BluFi回调初始化 */
+static esp_err_t blufi_ble_init(xn_blufi_t *blufi)
 {
-    if (blufi == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    g_blufi_instance = blufi;
     esp_err_t ret;
     
-    // 初始化存储层
-    ret = xn_wifi_storage_init();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "初始化存储层失败");
-        return ret;
-    }
-    
-    // 初始化WiFi管理器
-    ret = xn_wifi_manager_init(blufi->wifi_manager);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "初始化WiFi管理器失败");
-        return ret;
-    }
-    
     // 释放蓝牙控制器内存给经典蓝牙
+    int64_t stage_start = esp_timer_get_time();
     ESP_ERROR_CHECK(esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT));
     
     // 初始化蓝牙控制器
@@ -362,13 +717,16 @@ esp_err_t xn_blufi_init(xn_blufi_t *blufi)
         ESP_LOGE(TAG, "启用蓝牙控制器失败: %s", esp_err_to_name(ret));
         return ret;
     }
+    xn_boot_profile_record("bt_controller", stage_start);
     
     // 初始化NimBLE协议栈
+    stage_start = esp_timer_get_time();
     ret = esp_nimble_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "初始化NimBLE失败: %s", esp_err_to_name(ret));
         return ret;
     }
+    xn_boot_profile_record("nimble_init", stage_start);
     
     // 配置NimBLE主机
     ble_hs_cfg.reset_cb = xn_blufi_on_reset;
@@ -377,6 +735,7 @@ esp_err_t xn_blufi_init(xn_blufi_t *blufi)
     ble_hs_cfg.store_status_cb = ble_store_util_status_rr;
     
     // 初始化GATT服务器
+    stage_start = esp_timer_get_time();
     ret = esp_blufi_gatt_svr_init();
     if (ret != 0) {
         ESP_LOGE(TAG, "初始化GATT服务器失败");
@@ -399,11 +758,168 @@ esp_err_t xn_blufi_init(xn_blufi_t *blufi)
         ESP_LOGE(TAG, "注册BluFi回调失败: %s", esp_err_to_name(ret));
         return ret;
     }
+    xn_boot_profile_record("gatt_blufi_register", stage_start);
     
-    // 启动NimBLE主机任务
-    ret = esp_nimble_enable(xn_blufi_host_task);
-    if (ret) {
-        ESP_LOGE(TAG, "启动NimBLE失败: %s", esp_err_to_name(ret));
+    ret = xn_blufi_adv_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    blufi_adv_update(XN_WIFI_DISCONNECTED);
+    
+    // 启动NimBLE主机任务（代替esp_nimble_enable，以便指定核心、优先级和栈大小）
+    stage_start = esp_timer_get_time();
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    s_host_task = xTaskCreateStaticPinnedToCore(xn_blufi_host_task, "nimble_host", HOST_TASK_STACK_SIZE,
+                                                NULL, HOST_TASK_PRIORITY, s_host_stack, &s_host_tcb,
+                                                HOST_TASK_CORE);
+    if (s_host_task == NULL) {
+#else
+    if (xTaskCreatePinnedToCore(xn_blufi_host_task, "nimble_host", HOST_TASK_STACK_SIZE,
+                                NULL, HOST_TASK_PRIORITY, &s_host_task,
+                                HOST_TASK_CORE) != pdPASS) {
+#endif
+        ESP_LOGE(TAG, "启动NimBLE主机任务失败");
+        s_host_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    xn_boot_profile_record("nimble_enable", stage_start);
+    
+    return ESP_OK;
+}
+
+#if CONFIG_XN_BLUFI_PARALLEL_INIT
+/* 蓝牙初始化任务参数 */
+typedef struct {
+    xn_blufi_t *blufi;
+    esp_err_t ret;              // 初始化结果
+    SemaphoreHandle_t done;     // 完成信号（汇合点）
+} blufi_ble_init_ctx_t;
+
+/* 蓝牙初始化任务：与WiFi初始化并行执行，完成后通知调用者并退出 */
+static void blufi_ble_init_task(void *arg)
+{
+    blufi_ble_init_ctx_t *ctx = (blufi_ble_init_ctx_t *)arg;
+    int64_t stage_start = esp_timer_get_time();
+    
+    ctx->ret = blufi_ble_init(ctx->blufi);
+    xn_boot_profile_record("ble_init_total", stage_start);
+    
+    // 给出信号后ctx随调用者栈失效，不能再访问
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+#endif
+
+/* 自动连接最优先的已保存网络（WiFi就绪后立即发起，不等待蓝牙） */
+static void blufi_auto_connect(xn_blufi_t *blufi)
+{
+#if CONFIG_XN_BLUFI_AUTO_CONNECT
+    xn_wifi_config_t config;
+    if (xn_wifi_storage_load(&config) != ESP_OK) {
+        return;
+    }
+    
+    xn_wifi_cred_t cred;
+    xn_wifi_config_to_cred(&config, &cred);
+    memset(&config, 0, sizeof(config));
+    
+    ESP_LOGI(TAG, "自动连接已保存的网络: %.*s", cred.ssid_len, (const char *)cred.ssid);
+    blufi->boot_connect_start = esp_timer_get_time();
+    if (xn_wifi_manager_connect_cred(blufi->wifi_manager, &cred) != ESP_OK) {
+        blufi->boot_connect_start = 0;
+        xn_boot_profile_finish();
+    }
+    memset(&cred, 0, sizeof(cred));
+#endif
+}
+
+/* 初始化BluFi */
+esp_err_t xn_blufi_init(xn_blufi_t *blufi)
+{
+    if (blufi == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    g_blufi_instance = blufi;
+    esp_err_t ret;
+    bool wifi_ready = false;
+    
+    // 初始化存储层（NVS需要在WiFi和蓝牙之前就绪）
+    ret = xn_wifi_storage_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "初始化存储层失败");
+        return ret;
+    }
+    
+#if CONFIG_XN_BLUFI_PARALLEL_INIT
+    // 蓝牙初始化放到另一个核心的任务中，与WiFi初始化并行
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    StaticSemaphore_t done_buf;
+#endif
+    blufi_ble_init_ctx_t ble_ctx = {
+        .blufi = blufi,
+        .ret = ESP_FAIL,
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+        .done = xSemaphoreCreateBinaryStatic(&done_buf),
+#else
+        .done = xSemaphoreCreateBinary(),
+#endif
+    };
+    bool ble_task_created = false;
+    if (ble_ctx.done != NULL) {
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+        ble_task_created = xTaskCreateStaticPinnedToCore(blufi_ble_init_task, "xn_ble_init",
+                                                         BLE_INIT_TASK_STACK_SIZE, &ble_ctx,
+                                                         BLE_INIT_TASK_PRIORITY, s_ble_init_stack,
+                                                         &s_ble_init_tcb,
+                                                         portNUM_PROCESSORS > 1 ? 1 : 0) != NULL;
+#else
+        ble_task_created = xTaskCreatePinnedToCore(blufi_ble_init_task, "xn_ble_init",
+                                                   BLE_INIT_TASK_STACK_SIZE, &ble_ctx,
+                                                   BLE_INIT_TASK_PRIORITY, NULL,
+                                                   portNUM_PROCESSORS > 1 ? 1 : 0) == pdPASS;
+#endif
+    }
+    if (!ble_task_created) {
+        ESP_LOGE(TAG, "创建蓝牙初始化任务失败");
+        if (ble_ctx.done) {
+            vSemaphoreDelete(ble_ctx.done);
+        }
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+
+    // 初始化WiFi管理器，就绪后立即连接已保存的网络
+    ret = xn_wifi_manager_init(blufi->wifi_manager);
+    if (ret == ESP_OK) {
+        blufi_auto_connect(blufi);
+    } else {
+        ESP_LOGE(TAG, "初始化WiFi管理器失败");
+    }
+    
+#if CONFIG_XN_BLUFI_PARALLEL_INIT
+    // 汇合：无论WiFi是否成功，都要等蓝牙任务结束，避免其访问已失效的参数
+    int64_t stage_start = esp_timer_get_time();
+    xSemaphoreTake(ble_ctx.done, portMAX_DELAY);
+    vSemaphoreDelete(ble_ctx.done);
+    xn_boot_profile_record("ble_join_wait", stage_start);
+    if (ret == ESP_OK) {
+        ret = ble_ctx.ret;
+        wifi_ready = true;
+    }
+#else
+    if (ret == ESP_OK) {
+        wifi_ready = true;
+        ret = blufi_ble_init(blufi);
+    }
+#endif
+    if (ret != ESP_OK) {
+        // WiFi已就绪而蓝牙失败：自动连接已经发起，停止WiFi，不留下无法配网的后台连接
+        if (wifi_ready) {
+            ESP_LOGE(TAG, "蓝牙初始化失败，停止WiFi: %s", esp_err_to_name(ret));
+            xn_wifi_manager_deinit(blufi->wifi_manager);
+            blufi->boot_connect_start = 0;
+        }
         return ret;
     }
     
@@ -411,6 +927,76 @@ esp_err_t xn_blufi_init(xn_blufi_t *blufi)
     return ESP_OK;
 }
 
+/* 快速唤醒初始化：只初始化NVS和WiFi，用RTC内存中的状态直接重连 */
+esp_err_t xn_blufi_init_fast_wake(xn_blufi_t *blufi)
+{
+    if (blufi == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xn_fast_wake_state_t state;
+    esp_err_t ret = xn_fast_wake_load(&state);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // WiFi驱动本身要用NVS（PHY校准数据等），这里只初始化NVS，不读取配置列表
+    int64_t stage_start = esp_timer_get_time();
+    ret = nvs_flash_init();
+    xn_boot_profile_record("nvs_init", stage_start);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "快速唤醒初始化NVS失败: %s", esp_err_to_name(ret));
+        memset(&state, 0, sizeof(state));
+        return ret;
+    }
+    
+    g_blufi_instance = blufi;
+    blufi->fast_wake = true;
+    ret = xn_wifi_manager_init(blufi->wifi_manager);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "快速唤醒，直接重连: %.*s（租约剩余%lu s）", state.cred.ssid_len,
+                 (const char *)state.cred.ssid, (unsigned long)state.fresh_s);
+        blufi->boot_connect_start = esp_timer_get_time();
+        ret = xn_wifi_manager_connect_lease(blufi->wifi_manager, &state.cred, &state.lease, state.fresh_s);
+        if (ret != ESP_OK) {
+            blufi->boot_connect_start = 0;
+        }
+    }
+    memset(&state, 0, sizeof(state));
+    return ret;
+}
+
+/* 保存快速唤醒状态（进入深度睡眠前调用） */
+esp_err_t xn_blufi_fast_wake_save(xn_blufi_t *blufi)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xn_fast_wake_state_t state = {0};
+    esp_err_t ret = xn_wifi_manager_get_connected_cred(blufi->wifi_manager, &state.cred);
+    if (ret == ESP_OK) {
+        ret = xn_wifi_manager_get_lease(blufi->wifi_manager, &state.lease, &state.fresh_s);
+    }
+    if (ret == ESP_OK) {
+        ret = xn_fast_wake_save(&state);
+    }
+    memset(&state, 0, sizeof(state));
+    return ret;
+}
+
+/* 清除快速唤醒状态 */
+void xn_blufi_fast_wake_clear(void)
+{
+    xn_fast_wake_clear();
+}
+
+/* 是否由快速唤醒路径初始化 */
+bool xn_blufi_is_fast_wake(xn_blufi_t *blufi)
+{
+    return blufi && blufi->fast_wake;
+}
+
 /* 反初始化BluFi */
 esp_err_t xn_blufi_deinit(xn_blufi_t *blufi)
 {
@@ -418,6 +1004,17 @@ esp_err_t xn_blufi_deinit(xn_blufi_t *blufi)
         return ESP_ERR_INVALID_ARG;
     }
     
+    if (blufi->fast_wake) {
+        // 快速唤醒路径没有初始化蓝牙
+        xn_wifi_manager_deinit(blufi->wifi_manager);
+        blufi->fast_wake = false;
+        g_blufi_instance = NULL;
+        return ESP_OK;
+    }
+    
+    // 停止广播
+    xn_blufi_adv_deinit();
+    
     // 反初始化GATT服务器
     esp_blufi_gatt_svr_deinit();
     
@@ -455,6 +1052,24 @@ esp_err_t xn_blufi_wifi_connect(xn_blufi_t *blufi, const char *ssid, const char
     return xn_wifi_manager_connect(blufi->wifi_manager, ssid, password);
 }
 
+/* 按带长度凭据连接WiFi - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_connect_cred(xn_blufi_t *blufi, const xn_wifi_cred_t *cred)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_connect_cred(blufi->wifi_manager, cred);
+}
+
+/* 获取当前连接的凭据 - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_get_connected_cred(xn_blufi_t *blufi, xn_wifi_cred_t *cred)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_get_connected_cred(blufi->wifi_manager, cred);
+}
+
 /* 断开WiFi - 委托给WiFi管理器 */
 esp_err_t xn_blufi_wifi_disconnect(xn_blufi_t *blufi)
 {
@@ -470,7 +1085,39 @@ esp_err_t xn_blufi_wifi_save(xn_blufi_t *blufi, const char *ssid, const char *pa
     if (blufi == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    return xn_wifi_storage_save(ssid, password);
+    esp_err_t ret = xn_wifi_storage_save(ssid, password);
+    blufi_adv_update(xn_wifi_manager_get_status(blufi->wifi_manager));
+    return ret;
+}
+
+/* 按带长度凭据保存WiFi配置 - 委托给存储层 */
+esp_err_t xn_blufi_wifi_save_cred(xn_blufi_t *blufi, const xn_wifi_cred_t *cred)
+{
+    if (blufi == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = xn_wifi_storage_save_cred(cred);
+    blufi_adv_update(xn_wifi_manager_get_status(blufi->wifi_manager));
+    return ret;
+}
+
+/* 记录连接成功 - 委托给存储层 */
+esp_err_t xn_blufi_wifi_mark_connected(xn_blufi_t *blufi, const uint8_t *ssid, uint8_t ssid_len)
+{
+    if (blufi == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_storage_mark_connected(ssid, ssid_len);
+}
+
+/* 设置网络优先级 - 委托给存储层 */
+esp_err_t xn_blufi_wifi_set_priority(xn_blufi_t *blufi, const uint8_t *ssid, uint8_t ssid_len,
+                                     uint8_t priority)
+{
+    if (blufi == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_storage_set_priority(ssid, ssid_len, priority);
 }
 
 /* 删除WiFi配置 - 委托给存储层 */
@@ -479,7 +1126,10 @@ esp_err_t xn_blufi_wifi_delete(xn_blufi_t *blufi)
     if (blufi == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    return xn_wifi_storage_delete();
+    xn_fast_wake_clear();   // 配置已删除，不能再从RTC内存重连
+    esp_err_t ret = xn_wifi_storage_delete();
+    blufi_adv_update(xn_wifi_manager_get_status(blufi->wifi_manager));
+    return ret;
 }
 
 /* 加载WiFi配置 - 委托给存储层 */
@@ -497,7 +1147,15 @@ esp_err_t xn_blufi_wifi_scan(xn_blufi_t *blufi, xn_wifi_scan_done_cb_t callback)
     if (blufi == NULL || blufi->wifi_manager == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    return xn_wifi_manager_scan(blufi->wifi_manager, callback);
+    
+    blufi->user_scan_cb = callback;
+    coex_phase_begin(blufi, COEX_PHASE_WIFI_SCAN);
+    
+    esp_err_t ret = xn_wifi_manager_scan(blufi->wifi_manager, blufi_wifi_scan_done_handler);
+    if (ret != ESP_OK) {
+        coex_phase_end(blufi, COEX_PHASE_WIFI_SCAN);
+    }
+    return ret;
 }
 
 /* 获取WiFi状态 - 委托给WiFi管理器 */
@@ -509,14 +1167,115 @@ xn_wifi_status_t xn_blufi_wifi_get_status(xn_blufi_t *blufi)
     return xn_wifi_manager_get_status(blufi->wifi_manager);
 }
 
-/* 注册状态回调 - 委托给WiFi管理器 */
+/* 获取WiFi状态快照 - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_get_snapshot(xn_blufi_t *blufi, xn_wifi_snapshot_t *snapshot)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_get_snapshot(blufi->wifi_manager, snapshot);
+}
+
+/* 切换WiFi档位 - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_set_profile(xn_blufi_t *blufi, xn_wifi_profile_id_t id)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_set_profile(blufi->wifi_manager, id);
+}
+
+/* 自定义WiFi档位 - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_set_custom_profile(xn_blufi_t *blufi, const xn_wifi_profile_t *profile)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_set_custom_profile(blufi->wifi_manager, profile);
+}
+
+/* 获取WiFi档位状态 - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_get_profile_info(xn_blufi_t *blufi, xn_wifi_profile_info_t *info)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_get_profile_info(blufi->wifi_manager, info);
+}
+
+/* 获取WiFi漫游统计 - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_get_roam_stats(xn_blufi_t *blufi, xn_wifi_roam_stats_t *stats)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_get_roam_stats(blufi->wifi_manager, stats);
+}
+
+/* 获取WiFi链路质量 - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_get_link_info(xn_blufi_t *blufi, xn_wifi_link_info_t *info)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_get_link_info(blufi->wifi_manager, info);
+}
+
+/* 等待获取IP - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_wait_for_ip(xn_blufi_t *blufi, TickType_t timeout)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_wait_for_ip(blufi->wifi_manager, timeout);
+}
+
+/* 等待断开 - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_wait_for_disconnect(xn_blufi_t *blufi, TickType_t timeout)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_wait_for_disconnect(blufi->wifi_manager, timeout);
+}
+
+/* 注册状态回调 - 由组件内部状态处理函数转发 */
 void xn_blufi_wifi_register_status_cb(xn_blufi_t *blufi, xn_wifi_status_cb_t callback)
 {
-    if (blufi && blufi->wifi_manager) {
-        xn_wifi_manager_register_status_cb(blufi->wifi_manager, callback);
+    if (blufi) {
+        blufi->user_status_cb = callback;
     }
 }
 
+/* 订阅WiFi事件 - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_subscribe(xn_blufi_t *blufi, xn_wifi_event_cb_t callback,
+                                  void *user_ctx, uint32_t event_mask, int *sub_id)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_subscribe(blufi->wifi_manager, callback, user_ctx, event_mask, sub_id);
+}
+
+/* 以队列方式订阅WiFi事件 - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_subscribe_queue(xn_blufi_t *blufi, QueueHandle_t queue,
+                                        uint32_t event_mask, int *sub_id)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_subscribe_queue(blufi->wifi_manager, queue, event_mask, sub_id);
+}
+
+/* 取消订阅WiFi事件 - 委托给WiFi管理器 */
+esp_err_t xn_blufi_wifi_unsubscribe(xn_blufi_t *blufi, int sub_id)
+{
+    if (blufi == NULL || blufi->wifi_manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xn_wifi_manager_unsubscribe(blufi->wifi_manager, sub_id);
+}
+
 /* 获取蓝牙连接状态 */
 bool xn_blufi_is_ble_connected(xn_blufi_t *blufi)
 {
@@ -525,3 +1284,120 @@ bool xn_blufi_is_ble_connected(xn_blufi_t *blufi)
     }
     return blufi->ble_connected;
 }
+
+/* 设置共存调度策略 */
+esp_err_t xn_blufi_set_coex_policy(xn_blufi_t *blufi, xn_blufi_coex_policy_t policy)
+{
+    if (blufi == NULL || blufi->coex_lock == NULL || policy > XN_BLUFI_COEX_PREFER_BT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(blufi->coex_lock, portMAX_DELAY);
+    blufi->coex_policy = policy;
+    coex_apply(blufi);
+    xSemaphoreGive(blufi->coex_lock);
+    
+    ESP_LOGI(TAG, "共存调度策略: %d", policy);
+    return ESP_OK;
+}
+
+/* 获取共存调度统计 */
+esp_err_t xn_blufi_get_coex_stats(xn_blufi_t *blufi, xn_blufi_coex_stats_t *stats)
+{
+    if (blufi == NULL || blufi->coex_lock == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(blufi->coex_lock, portMAX_DELAY);
+    *stats = blufi->coex_stats;
+    xSemaphoreGive(blufi->coex_lock);
+    return ESP_OK;
+}
+
+/* 重新开始快速广播（按键唤醒） */
+esp_err_t xn_blufi_adv_wake(xn_blufi_t *blufi)
+{
+    if (blufi == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (blufi->fast_wake || g_blufi_instance != blufi) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return xn_blufi_adv_start_fast();
+}
+
+/* 获取广播调度统计 */
+esp_err_t xn_blufi_get_adv_stats(xn_blufi_t *blufi, xn_blufi_adv_stats_t *stats)
+{
+    if (blufi == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+#if CONFIG_XN_BLUFI_ADV_SCHEDULE
+    return xn_blufi_adv_get_stats(stats);
+#else
+    memset(stats, 0, sizeof(*stats));
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/* 获取安全层统计 */
+esp_err_t xn_blufi_get_security_stats(xn_blufi_t *blufi, xn_blufi_security_stats_t *stats)
+{
+    if (blufi == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+#if CONFIG_XN_BLUFI_SECURITY
+    xn_blufi_security_get_stats(stats);
+    return ESP_OK;
+#else
+    memset(stats, 0, sizeof(*stats));
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/* 获取启动耗时分解 */
+esp_err_t xn_blufi_get_boot_profile(xn_blufi_t *blufi, xn_boot_profile_t *profile)
+{
+    if (blufi == NULL || profile == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    return xn_boot_profile_get(profile);
+}
+
+/* 填充任务信息 */
+static void task_info_fill(xn_blufi_task_info_t *info, TaskHandle_t task, int core,
+                           uint32_t priority, uint32_t stack_size)
+{
+    info->running = (task != NULL);
+    info->core = (core == tskNO_AFFINITY) ? -1 : core;
+    info->priority = priority;
+    info->stack_size = stack_size;
+    info->stack_high_water = task ? uxTaskGetStackHighWaterMark(task) : 0;
+}
+
+/* 获取组件任务信息 */
+esp_err_t xn_blufi_get_task_stats(xn_blufi_t *blufi, xn_blufi_task_stats_t *stats)
+{
+    if (blufi == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    task_info_fill(&stats->ble_host, s_host_task, HOST_TASK_CORE,
+                   HOST_TASK_PRIORITY, HOST_TASK_STACK_SIZE);
+    
+    int worker_core = CONFIG_XN_BLUFI_WIFI_WORKER_CORE;
+    if (worker_core >= portNUM_PROCESSORS) {
+        worker_core = 0;
+    }
+    uint32_t worker_free = xn_wifi_manager_get_stack_high_water(blufi->wifi_manager);
+    stats->wifi_worker.running = (worker_free > 0);
+    stats->wifi_worker.core = worker_core;
+    stats->wifi_worker.priority = CONFIG_XN_BLUFI_WIFI_WORKER_PRIORITY;
+    stats->wifi_worker.stack_size = CONFIG_XN_BLUFI_WIFI_WORKER_STACK_SIZE;
+    stats->wifi_worker.stack_high_water = worker_free;
+    return ESP_OK;
+}
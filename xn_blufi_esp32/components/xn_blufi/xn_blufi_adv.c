@@ -0,0 +1,427 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: 蓝牙广播调度 - 实现文件
+ *
+ * 广播由组件自己发起（代替esp_blufi_adv_start），以便指定广播间隔；
+ * GAP事件仍交给BluFi处理，连接、断开流程与官方实现一致。
+ * 射频占用按广播事件数估算：每个事件在3个广播信道上各发送一次，
+ * 事件之间另有0~10ms的随机延时，不含扫描响应。
+ * 扫描响应携带厂商数据（配网状态、WiFi状态、固件版本、MAC后缀），
+ * 状态变化时更新，小程序扫描时不连接即可筛选、排序设备。
+ */
+
+#include "xn_blufi.h"
+#include "xn_blufi_internal.h"
+#include "xn_blufi_proto.h"
+#include "esp_log.h"
+#include "esp_blufi.h"
+#include "esp_timer.h"
+#include "host/ble_hs.h"
+#include "services/gap/ble_svc_gap.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+static const char *TAG = "XN_BLUFI_ADV";
+
+#if CONFIG_XN_BLUFI_ADV_SCHEDULE
+#define ADV_FAST_INTERVAL_MS CONFIG_XN_BLUFI_ADV_FAST_INTERVAL                          // 快速广播间隔
+#define ADV_FAST_DURATION_US ((int64_t)CONFIG_XN_BLUFI_ADV_FAST_DURATION * 1000000)     // 快速广播持续时间
+#define ADV_SLOW_INTERVAL_MS CONFIG_XN_BLUFI_ADV_SLOW_INTERVAL                          // 慢速广播间隔
+#define ADV_SLOW_DURATION_US ((int64_t)CONFIG_XN_BLUFI_ADV_SLOW_DURATION * 1000000)     // 慢速广播持续时间，0表示不停止
+#define ADV_DELAY_AVG_US 5000           // 广播事件间随机延时的平均值
+#define ADV_EVENT_AIRTIME_US 1500       // 单个广播事件的射频占用（3个信道发送、收发切换和射频启动）
+#define ADV_RADIO_CURRENT_MA 100        // 射频收发时的估算电流
+#define BLUFI_APP_UUID 0xFFFF           // BluFi服务UUID，与官方广播内容一致
+#endif
+
+/* 广播状态 */
+static struct {
+    SemaphoreHandle_t lock;             // 广播锁（会调用NimBLE接口，不能用自旋锁）
+    StaticSemaphore_t lock_buf;
+    bool ready;                         // 已初始化（快速唤醒路径不初始化蓝牙）
+    uint8_t mfg_data[XN_BLUFI_PROTO_ADV_DATA_LEN];  // 扫描响应中的厂商数据（设备状态）
+    uint8_t mfg_len;
+#if CONFIG_XN_BLUFI_ADV_SCHEDULE
+    esp_timer_handle_t timer;           // 阶段超时定时器
+    xn_blufi_adv_phase_t phase;         // 当前阶段
+    bool ble_connected;                 // 蓝牙已连接，不广播
+    bool wifi_up;                       // WiFi已获取IP
+    int64_t account_start;              // 上次累计时间的时刻
+    uint64_t fast_us;                   // 累计快速广播时间
+    uint64_t slow_us;                   // 累计慢速广播时间
+    uint64_t idle_us;                   // 累计未广播时间
+    uint32_t fast_starts;               // 进入快速阶段的次数
+#endif
+} s_adv;
+
+/* 创建广播锁（反初始化后保留，重新初始化时复用） */
+static void adv_lock_init(void)
+{
+    if (s_adv.lock == NULL) {
+        s_adv.lock = xSemaphoreCreateMutexStatic(&s_adv.lock_buf);
+    }
+}
+
+/* 把厂商数据写入扫描响应，广播进行中也可更新（调用者需持有锁） */
+static void adv_set_rsp(void)
+{
+    if (s_adv.mfg_len == 0) {
+        return;
+    }
+    
+    struct ble_hs_adv_fields fields = {0};
+    fields.mfg_data = s_adv.mfg_data;
+    fields.mfg_data_len = s_adv.mfg_len;
+    int rc = ble_gap_adv_rsp_set_fields(&fields);
+    if (rc != 0) {
+        ESP_LOGW(TAG, "设置扫描响应失败: %d", rc);
+    }
+}
+
+/* 更新扫描响应中的设备状态 */
+void xn_blufi_adv_set_mfg_data(const uint8_t *data, size_t len)
+{
+    if (!s_adv.ready || data == NULL || len > sizeof(s_adv.mfg_data)) {
+        return;
+    }
+    
+    xSemaphoreTake(s_adv.lock, portMAX_DELAY);
+    if (len != s_adv.mfg_len || memcmp(s_adv.mfg_data, data, len) != 0) {
+        memcpy(s_adv.mfg_data, data, len);
+        s_adv.mfg_len = (uint8_t)len;
+        // 未广播时只保存，下次开始广播前写入
+        if (ble_gap_adv_active()) {
+            adv_set_rsp();
+        }
+    }
+    xSemaphoreGive(s_adv.lock);
+}
+
+#if CONFIG_XN_BLUFI_ADV_SCHEDULE
+
+static const char *const s_phase_names[] = { "停止", "快速", "慢速" };
+
+static int adv_gap_event(struct ble_gap_event *event, void *arg);
+
+/* 阶段对应的广播间隔，未广播时为0 */
+static uint32_t adv_interval_ms(xn_blufi_adv_phase_t phase)
+{
+    switch (phase) {
+        case XN_BLUFI_ADV_FAST:
+            return ADV_FAST_INTERVAL_MS;
+        case XN_BLUFI_ADV_SLOW:
+            return ADV_SLOW_INTERVAL_MS;
+        default:
+            return 0;
+    }
+}
+
+/* 按广播间隔估算的射频占空比（百万分比） */
+static uint32_t adv_duty_ppm(uint32_t interval_ms)
+{
+    if (interval_ms == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)ADV_EVENT_AIRTIME_US * 1000000 / (interval_ms * 1000 + ADV_DELAY_AVG_US));
+}
+
+/* 把上次统计以来的时间累计到当前阶段（调用者需持有锁） */
+static void adv_account(void)
+{
+    int64_t now = esp_timer_get_time();
+    uint64_t elapsed = (uint64_t)(now - s_adv.account_start);
+    s_adv.account_start = now;
+    
+    if (s_adv.phase == XN_BLUFI_ADV_FAST) {
+        s_adv.fast_us += elapsed;
+    } else if (s_adv.phase == XN_BLUFI_ADV_SLOW) {
+        s_adv.slow_us += elapsed;
+    } else {
+        s_adv.idle_us += elapsed;
+    }
+}
+
+/* 按当前阶段重新开始或停止广播（调用者需持有锁） */
+static int adv_apply(void)
+{
+    if (ble_gap_adv_active()) {
+        ble_gap_adv_stop();
+    }
+    
+    uint32_t interval_ms = adv_interval_ms(s_adv.phase);
+    if (interval_ms == 0) {
+        return 0;
+    }
+    
+    // 广播内容与BluFi官方一致：标志、发射功率、设备名和BluFi服务UUID
+    const char *name = ble_svc_gap_device_name();
+    struct ble_hs_adv_fields fields = {0};
+    fields.flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP;
+    fields.tx_pwr_lvl_is_present = 1;
+    fields.tx_pwr_lvl = BLE_HS_ADV_TX_PWR_LVL_AUTO;
+    fields.name = (const uint8_t *)name;
+    fields.name_len = strlen(name);
+    fields.name_is_complete = 1;
+    fields.uuids16 = (ble_uuid16_t[]) { BLE_UUID16_INIT(BLUFI_APP_UUID) };
+    fields.num_uuids16 = 1;
+    fields.uuids16_is_complete = 1;
+    
+    int rc = ble_gap_adv_set_fields(&fields);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "设置广播数据失败: %d", rc);
+        return rc;
+    }
+    adv_set_rsp();
+    
+    uint8_t own_addr_type;
+    rc = ble_hs_id_infer_auto(0, &own_addr_type);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "获取蓝牙地址类型失败: %d", rc);
+        return rc;
+    }
+    
+    struct ble_gap_adv_params params = {0};
+    params.conn_mode = BLE_GAP_CONN_MODE_UND;
+    params.disc_mode = BLE_GAP_DISC_MODE_GEN;
+    params.itvl_min = BLE_GAP_ADV_ITVL_MS(interval_ms);
+    params.itvl_max = BLE_GAP_ADV_ITVL_MS(interval_ms);
+    rc = ble_gap_adv_start(own_addr_type, NULL, BLE_HS_FOREVER, &params, adv_gap_event, NULL);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "启动广播失败: %d", rc);
+    }
+    return rc;
+}
+
+/* 进入指定阶段并启动该阶段的超时定时器（调用者需持有锁） */
+static esp_err_t adv_enter(xn_blufi_adv_phase_t phase)
+{
+    adv_account();
+    esp_timer_stop(s_adv.timer);
+    s_adv.phase = phase;
+    
+    if (adv_apply() != 0) {
+        s_adv.phase = XN_BLUFI_ADV_OFF;
+        return ESP_FAIL;
+    }
+    
+    int64_t duration_us = 0;
+    if (phase == XN_BLUFI_ADV_FAST) {
+        duration_us = ADV_FAST_DURATION_US;
+        s_adv.fast_starts++;
+    } else if (phase == XN_BLUFI_ADV_SLOW) {
+        duration_us = ADV_SLOW_DURATION_US;
+    }
+    if (duration_us > 0) {
+        esp_timer_start_once(s_adv.timer, duration_us);
+    }
+    
+    uint32_t interval_ms = adv_interval_ms(phase);
+    uint32_t ppm = adv_duty_ppm(interval_ms);
+    ESP_LOGI(TAG, "广播%s：间隔%lu ms，射频占空比约%lu.%02lu%%，估算平均电流%lu uA",
+             s_phase_names[phase], (unsigned long)interval_ms, (unsigned long)(ppm / 10000),
+             (unsigned long)(ppm / 100 % 100), (unsigned long)(ppm * ADV_RADIO_CURRENT_MA / 1000));
+    return ESP_OK;
+}
+
+/* 阶段超时：快速转慢速，慢速转停止 */
+static void adv_timer_callback(void *arg)
+{
+    xSemaphoreTake(s_adv.lock, portMAX_DELAY);
+    if (s_adv.timer == NULL) {
+        // 已反初始化
+    } else if (s_adv.phase == XN_BLUFI_ADV_FAST) {
+        adv_enter(XN_BLUFI_ADV_SLOW);
+    } else if (s_adv.phase == XN_BLUFI_ADV_SLOW) {
+        adv_enter(XN_BLUFI_ADV_OFF);
+    }
+    xSemaphoreGive(s_adv.lock);
+}
+
+/* GAP事件：交给BluFi处理，连接建立失败时按当前阶段重新广播 */
+static int adv_gap_event(struct ble_gap_event *event, void *arg)
+{
+    // BluFi在连接失败时会按默认参数重新广播，这里改为保持当前阶段的间隔
+    if (event->type == BLE_GAP_EVENT_CONNECT && event->connect.status != 0) {
+        xSemaphoreTake(s_adv.lock, portMAX_DELAY);
+        adv_apply();
+        xSemaphoreGive(s_adv.lock);
+        return 0;
+    }
+    return esp_blufi_handle_gap_events(event, arg);
+}
+
+/* 初始化广播调度 */
+esp_err_t xn_blufi_adv_init(void)
+{
+    if (s_adv.timer) {
+        return ESP_OK;
+    }
+    
+    adv_lock_init();
+    
+    const esp_timer_create_args_t timer_args = {
+        .callback = adv_timer_callback,
+        .name = "xn_blufi_adv",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &s_adv.timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "创建广播定时器失败");
+        return ret;
+    }
+    
+    s_adv.phase = XN_BLUFI_ADV_OFF;
+    s_adv.ble_connected = false;
+    s_adv.account_start = esp_timer_get_time();
+    s_adv.ready = true;
+    return ESP_OK;
+}
+
+/* 停止广播并释放广播调度资源 */
+void xn_blufi_adv_deinit(void)
+{
+    if (s_adv.timer == NULL) {
+        return;
+    }
+    
+    xSemaphoreTake(s_adv.lock, portMAX_DELAY);
+    adv_enter(XN_BLUFI_ADV_OFF);
+    esp_timer_delete(s_adv.timer);
+    s_adv.timer = NULL;
+    s_adv.ready = false;
+    xSemaphoreGive(s_adv.lock);
+}
+
+/* 从快速阶段开始广播 */
+esp_err_t xn_blufi_adv_start_fast(void)
+{
+    if (s_adv.timer == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_adv.lock, portMAX_DELAY);
+    if (!s_adv.ble_connected) {
+        ret = adv_enter(XN_BLUFI_ADV_FAST);
+    }
+    xSemaphoreGive(s_adv.lock);
+    return ret;
+}
+
+/* 蓝牙连接状态变化：连接时停止广播，断开后重新快速广播 */
+void xn_blufi_adv_on_ble(bool connected)
+{
+    if (s_adv.timer == NULL) {
+        return;
+    }
+    
+    xSemaphoreTake(s_adv.lock, portMAX_DELAY);
+    s_adv.ble_connected = connected;
+    adv_enter(connected ? XN_BLUFI_ADV_OFF : XN_BLUFI_ADV_FAST);
+    xSemaphoreGive(s_adv.lock);
+}
+
+/* WiFi状态变化：已连上的网络断开时重新开始快速广播，便于重新配网 */
+void xn_blufi_adv_on_wifi(bool got_ip)
+{
+    if (s_adv.timer == NULL) {
+        return;
+    }
+    
+    xSemaphoreTake(s_adv.lock, portMAX_DELAY);
+    bool lost = s_adv.wifi_up && !got_ip;
+    s_adv.wifi_up = got_ip;
+    if (lost && !s_adv.ble_connected) {
+        ESP_LOGI(TAG, "WiFi断开，重新开始快速广播");
+        adv_enter(XN_BLUFI_ADV_FAST);
+    }
+    xSemaphoreGive(s_adv.lock);
+}
+
+/* 获取广播调度统计 */
+esp_err_t xn_blufi_adv_get_stats(xn_blufi_adv_stats_t *stats)
+{
+    if (s_adv.lock == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_adv.lock, portMAX_DELAY);
+    adv_account();
+    
+    uint64_t events = s_adv.fast_us / (ADV_FAST_INTERVAL_MS * 1000 + ADV_DELAY_AVG_US) +
+                      s_adv.slow_us / (ADV_SLOW_INTERVAL_MS * 1000 + ADV_DELAY_AVG_US);
+    uint64_t radio_us = events * ADV_EVENT_AIRTIME_US;
+    uint64_t total_us = s_adv.fast_us + s_adv.slow_us + s_adv.idle_us;
+    uint32_t phase_ppm = adv_duty_ppm(adv_interval_ms(s_adv.phase));
+    
+    memset(stats, 0, sizeof(*stats));
+    stats->phase = s_adv.phase;
+    stats->interval_ms = adv_interval_ms(s_adv.phase);
+    stats->fast_ms = (uint32_t)(s_adv.fast_us / 1000);
+    stats->slow_ms = (uint32_t)(s_adv.slow_us / 1000);
+    stats->idle_ms = (uint32_t)(s_adv.idle_us / 1000);
+    stats->adv_events = (uint32_t)events;
+    stats->radio_on_ms = (uint32_t)(radio_us / 1000);
+    if (total_us) {
+        stats->duty_permille = (uint16_t)(radio_us * 1000 / total_us);
+        stats->avg_current_ua = (uint32_t)(radio_us * ADV_RADIO_CURRENT_MA * 1000 / total_us);
+    }
+    stats->phase_duty_permille = (uint16_t)(phase_ppm / 1000);
+    stats->phase_current_ua = phase_ppm * ADV_RADIO_CURRENT_MA / 1000;
+    stats->fast_starts = s_adv.fast_starts;
+    
+    xSemaphoreGive(s_adv.lock);
+    return ESP_OK;
+}
+
+#else
+
+/* 未开启广播调度：按ESP-IDF默认参数一直广播 */
+esp_err_t xn_blufi_adv_init(void)
+{
+    adv_lock_init();
+    s_adv.ready = true;
+    return ESP_OK;
+}
+
+void xn_blufi_adv_deinit(void)
+{
+    s_adv.ready = false;
+}
+
+esp_err_t xn_blufi_adv_start_fast(void)
+{
+    if (!s_adv.ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // 广播数据由BluFi设置，厂商数据放在扫描响应中
+    xSemaphoreTake(s_adv.lock, portMAX_DELAY);
+    adv_set_rsp();
+    xSemaphoreGive(s_adv.lock);
+    esp_blufi_adv_start();
+    return ESP_OK;
+}
+
+void xn_blufi_adv_on_ble(bool connected)
+{
+    if (connected) {
+        esp_blufi_adv_stop();
+    } else {
+        xn_blufi_adv_start_fast();
+    }
+}
+
+void xn_blufi_adv_on_wifi(bool got_ip)
+{
+}
+
+esp_err_t xn_blufi_adv_get_stats(xn_blufi_adv_stats_t *stats)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
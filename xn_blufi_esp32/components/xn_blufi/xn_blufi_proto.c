@@ -0,0 +1,199 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: BluFi自定义数据协议编解码 - 实现文件
+ */
+
+#include "xn_blufi_proto.h"
+#include <string.h>
+
+/* 解析自定义数据命令 */
+esp_err_t xn_blufi_proto_parse(const uint8_t *data, size_t len, xn_blufi_cmd_t *cmd)
+{
+    if (cmd == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(cmd, 0, sizeof(xn_blufi_cmd_t));
+    if (data == NULL || len < 1) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    cmd->type = data[0];
+    switch (cmd->type) {
+        case XN_BLUFI_CMD_GET_CONFIGS:
+        case XN_BLUFI_CMD_GET_STATUS:
+            return ESP_OK;
+            
+        case XN_BLUFI_CMD_DELETE_CONFIG:
+            if (len < 2) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            cmd->index = data[1];
+            return ESP_OK;
+            
+        default:
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+}
+
+/* 构建存储配置列表回复 */
+size_t xn_blufi_proto_build_config_list(const xn_wifi_config_t *configs, uint8_t count,
+                                        uint8_t *out, size_t out_size)
+{
+    if (out == NULL || out_size < 3 || (count > 0 && configs == NULL)) {
+        return 0;
+    }
+    
+    size_t offset = 0;
+    out[offset++] = XN_BLUFI_CMD_GET_CONFIGS;   // 类型：存储的WiFi配置
+    
+    if (count == 0) {
+        out[offset++] = XN_BLUFI_STATUS_FAIL;   // 状态：未找到
+        out[offset++] = 0;                      // 数量：0
+        return offset;
+    }
+    
+    out[offset++] = XN_BLUFI_STATUS_OK;         // 状态：成功
+    out[offset++] = count;                      // 配置数量
+    
+    for (int i = 0; i < count; i++) {
+        // 按记录的长度发送，SSID可含'\0'
+        size_t ssid_len = configs[i].ssid_len;
+        size_t pwd_len = configs[i].password_len;
+        if (offset + 2 + ssid_len + pwd_len > out_size) {
+            return 0;
+        }
+        
+        // SSID
+        out[offset++] = (uint8_t)ssid_len;
+        memcpy(&out[offset], configs[i].ssid, ssid_len);
+        offset += ssid_len;
+        
+        // 密码
+        out[offset++] = (uint8_t)pwd_len;
+        memcpy(&out[offset], configs[i].password, pwd_len);
+        offset += pwd_len;
+    }
+    
+    return offset;
+}
+
+/* 按小端写入32位整数 */
+static size_t put_le32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+    return 4;
+}
+
+/* 构建扩展状态回复 */
+size_t xn_blufi_proto_build_status_report(const xn_blufi_status_report_t *report,
+                                          uint8_t *out, size_t out_size)
+{
+    if (report == NULL || out == NULL || out_size < XN_BLUFI_PROTO_STATUS_REPORT_LEN) {
+        return 0;
+    }
+    
+    size_t offset = 0;
+    out[offset++] = XN_BLUFI_CMD_GET_STATUS;    // 类型：扩展连接状态
+    out[offset++] = XN_BLUFI_STATUS_OK;         // 状态：成功
+    out[offset++] = report->wifi_status;
+    out[offset++] = (uint8_t)report->rssi;
+    out[offset++] = report->channel;
+    out[offset++] = report->authmode;
+    memcpy(&out[offset], report->bssid, sizeof(report->bssid));
+    offset += sizeof(report->bssid);
+    
+    // 网络字节序的地址在内存中即为a.b.c.d顺序
+    memcpy(&out[offset], &report->ip, 4);
+    offset += 4;
+    memcpy(&out[offset], &report->gw, 4);
+    offset += 4;
+    
+    offset += put_le32(&out[offset], report->uptime_s);
+    offset += put_le32(&out[offset], report->reconnect_count);
+    return offset;
+}
+
+/* 构建扫描响应中的厂商数据 */
+size_t xn_blufi_proto_build_adv_data(const xn_blufi_adv_state_t *state, uint8_t *out, size_t out_size)
+{
+    if (state == NULL || out == NULL || out_size < XN_BLUFI_PROTO_ADV_DATA_LEN) {
+        return 0;
+    }
+    
+    size_t offset = 0;
+    out[offset++] = XN_BLUFI_ADV_COMPANY_ID & 0xFF;
+    out[offset++] = XN_BLUFI_ADV_COMPANY_ID >> 8;
+    out[offset++] = XN_BLUFI_ADV_FRAME_VERSION;
+    out[offset++] = state->provisioned ? XN_BLUFI_ADV_FLAG_PROVISIONED : 0;
+    out[offset++] = state->wifi_status;
+    memcpy(&out[offset], state->fw_version, sizeof(state->fw_version));
+    offset += sizeof(state->fw_version);
+    memcpy(&out[offset], state->mac_suffix, sizeof(state->mac_suffix));
+    offset += sizeof(state->mac_suffix);
+    return offset;
+}
+
+/* 解析固件版本字符串 */
+void xn_blufi_proto_parse_version(const char *version, uint8_t out[3])
+{
+    memset(out, 0, 3);
+    if (version == NULL) {
+        return;
+    }
+    
+    const char *p = version;
+    if (*p == 'v' || *p == 'V') {
+        p++;
+    }
+    
+    // 依次读取以'.'分隔的数字，遇到其他字符停止
+    for (int i = 0; i < 3 && *p >= '0' && *p <= '9'; i++) {
+        uint32_t value = 0;
+        while (*p >= '0' && *p <= '9') {
+            if (value < 255) {
+                value = value * 10 + (uint32_t)(*p - '0');
+            }
+            p++;
+        }
+        out[i] = value > 255 ? 255 : (uint8_t)value;
+        if (*p != '.') {
+            break;
+        }
+        p++;
+    }
+}
+
+/* 构建状态回复 */
+size_t xn_blufi_proto_build_status(uint8_t type, uint8_t status, uint8_t *out, size_t out_size)
+{
+    if (out == NULL || out_size < 2) {
+        return 0;
+    }
+    
+    out[0] = type;
+    out[1] = status;
+    return 2;
+}
+
+/* 复制对端发来的SSID/密码 */
+esp_err_t xn_blufi_proto_copy_field(uint8_t *dst, size_t dst_size, const uint8_t *src, int len)
+{
+    if (dst == NULL || dst_size == 0 || len < 0 || (len > 0 && src == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if ((size_t)len >= dst_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    memset(dst, 0, dst_size);
+    if (len > 0) {
+        memcpy(dst, src, len);
+    }
+    return ESP_OK;
+}
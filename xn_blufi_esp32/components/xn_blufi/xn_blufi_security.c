@@ -0,0 +1,340 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: BluFi安全层 - DH密钥协商、AES-128-CFB帧加解密、CRC16校验
+ *
+ * 协议与ESP-IDF官方BluFi一致（EspBlufi等官方客户端可直接使用）：
+ * 1. 客户端发送协商数据 [0x00, 参数长度(2字节大端)]
+ * 2. 客户端发送协商数据 [0x01, P, G, 客户端公钥]（mbedtls_dhm参数格式，可分片）
+ * 3. 设备回复自己的DH公钥，双方用共享密钥的MD5作为AES-128密钥
+ * 4. 之后的帧使用AES-128-CFB加密，IV首字节为帧序号、其余为0；CRC16覆盖序号、长度和明文
+ *
+ * 加解密由mbedTLS完成，ESP32-S3上自动使用AES/SHA/MPI硬件加速。
+ */
+
+#include "xn_blufi.h"
+#include "xn_blufi_internal.h"
+#include "esp_log.h"
+#include "esp_blufi_api.h"
+#include "esp_crc.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "mbedtls/aes.h"
+#include "mbedtls/dhm.h"
+#include "mbedtls/md5.h"
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "XN_BLUFI_SEC";
+
+/* 协商数据类型 */
+#define SEC_TYPE_DH_PARAM_LEN   0x00
+#define SEC_TYPE_DH_PARAM_DATA  0x01
+#define SEC_TYPE_DH_P           0x02
+#define SEC_TYPE_DH_G           0x03
+#define SEC_TYPE_DH_PUBLIC      0x04
+
+#define DH_SELF_PUB_KEY_LEN     128     // 支持最大1024位DH参数
+#define SHARE_KEY_LEN           128
+#define PSK_LEN                 16      // MD5输出，作为AES-128密钥
+#define DH_PARAM_MAX_LEN        (3 * (2 + DH_SELF_PUB_KEY_LEN))    // P、G、客户端公钥各带2字节长度
+
+/* 安全会话（每个BLE连接一份） */
+typedef struct {
+    uint8_t self_public_key[DH_SELF_PUB_KEY_LEN];   // 设备公钥
+    uint8_t share_key[SHARE_KEY_LEN];               // DH共享密钥
+    size_t share_len;
+    uint8_t psk[PSK_LEN];                           // AES密钥
+    uint8_t *dh_param;                              // 客户端发来的DH参数
+    int dh_param_len;
+    uint8_t iv[16];
+    bool negotiated;                                // 是否已完成协商
+    mbedtls_dhm_context dhm;
+    mbedtls_aes_context aes;
+} blufi_security_t;
+
+static blufi_security_t *s_sec = NULL;
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+static blufi_security_t s_sec_buf;                              // 静态分配的安全会话
+static uint8_t s_dh_param_buf[DH_PARAM_MAX_LEN];                // 静态分配的DH参数缓冲区
+#endif
+static xn_blufi_security_stats_t s_stats = {0};                 // 安全层统计
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED; // 统计自旋锁
+
+/* mbedTLS随机数回调，使用硬件随机数发生器 */
+static int security_rand(void *rng_state, unsigned char *output, size_t len)
+{
+    esp_fill_random(output, len);
+    return 0;
+}
+
+/* 记录单帧加解密耗时 */
+static void security_count_frame(bool encrypt, int64_t start)
+{
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    
+    portENTER_CRITICAL(&s_stats_lock);
+    if (encrypt) {
+        s_stats.encrypt_frames++;
+        s_stats.encrypt_us_total += elapsed;
+        if (elapsed > s_stats.encrypt_us_max) {
+            s_stats.encrypt_us_max = elapsed;
+        }
+    } else {
+        s_stats.decrypt_frames++;
+        s_stats.decrypt_us_total += elapsed;
+        if (elapsed > s_stats.decrypt_us_max) {
+            s_stats.decrypt_us_max = elapsed;
+        }
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+/* 分配DH参数缓冲区，静态分配模式下使用固定缓冲区；长度由手机给出，超长参数视为分配失败 */
+static uint8_t *dh_param_alloc(int len)
+{
+    if (len <= 0 || len > DH_PARAM_MAX_LEN) {
+        return NULL;
+    }
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    return s_dh_param_buf;
+#else
+    return (uint8_t *)malloc(len);
+#endif
+}
+
+/* 释放会话中的DH参数缓冲区 */
+static void dh_param_free(void)
+{
+    if (s_sec && s_sec->dh_param) {
+#if !CONFIG_XN_BLUFI_STATIC_ALLOC
+        free(s_sec->dh_param);
+#endif
+        s_sec->dh_param = NULL;
+    }
+}
+
+/* 协商失败：上报错误并丢弃已收到的参数 */
+static void security_fail(esp_blufi_error_state_t state)
+{
+    dh_param_free();
+    
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.negotiate_failures++;
+    portEXIT_CRITICAL(&s_stats_lock);
+    
+    esp_blufi_send_error_info(state);
+}
+
+/* 初始化安全会话（BLE连接时调用） */
+esp_err_t xn_blufi_security_init(void)
+{
+    if (s_sec != NULL) {
+        xn_blufi_security_deinit();
+    }
+    
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    s_sec = &s_sec_buf;
+    memset(s_sec, 0, sizeof(blufi_security_t));
+#else
+    s_sec = (blufi_security_t *)calloc(1, sizeof(blufi_security_t));
+#endif
+    if (s_sec == NULL) {
+        ESP_LOGE(TAG, "分配安全会话失败");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    mbedtls_dhm_init(&s_sec->dhm);
+    mbedtls_aes_init(&s_sec->aes);
+    return ESP_OK;
+}
+
+/* 释放安全会话（BLE断开时调用），清除密钥材料 */
+void xn_blufi_security_deinit(void)
+{
+    if (s_sec == NULL) {
+        return;
+    }
+    
+    dh_param_free();
+    mbedtls_dhm_free(&s_sec->dhm);
+    mbedtls_aes_free(&s_sec->aes);
+    
+    memset(s_sec, 0, sizeof(blufi_security_t));
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    memset(s_dh_param_buf, 0, sizeof(s_dh_param_buf));
+#else
+    free(s_sec);
+#endif
+    s_sec = NULL;
+}
+
+/* 处理协商数据 */
+void xn_blufi_security_negotiate(uint8_t *data, int len, uint8_t **output_data, int *output_len, bool *need_free)
+{
+    if (data == NULL || len < 3) {
+        security_fail(ESP_BLUFI_DATA_FORMAT_ERROR);
+        return;
+    }
+    
+    if (s_sec == NULL) {
+        security_fail(ESP_BLUFI_INIT_SECURITY_ERROR);
+        return;
+    }
+    
+    uint8_t type = data[0];
+    switch (type) {
+        case SEC_TYPE_DH_PARAM_LEN:
+            s_sec->dh_param_len = (data[1] << 8) | data[2];
+            dh_param_free();
+            s_sec->dh_param = dh_param_alloc(s_sec->dh_param_len);
+            if (s_sec->dh_param == NULL) {
+                security_fail(ESP_BLUFI_DH_MALLOC_ERROR);
+                return;
+            }
+            break;
+            
+        case SEC_TYPE_DH_PARAM_DATA: {
+            if (s_sec->dh_param == NULL) {
+                security_fail(ESP_BLUFI_DH_PARAM_ERROR);
+                return;
+            }
+            if (len < s_sec->dh_param_len + 1) {
+                security_fail(ESP_BLUFI_DATA_FORMAT_ERROR);
+                return;
+            }
+            
+            int64_t start = esp_timer_get_time();
+            
+            // 参数格式：P、G、客户端公钥，各自带2字节大端长度
+            uint8_t *param = s_sec->dh_param;
+            memcpy(s_sec->dh_param, &data[1], s_sec->dh_param_len);
+            int ret = mbedtls_dhm_read_params(&s_sec->dhm, &param, &param[s_sec->dh_param_len]);
+            dh_param_free();
+            if (ret) {
+                ESP_LOGE(TAG, "读取DH参数失败: -0x%04x", -ret);
+                security_fail(ESP_BLUFI_READ_PARAM_ERROR);
+                return;
+            }
+            
+            const int dhm_len = mbedtls_dhm_get_len(&s_sec->dhm);
+            if (dhm_len > DH_SELF_PUB_KEY_LEN) {
+                ESP_LOGE(TAG, "DH参数过长: %d", dhm_len);
+                security_fail(ESP_BLUFI_DH_PARAM_ERROR);
+                return;
+            }
+            
+            ret = mbedtls_dhm_make_public(&s_sec->dhm, dhm_len, s_sec->self_public_key,
+                                          dhm_len, security_rand, NULL);
+            if (ret) {
+                ESP_LOGE(TAG, "生成DH公钥失败: -0x%04x", -ret);
+                security_fail(ESP_BLUFI_MAKE_PUBLIC_ERROR);
+                return;
+            }
+            
+            ret = mbedtls_dhm_calc_secret(&s_sec->dhm, s_sec->share_key, SHARE_KEY_LEN,
+                                          &s_sec->share_len, security_rand, NULL);
+            if (ret) {
+                ESP_LOGE(TAG, "计算共享密钥失败: -0x%04x", -ret);
+                security_fail(ESP_BLUFI_ENCRYPT_ERROR);
+                return;
+            }
+            
+            ret = mbedtls_md5(s_sec->share_key, s_sec->share_len, s_sec->psk);
+            memset(s_sec->share_key, 0, sizeof(s_sec->share_key));
+            if (ret) {
+                security_fail(ESP_BLUFI_CALC_MD5_ERROR);
+                return;
+            }
+            
+            // 密钥没装进AES上下文就不能宣布协商完成，否则之后的帧会用全零密钥加解密
+            ret = mbedtls_aes_setkey_enc(&s_sec->aes, s_sec->psk, PSK_LEN * 8);
+            if (ret) {
+                ESP_LOGE(TAG, "设置AES密钥失败: -0x%04x", -ret);
+                memset(s_sec->psk, 0, sizeof(s_sec->psk));
+                s_sec->negotiated = false;
+                security_fail(ESP_BLUFI_INIT_SECURITY_ERROR);
+                return;
+            }
+            s_sec->negotiated = true;
+            
+            uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+            portENTER_CRITICAL(&s_stats_lock);
+            s_stats.negotiations++;
+            s_stats.negotiate_us = elapsed;
+            portEXIT_CRITICAL(&s_stats_lock);
+            ESP_LOGI(TAG, "密钥协商完成（%d位DH），耗时%lu us", dhm_len * 8, (unsigned long)elapsed);
+            
+            // 回复设备公钥
+            *output_data = &s_sec->self_public_key[0];
+            *output_len = dhm_len;
+            *need_free = false;
+            break;
+        }
+        
+        case SEC_TYPE_DH_P:
+        case SEC_TYPE_DH_G:
+        case SEC_TYPE_DH_PUBLIC:
+            // 分开发送P/G/公钥的旧格式，官方实现同样忽略
+            break;
+            
+        default:
+            ESP_LOGW(TAG, "未知协商数据类型: %d", type);
+            break;
+    }
+}
+
+/* 加密帧数据（原地加密），返回加密后长度，失败返回-1 */
+int xn_blufi_security_encrypt(uint8_t iv8, uint8_t *crypt_data, int crypt_len)
+{
+    if (s_sec == NULL || !s_sec->negotiated) {
+        return -1;
+    }
+    
+    size_t iv_offset = 0;
+    uint8_t iv0[16];
+    memcpy(iv0, s_sec->iv, sizeof(s_sec->iv));
+    iv0[0] = iv8;
+    
+    int64_t start = esp_timer_get_time();
+    int ret = mbedtls_aes_crypt_cfb128(&s_sec->aes, MBEDTLS_AES_ENCRYPT, crypt_len,
+                                       &iv_offset, iv0, crypt_data, crypt_data);
+    security_count_frame(true, start);
+    
+    return ret ? -1 : crypt_len;
+}
+
+/* 解密帧数据（原地解密），返回解密后长度，失败返回-1 */
+int xn_blufi_security_decrypt(uint8_t iv8, uint8_t *crypt_data, int crypt_len)
+{
+    if (s_sec == NULL || !s_sec->negotiated) {
+        return -1;
+    }
+    
+    size_t iv_offset = 0;
+    uint8_t iv0[16];
+    memcpy(iv0, s_sec->iv, sizeof(s_sec->iv));
+    iv0[0] = iv8;
+    
+    int64_t start = esp_timer_get_time();
+    int ret = mbedtls_aes_crypt_cfb128(&s_sec->aes, MBEDTLS_AES_DECRYPT, crypt_len,
+                                       &iv_offset, iv0, crypt_data, crypt_data);
+    security_count_frame(false, start);
+    
+    return ret ? -1 : crypt_len;
+}
+
+/* 计算帧校验和（data已包含序号和长度，iv8不参与计算） */
+uint16_t xn_blufi_security_checksum(uint8_t iv8, uint8_t *data, int len)
+{
+    return esp_crc16_be(0, data, len);
+}
+
+/* 获取安全层统计 */
+void xn_blufi_security_get_stats(xn_blufi_security_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
@@ -0,0 +1,112 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: 启动耗时分析 - 实现文件
+ */
+
+#include "xn_boot_profile.h"
+#include "sdkconfig.h"
+
+#if CONFIG_XN_BLUFI_BOOT_PROFILE
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "XN_BOOT";
+
+static xn_boot_profile_t s_profile = {0};                       // 启动耗时分解
+static portMUX_TYPE s_profile_lock = portMUX_INITIALIZER_UNLOCKED; // 自旋锁（各阶段可能在不同任务中记录）
+
+/* 记录一个已完成的启动阶段 */
+void xn_boot_profile_record(const char *name, int64_t start_us)
+{
+    uint32_t end = (uint32_t)esp_timer_get_time();
+    
+    portENTER_CRITICAL(&s_profile_lock);
+    if (!s_profile.finished) {
+        if (s_profile.count < XN_BOOT_PROFILE_MAX_STAGES) {
+            xn_boot_stage_t *stage = &s_profile.stages[s_profile.count++];
+            stage->name = name;
+            stage->start_us = (uint32_t)start_us;
+            stage->duration_us = end - (uint32_t)start_us;
+        } else if (s_profile.dropped < UINT8_MAX) {
+            s_profile.dropped++;
+        }
+        if (end > s_profile.end_us) {
+            s_profile.end_us = end;
+        }
+    }
+    portEXIT_CRITICAL(&s_profile_lock);
+}
+
+/* 结束记录并打印分解结果 */
+void xn_boot_profile_finish(void)
+{
+    xn_boot_profile_t profile;
+    
+    portENTER_CRITICAL(&s_profile_lock);
+    bool already = s_profile.finished;
+    s_profile.finished = true;
+    profile = s_profile;
+    portEXIT_CRITICAL(&s_profile_lock);
+    
+    if (already) {
+        return;
+    }
+    
+    // 按耗时从大到小排序（插入排序，阶段数很少）
+    for (int i = 1; i < profile.count; i++) {
+        xn_boot_stage_t stage = profile.stages[i];
+        int j = i - 1;
+        while (j >= 0 && profile.stages[j].duration_us < stage.duration_us) {
+            profile.stages[j + 1] = profile.stages[j];
+            j--;
+        }
+        profile.stages[j + 1] = stage;
+    }
+    
+    uint32_t total = profile.end_us ? profile.end_us : 1;
+    ESP_LOGI(TAG, "启动耗时分解（上电到启动完成共%lu ms）：", (unsigned long)(profile.end_us / 1000));
+    for (int i = 0; i < profile.count; i++) {
+        const xn_boot_stage_t *stage = &profile.stages[i];
+        ESP_LOGI(TAG, "  %-20s %7lu us  %3lu%%  @%lu ms", stage->name,
+                 (unsigned long)stage->duration_us,
+                 (unsigned long)((uint64_t)stage->duration_us * 100 / total),
+                 (unsigned long)(stage->start_us / 1000));
+    }
+    if (profile.dropped) {
+        ESP_LOGW(TAG, "  另有%d个阶段超出记录容量", profile.dropped);
+    }
+}
+
+/* 获取启动耗时分解 */
+esp_err_t xn_boot_profile_get(xn_boot_profile_t *profile)
+{
+    if (profile == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&s_profile_lock);
+    *profile = s_profile;
+    portEXIT_CRITICAL(&s_profile_lock);
+    return ESP_OK;
+}
+
+#else
+
+void xn_boot_profile_record(const char *name, int64_t start_us)
+{
+}
+
+void xn_boot_profile_finish(void)
+{
+}
+
+esp_err_t xn_boot_profile_get(xn_boot_profile_t *profile)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
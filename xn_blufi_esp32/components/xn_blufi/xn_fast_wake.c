@@ -0,0 +1,102 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: 深度睡眠快速唤醒 - 实现文件
+ *
+ * 租约时间用time()的原始值计算：RTC时钟在深度睡眠期间持续计时，
+ * 不需要SNTP校时；上电后RTC内存被清空，不会用到上一次上电的时间。
+ */
+
+#include "xn_fast_wake.h"
+#include "sdkconfig.h"
+
+#if CONFIG_XN_BLUFI_FAST_WAKE
+
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "esp_rom_crc.h"
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#define FAST_WAKE_MAGIC 0x4B574658  // "XFWK"
+
+/* RTC内存中的状态 */
+typedef struct {
+    uint32_t magic;
+    xn_wifi_cred_t cred;
+    xn_wifi_lease_t lease;
+    int64_t t1;                 // 租约T1对应的time()原始值，0表示未知
+    uint32_t crc;               // 覆盖crc之前的全部字段
+} fast_wake_rtc_t;
+
+static RTC_DATA_ATTR fast_wake_rtc_t s_rtc;
+
+/* 计算RTC状态校验值 */
+static uint32_t fast_wake_crc(void)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)&s_rtc, offsetof(fast_wake_rtc_t, crc));
+}
+
+/* 保存快速唤醒状态到RTC内存 */
+esp_err_t xn_fast_wake_save(const xn_fast_wake_state_t *state)
+{
+    if (state == NULL || state->cred.ssid_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(&s_rtc, 0, sizeof(s_rtc));
+    s_rtc.magic = FAST_WAKE_MAGIC;
+    s_rtc.cred = state->cred;
+    s_rtc.lease = state->lease;
+    s_rtc.t1 = state->fresh_s ? (int64_t)time(NULL) + state->fresh_s : 0;
+    s_rtc.crc = fast_wake_crc();
+    return ESP_OK;
+}
+
+/* 读取快速唤醒状态 */
+esp_err_t xn_fast_wake_load(xn_fast_wake_state_t *state)
+{
+    if (state == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UNDEFINED ||
+        s_rtc.magic != FAST_WAKE_MAGIC || s_rtc.crc != fast_wake_crc()) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    memset(state, 0, sizeof(xn_fast_wake_state_t));
+    state->cred = s_rtc.cred;
+    state->lease = s_rtc.lease;
+    
+    int64_t now = time(NULL);
+    if (s_rtc.t1 && now < s_rtc.t1) {
+        state->fresh_s = (uint32_t)(s_rtc.t1 - now);
+    }
+    return ESP_OK;
+}
+
+/* 清除快速唤醒状态 */
+void xn_fast_wake_clear(void)
+{
+    memset(&s_rtc, 0, sizeof(s_rtc));
+}
+
+#else
+
+esp_err_t xn_fast_wake_save(const xn_fast_wake_state_t *state)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t xn_fast_wake_load(xn_fast_wake_state_t *state)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void xn_fast_wake_clear(void)
+{
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: WiFi凭据 - 实现文件
+ */
+
+#include "xn_wifi_cred.h"
+#include "mbedtls/md.h"
+#include "mbedtls/pkcs5.h"
+#include <string.h>
+
+#define WPA_PASSPHRASE_MIN_LEN  8       // WPA口令最短长度
+#define WPA_PASSPHRASE_MAX_LEN  63      // WPA口令最长长度（64字节为十六进制PSK）
+#define WPA_PBKDF2_ITERATIONS   4096    // IEEE 802.11i规定的迭代次数
+
+/* 按原始字节设置凭据 */
+esp_err_t xn_wifi_cred_set(xn_wifi_cred_t *cred,
+                           const uint8_t *ssid, size_t ssid_len,
+                           const uint8_t *password, size_t password_len)
+{
+    if (cred == NULL || (ssid_len > 0 && ssid == NULL) || (password_len > 0 && password == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (ssid_len > XN_WIFI_SSID_MAX_LEN || password_len > XN_WIFI_PASSWORD_MAX_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    memset(cred, 0, sizeof(xn_wifi_cred_t));
+    if (ssid_len > 0) {
+        memcpy(cred->ssid, ssid, ssid_len);
+    }
+    if (password_len > 0) {
+        memcpy(cred->password, password, password_len);
+    }
+    cred->ssid_len = (uint8_t)ssid_len;
+    cred->password_len = (uint8_t)password_len;
+    return ESP_OK;
+}
+
+/* 由字符串设置凭据 */
+esp_err_t xn_wifi_cred_from_str(xn_wifi_cred_t *cred, const char *ssid, const char *password)
+{
+    if (ssid == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // 只扫描到上限+1，超长字符串直接判定超限
+    size_t ssid_len = strnlen(ssid, XN_WIFI_SSID_MAX_LEN + 1);
+    size_t password_len = password ? strnlen(password, XN_WIFI_PASSWORD_MAX_LEN + 1) : 0;
+    return xn_wifi_cred_set(cred, (const uint8_t *)ssid, ssid_len,
+                            (const uint8_t *)password, password_len);
+}
+
+/* 由口令和SSID计算PMK */
+esp_err_t xn_wifi_cred_derive_pmk(xn_wifi_cred_t *cred)
+{
+    if (cred == NULL || cred->ssid_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    cred->pmk_valid = false;
+    if (cred->password_len < WPA_PASSPHRASE_MIN_LEN || cred->password_len > WPA_PASSPHRASE_MAX_LEN) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    int err = mbedtls_pkcs5_pbkdf2_hmac_ext(MBEDTLS_MD_SHA1,
+                                            cred->password, cred->password_len,
+                                            cred->ssid, cred->ssid_len,
+                                            WPA_PBKDF2_ITERATIONS,
+                                            sizeof(cred->pmk), cred->pmk);
+    if (err != 0) {
+        memset(cred->pmk, 0, sizeof(cred->pmk));
+        return ESP_FAIL;
+    }
+    
+    cred->pmk_valid = true;
+    return ESP_OK;
+}
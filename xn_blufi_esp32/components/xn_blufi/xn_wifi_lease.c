@@ -0,0 +1,209 @@
+/*
+ * @Author: 星年 jixingnian@gmail.com
+ * @Date: 2025-01-15
+ * @Description: WiFi租约缓存 - 实现文件
+ *
+ * 整张表作为一个blob保存在NVS中，首次使用时读入RAM，之后读取走内存。
+ * 网络以SSID的CRC32和长度标识；偶发的哈希碰撞不影响正确性，
+ * 使用记录前管理器会核对实际连接的BSSID。
+ */
+
+#include "xn_wifi_lease.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "esp_rom_crc.h"
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "XN_WIFI_LEASE";
+
+#define NVS_NAMESPACE "wifi_lease"
+#define NVS_KEY "table"
+#define LEASE_TABLE_MAGIC 0x534C4E58   // "XNLS"
+#define LEASE_TABLE_VERSION 1
+#define LEASE_TIME_VALID_MIN 1577836800 // 2020-01-01，早于此视为系统时间未校准
+
+/* 表项 */
+typedef struct {
+    uint32_t ssid_hash;         // SSID的CRC32
+    uint8_t ssid_len;           // SSID长度，0表示空表项
+    uint8_t reserved[3];
+    uint32_t seq;               // 最近使用序号，越大越新
+    xn_wifi_lease_t lease;
+} lease_entry_t;
+
+/* NVS中的整张表 */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seq;               // 已分配的最大序号
+    lease_entry_t entries[XN_WIFI_LEASE_MAX_ENTRIES];
+} lease_table_t;
+
+static lease_table_t s_table;
+static bool s_loaded = false;
+
+/* 首次使用时从NVS读入，记录不存在或格式不符时从空表开始 */
+static void lease_load(void)
+{
+    if (s_loaded) {
+        return;
+    }
+    s_loaded = true;
+    
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        size_t len = sizeof(s_table);
+        esp_err_t ret = nvs_get_blob(nvs_handle, NVS_KEY, &s_table, &len);
+        nvs_close(nvs_handle);
+        if (ret == ESP_OK && len == sizeof(s_table) &&
+            s_table.magic == LEASE_TABLE_MAGIC && s_table.version == LEASE_TABLE_VERSION) {
+            return;
+        }
+    }
+    
+    memset(&s_table, 0, sizeof(s_table));
+    s_table.magic = LEASE_TABLE_MAGIC;
+    s_table.version = LEASE_TABLE_VERSION;
+}
+
+/* 写回NVS */
+static esp_err_t lease_flush(void)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "打开NVS失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = nvs_set_blob(nvs_handle, NVS_KEY, &s_table, sizeof(s_table));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "保存租约失败: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/* 查找网络对应的表项 */
+static lease_entry_t *lease_find(const uint8_t *ssid, size_t ssid_len)
+{
+    uint32_t hash = esp_rom_crc32_le(0, ssid, ssid_len);
+    
+    for (int i = 0; i < XN_WIFI_LEASE_MAX_ENTRIES; i++) {
+        lease_entry_t *entry = &s_table.entries[i];
+        if (entry->ssid_len == ssid_len && entry->ssid_hash == hash) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* 读取网络的租约记录 */
+esp_err_t xn_wifi_lease_get(const uint8_t *ssid, size_t ssid_len, xn_wifi_lease_t *lease)
+{
+    if (ssid == NULL || ssid_len == 0 || ssid_len > UINT8_MAX || lease == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    lease_load();
+    lease_entry_t *entry = lease_find(ssid, ssid_len);
+    if (entry == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    *lease = entry->lease;
+    return ESP_OK;
+}
+
+/* 保存网络的租约记录 */
+esp_err_t xn_wifi_lease_put(const uint8_t *ssid, size_t ssid_len, const xn_wifi_lease_t *lease)
+{
+    if (ssid == NULL || ssid_len == 0 || ssid_len > UINT8_MAX || lease == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    lease_load();
+    lease_entry_t *entry = lease_find(ssid, ssid_len);
+    if (entry != NULL) {
+        // 地址和AP都没变，且获得时间只是向后推移了不到租期的1/4，不值得写Flash
+        xn_wifi_lease_t old = entry->lease;
+        int64_t age = lease->obtained_at - old.obtained_at;
+        old.obtained_at = lease->obtained_at;
+        if (memcmp(&old, lease, sizeof(old)) == 0 &&
+            (lease->obtained_at == 0 || lease->lease_s == 0 ||
+             (age >= 0 && age < lease->lease_s / 4))) {
+            return ESP_OK;
+        }
+    } else {
+        // 占用空表项，没有则替换最久未使用的
+        entry = &s_table.entries[0];
+        for (int i = 0; i < XN_WIFI_LEASE_MAX_ENTRIES; i++) {
+            if (s_table.entries[i].ssid_len == 0) {
+                entry = &s_table.entries[i];
+                break;
+            }
+            if (s_table.entries[i].seq < entry->seq) {
+                entry = &s_table.entries[i];
+            }
+        }
+        memset(entry, 0, sizeof(lease_entry_t));
+        entry->ssid_hash = esp_rom_crc32_le(0, ssid, ssid_len);
+        entry->ssid_len = (uint8_t)ssid_len;
+    }
+    
+    entry->seq = ++s_table.seq;
+    entry->lease = *lease;
+    return lease_flush();
+}
+
+/* 删除网络的租约记录 */
+esp_err_t xn_wifi_lease_remove(const uint8_t *ssid, size_t ssid_len)
+{
+    if (ssid == NULL || ssid_len == 0 || ssid_len > UINT8_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    lease_load();
+    lease_entry_t *entry = lease_find(ssid, ssid_len);
+    if (entry == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    memset(entry, 0, sizeof(lease_entry_t));
+    return lease_flush();
+}
+
+/* 获取当前系统时间（秒） */
+int64_t xn_wifi_lease_now(void)
+{
+    time_t now = time(NULL);
+    return now >= LEASE_TIME_VALID_MIN ? (int64_t)now : 0;
+}
+
+/* 判断租约是否仍在T1之前 */
+bool xn_wifi_lease_is_fresh(const xn_wifi_lease_t *lease, uint32_t *remaining_s)
+{
+    if (lease == NULL || lease->ip == 0 || lease->lease_s == 0 || lease->obtained_at == 0) {
+        return false;
+    }
+    
+    int64_t now = xn_wifi_lease_now();
+    if (now == 0 || now < lease->obtained_at) {
+        return false;
+    }
+    
+    int64_t t1 = lease->obtained_at + lease->lease_s / 2;
+    if (now >= t1) {
+        return false;
+    }
+    
+    if (remaining_s) {
+        *remaining_s = (uint32_t)(t1 - now);
+    }
+    return true;
+}
@@ -2,134 +2,1574 @@
  * @Author: 星年 jixingnian@gmail.com
  * @Date: 2025-01-15
  * @Description: WiFi管理层 - 实现文件
+ *
+ * 线程模型：
+ * 连接、断开、扫描命令以及WiFi/IP事件统一投递到命令队列，
+ * 由唯一的工作任务串行处理，管理器内部状态只有工作任务会修改。
+ * 其他任务通过原子状态字或状态快照读取，无需加锁等待。
+ *
+ * 事件发布：
+ * 订阅者表为固定容量的槽位数组，槽位状态字带代数，订阅/取消订阅通过CAS修改，
+ * 工作任务发布事件时按"读状态-拷贝字段-复查状态"方式读取，全程无锁、无内存分配。
+ * 事件只以非阻塞方式投递到队列：队列方式投递到订阅者自己的队列，回调方式投递到
+ * 槽位专用的投递任务，回调在该任务中执行，慢速回调不会拖住工作任务和其他订阅者。
  */
 
 #include "xn_wifi_manager.h"
+#include "xn_boot_profile.h"
+#include "xn_wifi_lease.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
+#include "lwip/dhcp.h"
+#if CONFIG_XN_BLUFI_LEASE_STATIC_IP
+#include "ping/ping_sock.h"
+#endif
+#if CONFIG_XN_BLUFI_ROAMING
+#include "esp_rrm.h"
+#include "esp_wnm.h"
+#endif
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
 #include "freertos/event_groups.h"
+#include <stdatomic.h>
+#include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "XN_WIFI_MANAGER";
 
-#define WIFI_CONNECTED_BIT BIT0
+#define WIFI_CONNECTED_BIT BIT0         // 已获取IP
+#define WIFI_WORKER_EXIT_BIT BIT1       // 工作任务已退出
+#define WIFI_DISCONNECTED_BIT BIT2      // 已断开（不再重连）
+#define WIFI_SCAN_DONE_BIT BIT3         // 扫描完成（无扫描进行中）
 #define MAX_RETRY_COUNT 5
 
+#define TX_POWER_MAX 84                 // 最大发射功率上限（0.25dBm），驱动按PHY参数再限幅
+#define WIFI_PROTOCOL_BGN (WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N)
+
+// 初始化时使用的档位
+#if CONFIG_XN_BLUFI_WIFI_PROFILE_MAX_THROUGHPUT
+#define WIFI_DEFAULT_PROFILE XN_WIFI_PROFILE_MAX_THROUGHPUT
+#elif CONFIG_XN_BLUFI_WIFI_PROFILE_LOW_POWER
+#define WIFI_DEFAULT_PROFILE XN_WIFI_PROFILE_LOW_POWER
+#else
+#define WIFI_DEFAULT_PROFILE XN_WIFI_PROFILE_BALANCED
+#endif
+
+#define LEASE_VERIFY_PING_COUNT 3       // 静态IP校验：ping网关次数
+#define LEASE_VERIFY_PING_TIMEOUT_MS 300 // 静态IP校验：单次ping超时
+
+#if CONFIG_XN_BLUFI_ROAMING
+#define ROAM_RSSI_THRESHOLD CONFIG_XN_BLUFI_ROAM_RSSI_THRESHOLD  // 触发漫游评估的信号强度
+#define ROAM_RSSI_GAIN CONFIG_XN_BLUFI_ROAM_RSSI_GAIN            // 候选AP至少比当前AP强的dB数
+#define ROAM_COOLDOWN_US ((int64_t)CONFIG_XN_BLUFI_ROAM_INTERVAL * 1000000)  // 两次评估的最小间隔
+#define ROAM_NEIGHBOR_TIMEOUT_US 1000000  // 等待邻居报告的超时，超时后全信道扫描
+#define WLAN_EID_NEIGHBOR_REPORT 52
+#define NEIGHBOR_REPORT_MIN_LEN 13        // BSSID(6) + BSSID信息(4) + 操作类别 + 信道 + PHY类型
+#endif
+
+#if CONFIG_XN_BLUFI_LINK_MONITOR
+#define LINK_SAMPLE_INTERVAL_US ((uint64_t)CONFIG_XN_BLUFI_LINK_SAMPLE_INTERVAL * 1000)  // 链路采样间隔
+#define LINK_DEGRADED_RSSI CONFIG_XN_BLUFI_LINK_DEGRADED_RSSI  // 链路变差门限
+#define LINK_HYSTERESIS CONFIG_XN_BLUFI_LINK_HYSTERESIS        // 链路恢复迟滞
+#define LINK_RECOVER_SAMPLES 3          // 恢复前需要连续满足条件的采样次数
+#define LINK_RSSI_SMOOTH_SHIFT 2        // 信号强度一阶低通系数1/4
+#endif
+
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+#define WIFI_SCAN_MAX_AP CONFIG_XN_BLUFI_SCAN_MAX_AP  // 静态扫描结果缓冲区容量
+#endif
+
+#define WIFI_CMD_QUEUE_LEN 8            // 命令队列长度
+#define WIFI_CMD_POST_TIMEOUT_MS 100    // 投递命令超时时间
+#define WIFI_WORKER_STACK_SIZE CONFIG_XN_BLUFI_WIFI_WORKER_STACK_SIZE  // 工作任务栈大小
+#define WIFI_WORKER_PRIORITY CONFIG_XN_BLUFI_WIFI_WORKER_PRIORITY       // 工作任务优先级
+// 工作任务运行核心，-1不绑定，单核芯片上统一为0
+#define WIFI_WORKER_CORE ((CONFIG_XN_BLUFI_WIFI_WORKER_CORE) < 0 ? tskNO_AFFINITY : \
+                          ((CONFIG_XN_BLUFI_WIFI_WORKER_CORE) < portNUM_PROCESSORS ? (CONFIG_XN_BLUFI_WIFI_WORKER_CORE) : 0))
+#define SUB_TASK_STACK_SIZE CONFIG_XN_BLUFI_WIFI_SUB_TASK_STACK_SIZE    // 回调投递任务栈大小
+#define SUB_TASK_PRIORITY CONFIG_XN_BLUFI_WIFI_SUB_TASK_PRIORITY        // 回调投递任务优先级
+#define SUB_QUEUE_LEN 8                 // 回调投递队列长度
+
+/* 预置档位参数，取舍说明见xn_wifi_manager.h */
+static const xn_wifi_profile_t PRESET_PROFILES[] = {
+    [XN_WIFI_PROFILE_MAX_THROUGHPUT] = {
+        .ps_type = WIFI_PS_NONE,
+        .listen_interval = 0,
+        .bandwidth = WIFI_BW_HT40,
+        .protocol = WIFI_PROTOCOL_BGN,
+        .max_tx_power = 0,
+    },
+    [XN_WIFI_PROFILE_BALANCED] = {
+        .ps_type = WIFI_PS_MIN_MODEM,
+        .listen_interval = 3,
+        .bandwidth = WIFI_BW_HT20,
+        .protocol = WIFI_PROTOCOL_BGN,
+        .max_tx_power = 0,
+    },
+    [XN_WIFI_PROFILE_LOW_POWER] = {
+        .ps_type = WIFI_PS_MAX_MODEM,
+        .listen_interval = 10,
+        .bandwidth = WIFI_BW_HT20,
+        .protocol = WIFI_PROTOCOL_BGN,
+        .max_tx_power = 52,     // 13dBm
+    },
+};
+
+/* 订阅者槽位状态（低2位），高位为代数，槽位每次被占用时递增 */
+#define SUB_STATE_FREE      0u
+#define SUB_STATE_CLAIMED   1u
+#define SUB_STATE_ACTIVE    2u
+#define SUB_STATE_MASK      3u
+#define SUB_GEN_INC         4u
+
+/* 投递给回调方式订阅者的事件，带发布时的槽位状态字，只投递给同一次订阅 */
+typedef struct {
+    xn_wifi_event_t event;
+    unsigned int state;                 // 0表示让投递任务退出
+} sub_event_t;
+
+/* 事件订阅者 */
+typedef struct {
+    atomic_uint state;                  // 槽位状态 | 代数
+    uint32_t event_mask;                // 关注的事件掩码
+    xn_wifi_event_cb_t callback;        // 回调方式
+    void *user_ctx;                     // 回调上下文
+    QueueHandle_t queue;                // 队列方式
+    atomic_uint dropped;                // 队列满丢弃的事件数
+    atomic_uint inflight;               // 正在读取该槽位/投递事件的发布者和投递任务数
+    QueueHandle_t cb_queue;             // 回调方式：本槽位的投递队列（首次用于回调方式时创建）
+    TaskHandle_t cb_task;               // 回调方式：本槽位的投递任务
+    atomic_bool cb_exited;              // 投递任务已退出
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    StaticQueue_t cb_queue_buf;
+    uint8_t cb_queue_storage[SUB_QUEUE_LEN * sizeof(sub_event_t)];
+    StaticTask_t cb_tcb;
+    StackType_t cb_stack[SUB_TASK_STACK_SIZE];
+#endif
+} wifi_subscriber_t;
+
+/* 工作任务命令类型 */
+typedef enum {
+    WIFI_CMD_CONNECT = 0,           // 连接WiFi
+    WIFI_CMD_DISCONNECT,            // 断开WiFi
+    WIFI_CMD_SCAN,                  // 扫描WiFi
+    WIFI_CMD_EVT_CONNECTED,         // 事件：已连接AP
+    WIFI_CMD_EVT_DISCONNECTED,      // 事件：连接断开
+    WIFI_CMD_EVT_SCAN_DONE,         // 事件：扫描完成
+    WIFI_CMD_EVT_GOT_IP,            // 事件：获取到IP
+    WIFI_CMD_LEASE_VERIFIED,        // 静态IP网关校验结束
+    WIFI_CMD_LEASE_RENEW,           // 静态IP到达续约时间（T1）
+    WIFI_CMD_SET_PROFILE,           // 切换功耗/性能档位
+    WIFI_CMD_ROAM_RSSI_LOW,         // 事件：信号低于漫游门限
+    WIFI_CMD_ROAM_NEIGHBORS,        // 事件：收到11k邻居报告
+    WIFI_CMD_ROAM_TIMER,            // 漫游定时器到期
+    WIFI_CMD_EVT_BEACON_TIMEOUT,    // 事件：丢失beacon
+    WIFI_CMD_LINK_SAMPLE,           // 链路质量采样
+    WIFI_CMD_EXIT,                  // 退出工作任务
+} wifi_cmd_type_t;
+
+/* 工作任务命令 */
+typedef struct {
+    wifi_cmd_type_t type;
+    union {
+        struct {
+            xn_wifi_cred_t cred;
+            xn_wifi_lease_t lease;              // 调用者给出的AP和租约（快速唤醒），不再读NVS
+            bool has_lease;
+            uint32_t fresh_s;                   // 租约距T1的剩余秒数，0表示按系统时间判断
+        } connect;                              // WIFI_CMD_CONNECT
+        xn_wifi_scan_done_cb_t scan_callback;   // WIFI_CMD_SCAN
+        uint8_t reason;                         // WIFI_CMD_EVT_DISCONNECTED
+        struct {
+            wifi_auth_mode_t authmode;
+            uint8_t bssid[6];
+            uint8_t channel;
+        } connected;                            // WIFI_CMD_EVT_CONNECTED
+        esp_netif_ip_info_t ip_info;            // WIFI_CMD_EVT_GOT_IP
+        bool verified;                          // WIFI_CMD_LEASE_VERIFIED
+        struct {
+            xn_wifi_profile_id_t id;
+            xn_wifi_profile_t config;
+        } profile;                              // WIFI_CMD_SET_PROFILE
+        int8_t rssi;                            // WIFI_CMD_ROAM_RSSI_LOW
+        uint16_t channels;                      // WIFI_CMD_ROAM_NEIGHBORS，邻居AP所在信道位图（bit n为信道n）
+    };
+} wifi_cmd_t;
+
 /* WiFi管理器实例结构体 */
 struct xn_wifi_manager_s {
     EventGroupHandle_t event_group;         // WiFi事件组
-    xn_wifi_status_t status;                // WiFi连接状态
+    atomic_int status;                      // WiFi连接状态（原子状态字）
+    xn_wifi_status_cb_t status_callback;    // 状态变化回调（兼容旧接口）
+    wifi_subscriber_t subscribers[XN_WIFI_MAX_SUBSCRIBERS];    // 事件订阅者表
+    QueueHandle_t cmd_queue;                // 命令队列
+    TaskHandle_t worker_task;               // 工作任务
+    esp_netif_t *netif;                     // 网络接口
+    
+    /* 以下字段只由工作任务修改 */
     xn_wifi_scan_done_cb_t scan_callback;   // 扫描完成回调
-    xn_wifi_status_cb_t status_callback;    // 状态变化回调
     wifi_config_t wifi_config;              // WiFi配置
     uint8_t retry_count;                    // 重连计数
     bool is_connecting;                     // 是否正在连接
-    esp_netif_t *netif;                     // 网络接口
+    bool disconnect_pending;                // 发起新连接时断开了旧连接，其DISCONNECTED事件还没到
+    bool using_pmk;                         // 当前连接使用预计算的PMK
+    wifi_auth_mode_t authmode;              // 已连接AP的认证方式
+    uint8_t bssid[6];                       // 已连接AP的BSSID
+    uint8_t channel;                        // 已连接AP的信道
+    int64_t connect_start;                  // 发起连接的时间（us），0表示已统计过获取IP耗时
+    int64_t connected_at;                   // 连上当前AP的时间（us），0表示未连接
+    esp_ip4_addr_t ip;                      // 当前IP地址，未获取IP为0
+    esp_ip4_addr_t gw;                      // 当前网关
+    uint32_t reconnect_count;               // 初始化以来自动重连的次数
+    uint32_t time_to_ip_ms;                 // 最近一次从发起连接到获取IP的耗时
+    xn_wifi_lease_t lease;                  // 目标网络缓存的AP和租约（修改时持有snapshot_lock）
+    bool has_lease;                         // lease是否有效
+    bool using_hint;                        // 当前连接按缓存的BSSID/信道直连
+    bool static_ip;                         // 正在使用缓存的地址（DHCP客户端已停止）
+    uint32_t lease_fresh_s;                 // 调用者给出的租约距T1秒数，0表示按系统时间判断
+    int64_t lease_t1;                       // 当前地址到达T1的时间（us），0表示未知
+#if CONFIG_XN_BLUFI_LEASE_STATIC_IP
+    esp_ping_handle_t ping;                 // 网关校验会话
+    uint32_t renew_s;                       // 校验通过后距T1的秒数
+    esp_timer_handle_t renew_timer;         // 到T1时切回DHCP
+#endif
+    xn_wifi_cred_t cred;                    // 当前连接的凭据（修改时持有snapshot_lock，供其他任务读取）
+    xn_wifi_profile_id_t profile_id;        // 当前档位（修改时持有snapshot_lock）
+    xn_wifi_profile_t profile;              // 当前档位参数（修改时持有snapshot_lock）
+#if CONFIG_XN_BLUFI_ROAMING
+    bool roam_scanning;                     // 漫游扫描进行中
+    bool scan_deferred;                     // 漫游扫描期间收到的扫描请求，漫游扫描结束后执行
+    bool roam_waiting;                      // 已请求邻居报告/BSS切换引导，等待AP回复
+    bool roam_pending;                      // 已为切换AP主动断开，等待连接目标AP
+    int64_t roam_start;                     // 开始切换AP的时间（us），0表示不在切换中
+    uint8_t roam_from[6];                   // 切换前的AP
+    esp_timer_handle_t roam_timer;          // 邻居报告超时/评估冷却定时器
+    xn_wifi_roam_stats_t roam_stats;        // 漫游统计（修改时持有snapshot_lock）
+#endif
+#if CONFIG_XN_BLUFI_LINK_MONITOR
+    esp_timer_handle_t link_timer;          // 链路采样定时器
+    int32_t link_rssi_x16;                  // 平滑信号强度（1/16 dBm）
+    uint32_t link_beacon_seen;              // 上次采样时的beacon丢失计数
+    uint8_t link_clean;                     // 变差状态下连续满足恢复条件的采样次数
+    xn_wifi_link_info_t link;               // 链路质量（修改时持有snapshot_lock）
+#endif
+
+    /* 状态快照，工作任务写入，其他任务读取 */
+    portMUX_TYPE snapshot_lock;             // 快照自旋锁
+    xn_wifi_snapshot_t snapshot;            // 状态快照
+    
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    /* 静态分配模式下的内核对象和缓冲区 */
+    StaticEventGroup_t event_group_buf;
+    StaticQueue_t cmd_queue_buf;
+    uint8_t cmd_queue_storage[WIFI_CMD_QUEUE_LEN * sizeof(wifi_cmd_t)];
+    StaticTask_t worker_tcb;
+    StackType_t worker_stack[WIFI_WORKER_STACK_SIZE];
+    wifi_ap_record_t scan_records[WIFI_SCAN_MAX_AP];   // 扫描结果，只由工作任务使用
+#endif
 };
 
-/* 更新WiFi状态并触发回调 */
-static void update_status(xn_wifi_manager_t *manager, xn_wifi_status_t new_status)
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+static xn_wifi_manager_t s_manager;         // 静态分配模式下唯一的实例
+static bool s_manager_in_use = false;
+#endif
+
+/* 发布状态快照（仅工作任务调用） */
+static void publish_snapshot(xn_wifi_manager_t *manager)
+{
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    manager->snapshot.status = (xn_wifi_status_t)atomic_load(&manager->status);
+    manager->snapshot.is_connecting = manager->is_connecting;
+    manager->snapshot.retry_count = manager->retry_count;
+    memcpy(manager->snapshot.ssid, manager->wifi_config.sta.ssid, sizeof(manager->wifi_config.sta.ssid));
+    manager->snapshot.ssid[sizeof(manager->snapshot.ssid) - 1] = '\0';
+    manager->snapshot.time_to_ip_ms = manager->time_to_ip_ms;
+    manager->snapshot.ip_from_lease = manager->static_ip;
+    memcpy(manager->snapshot.bssid, manager->bssid, sizeof(manager->bssid));
+    manager->snapshot.channel = manager->channel;
+    manager->snapshot.authmode = manager->authmode;
+    manager->snapshot.ip = manager->ip.addr;
+    manager->snapshot.gw = manager->gw.addr;
+    manager->snapshot.connected_at = manager->connected_at;
+    manager->snapshot.reconnect_count = manager->reconnect_count;
+#if CONFIG_XN_BLUFI_LINK_MONITOR
+    xn_wifi_status_t status = (xn_wifi_status_t)atomic_load(&manager->status);
+    bool linked = status == XN_WIFI_CONNECTED || status == XN_WIFI_GOT_IP;
+    manager->snapshot.rssi = linked ? manager->link.rssi_avg : 0;
+    manager->snapshot.link_degraded = linked && manager->link.degraded;
+#endif
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+}
+
+/* 向订阅者发布事件（仅工作任务调用，无锁、不阻塞） */
+static void publish_event(xn_wifi_manager_t *manager, xn_wifi_event_t event)
+{
+    uint32_t event_bit = XN_WIFI_EVENT_MASK(event);
+    
+    for (int i = 0; i < XN_WIFI_MAX_SUBSCRIBERS; i++) {
+        wifi_subscriber_t *sub = &manager->subscribers[i];
+        
+        // 先登记再检查状态：取消订阅先改状态再等登记清零，两者之一必然看到对方
+        atomic_fetch_add(&sub->inflight, 1);
+        unsigned int state = atomic_load(&sub->state);
+        if ((state & SUB_STATE_MASK) != SUB_STATE_ACTIVE) {
+            atomic_fetch_sub(&sub->inflight, 1);
+            continue;
+        }
+        
+        if (sub->event_mask & event_bit) {
+            BaseType_t sent;
+            if (sub->callback) {
+                sub_event_t item = { .event = event, .state = state };
+                sent = xQueueSend(sub->cb_queue, &item, 0);
+            } else {
+                sent = xQueueSend(sub->queue, &event, 0);
+            }
+            if (sent != pdTRUE) {
+                atomic_fetch_add_explicit(&sub->dropped, 1, memory_order_relaxed);
+            }
+        }
+        atomic_fetch_sub_explicit(&sub->inflight, 1, memory_order_release);
+    }
+}
+
+/* 回调投递任务：按顺序执行一个槽位的回调 */
+static void subscriber_task(void *param)
+{
+    wifi_subscriber_t *sub = (wifi_subscriber_t *)param;
+    sub_event_t item;
+    
+    while (1) {
+        if (xQueueReceive(sub->cb_queue, &item, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (item.state == 0) {
+            break;
+        }
+        
+        // 与发布者相同的登记方式；槽位已取消或被重新占用（代数不同）时丢弃
+        atomic_fetch_add(&sub->inflight, 1);
+        if (atomic_load(&sub->state) == item.state) {
+            sub->callback(item.event, sub->user_ctx);
+        }
+        atomic_fetch_sub_explicit(&sub->inflight, 1, memory_order_release);
+    }
+    
+    atomic_store(&sub->cb_exited, true);
+    vTaskDelete(NULL);
+}
+
+/* 创建槽位的回调投递队列和任务（已有时复用） */
+static esp_err_t subscriber_task_start(wifi_subscriber_t *sub, int index)
+{
+    if (sub->cb_task) {
+        return ESP_OK;
+    }
+    
+    char name[16];
+    snprintf(name, sizeof(name), "xn_wifi_sub%d", index);
+    atomic_store(&sub->cb_exited, false);
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    sub->cb_queue = xQueueCreateStatic(SUB_QUEUE_LEN, sizeof(sub_event_t),
+                                       sub->cb_queue_storage, &sub->cb_queue_buf);
+    sub->cb_task = xTaskCreateStaticPinnedToCore(subscriber_task, name, SUB_TASK_STACK_SIZE, sub,
+                                                 SUB_TASK_PRIORITY, sub->cb_stack, &sub->cb_tcb,
+                                                 WIFI_WORKER_CORE);
+#else
+    sub->cb_queue = xQueueCreate(SUB_QUEUE_LEN, sizeof(sub_event_t));
+    if (sub->cb_queue != NULL &&
+        xTaskCreatePinnedToCore(subscriber_task, name, SUB_TASK_STACK_SIZE, sub,
+                                SUB_TASK_PRIORITY, &sub->cb_task, WIFI_WORKER_CORE) != pdPASS) {
+        sub->cb_task = NULL;
+    }
+#endif
+    if (sub->cb_task == NULL) {
+        ESP_LOGE(TAG, "创建订阅者[%d]的投递任务失败", index);
+#if !CONFIG_XN_BLUFI_STATIC_ALLOC
+        if (sub->cb_queue) {
+            vQueueDelete(sub->cb_queue);
+        }
+#endif
+        sub->cb_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/* 让槽位的回调投递任务退出并释放队列（销毁管理器时调用） */
+static void subscriber_task_stop(wifi_subscriber_t *sub)
+{
+    if (sub->cb_task == NULL) {
+        return;
+    }
+    
+    sub_event_t item = { .state = 0 };
+    xQueueSend(sub->cb_queue, &item, portMAX_DELAY);
+    while (!atomic_load(&sub->cb_exited)) {
+        vTaskDelay(1);
+    }
+    sub->cb_task = NULL;
+#if !CONFIG_XN_BLUFI_STATIC_ALLOC
+    vQueueDelete(sub->cb_queue);
+#endif
+    sub->cb_queue = NULL;
+}
+
+/*
+ * 等待槽位上进行中的发布和回调结束（槽位已不是ACTIVE状态）。
+ * 在工作任务中调用时发布者就是自己；在该槽位的投递任务中调用时（回调里取消/重新订阅）
+ * 正在执行的回调就是调用者，返回后不再访问槽位字段，都不需要等待
+ */
+static void wait_subscriber_quiescent(xn_wifi_manager_t *manager, wifi_subscriber_t *sub)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (self == manager->worker_task || (sub->cb_task != NULL && self == sub->cb_task)) {
+        return;
+    }
+    while (atomic_load_explicit(&sub->inflight, memory_order_acquire) != 0) {
+        vTaskDelay(1);
+    }
+}
+
+/* 根据连接状态同步事件组，唤醒等待连接变化的任务 */
+static void sync_status_bits(xn_wifi_manager_t *manager, xn_wifi_status_t status)
+{
+    switch (status) {
+        case XN_WIFI_GOT_IP:
+            xEventGroupClearBits(manager->event_group, WIFI_DISCONNECTED_BIT);
+            xEventGroupSetBits(manager->event_group, WIFI_CONNECTED_BIT);
+            break;
+        case XN_WIFI_DISCONNECTED:
+            xEventGroupClearBits(manager->event_group, WIFI_CONNECTED_BIT);
+            xEventGroupSetBits(manager->event_group, WIFI_DISCONNECTED_BIT);
+            break;
+        default:
+            xEventGroupClearBits(manager->event_group, WIFI_CONNECTED_BIT | WIFI_DISCONNECTED_BIT);
+            break;
+    }
+}
+
+/* 更新WiFi状态并触发回调（仅工作任务调用） */
+static void update_status(xn_wifi_manager_t *manager, xn_wifi_status_t new_status)
+{
+    xn_wifi_status_t old_status = (xn_wifi_status_t)atomic_exchange(&manager->status, new_status);
+    if (old_status != new_status) {
+        publish_snapshot(manager);
+        sync_status_bits(manager, new_status);
+        ESP_LOGI(TAG, "WiFi状态变化: %d", new_status);
+        if (manager->status_callback) {
+            manager->status_callback(new_status);
+        }
+        publish_event(manager, (xn_wifi_event_t)new_status);
+    }
+}
+
+/* 占用一个空闲订阅者槽位 */
+static esp_err_t add_subscriber(xn_wifi_manager_t *manager, xn_wifi_event_cb_t callback,
+                                void *user_ctx, QueueHandle_t queue,
+                                uint32_t event_mask, int *sub_id)
+{
+    for (int i = 0; i < XN_WIFI_MAX_SUBSCRIBERS; i++) {
+        wifi_subscriber_t *sub = &manager->subscribers[i];
+        
+        unsigned int state = atomic_load(&sub->state);
+        if ((state & SUB_STATE_MASK) != SUB_STATE_FREE) {
+            continue;
+        }
+        
+        unsigned int claimed = ((state & ~SUB_STATE_MASK) + SUB_GEN_INC) | SUB_STATE_CLAIMED;
+        if (!atomic_compare_exchange_strong(&sub->state, &state, claimed)) {
+            continue;
+        }
+        
+        // 刚取消的订阅可能还在投递，等它结束后再改写槽位
+        wait_subscriber_quiescent(manager, sub);
+        if (callback && subscriber_task_start(sub, i) != ESP_OK) {
+            atomic_store(&sub->state, claimed & ~SUB_STATE_MASK);
+            return ESP_ERR_NO_MEM;
+        }
+        sub->event_mask = event_mask;
+        sub->callback = callback;
+        sub->user_ctx = user_ctx;
+        sub->queue = queue;
+        atomic_store_explicit(&sub->dropped, 0, memory_order_relaxed);
+        atomic_store_explicit(&sub->state, (claimed & ~SUB_STATE_MASK) | SUB_STATE_ACTIVE,
+                              memory_order_release);
+        
+        if (sub_id) {
+            *sub_id = i;
+        }
+        ESP_LOGI(TAG, "新增事件订阅者[%d]，掩码: 0x%08lx", i, (unsigned long)event_mask);
+        return ESP_OK;
+    }
+    
+    ESP_LOGE(TAG, "订阅者表已满");
+    return ESP_ERR_NO_MEM;
+}
+
+/* 投递命令到工作任务 */
+static esp_err_t post_cmd(xn_wifi_manager_t *manager, const wifi_cmd_t *cmd)
+{
+    if (manager->cmd_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xQueueSend(manager->cmd_queue, cmd, pdMS_TO_TICKS(WIFI_CMD_POST_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "命令队列已满，丢弃命令: %d", cmd->type);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+/*
+ * 取出扫描结果并释放驱动中的列表，没有结果时返回NULL。
+ * 静态分配模式下使用管理器内的缓冲区，只保留信号最强的WIFI_SCAN_MAX_AP个
+ */
+static wifi_ap_record_t *scan_records_get(xn_wifi_manager_t *manager, uint16_t *ap_count)
+{
+    esp_wifi_scan_get_ap_num(ap_count);
+    if (*ap_count == 0) {
+        return NULL;
+    }
+    
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    if (*ap_count > WIFI_SCAN_MAX_AP) {
+        *ap_count = WIFI_SCAN_MAX_AP;
+    }
+    wifi_ap_record_t *ap_list = manager->scan_records;
+#else
+    wifi_ap_record_t *ap_list = malloc(sizeof(wifi_ap_record_t) * *ap_count);
+    if (ap_list == NULL) {
+        ESP_LOGE(TAG, "分配内存失败");
+        esp_wifi_clear_ap_list();
+        *ap_count = 0;
+        return NULL;
+    }
+#endif
+
+    esp_wifi_scan_get_ap_records(ap_count, ap_list);
+    return ap_list;
+}
+
+/* 归还scan_records_get取出的扫描结果 */
+static void scan_records_put(xn_wifi_manager_t *manager, wifi_ap_record_t *ap_list)
+{
+#if !CONFIG_XN_BLUFI_STATIC_ALLOC
+    free(ap_list);
+#endif
+}
+
+/* 处理扫描完成 */
+static void handle_scan_done(xn_wifi_manager_t *manager)
+{
+    xn_wifi_scan_done_cb_t callback = manager->scan_callback;
+    manager->scan_callback = NULL;
+    
+    uint16_t ap_count = 0;
+    wifi_ap_record_t *ap_list = scan_records_get(manager, &ap_count);
+    if (ap_list == NULL) {
+        ESP_LOGW(TAG, "未扫描到WiFi");
+        if (callback) {
+            callback(0, NULL);
+        }
+        return;
+    }
+    
+    ESP_LOGI(TAG, "扫描到%d个WiFi", ap_count);
+    
+    if (callback) {
+        callback(ap_count, ap_list);
+    }
+    
+    scan_records_put(manager, ap_list);
+}
+
+/* 开始扫描，结果交给scan_callback */
+static void start_scan(xn_wifi_manager_t *manager)
+{
+    wifi_scan_config_t scan_config = {
+        .ssid = NULL,
+        .bssid = NULL,
+        .channel = 0,
+        .show_hidden = false
+    };
+    
+    ESP_LOGI(TAG, "开始扫描WiFi");
+    esp_err_t ret = esp_wifi_scan_start(&scan_config, false);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "启动扫描失败: %s", esp_err_to_name(ret));
+        xn_wifi_scan_done_cb_t callback = manager->scan_callback;
+        manager->scan_callback = NULL;
+        if (callback) {
+            callback(0, NULL);
+        }
+        xEventGroupSetBits(manager->event_group, WIFI_SCAN_DONE_BIT);
+    }
+}
+
+/*
+ * 由当前凭据生成STA配置，use_pmk为true时以64位十六进制PSK形式下发PMK，驱动跳过PBKDF2；
+ * use_hint为true时直接连接租约记录中的BSSID和信道，省去全信道扫描
+ */
+static void build_sta_config(xn_wifi_manager_t *manager, bool use_pmk, bool use_hint)
+{
+    static const char hex[] = "0123456789abcdef";
+    const xn_wifi_cred_t *cred = &manager->cred;
+    
+    // 按长度复制：32字节SSID/64字节PSK不以'\0'结尾，SSID可含'\0'
+    memset(&manager->wifi_config, 0, sizeof(wifi_config_t));
+    memcpy(manager->wifi_config.sta.ssid, cred->ssid, cred->ssid_len);
+    if (use_pmk) {
+        for (int i = 0; i < XN_WIFI_PMK_LEN; i++) {
+            manager->wifi_config.sta.password[i * 2] = hex[cred->pmk[i] >> 4];
+            manager->wifi_config.sta.password[i * 2 + 1] = hex[cred->pmk[i] & 0x0F];
+        }
+    } else {
+        memcpy(manager->wifi_config.sta.password, cred->password, cred->password_len);
+    }
+    manager->wifi_config.sta.listen_interval = manager->profile.listen_interval;
+#if CONFIG_XN_BLUFI_ROAMING
+    // 接受AP的邻居报告（11k）和BSS切换引导（11v），AP支持时切换走快速BSS切换（11r）
+    manager->wifi_config.sta.rm_enabled = 1;
+    manager->wifi_config.sta.btm_enabled = 1;
+    manager->wifi_config.sta.ft_enabled = 1;
+#endif
+    if (use_hint) {
+        manager->wifi_config.sta.bssid_set = true;
+        memcpy(manager->wifi_config.sta.bssid, manager->lease.bssid, sizeof(manager->lease.bssid));
+        manager->wifi_config.sta.channel = manager->lease.channel;
+    }
+    manager->using_pmk = use_pmk;
+    manager->using_hint = use_hint;
+}
+
+/* 设置目标网络的AP和租约，调用者没有给出时读取NVS中的缓存 */
+static void lease_prepare(xn_wifi_manager_t *manager, const xn_wifi_lease_t *given, uint32_t fresh_s)
+{
+    xn_wifi_lease_t lease = {0};
+    bool has_lease = false;
+    
+    if (given) {
+        lease = *given;
+        has_lease = lease.channel != 0;
+    }
+#if CONFIG_XN_BLUFI_LEASE_CACHE
+    else {
+        has_lease = xn_wifi_lease_get(manager->cred.ssid, manager->cred.ssid_len, &lease) == ESP_OK &&
+                    lease.channel != 0;
+    }
+#endif
+
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    manager->lease = lease;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    manager->has_lease = has_lease;
+    manager->lease_fresh_s = fresh_s;
+    manager->lease_t1 = 0;
+}
+
+/* 读取DHCP租期的参数和结果 */
+typedef struct {
+    esp_netif_t *netif;
+    uint32_t lease_s;
+} lease_dhcp_read_t;
+
+/* 读取lwIP DHCP客户端的租期（esp_netif_tcpip_exec()回调，在TCP/IP任务中执行） */
+static esp_err_t lease_dhcp_read(void *ctx)
+{
+    lease_dhcp_read_t *read = (lease_dhcp_read_t *)ctx;
+    struct netif *lwip_netif = esp_netif_get_netif_impl(read->netif);
+    struct dhcp *dhcp = lwip_netif ? netif_dhcp_data(lwip_netif) : NULL;
+    read->lease_s = dhcp ? dhcp->offered_t0_lease : 0;
+    return ESP_OK;
+}
+
+/* 通过DHCP获取IP后记录租约（开启租约缓存时同时写入NVS） */
+static void lease_record(xn_wifi_manager_t *manager, const esp_netif_ip_info_t *ip_info)
+{
+    if (manager->static_ip || manager->cred.ssid_len == 0) {
+        return;
+    }
+    
+    xn_wifi_lease_t lease = {0};
+    memcpy(lease.bssid, manager->bssid, sizeof(lease.bssid));
+    lease.channel = manager->channel;
+    lease.ip = ip_info->ip.addr;
+    lease.netmask = ip_info->netmask.addr;
+    lease.gw = ip_info->gw.addr;
+    
+    esp_netif_dns_info_t dns;
+    if (esp_netif_get_dns_info(manager->netif, ESP_NETIF_DNS_MAIN, &dns) == ESP_OK &&
+        dns.ip.type == ESP_IPADDR_TYPE_V4) {
+        lease.dns = dns.ip.u_addr.ip4.addr;
+    }
+    
+    // esp_netif不导出租期，只能读lwIP DHCP客户端的字段；DHCP状态归TCP/IP任务所有，
+    // 续租时会被改写，因此切到TCP/IP任务中读取
+    lease_dhcp_read_t read = { .netif = manager->netif };
+    if (esp_netif_tcpip_exec(lease_dhcp_read, &read) == ESP_OK) {
+        lease.lease_s = read.lease_s;
+    }
+    lease.obtained_at = xn_wifi_lease_now();
+    
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    manager->lease = lease;
+    manager->lease_t1 = lease.lease_s ? esp_timer_get_time() + (int64_t)lease.lease_s * 500000 : 0;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    manager->has_lease = true;
+#if CONFIG_XN_BLUFI_LEASE_CACHE
+    xn_wifi_lease_put(manager->cred.ssid, manager->cred.ssid_len, &lease);
+#endif
+}
+
+#if CONFIG_XN_BLUFI_LEASE_STATIC_IP
+/* 网关校验结束（ping任务中调用），结果交给工作任务处理 */
+static void lease_ping_end(esp_ping_handle_t hdl, void *args)
+{
+    xn_wifi_manager_t *manager = (xn_wifi_manager_t *)args;
+    uint32_t received = 0;
+    esp_ping_get_profile(hdl, ESP_PING_PROF_REPLY, &received, sizeof(received));
+    
+    wifi_cmd_t cmd = { .type = WIFI_CMD_LEASE_VERIFIED, .verified = received > 0 };
+    post_cmd(manager, &cmd);
+}
+
+/* 静态IP到达T1（esp_timer任务中调用） */
+static void lease_renew_timer_cb(void *arg)
+{
+    wifi_cmd_t cmd = { .type = WIFI_CMD_LEASE_RENEW };
+    post_cmd((xn_wifi_manager_t *)arg, &cmd);
+}
+
+/* 已连接到租约记录中的AP且租约未过T1时，直接使用缓存的地址，随后ping网关校验 */
+static void lease_apply_static(xn_wifi_manager_t *manager)
+{
+    uint32_t remaining_s = manager->lease_fresh_s;
+    if (!manager->has_lease || manager->static_ip ||
+        memcmp(manager->bssid, manager->lease.bssid, sizeof(manager->bssid)) != 0 ||
+        (remaining_s == 0 && !xn_wifi_lease_is_fresh(&manager->lease, &remaining_s))) {
+        return;
+    }
+    
+    esp_netif_ip_info_t ip_info = {
+        .ip.addr = manager->lease.ip,
+        .netmask.addr = manager->lease.netmask,
+        .gw.addr = manager->lease.gw,
+    };
+    esp_netif_dhcpc_stop(manager->netif);
+    if (esp_netif_set_ip_info(manager->netif, &ip_info) != ESP_OK) {
+        esp_netif_dhcpc_start(manager->netif);
+        return;
+    }
+    if (manager->lease.dns) {
+        esp_netif_dns_info_t dns = { .ip.type = ESP_IPADDR_TYPE_V4 };
+        dns.ip.u_addr.ip4.addr = manager->lease.dns;
+        esp_netif_set_dns_info(manager->netif, ESP_NETIF_DNS_MAIN, &dns);
+    }
+    manager->static_ip = true;
+    manager->renew_s = remaining_s;
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    manager->lease_t1 = esp_timer_get_time() + (int64_t)remaining_s * 1000000;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    ESP_LOGI(TAG, "使用缓存的地址 " IPSTR "，校验网关中", IP2STR(&ip_info.ip));
+    
+    esp_ping_config_t config = ESP_PING_DEFAULT_CONFIG();
+    ip_addr_set_ip4_u32(&config.target_addr, manager->lease.gw);
+    config.count = LEASE_VERIFY_PING_COUNT;
+    config.interval_ms = LEASE_VERIFY_PING_TIMEOUT_MS;
+    config.timeout_ms = LEASE_VERIFY_PING_TIMEOUT_MS;
+    esp_ping_callbacks_t cbs = {
+        .cb_args = manager,
+        .on_ping_end = lease_ping_end,
+    };
+    if (esp_ping_new_session(&config, &cbs, &manager->ping) != ESP_OK ||
+        esp_ping_start(manager->ping) != ESP_OK) {
+        // 无法校验就不冒地址冲突的风险，走正常DHCP
+        if (manager->ping) {
+            esp_ping_delete_session(manager->ping);
+            manager->ping = NULL;
+        }
+        manager->static_ip = false;
+        esp_netif_dhcpc_start(manager->netif);
+    }
+}
+#endif
+
+/* 停止使用缓存的地址，恢复DHCP客户端 */
+static void lease_stop_static(xn_wifi_manager_t *manager)
+{
+#if CONFIG_XN_BLUFI_LEASE_STATIC_IP
+    if (manager->ping) {
+        esp_ping_stop(manager->ping);
+        esp_ping_delete_session(manager->ping);
+        manager->ping = NULL;
+    }
+    if (manager->renew_timer) {
+        esp_timer_stop(manager->renew_timer);
+    }
+    if (manager->static_ip) {
+        manager->static_ip = false;
+        esp_netif_dhcpc_start(manager->netif);
+    }
+#endif
+}
+
+/* 应用档位的协议和带宽（esp_wifi_start之前或运行时，下次关联生效） */
+static void profile_apply_link(xn_wifi_manager_t *manager)
+{
+    esp_err_t ret = esp_wifi_set_protocol(WIFI_IF_STA, manager->profile.protocol);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "设置WiFi协议失败: %s", esp_err_to_name(ret));
+    }
+    ret = esp_wifi_set_bandwidth(WIFI_IF_STA, manager->profile.bandwidth);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "设置WiFi带宽失败: %s", esp_err_to_name(ret));
+    }
+}
+
+/* 应用档位的省电模式和发射功率（esp_wifi_start之后，立即生效） */
+static void profile_apply_power(xn_wifi_manager_t *manager)
+{
+    esp_err_t ret = esp_wifi_set_ps(manager->profile.ps_type);
+    if (ret != ESP_OK && manager->profile.ps_type == WIFI_PS_NONE) {
+        // 与蓝牙共存时不允许关闭Modem-sleep
+        ESP_LOGW(TAG, "无法关闭省电模式（蓝牙共存中），改用MIN_MODEM");
+        ret = esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "设置省电模式失败: %s", esp_err_to_name(ret));
+    }
+    
+    int8_t tx_power = manager->profile.max_tx_power ? manager->profile.max_tx_power : TX_POWER_MAX;
+    ret = esp_wifi_set_max_tx_power(tx_power);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "设置发射功率失败: %s", esp_err_to_name(ret));
+    }
+}
+
+#if CONFIG_XN_BLUFI_ROAMING
+/* 漫游定时器到期（esp_timer任务中调用） */
+static void roam_timer_cb(void *arg)
+{
+    wifi_cmd_t cmd = { .type = WIFI_CMD_ROAM_TIMER };
+    post_cmd((xn_wifi_manager_t *)arg, &cmd);
+}
+
+/* 重新启动漫游定时器 */
+static void roam_timer_restart(xn_wifi_manager_t *manager, int64_t timeout_us)
+{
+    esp_timer_stop(manager->roam_timer);
+    esp_timer_start_once(manager->roam_timer, (uint64_t)timeout_us);
+}
+
+/* 本轮评估结束，冷却后重新设置门限，信号仍低于门限时驱动会再次上报 */
+static void roam_finish_eval(xn_wifi_manager_t *manager)
+{
+    manager->roam_waiting = false;
+    roam_timer_restart(manager, ROAM_COOLDOWN_US);
+}
+
+/* 从邻居报告中取出邻居AP所在的2.4GHz信道（事件任务中调用） */
+static uint16_t roam_parse_neighbors(const wifi_event_neighbor_report_t *event)
+{
+    uint16_t channels = 0;
+    const uint8_t *pos = event->report;
+    size_t len = event->report_len;
+    
+    while (len >= 2) {
+        uint8_t id = pos[0];
+        uint8_t elen = pos[1];
+        if ((size_t)elen + 2 > len) {
+            break;
+        }
+        if (id == WLAN_EID_NEIGHBOR_REPORT && elen >= NEIGHBOR_REPORT_MIN_LEN) {
+            uint8_t channel = pos[2 + 11];  // BSSID、BSSID信息、操作类别之后
+            if (channel >= 1 && channel <= 14) {
+                channels |= 1u << channel;
+            }
+        }
+        pos += 2 + elen;
+        len -= 2 + elen;
+    }
+    return channels;
+}
+
+/* 扫描同一SSID的AP，channel为0时扫描全部信道 */
+static void roam_start_scan(xn_wifi_manager_t *manager, uint8_t channel)
+{
+    // 用户扫描进行中或排队中，放弃本轮评估
+    if (!(xEventGroupGetBits(manager->event_group) & WIFI_SCAN_DONE_BIT)) {
+        roam_finish_eval(manager);
+        return;
+    }
+    
+    wifi_scan_config_t scan_config = {
+        .ssid = manager->cred.ssid,
+        .bssid = NULL,
+        .channel = channel,
+        .show_hidden = false
+    };
+    esp_err_t ret = esp_wifi_scan_start(&scan_config, false);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "启动漫游扫描失败: %s", esp_err_to_name(ret));
+        roam_finish_eval(manager);
+        return;
+    }
+    manager->roam_scanning = true;
+    ESP_LOGI(TAG, "漫游扫描，信道: %d（0为全部）", channel);
+}
+
+/* 信号低于门限：请求AP引导（11v）和邻居报告（11k），AP都不支持时直接扫描 */
+static void roam_evaluate(xn_wifi_manager_t *manager, int8_t rssi)
+{
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    manager->roam_stats.rssi_low_count++;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    
+    // 评估进行中的，结束时会重新设置门限；未获取IP的，连上后会重新设置门限
+    if (atomic_load(&manager->status) != XN_WIFI_GOT_IP || manager->is_connecting ||
+        manager->roam_scanning || manager->roam_waiting) {
+        return;
+    }
+    ESP_LOGI(TAG, "信号%d dBm低于漫游门限，评估同一网络的其他AP", rssi);
+    
+    // AP回复BSS切换请求后由驱动直接切换，AP支持11r时走快速BSS切换
+    bool waiting = false;
+    if (esp_wnm_is_btm_supported_connection() &&
+        esp_wnm_send_bss_transition_mgmt_query(REASON_RSSI, NULL, 0) == 0) {
+        portENTER_CRITICAL(&manager->snapshot_lock);
+        manager->roam_stats.btm_queries++;
+        portEXIT_CRITICAL(&manager->snapshot_lock);
+        waiting = true;
+    }
+    
+    // 邻居报告给出同一网络其他AP的信道，可以只扫这些信道
+    if (esp_rrm_is_rrm_supported_connection() && esp_rrm_send_neighbor_report_request() == 0) {
+        waiting = true;
+    }
+    
+    if (waiting) {
+        manager->roam_waiting = true;
+        roam_timer_restart(manager, ROAM_NEIGHBOR_TIMEOUT_US);
+    } else {
+        roam_start_scan(manager, 0);
+    }
+}
+
+/* 收到邻居报告：邻居都在同一信道时只扫该信道，否则全信道扫描 */
+static void roam_on_neighbors(xn_wifi_manager_t *manager, uint16_t channels)
+{
+    if (!manager->roam_waiting) {
+        return;     // 已超时或已切换
+    }
+    manager->roam_waiting = false;
+    esp_timer_stop(manager->roam_timer);
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    manager->roam_stats.neighbor_reports++;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    
+    if (channels == 0) {
+        ESP_LOGI(TAG, "AP报告没有邻居");
+        roam_finish_eval(manager);
+        return;
+    }
+    roam_start_scan(manager, (channels & (channels - 1)) == 0 ? __builtin_ctz(channels) : 0);
+}
+
+/* 漫游定时器到期：等待AP回复超时则扫描，冷却结束则重新设置门限 */
+static void roam_on_timer(xn_wifi_manager_t *manager)
+{
+    if (atomic_load(&manager->status) != XN_WIFI_GOT_IP || manager->is_connecting) {
+        manager->roam_waiting = false;
+        return;
+    }
+    
+    if (manager->roam_waiting) {
+        manager->roam_waiting = false;
+        roam_start_scan(manager, 0);
+    } else {
+        esp_wifi_set_rssi_threshold(ROAM_RSSI_THRESHOLD);
+    }
+}
+
+/* 切换到目标AP：断开后按目标BSSID和信道直连，连不上时退回扫描后连接 */
+static void roam_to(xn_wifi_manager_t *manager, const wifi_ap_record_t *target, int8_t rssi)
+{
+    ESP_LOGI(TAG, "切换到AP " MACSTR "，信道%d，信号%d dBm -> %d dBm",
+             MAC2STR(target->bssid), target->primary, rssi, target->rssi);
+    
+    manager->roam_start = esp_timer_get_time();
+    memcpy(manager->roam_from, manager->bssid, sizeof(manager->roam_from));
+    build_sta_config(manager, manager->cred.pmk_valid, false);
+    manager->wifi_config.sta.bssid_set = true;
+    memcpy(manager->wifi_config.sta.bssid, target->bssid, sizeof(manager->wifi_config.sta.bssid));
+    manager->wifi_config.sta.channel = target->primary;
+    manager->using_hint = true;
+    
+    manager->is_connecting = true;
+    manager->retry_count = 0;
+    manager->roam_pending = true;
+    manager->connect_start = manager->roam_start;
+    esp_wifi_disconnect();
+    lease_stop_static(manager);
+    esp_wifi_set_config(WIFI_IF_STA, &manager->wifi_config);
+}
+
+/* 漫游扫描完成：选出信号比当前AP强ROAM_RSSI_GAIN以上的同网络AP并切换 */
+static void roam_on_scan_done(xn_wifi_manager_t *manager)
+{
+    manager->roam_scanning = false;
+    
+    wifi_ap_record_t current = {0};
+    wifi_ap_record_t best = {0};
+    bool found = false;
+    uint16_t ap_count = 0;
+    wifi_ap_record_t *ap_list = scan_records_get(manager, &ap_count);
+    
+    if (ap_list) {
+        if (atomic_load(&manager->status) == XN_WIFI_GOT_IP && !manager->is_connecting &&
+            esp_wifi_sta_get_ap_info(&current) == ESP_OK) {
+            for (int i = 0; i < ap_count; i++) {
+                const wifi_ap_record_t *ap = &ap_list[i];
+                if (memcmp(ap->bssid, manager->bssid, sizeof(manager->bssid)) == 0 ||
+                    strnlen((const char *)ap->ssid, sizeof(ap->ssid)) != manager->cred.ssid_len ||
+                    memcmp(ap->ssid, manager->cred.ssid, manager->cred.ssid_len) != 0 ||
+                    ap->rssi < current.rssi + ROAM_RSSI_GAIN) {
+                    continue;
+                }
+                if (!found || ap->rssi > best.rssi) {
+                    best = *ap;
+                    found = true;
+                }
+            }
+        }
+        scan_records_put(manager, ap_list);
+    }
+    
+    if (found) {
+        roam_to(manager, &best, current.rssi);
+    } else {
+        ESP_LOGI(TAG, "没有明显更好的AP，保持当前连接");
+        roam_finish_eval(manager);
+    }
+    
+    if (manager->scan_deferred) {
+        manager->scan_deferred = false;
+        start_scan(manager);
+    }
+}
+
+/*
+ * 连接断开：返回true表示是切换AP时主动断开的。
+ * AP引导的切换由驱动执行，从旧连接断开开始计时
+ */
+static bool roam_on_disconnected(xn_wifi_manager_t *manager)
+{
+    if (manager->roam_pending) {
+        manager->roam_pending = false;
+        return true;
+    }
+    
+    xn_wifi_status_t status = (xn_wifi_status_t)atomic_load(&manager->status);
+    if (!manager->is_connecting && (status == XN_WIFI_CONNECTED || status == XN_WIFI_GOT_IP)) {
+        manager->roam_start = esp_timer_get_time();
+        memcpy(manager->roam_from, manager->bssid, sizeof(manager->roam_from));
+    }
+    return false;
+}
+
+/* 连上AP（manager->bssid已更新）：统计切换次数和耗时，设置信号门限开始监测 */
+static void roam_on_connected(xn_wifi_manager_t *manager)
+{
+    manager->roam_waiting = false;
+    esp_timer_stop(manager->roam_timer);
+    
+    if (manager->roam_start && memcmp(manager->bssid, manager->roam_from, sizeof(manager->bssid)) != 0) {
+        uint32_t latency_ms = (uint32_t)((esp_timer_get_time() - manager->roam_start) / 1000);
+        portENTER_CRITICAL(&manager->snapshot_lock);
+        manager->roam_stats.roam_count++;
+        manager->roam_stats.last_latency_ms = latency_ms;
+        manager->roam_stats.total_latency_ms += latency_ms;
+        if (latency_ms > manager->roam_stats.max_latency_ms) {
+            manager->roam_stats.max_latency_ms = latency_ms;
+        }
+        portEXIT_CRITICAL(&manager->snapshot_lock);
+        ESP_LOGI(TAG, "已切换到AP " MACSTR "，耗时%lu ms", MAC2STR(manager->bssid), (unsigned long)latency_ms);
+    }
+    manager->roam_start = 0;
+    
+    esp_err_t ret = esp_wifi_set_rssi_threshold(ROAM_RSSI_THRESHOLD);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "设置漫游信号门限失败: %s", esp_err_to_name(ret));
+    }
+}
+
+/* 切换到目标AP失败，退回扫描后连接 */
+static void roam_on_failed(xn_wifi_manager_t *manager)
+{
+    if (manager->roam_start == 0) {
+        return;
+    }
+    manager->roam_start = 0;
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    manager->roam_stats.roam_failures++;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+}
+#endif
+
+#if CONFIG_XN_BLUFI_LINK_MONITOR
+/* 链路采样定时器（esp_timer任务中调用），队列满时跳过本次采样，不阻塞定时器任务 */
+static void link_timer_cb(void *arg)
+{
+    xn_wifi_manager_t *manager = (xn_wifi_manager_t *)arg;
+    wifi_cmd_t cmd = { .type = WIFI_CMD_LINK_SAMPLE };
+    xQueueSend(manager->cmd_queue, &cmd, 0);
+}
+
+/* 连上AP：复位本次连接的链路统计并开始采样 */
+static void link_start(xn_wifi_manager_t *manager)
+{
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    memset(&manager->link, 0, sizeof(manager->link));
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    manager->link_rssi_x16 = 0;
+    manager->link_beacon_seen = 0;
+    manager->link_clean = 0;
+    
+    esp_timer_stop(manager->link_timer);
+    esp_timer_start_periodic(manager->link_timer, LINK_SAMPLE_INTERVAL_US);
+}
+
+/* 连接断开：停止采样，变差状态随连接复位（断开事件本身已通知订阅者） */
+static void link_stop(xn_wifi_manager_t *manager)
+{
+    esp_timer_stop(manager->link_timer);
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    manager->link.degraded = false;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+}
+
+/* 采样一次：平滑信号强度，按迟滞判断链路变差/恢复 */
+static void link_sample(xn_wifi_manager_t *manager)
+{
+    xn_wifi_status_t status = (xn_wifi_status_t)atomic_load(&manager->status);
+    int rssi = 0;
+    if ((status != XN_WIFI_CONNECTED && status != XN_WIFI_GOT_IP) ||
+        esp_wifi_sta_get_rssi(&rssi) != ESP_OK) {
+        return;
+    }
+    wifi_phy_mode_t phymode = manager->link.phymode;
+    esp_wifi_sta_get_negotiated_phymode(&phymode);
+    
+    // 一阶低通：单次波动只计入1/4，持续变化约4次采样后跟上
+    if (manager->link.samples == 0) {
+        manager->link_rssi_x16 = rssi * 16;
+    } else {
+        manager->link_rssi_x16 += (rssi * 16 - manager->link_rssi_x16) >> LINK_RSSI_SMOOTH_SHIFT;
+    }
+    int8_t rssi_avg = (int8_t)(manager->link_rssi_x16 / 16);
+    
+    bool beacon_lost = manager->link.beacon_timeouts != manager->link_beacon_seen;
+    manager->link_beacon_seen = manager->link.beacon_timeouts;
+    
+    // 变差：低于门限或本周期丢失beacon；恢复：高于门限加迟滞，且连续多次采样无beacon丢失
+    bool degraded = manager->link.degraded;
+    if (!degraded) {
+        degraded = rssi_avg < LINK_DEGRADED_RSSI || beacon_lost;
+        manager->link_clean = 0;
+    } else if (!beacon_lost && rssi_avg >= LINK_DEGRADED_RSSI + LINK_HYSTERESIS) {
+        degraded = ++manager->link_clean < LINK_RECOVER_SAMPLES;
+    } else {
+        manager->link_clean = 0;
+    }
+    bool changed = degraded != manager->link.degraded;
+    
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    manager->link.rssi = (int8_t)rssi;
+    manager->link.rssi_avg = rssi_avg;
+    manager->link.phymode = phymode;
+    manager->link.samples++;
+    manager->link.degraded = degraded;
+    if (changed && degraded) {
+        manager->link.degraded_count++;
+    }
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    
+    if (changed) {
+        publish_snapshot(manager);
+        ESP_LOGW(TAG, "链路%s，信号%d dBm（平滑后%d dBm）%s", degraded ? "变差" : "恢复",
+                 rssi, rssi_avg, beacon_lost ? "，丢失beacon" : "");
+        publish_event(manager, degraded ? XN_WIFI_EVENT_LINK_DEGRADED : XN_WIFI_EVENT_LINK_RECOVERED);
+    }
+}
+#endif
+
+/* 在工作任务中执行命令 */
+static void handle_cmd(xn_wifi_manager_t *manager, wifi_cmd_t *cmd)
 {
-    if (manager->status != new_status) {
-        manager->status = new_status;
-        ESP_LOGI(TAG, "WiFi状态变化: %d", new_status);
-        if (manager->status_callback) {
-            manager->status_callback(new_status);
+    switch (cmd->type) {
+        case WIFI_CMD_CONNECT: {
+            // 设置WiFi配置，有预计算的PMK时优先使用
+            portENTER_CRITICAL(&manager->snapshot_lock);
+            manager->cred = cmd->connect.cred;
+            portEXIT_CRITICAL(&manager->snapshot_lock);
+            lease_prepare(manager, cmd->connect.has_lease ? &cmd->connect.lease : NULL,
+                          cmd->connect.fresh_s);
+            build_sta_config(manager, manager->cred.pmk_valid, manager->has_lease);
+            
+            // 断开当前连接，上一个网络的静态地址不能带到新网络；
+            // 旧连接（或正在进行的尝试）随后上报的DISCONNECTED不属于新的连接尝试
+            manager->disconnect_pending = manager->is_connecting ||
+                                          atomic_load(&manager->status) != XN_WIFI_DISCONNECTED;
+            esp_wifi_disconnect();
+            lease_stop_static(manager);
+#if CONFIG_XN_BLUFI_ROAMING
+            manager->roam_pending = false;
+            manager->roam_waiting = false;
+            manager->roam_start = 0;
+            esp_timer_stop(manager->roam_timer);
+#endif
+
+            // 设置新配置并连接
+            esp_err_t ret = esp_wifi_set_config(WIFI_IF_STA, &manager->wifi_config);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "设置WiFi配置失败: %s", esp_err_to_name(ret));
+                manager->is_connecting = false;
+                update_status(manager, XN_WIFI_DISCONNECTED);
+                break;
+            }
+            manager->is_connecting = true;
+            manager->retry_count = 0;
+            manager->connect_start = esp_timer_get_time();
+            update_status(manager, XN_WIFI_CONNECTING);
+            
+            ESP_LOGI(TAG, "开始连接WiFi: %.*s%s%s", manager->cred.ssid_len, (const char *)manager->cred.ssid,
+                     manager->using_pmk ? "（使用缓存的PMK）" : "",
+                     manager->using_hint ? "（直连上次的AP）" : "");
+            ret = esp_wifi_connect();
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "连接WiFi失败: %s", esp_err_to_name(ret));
+            }
+            break;
+        }
+        
+        case WIFI_CMD_DISCONNECT:
+            manager->is_connecting = false;
+            manager->disconnect_pending = false;
+            ESP_LOGI(TAG, "断开WiFi连接");
+            esp_wifi_disconnect();
+            lease_stop_static(manager);
+            break;
+            
+        case WIFI_CMD_SCAN:
+            manager->scan_callback = cmd->scan_callback;
+#if CONFIG_XN_BLUFI_ROAMING
+            if (manager->roam_scanning) {
+                manager->scan_deferred = true;  // 漫游扫描结束后再开始
+                break;
+            }
+#endif
+            start_scan(manager);
+            break;
+            
+        case WIFI_CMD_EVT_CONNECTED:
+            manager->authmode = cmd->connected.authmode;
+            memcpy(manager->bssid, cmd->connected.bssid, sizeof(manager->bssid));
+            manager->channel = cmd->connected.channel;
+            manager->connected_at = esp_timer_get_time();
+            manager->disconnect_pending = false;
+            // 获取IP之前仍算本次连接尝试：关联后、获取IP前断开按失败重试
+#if CONFIG_XN_BLUFI_ROAMING
+            roam_on_connected(manager);
+#endif
+#if CONFIG_XN_BLUFI_LINK_MONITOR
+            link_start(manager);
+#endif
+            update_status(manager, XN_WIFI_CONNECTED);
+#if CONFIG_XN_BLUFI_LEASE_STATIC_IP
+            lease_apply_static(manager);
+#endif
+            break;
+            
+        case WIFI_CMD_EVT_DISCONNECTED:
+            // 如果正在连接且未超过重试次数，则重连
+            lease_stop_static(manager);
+#if CONFIG_XN_BLUFI_LINK_MONITOR
+            link_stop(manager);
+#endif
+            // 发起新连接时主动断开旧连接产生的事件，新的尝试已经开始：
+            // 不计为失败，也不进入漫游的断开/失败统计
+            bool stale = manager->disconnect_pending && cmd->reason == WIFI_REASON_ASSOC_LEAVE;
+            manager->disconnect_pending = false;
+#if CONFIG_XN_BLUFI_ROAMING
+            bool roaming = !stale && roam_on_disconnected(manager);
+#endif
+            bool associated = manager->connected_at != 0;
+            manager->connected_at = 0;
+            manager->ip.addr = 0;
+            manager->gw.addr = 0;
+            memset(manager->bssid, 0, sizeof(manager->bssid));
+            manager->channel = 0;
+            if (stale) {
+                break;
+            }
+#if CONFIG_XN_BLUFI_ROAMING
+            if (roaming) {
+                // 切换AP时主动断开，直接连接目标AP
+                esp_wifi_connect();
+                update_status(manager, XN_WIFI_CONNECTING);
+                break;
+            }
+#endif
+            if (manager->is_connecting && manager->retry_count < MAX_RETRY_COUNT) {
+                // 本次尝试使用PMK连接失败（例如AP改为WPA3或缓存已过期），作废PMK改用口令重试；
+                // 直连上次的AP失败（AP离线或换了信道），改为正常扫描。
+                // 断开旧连接产生的事件已在上面忽略，不会走到这里；
+                // 已关联后才断开的（获取IP前被踢出），PMK和AP本身没有问题
+                if (!associated && (manager->using_pmk || manager->using_hint)) {
+                    if (manager->using_pmk) {
+                        ESP_LOGW(TAG, "使用缓存的PMK连接失败，改用口令重试");
+                        portENTER_CRITICAL(&manager->snapshot_lock);
+                        manager->cred.pmk_valid = false;
+                        portEXIT_CRITICAL(&manager->snapshot_lock);
+                    }
+                    if (manager->using_hint) {
+                        ESP_LOGW(TAG, "直连上次的AP失败，改为扫描后连接");
+#if CONFIG_XN_BLUFI_ROAMING
+                        roam_on_failed(manager);
+#endif
+                    }
+                    build_sta_config(manager, false, false);
+                    esp_wifi_set_config(WIFI_IF_STA, &manager->wifi_config);
+                }
+                esp_wifi_connect();
+                manager->retry_count++;
+                manager->reconnect_count++;
+                ESP_LOGI(TAG, "重连WiFi，第%d次", manager->retry_count);
+                update_status(manager, XN_WIFI_CONNECTING);
+            } else {
+                manager->is_connecting = false;
+                update_status(manager, XN_WIFI_DISCONNECTED);
+            }
+            break;
+            
+        case WIFI_CMD_EVT_SCAN_DONE:
+#if CONFIG_XN_BLUFI_ROAMING
+            if (manager->roam_scanning) {
+                roam_on_scan_done(manager);
+                break;
+            }
+#endif
+            handle_scan_done(manager);
+            xEventGroupSetBits(manager->event_group, WIFI_SCAN_DONE_BIT);
+            break;
+            
+        case WIFI_CMD_EVT_GOT_IP:
+            if (manager->connect_start) {
+                manager->time_to_ip_ms = (uint32_t)((esp_timer_get_time() - manager->connect_start) / 1000);
+                manager->connect_start = 0;
+                ESP_LOGI(TAG, "从发起连接到获取IP耗时%lu ms%s", (unsigned long)manager->time_to_ip_ms,
+                         manager->static_ip ? "（缓存的地址）" : "");
+            }
+            manager->is_connecting = false;
+            manager->retry_count = 0;
+            manager->ip = cmd->ip_info.ip;
+            manager->gw = cmd->ip_info.gw;
+            lease_record(manager, &cmd->ip_info);
+            update_status(manager, XN_WIFI_GOT_IP);
+            break;
+            
+#if CONFIG_XN_BLUFI_LEASE_STATIC_IP
+        case WIFI_CMD_LEASE_VERIFIED:
+            if (manager->ping == NULL) {
+                break;  // 校验期间已断开或换了网络
+            }
+            esp_ping_delete_session(manager->ping);
+            manager->ping = NULL;
+            if (cmd->verified) {
+                esp_timer_start_once(manager->renew_timer, (uint64_t)manager->renew_s * 1000000ULL);
+            } else if (manager->static_ip) {
+                // 网关不通，缓存的地址可能已失效，丢弃并重新走DHCP
+                ESP_LOGW(TAG, "缓存的地址校验失败，改用DHCP");
+                xn_wifi_lease_remove(manager->cred.ssid, manager->cred.ssid_len);
+                manager->has_lease = false;
+                lease_stop_static(manager);
+            }
+            break;
+            
+        case WIFI_CMD_LEASE_RENEW:
+            // 不在T1之后继续占用地址；重启DHCP客户端会短暂清空地址，地址通常保持不变
+            if (manager->static_ip) {
+                ESP_LOGI(TAG, "缓存的租约到达续约时间，切回DHCP");
+                lease_stop_static(manager);
+            }
+            break;
+#endif
+
+        case WIFI_CMD_SET_PROFILE:
+            portENTER_CRITICAL(&manager->snapshot_lock);
+            manager->profile_id = cmd->profile.id;
+            manager->profile = cmd->profile.config;
+            portEXIT_CRITICAL(&manager->snapshot_lock);
+            profile_apply_link(manager);
+            profile_apply_power(manager);
+            ESP_LOGI(TAG, "切换WiFi档位: %d（监听间隔、带宽、协议下次连接生效）", cmd->profile.id);
+            break;
+            
+#if CONFIG_XN_BLUFI_ROAMING
+        case WIFI_CMD_ROAM_RSSI_LOW:
+            roam_evaluate(manager, cmd->rssi);
+            break;
+            
+        case WIFI_CMD_ROAM_NEIGHBORS:
+            roam_on_neighbors(manager, cmd->channels);
+            break;
+            
+        case WIFI_CMD_ROAM_TIMER:
+            roam_on_timer(manager);
+            break;
+#endif
+
+#if CONFIG_XN_BLUFI_LINK_MONITOR
+        case WIFI_CMD_EVT_BEACON_TIMEOUT:
+            // 立即采样，丢失beacon时不等下一个采样周期
+            portENTER_CRITICAL(&manager->snapshot_lock);
+            manager->link.beacon_timeouts++;
+            portEXIT_CRITICAL(&manager->snapshot_lock);
+            link_sample(manager);
+            break;
+            
+        case WIFI_CMD_LINK_SAMPLE:
+            link_sample(manager);
+            break;
+#endif
+
+        default:
+            break;
+    }
+    
+    publish_snapshot(manager);
+}
+
+/* WiFi管理器工作任务 */
+static void wifi_worker_task(void *param)
+{
+    xn_wifi_manager_t *manager = (xn_wifi_manager_t *)param;
+    wifi_cmd_t cmd;
+    
+    ESP_LOGI(TAG, "WiFi管理器工作任务启动");
+    while (1) {
+        if (xQueueReceive(manager->cmd_queue, &cmd, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (cmd.type == WIFI_CMD_EXIT) {
+            break;
         }
+        handle_cmd(manager, &cmd);
     }
+    
+    xEventGroupSetBits(manager->event_group, WIFI_WORKER_EXIT_BIT);
+    vTaskDelete(NULL);
 }
 
-/* WiFi事件处理函数 */
+/* WiFi事件处理函数：只做转发，状态修改交给工作任务 */
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                int32_t event_id, void* event_data)
 {
     xn_wifi_manager_t *manager = (xn_wifi_manager_t *)arg;
+    wifi_cmd_t cmd = {0};
     
     if (event_base == WIFI_EVENT) {
         switch (event_id) {
             case WIFI_EVENT_STA_START:
                 ESP_LOGI(TAG, "WiFi已启动");
-                break;
+                return;
                 
             case WIFI_EVENT_STA_CONNECTED: {
                 wifi_event_sta_connected_t *event = (wifi_event_sta_connected_t*)event_data;
-                ESP_LOGI(TAG, "已连接到WiFi: %s", event->ssid);
-                update_status(manager, XN_WIFI_CONNECTED);
-                manager->is_connecting = false;
-                manager->retry_count = 0;
+                ESP_LOGI(TAG, "已连接到WiFi: %.*s", event->ssid_len, event->ssid);
+                cmd.type = WIFI_CMD_EVT_CONNECTED;
+                cmd.connected.authmode = event->authmode;
+                memcpy(cmd.connected.bssid, event->bssid, sizeof(cmd.connected.bssid));
+                cmd.connected.channel = event->channel;
                 break;
             }
             
             case WIFI_EVENT_STA_DISCONNECTED: {
                 wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t*)event_data;
                 ESP_LOGW(TAG, "WiFi断开，原因: %d", event->reason);
-                
-                // 如果正在连接且未超过重试次数，则重连
-                if (manager->is_connecting && manager->retry_count < MAX_RETRY_COUNT) {
-                    esp_wifi_connect();
-                    manager->retry_count++;
-                    ESP_LOGI(TAG, "重连WiFi，第%d次", manager->retry_count);
-                    update_status(manager, XN_WIFI_CONNECTING);
-                } else {
-                    manager->is_connecting = false;
-                    update_status(manager, XN_WIFI_DISCONNECTED);
-                }
-                xEventGroupClearBits(manager->event_group, WIFI_CONNECTED_BIT);
+                cmd.type = WIFI_CMD_EVT_DISCONNECTED;
+                cmd.reason = event->reason;
                 break;
             }
             
-            case WIFI_EVENT_SCAN_DONE: {
-                uint16_t ap_count = 0;
-                esp_wifi_scan_get_ap_num(&ap_count);
-                
-                if (ap_count == 0) {
-                    ESP_LOGW(TAG, "未扫描到WiFi");
-                    if (manager->scan_callback) {
-                        manager->scan_callback(0, NULL);
-                    }
-                    break;
-                }
-                
-                wifi_ap_record_t *ap_list = malloc(sizeof(wifi_ap_record_t) * ap_count);
-                if (ap_list == NULL) {
-                    ESP_LOGE(TAG, "分配内存失败");
-                    break;
-                }
-                
-                esp_wifi_scan_get_ap_records(&ap_count, ap_list);
-                ESP_LOGI(TAG, "扫描到%d个WiFi", ap_count);
-                
-                if (manager->scan_callback) {
-                    manager->scan_callback(ap_count, ap_list);
-                }
+            case WIFI_EVENT_SCAN_DONE:
+                cmd.type = WIFI_CMD_EVT_SCAN_DONE;
+                break;
                 
-                free(ap_list);
+#if CONFIG_XN_BLUFI_ROAMING
+            case WIFI_EVENT_STA_BSS_RSSI_LOW: {
+                wifi_event_bss_rssi_low_t *event = (wifi_event_bss_rssi_low_t*)event_data;
+                cmd.type = WIFI_CMD_ROAM_RSSI_LOW;
+                cmd.rssi = (int8_t)event->rssi;
                 break;
             }
+            
+            case WIFI_EVENT_STA_NEIGHBOR_REP:
+                cmd.type = WIFI_CMD_ROAM_NEIGHBORS;
+                cmd.channels = roam_parse_neighbors((wifi_event_neighbor_report_t*)event_data);
+                break;
+#endif
+
+#if CONFIG_XN_BLUFI_LINK_MONITOR
+            case WIFI_EVENT_STA_BEACON_TIMEOUT:
+                ESP_LOGW(TAG, "丢失beacon");
+                cmd.type = WIFI_CMD_EVT_BEACON_TIMEOUT;
+                break;
+#endif
+
+            default:
+                return;
         }
-    } else if (event_base == IP_EVENT) {
-        if (event_id == IP_EVENT_STA_GOT_IP) {
-            ip_event_got_ip_t *event = (ip_event_got_ip_t*)event_data;
-            ESP_LOGI(TAG, "获取到IP: " IPSTR, IP2STR(&event->ip_info.ip));
-            xEventGroupSetBits(manager->event_group, WIFI_CONNECTED_BIT);
-            update_status(manager, XN_WIFI_GOT_IP);
-        }
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t *event = (ip_event_got_ip_t*)event_data;
+        ESP_LOGI(TAG, "获取到IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        cmd.type = WIFI_CMD_EVT_GOT_IP;
+        cmd.ip_info = event->ip_info;
+    } else {
+        return;
     }
+    
+    post_cmd(manager, &cmd);
 }
 
 /* 创建WiFi管理器实例 */
 xn_wifi_manager_t* xn_wifi_manager_create(void)
 {
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    if (s_manager_in_use) {
+        ESP_LOGE(TAG, "静态分配模式下只支持一个实例");
+        return NULL;
+    }
+    s_manager_in_use = true;
+    xn_wifi_manager_t *manager = &s_manager;
+#else
     xn_wifi_manager_t *manager = malloc(sizeof(xn_wifi_manager_t));
     if (manager == NULL) {
         ESP_LOGE(TAG, "分配内存失败");
         return NULL;
     }
-    
+#endif
+
     memset(manager, 0, sizeof(xn_wifi_manager_t));
-    manager->status = XN_WIFI_DISCONNECTED;
+    atomic_init(&manager->status, XN_WIFI_DISCONNECTED);
+    portMUX_INITIALIZE(&manager->snapshot_lock);
+    manager->snapshot.status = XN_WIFI_DISCONNECTED;
+    manager->profile_id = WIFI_DEFAULT_PROFILE;
+    manager->profile = PRESET_PROFILES[WIFI_DEFAULT_PROFILE];
     
     ESP_LOGI(TAG, "WiFi管理器创建成功");
     return manager;
@@ -139,10 +1579,20 @@ xn_wifi_manager_t* xn_wifi_manager_create(void)
 void xn_wifi_manager_destroy(xn_wifi_manager_t *manager)
 {
     if (manager) {
+        for (int i = 0; i < XN_WIFI_MAX_SUBSCRIBERS; i++) {
+            subscriber_task_stop(&manager->subscribers[i]);
+        }
+        if (manager->cmd_queue) {
+            vQueueDelete(manager->cmd_queue);
+        }
         if (manager->event_group) {
             vEventGroupDelete(manager->event_group);
         }
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+        s_manager_in_use = false;
+#else
         free(manager);
+#endif
         ESP_LOGI(TAG, "WiFi管理器已销毁");
     }
 }
@@ -155,28 +1605,108 @@ esp_err_t xn_wifi_manager_init(xn_wifi_manager_t *manager)
     }
     
     // 创建事件组
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    manager->event_group = xEventGroupCreateStatic(&manager->event_group_buf);
+#else
     manager->event_group = xEventGroupCreate();
+#endif
     if (manager->event_group == NULL) {
         ESP_LOGE(TAG, "创建事件组失败");
         return ESP_FAIL;
     }
+    xEventGroupSetBits(manager->event_group, WIFI_DISCONNECTED_BIT | WIFI_SCAN_DONE_BIT);
+    
+    // 创建命令队列和工作任务
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    manager->cmd_queue = xQueueCreateStatic(WIFI_CMD_QUEUE_LEN, sizeof(wifi_cmd_t),
+                                            manager->cmd_queue_storage, &manager->cmd_queue_buf);
+#else
+    manager->cmd_queue = xQueueCreate(WIFI_CMD_QUEUE_LEN, sizeof(wifi_cmd_t));
+#endif
+    if (manager->cmd_queue == NULL) {
+        ESP_LOGE(TAG, "创建命令队列失败");
+        return ESP_FAIL;
+    }
     
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    manager->worker_task = xTaskCreateStaticPinnedToCore(wifi_worker_task, "xn_wifi_worker",
+                                                         WIFI_WORKER_STACK_SIZE, manager,
+                                                         WIFI_WORKER_PRIORITY, manager->worker_stack,
+                                                         &manager->worker_tcb, WIFI_WORKER_CORE);
+    if (manager->worker_task == NULL) {
+#else
+    if (xTaskCreatePinnedToCore(wifi_worker_task, "xn_wifi_worker", WIFI_WORKER_STACK_SIZE,
+                                manager, WIFI_WORKER_PRIORITY, &manager->worker_task,
+                                WIFI_WORKER_CORE) != pdPASS) {
+#endif
+        ESP_LOGE(TAG, "创建工作任务失败");
+        return ESP_FAIL;
+    }
+    
+#if CONFIG_XN_BLUFI_LEASE_STATIC_IP
+    const esp_timer_create_args_t timer_args = {
+        .callback = lease_renew_timer_cb,
+        .arg = manager,
+        .name = "xn_lease_renew",
+    };
+    if (esp_timer_create(&timer_args, &manager->renew_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "创建续约定时器失败");
+        return ESP_FAIL;
+    }
+#endif
+#if CONFIG_XN_BLUFI_ROAMING
+    const esp_timer_create_args_t roam_timer_args = {
+        .callback = roam_timer_cb,
+        .arg = manager,
+        .name = "xn_roam",
+    };
+    if (esp_timer_create(&roam_timer_args, &manager->roam_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "创建漫游定时器失败");
+        return ESP_FAIL;
+    }
+#endif
+#if CONFIG_XN_BLUFI_LINK_MONITOR
+    const esp_timer_create_args_t link_timer_args = {
+        .callback = link_timer_cb,
+        .arg = manager,
+        .name = "xn_link",
+    };
+    if (esp_timer_create(&link_timer_args, &manager->link_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "创建链路采样定时器失败");
+        return ESP_FAIL;
+    }
+#endif
+
     // 初始化网络接口
+    int64_t stage_start = esp_timer_get_time();
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
     manager->netif = esp_netif_create_default_wifi_sta();
     
     // 注册WiFi和IP事件处理函数
-    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, 
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID,
                                                &wifi_event_handler, manager));
     ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP,
                                                &wifi_event_handler, manager));
+    xn_boot_profile_record("netif_event_loop", stage_start);
     
     // 初始化WiFi
+    stage_start = esp_timer_get_time();
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+    esp_err_t ret = esp_wifi_init(&cfg);
+    if (ret != ESP_OK) {
+        // 驱动内存不足等可恢复的错误返回给调用者（并行初始化时还要等蓝牙任务汇合）
+        ESP_LOGE(TAG, "初始化WiFi驱动失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    profile_apply_link(manager);
+    xn_boot_profile_record("wifi_init", stage_start);
+    
+    stage_start = esp_timer_get_time();
     ESP_ERROR_CHECK(esp_wifi_start());
+    profile_apply_power(manager);
+    xn_boot_profile_record("wifi_start", stage_start);
     
     ESP_LOGI(TAG, "WiFi管理器初始化成功");
     return ESP_OK;
@@ -189,47 +1719,100 @@ esp_err_t xn_wifi_manager_deinit(xn_wifi_manager_t *manager)
         return ESP_ERR_INVALID_ARG;
     }
     
+    // 注销事件处理函数，不再向工作任务转发事件
+    esp_event_handler_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler);
+    esp_event_handler_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler);
+    
+    // 通知工作任务退出并等待
+    if (manager->worker_task) {
+        wifi_cmd_t cmd = { .type = WIFI_CMD_EXIT };
+        xQueueSend(manager->cmd_queue, &cmd, portMAX_DELAY);
+        xEventGroupWaitBits(manager->event_group, WIFI_WORKER_EXIT_BIT,
+                            pdTRUE, pdTRUE, portMAX_DELAY);
+        manager->worker_task = NULL;
+    }
+    lease_stop_static(manager);
+#if CONFIG_XN_BLUFI_LEASE_STATIC_IP
+    if (manager->renew_timer) {
+        esp_timer_delete(manager->renew_timer);
+        manager->renew_timer = NULL;
+    }
+#endif
+#if CONFIG_XN_BLUFI_ROAMING
+    if (manager->roam_timer) {
+        esp_timer_stop(manager->roam_timer);
+        esp_timer_delete(manager->roam_timer);
+        manager->roam_timer = NULL;
+    }
+#endif
+#if CONFIG_XN_BLUFI_LINK_MONITOR
+    if (manager->link_timer) {
+        esp_timer_stop(manager->link_timer);
+        esp_timer_delete(manager->link_timer);
+        manager->link_timer = NULL;
+    }
+#endif
+
     // 停止WiFi
     esp_wifi_stop();
     esp_wifi_deinit();
     
-    // 注销事件处理函数
-    esp_event_handler_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler);
-    esp_event_handler_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler);
-    
     ESP_LOGI(TAG, "WiFi管理器已反初始化");
     return ESP_OK;
 }
 
-/* 连接WiFi */
-esp_err_t xn_wifi_manager_connect(xn_wifi_manager_t *manager, 
-                                   const char *ssid, 
+/* 连接WiFi（字符串接口） */
+esp_err_t xn_wifi_manager_connect(xn_wifi_manager_t *manager,
+                                   const char *ssid,
                                    const char *password)
 {
     if (manager == NULL || ssid == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    // 设置WiFi配置
-    memset(&manager->wifi_config, 0, sizeof(wifi_config_t));
-    strncpy((char*)manager->wifi_config.sta.ssid, ssid, 
-           sizeof(manager->wifi_config.sta.ssid) - 1);
-    if (password) {
-        strncpy((char*)manager->wifi_config.sta.password, password, 
-               sizeof(manager->wifi_config.sta.password) - 1);
+    xn_wifi_cred_t cred;
+    esp_err_t ret = xn_wifi_cred_from_str(&cred, ssid, password);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SSID或密码过长");
+        return ret;
+    }
+    return xn_wifi_manager_connect_cred(manager, &cred);
+}
+
+/* 连接WiFi（带长度凭据） */
+esp_err_t xn_wifi_manager_connect_cred(xn_wifi_manager_t *manager, const xn_wifi_cred_t *cred)
+{
+    return xn_wifi_manager_connect_lease(manager, cred, NULL, 0);
+}
+
+/* 按给定的AP和租约连接WiFi */
+esp_err_t xn_wifi_manager_connect_lease(xn_wifi_manager_t *manager, const xn_wifi_cred_t *cred,
+                                        const xn_wifi_lease_t *lease, uint32_t fresh_s)
+{
+    if (manager == NULL || cred == NULL || cred->ssid_len == 0 ||
+        cred->ssid_len > XN_WIFI_SSID_MAX_LEN || cred->password_len > XN_WIFI_PASSWORD_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    // 断开当前连接
-    esp_wifi_disconnect();
+    wifi_cmd_t cmd = { .type = WIFI_CMD_CONNECT };
+    cmd.connect.cred = *cred;
+    if (lease) {
+        cmd.connect.lease = *lease;
+        cmd.connect.has_lease = true;
+        cmd.connect.fresh_s = fresh_s;
+    }
     
-    // 设置新配置并连接
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &manager->wifi_config));
-    manager->is_connecting = true;
-    manager->retry_count = 0;
-    update_status(manager, XN_WIFI_CONNECTING);
+    // 新的连接请求使旧的连接状态失效，避免等待者读到过期结果
+    if (manager->event_group) {
+        xEventGroupClearBits(manager->event_group, WIFI_CONNECTED_BIT | WIFI_DISCONNECTED_BIT);
+    }
     
-    ESP_LOGI(TAG, "开始连接WiFi: %s", ssid);
-    return esp_wifi_connect();
+    esp_err_t ret = post_cmd(manager, &cmd);
+    memset(&cmd, 0, sizeof(cmd));   // 栈上的命令副本含密码，投递后清除
+    if (ret != ESP_OK && manager->event_group) {
+        sync_status_bits(manager, xn_wifi_manager_get_status(manager));
+    }
+    return ret;
 }
 
 /* 断开WiFi */
@@ -239,30 +1822,29 @@ esp_err_t xn_wifi_manager_disconnect(xn_wifi_manager_t *manager)
         return ESP_ERR_INVALID_ARG;
     }
     
-    manager->is_connecting = false;
-    ESP_LOGI(TAG, "断开WiFi连接");
-    return esp_wifi_disconnect();
+    wifi_cmd_t cmd = { .type = WIFI_CMD_DISCONNECT };
+    return post_cmd(manager, &cmd);
 }
 
 /* 扫描WiFi */
-esp_err_t xn_wifi_manager_scan(xn_wifi_manager_t *manager, 
+esp_err_t xn_wifi_manager_scan(xn_wifi_manager_t *manager,
                                 xn_wifi_scan_done_cb_t callback)
 {
     if (manager == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    manager->scan_callback = callback;
+    wifi_cmd_t cmd = { .type = WIFI_CMD_SCAN, .scan_callback = callback };
     
-    wifi_scan_config_t scan_config = {
-        .ssid = NULL,
-        .bssid = NULL,
-        .channel = 0,
-        .show_hidden = false
-    };
+    if (manager->event_group) {
+        xEventGroupClearBits(manager->event_group, WIFI_SCAN_DONE_BIT);
+    }
     
-    ESP_LOGI(TAG, "开始扫描WiFi");
-    return esp_wifi_scan_start(&scan_config, false);
+    esp_err_t ret = post_cmd(manager, &cmd);
+    if (ret != ESP_OK && manager->event_group) {
+        xEventGroupSetBits(manager->event_group, WIFI_SCAN_DONE_BIT);
+    }
+    return ret;
 }
 
 /* 获取WiFi状态 */
@@ -271,14 +1853,304 @@ xn_wifi_status_t xn_wifi_manager_get_status(xn_wifi_manager_t *manager)
     if (manager == NULL) {
         return XN_WIFI_DISCONNECTED;
     }
-    return manager->status;
+    return (xn_wifi_status_t)atomic_load(&manager->status);
+}
+
+/* 等待事件组中的指定位 */
+static esp_err_t wait_bits(xn_wifi_manager_t *manager, EventBits_t bits, TickType_t timeout)
+{
+    if (manager == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (manager->event_group == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    EventBits_t result = xEventGroupWaitBits(manager->event_group, bits, pdFALSE, pdFALSE, timeout);
+    return (result & bits) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+/* 等待获取IP */
+esp_err_t xn_wifi_manager_wait_for_ip(xn_wifi_manager_t *manager, TickType_t timeout)
+{
+    return wait_bits(manager, WIFI_CONNECTED_BIT, timeout);
+}
+
+/* 等待断开 */
+esp_err_t xn_wifi_manager_wait_for_disconnect(xn_wifi_manager_t *manager, TickType_t timeout)
+{
+    return wait_bits(manager, WIFI_DISCONNECTED_BIT, timeout);
+}
+
+/* 等待扫描完成 */
+esp_err_t xn_wifi_manager_wait_for_scan_done(xn_wifi_manager_t *manager, TickType_t timeout)
+{
+    return wait_bits(manager, WIFI_SCAN_DONE_BIT, timeout);
+}
+
+/* 获取状态快照 */
+esp_err_t xn_wifi_manager_get_snapshot(xn_wifi_manager_t *manager, xn_wifi_snapshot_t *snapshot)
+{
+    if (manager == NULL || snapshot == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    *snapshot = manager->snapshot;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    return ESP_OK;
 }
 
 /* 注册状态回调 */
-void xn_wifi_manager_register_status_cb(xn_wifi_manager_t *manager, 
+void xn_wifi_manager_register_status_cb(xn_wifi_manager_t *manager,
                                          xn_wifi_status_cb_t callback)
 {
     if (manager) {
         manager->status_callback = callback;
     }
 }
+
+/* 订阅事件（回调方式） */
+esp_err_t xn_wifi_manager_subscribe(xn_wifi_manager_t *manager,
+                                    xn_wifi_event_cb_t callback,
+                                    void *user_ctx,
+                                    uint32_t event_mask,
+                                    int *sub_id)
+{
+    if (manager == NULL || callback == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return add_subscriber(manager, callback, user_ctx, NULL, event_mask, sub_id);
+}
+
+/* 订阅事件（队列方式） */
+esp_err_t xn_wifi_manager_subscribe_queue(xn_wifi_manager_t *manager,
+                                          QueueHandle_t queue,
+                                          uint32_t event_mask,
+                                          int *sub_id)
+{
+    if (manager == NULL || queue == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return add_subscriber(manager, NULL, NULL, queue, event_mask, sub_id);
+}
+
+/* 取消订阅 */
+esp_err_t xn_wifi_manager_unsubscribe(xn_wifi_manager_t *manager, int sub_id)
+{
+    if (manager == NULL || sub_id < 0 || sub_id >= XN_WIFI_MAX_SUBSCRIBERS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    wifi_subscriber_t *sub = &manager->subscribers[sub_id];
+    unsigned int state = atomic_load(&sub->state);
+    while ((state & SUB_STATE_MASK) == SUB_STATE_ACTIVE) {
+        if (atomic_compare_exchange_weak(&sub->state, &state,
+                                         (state & ~SUB_STATE_MASK) | SUB_STATE_FREE)) {
+            wait_subscriber_quiescent(manager, sub);
+            ESP_LOGI(TAG, "取消事件订阅者[%d]", sub_id);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+/* 获取订阅者丢弃的事件数 */
+uint32_t xn_wifi_manager_get_dropped_events(xn_wifi_manager_t *manager, int sub_id)
+{
+    if (manager == NULL || sub_id < 0 || sub_id >= XN_WIFI_MAX_SUBSCRIBERS) {
+        return 0;
+    }
+    return atomic_load_explicit(&manager->subscribers[sub_id].dropped, memory_order_relaxed);
+}
+
+/* 获取工作任务栈历史最小剩余 */
+uint32_t xn_wifi_manager_get_stack_high_water(xn_wifi_manager_t *manager)
+{
+    if (manager == NULL || manager->worker_task == NULL) {
+        return 0;
+    }
+    return uxTaskGetStackHighWaterMark(manager->worker_task);
+}
+
+/* 获取当前连接的凭据，WPA/WPA2-PSK网络上补算PMK */
+esp_err_t xn_wifi_manager_get_connected_cred(xn_wifi_manager_t *manager, xn_wifi_cred_t *cred)
+{
+    if (manager == NULL || cred == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xn_wifi_status_t status = xn_wifi_manager_get_status(manager);
+    if (status != XN_WIFI_CONNECTED && status != XN_WIFI_GOT_IP) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    *cred = manager->cred;
+    wifi_auth_mode_t authmode = manager->authmode;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    
+    // 不是通过管理器发起的连接，没有凭据可取
+    if (cred->ssid_len == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // PMK只适用于纯WPA/WPA2-PSK；WPA3(SAE)及过渡模式需要口令，不缓存PMK以免降级到WPA2
+    bool psk_only = (authmode == WIFI_AUTH_WPA_PSK || authmode == WIFI_AUTH_WPA2_PSK ||
+                     authmode == WIFI_AUTH_WPA_WPA2_PSK);
+    if (!psk_only) {
+        memset(cred->pmk, 0, sizeof(cred->pmk));
+        cred->pmk_valid = false;
+        return ESP_OK;
+    }
+    
+    if (!cred->pmk_valid) {
+        int64_t start = esp_timer_get_time();
+        if (xn_wifi_cred_derive_pmk(cred) == ESP_OK) {
+            ESP_LOGI(TAG, "已计算PMK，耗时%lu us，下次连接将跳过PBKDF2",
+                     (unsigned long)(esp_timer_get_time() - start));
+            
+            // 凭据未被新的连接请求替换时，缓存到管理器，避免重复计算
+            portENTER_CRITICAL(&manager->snapshot_lock);
+            if (manager->cred.ssid_len == cred->ssid_len &&
+                memcmp(manager->cred.ssid, cred->ssid, cred->ssid_len) == 0 &&
+                manager->cred.password_len == cred->password_len &&
+                memcmp(manager->cred.password, cred->password, cred->password_len) == 0) {
+                memcpy(manager->cred.pmk, cred->pmk, sizeof(cred->pmk));
+                manager->cred.pmk_valid = true;
+            }
+            portEXIT_CRITICAL(&manager->snapshot_lock);
+        }
+    }
+    return ESP_OK;
+}
+
+/* 获取当前地址对应的AP和租约 */
+esp_err_t xn_wifi_manager_get_lease(xn_wifi_manager_t *manager, xn_wifi_lease_t *lease, uint32_t *fresh_s)
+{
+    if (manager == NULL || lease == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (xn_wifi_manager_get_status(manager) != XN_WIFI_GOT_IP) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    *lease = manager->lease;
+    int64_t t1 = manager->lease_t1;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    
+    if (lease->ip == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (fresh_s) {
+        int64_t now = esp_timer_get_time();
+        *fresh_s = (t1 > now) ? (uint32_t)((t1 - now) / 1000000) : 0;
+    }
+    return ESP_OK;
+}
+
+/* 提交档位：初始化前直接保存，初始化后交给工作任务应用 */
+static esp_err_t submit_profile(xn_wifi_manager_t *manager, xn_wifi_profile_id_t id,
+                                const xn_wifi_profile_t *profile)
+{
+    if (manager->cmd_queue == NULL) {
+        portENTER_CRITICAL(&manager->snapshot_lock);
+        manager->profile_id = id;
+        manager->profile = *profile;
+        portEXIT_CRITICAL(&manager->snapshot_lock);
+        return ESP_OK;
+    }
+    
+    wifi_cmd_t cmd = { .type = WIFI_CMD_SET_PROFILE };
+    cmd.profile.id = id;
+    cmd.profile.config = *profile;
+    return post_cmd(manager, &cmd);
+}
+
+/* 切换功耗/性能档位 */
+esp_err_t xn_wifi_manager_set_profile(xn_wifi_manager_t *manager, xn_wifi_profile_id_t id)
+{
+    if (manager == NULL || id >= XN_WIFI_PROFILE_CUSTOM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return submit_profile(manager, id, &PRESET_PROFILES[id]);
+}
+
+/* 使用自定义档位参数 */
+esp_err_t xn_wifi_manager_set_custom_profile(xn_wifi_manager_t *manager, const xn_wifi_profile_t *profile)
+{
+    if (manager == NULL || profile == NULL || profile->ps_type > WIFI_PS_MAX_MODEM ||
+        (profile->protocol & WIFI_PROTOCOL_BGN) == 0 ||
+        (profile->bandwidth != WIFI_BW_HT20 && profile->bandwidth != WIFI_BW_HT40) ||
+        (profile->bandwidth == WIFI_BW_HT40 && !(profile->protocol & WIFI_PROTOCOL_11N)) ||
+        (profile->max_tx_power != 0 && (profile->max_tx_power < 8 || profile->max_tx_power > TX_POWER_MAX))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return submit_profile(manager, XN_WIFI_PROFILE_CUSTOM, profile);
+}
+
+/* 获取当前档位及实际生效的设置 */
+esp_err_t xn_wifi_manager_get_profile_info(xn_wifi_manager_t *manager, xn_wifi_profile_info_t *info)
+{
+    if (manager == NULL || info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(info, 0, sizeof(xn_wifi_profile_info_t));
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    info->id = manager->profile_id;
+    info->config = manager->profile;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    
+    esp_wifi_get_ps(&info->ps_type);
+    esp_wifi_get_bandwidth(WIFI_IF_STA, &info->bandwidth);
+    esp_wifi_get_max_tx_power(&info->tx_power);
+    
+    xn_wifi_status_t status = xn_wifi_manager_get_status(manager);
+    if (status == XN_WIFI_CONNECTED || status == XN_WIFI_GOT_IP) {
+        wifi_ap_record_t ap_info;
+        if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+            info->rssi = ap_info.rssi;
+        }
+    }
+    return ESP_OK;
+}
+
+/* 获取漫游统计 */
+esp_err_t xn_wifi_manager_get_roam_stats(xn_wifi_manager_t *manager, xn_wifi_roam_stats_t *stats)
+{
+    if (manager == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+#if CONFIG_XN_BLUFI_ROAMING
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    *stats = manager->roam_stats;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    return ESP_OK;
+#else
+    memset(stats, 0, sizeof(xn_wifi_roam_stats_t));
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/* 获取链路质量 */
+esp_err_t xn_wifi_manager_get_link_info(xn_wifi_manager_t *manager, xn_wifi_link_info_t *info)
+{
+    if (manager == NULL || info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+#if CONFIG_XN_BLUFI_LINK_MONITOR
+    portENTER_CRITICAL(&manager->snapshot_lock);
+    *info = manager->link;
+    portEXIT_CRITICAL(&manager->snapshot_lock);
+    return ESP_OK;
+#else
+    memset(info, 0, sizeof(xn_wifi_link_info_t));
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
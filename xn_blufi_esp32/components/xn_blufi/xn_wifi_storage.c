@@ -5,35 +5,660 @@
  */
 
 #include "xn_wifi_storage.h"
+#include "xn_boot_profile.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include <stddef.h>
 #include <string.h>
 
+#if CONFIG_XN_BLUFI_STORAGE_ENCRYPT
+#include "mbedtls/gcm.h"
+#include "mbedtls/sha256.h"
+#include "esp_random.h"
+#if defined(CONFIG_XN_BLUFI_STORAGE_HMAC_KEY_ID) && CONFIG_XN_BLUFI_STORAGE_HMAC_KEY_ID >= 0
+#include "esp_hmac.h"
+#define STORAGE_KEY_FROM_HMAC 1
+#endif
+#endif
+
 static const char *TAG = "XN_WIFI_STORAGE";
 #define NVS_NAMESPACE "wifi_cfg"
 #define MAX_WIFI_CONFIGS 10  // 最多存储10个WiFi配置
+#define META_FLUSH_THRESHOLD 16  // 排序未变化时，累计多少次成功连接才落盘一次元数据
+
+#define LIST_MAGIC 0x4C574E58  // "XNWL"
+#define LIST_VERSION_PLAIN_V1 1 // 旧版条目（无PMK）明文存储
+#define LIST_VERSION_GCM_V1 2   // 旧版条目（无PMK）AES-256-GCM加密存储
+#define LIST_VERSION_PLAIN 3    // 条目明文存储
+#define LIST_VERSION_GCM 4      // 条目AES-256-GCM加密存储
+
+/*
+ * 配置列表以整块blob存储，在list_a/list_b两个槽位之间交替写入。
+ * 每次修改都写到非当前槽位并提交，旧槽位在新槽位完整落盘前保持不变，
+ * 因此任意时刻掉电，初始化时都能通过序号+CRC恢复到最后一个完整版本。
+ */
+static const char *LIST_KEYS[2] = {"list_a", "list_b"};
+
+/* 列表头 */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;     // 配置数量
+    uint32_t seq;       // 提交序号，较大者为最新
+    uint32_t clock;     // 逻辑时钟
+    uint32_t crc;       // 头部（不含本字段）+ 条目的CRC32
+} list_header_t;
+
+/* 旧版列表条目（格式版本1/2），读取后展开为当前格式 */
+typedef struct {
+    char ssid[32];
+    char password[64];
+    uint32_t last_connected;
+    uint16_t success_count;
+    uint8_t priority;
+    uint8_t ssid_len;   // SSID长度，旧数据为0（按字符串计算）
+} list_entry_v1_t;
+
+/* 列表条目（前部与旧版条目布局相同） */
+typedef struct {
+    char ssid[32];
+    char password[64];
+    uint32_t last_connected;
+    uint16_t success_count;
+    uint8_t priority;
+    uint8_t ssid_len;   // SSID长度，旧数据为0（按字符串计算）
+    uint8_t pmk[XN_WIFI_PMK_LEN];   // 预计算的PMK
+    uint8_t pmk_valid;              // PMK是否有效
+    uint8_t reserved[3];
+} list_entry_t;
+
+_Static_assert(offsetof(list_entry_t, pmk) == sizeof(list_entry_v1_t), "list_entry_t必须以旧版条目布局开头");
+
+/* 列表blob */
+typedef struct {
+    list_header_t header;
+    list_entry_t entries[MAX_WIFI_CONFIGS];
+} list_blob_t;
+
+/* 加密参数，加密格式下紧跟在列表头之后，其后为密文条目 */
+typedef struct {
+    uint8_t iv[12];
+    uint8_t tag[16];
+} list_crypt_t;
+
+static xn_wifi_config_t s_configs[MAX_WIFI_CONFIGS];  // 配置缓存
+static uint8_t s_count = 0;                            // 已存储配置数量
+static uint32_t s_clock = 0;                           // 逻辑时钟，每次排序变化的连接成功加1
+static uint8_t s_unsaved_success = 0;                  // 未落盘的成功连接次数
+static int s_active_slot = -1;                         // 当前有效的A/B槽位，-1表示尚未写入
+static uint32_t s_seq = 0;                             // 当前有效槽位的提交序号
+static list_blob_t s_blob;                             // 序列化缓冲区（约1KB，放静态区避免占用调用者栈）
+static SemaphoreHandle_t s_lock = NULL;                // 缓存互斥锁
+
+#if CONFIG_XN_BLUFI_STORAGE_ENCRYPT
+#define LIST_VERSION LIST_VERSION_GCM
+#define LIST_WIRE_BUF s_wire
+#define LIST_WIRE_SIZE sizeof(s_wire)
+static uint8_t s_wire[sizeof(list_header_t) + sizeof(list_crypt_t) + sizeof(list_entry_t) * MAX_WIFI_CONFIGS]; // 密文缓冲区
+static mbedtls_gcm_context s_gcm;                     // 启动时设置好密钥，之后每次写入直接复用
+static bool s_crypto_ready = false;
+#else
+#define LIST_VERSION LIST_VERSION_PLAIN
+#define LIST_WIRE_BUF ((uint8_t *)&s_blob)
+#define LIST_WIRE_SIZE sizeof(s_blob)
+#endif
+
+static xn_wifi_storage_stats_t s_stats = {0};                   // 写入统计
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED; // 统计自旋锁
+
+/* 键写入计数 */
+static void storage_count_write(esp_err_t ret)
+{
+    if (ret == ESP_OK) {
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats.key_writes++;
+        portEXIT_CRITICAL(&s_stats_lock);
+    }
+}
+
+/* 提交NVS并计数 */
+static esp_err_t storage_commit(nvs_handle_t nvs_handle)
+{
+    esp_err_t ret = nvs_commit(nvs_handle);
+    if (ret == ESP_OK) {
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats.commits++;
+        portEXIT_CRITICAL(&s_stats_lock);
+    }
+    return ret;
+}
+
+/* 计算列表CRC32：头部（不含crc字段）+ 头部之后的全部数据 */
+static uint32_t list_crc(const uint8_t *data, size_t len)
+{
+    uint32_t crc = esp_rom_crc32_le(0, data, offsetof(list_header_t, crc));
+    return esp_rom_crc32_le(crc, data + sizeof(list_header_t), len - sizeof(list_header_t));
+}
+
+#if CONFIG_XN_BLUFI_STORAGE_ENCRYPT
+/* 累计加解密耗时 */
+static void storage_count_crypto(bool encrypt, int64_t start)
+{
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    portENTER_CRITICAL(&s_stats_lock);
+    if (encrypt) {
+        s_stats.encrypt_count++;
+        s_stats.encrypt_us_total += elapsed;
+    } else {
+        s_stats.decrypt_us += elapsed;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+/* 派生存储密钥并初始化GCM上下文（每次启动只执行一次） */
+static esp_err_t storage_crypto_init(void)
+{
+    if (s_crypto_ready) {
+        return ESP_OK;
+    }
+    
+    static const char label[] = "xn_wifi_storage";
+    uint8_t key[32];
+    int64_t start = esp_timer_get_time();
+    
+#ifdef STORAGE_KEY_FROM_HMAC
+    // eFuse中的HMAC密钥软件不可读，派生出的密钥只存在于RAM
+    esp_err_t ret = esp_hmac_calculate(HMAC_KEY0 + CONFIG_XN_BLUFI_STORAGE_HMAC_KEY_ID, label, strlen(label), key);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "HMAC派生存储密钥失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+#else
+    // 未配置eFuse密钥时，使用首次启动生成的随机设备密钥（单独命名空间）
+    uint8_t secret[32 + sizeof(label)];
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open("wifi_sec", NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "打开密钥命名空间失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    size_t len = 32;
+    ret = nvs_get_blob(nvs_handle, "secret", secret, &len);
+    if (ret != ESP_OK || len != 32) {
+        esp_fill_random(secret, 32);
+        ret = nvs_set_blob(nvs_handle, "secret", secret, 32);
+        if (ret == ESP_OK) {
+            ret = nvs_commit(nvs_handle);
+        }
+        ESP_LOGI(TAG, "已生成设备存储密钥");
+    }
+    nvs_close(nvs_handle);
+    
+    if (ret != ESP_OK) {
+        memset(secret, 0, sizeof(secret));
+        ESP_LOGE(TAG, "保存设备存储密钥失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    memcpy(secret + 32, label, sizeof(label));
+    mbedtls_sha256(secret, sizeof(secret), key, 0);
+    memset(secret, 0, sizeof(secret));
+#endif
+
+    mbedtls_gcm_init(&s_gcm);
+    int err = mbedtls_gcm_setkey(&s_gcm, MBEDTLS_CIPHER_ID_AES, key, 256);
+    memset(key, 0, sizeof(key));
+    if (err != 0) {
+        mbedtls_gcm_free(&s_gcm);
+        ESP_LOGE(TAG, "设置GCM密钥失败: -0x%04x", -err);
+        return ESP_FAIL;
+    }
+    
+    s_crypto_ready = true;
+    
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.key_derive_us = (uint32_t)(esp_timer_get_time() - start);
+    portEXIT_CRITICAL(&s_stats_lock);
+    ESP_LOGI(TAG, "存储密钥已就绪，耗时%lu us", (unsigned long)s_stats.key_derive_us);
+    return ESP_OK;
+}
+
+/* 加密s_blob中的条目到s_wire，返回写入长度 */
+static esp_err_t storage_encrypt(size_t *out_len)
+{
+    size_t entries_len = s_blob.header.count * sizeof(list_entry_t);
+    uint8_t *cipher = s_wire + sizeof(list_header_t) + sizeof(list_crypt_t);
+    list_crypt_t crypt;
+    
+    esp_fill_random(crypt.iv, sizeof(crypt.iv));
+    memcpy(s_wire, &s_blob.header, sizeof(list_header_t));
+    
+    // 列表头（序号、数量、时钟）作为附加认证数据，防止被单独篡改
+    int64_t start = esp_timer_get_time();
+    int err = mbedtls_gcm_crypt_and_tag(&s_gcm, MBEDTLS_GCM_ENCRYPT, entries_len,
+                                        crypt.iv, sizeof(crypt.iv),
+                                        s_wire, offsetof(list_header_t, crc),
+                                        (const uint8_t *)s_blob.entries, cipher,
+                                        sizeof(crypt.tag), crypt.tag);
+    storage_count_crypto(true, start);
+    if (err != 0) {
+        ESP_LOGE(TAG, "加密配置列表失败: -0x%04x", -err);
+        return ESP_FAIL;
+    }
+    
+    memcpy(s_wire + sizeof(list_header_t), &crypt, sizeof(crypt));
+    *out_len = sizeof(list_header_t) + sizeof(list_crypt_t) + entries_len;
+    
+    uint32_t crc = list_crc(s_wire, *out_len);
+    memcpy(s_wire + offsetof(list_header_t, crc), &crc, sizeof(crc));
+    return ESP_OK;
+}
+
+/* 解密s_wire中的密文条目到s_blob（entry_size为该格式版本的条目大小） */
+static esp_err_t storage_decrypt(const list_header_t *header, size_t entry_size)
+{
+    size_t entries_len = header->count * entry_size;
+    const uint8_t *cipher = s_wire + sizeof(list_header_t) + sizeof(list_crypt_t);
+    list_crypt_t crypt;
+    memcpy(&crypt, s_wire + sizeof(list_header_t), sizeof(crypt));
+    
+    int64_t start = esp_timer_get_time();
+    int err = mbedtls_gcm_auth_decrypt(&s_gcm, entries_len,
+                                       crypt.iv, sizeof(crypt.iv),
+                                       s_wire, offsetof(list_header_t, crc),
+                                       crypt.tag, sizeof(crypt.tag),
+                                       cipher, (uint8_t *)s_blob.entries);
+    storage_count_crypto(false, start);
+    if (err != 0) {
+        ESP_LOGE(TAG, "配置列表认证失败（密钥不匹配或数据被篡改）");
+        return ESP_ERR_INVALID_CRC;
+    }
+    
+    s_blob.header = *header;
+    return ESP_OK;
+}
+#endif
+
+/* 旧版条目原地展开为当前格式（从后往前搬移，新条目更大，不会覆盖未处理的旧条目） */
+static void list_expand_v1(uint16_t count)
+{
+    const list_entry_v1_t *old = (const list_entry_v1_t *)s_blob.entries;
+    for (int i = count - 1; i >= 0; i--) {
+        list_entry_v1_t tmp;
+        memcpy(&tmp, &old[i], sizeof(tmp));
+        memset(&s_blob.entries[i], 0, sizeof(list_entry_t));
+        memcpy(&s_blob.entries[i], &tmp, sizeof(tmp));
+    }
+}
+
+/* 读取并校验一个槽位，明文条目放入s_blob */
+static esp_err_t list_read_slot(nvs_handle_t nvs_handle, int slot)
+{
+    uint8_t *wire = LIST_WIRE_BUF;
+    size_t len = LIST_WIRE_SIZE;
+    memset(wire, 0, len);
+    memset(&s_blob, 0, sizeof(s_blob));
+    
+    esp_err_t ret = nvs_get_blob(nvs_handle, LIST_KEYS[slot], wire, &len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    list_header_t header;
+    if (len < sizeof(list_header_t)) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    memcpy(&header, wire, sizeof(header));
+    if (header.magic != LIST_MAGIC ||
+        header.count > MAX_WIFI_CONFIGS ||
+        header.crc != list_crc(wire, len)) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    
+    // 旧版格式的条目不含PMK，读取后展开，加载时会以当前格式重新写入
+    bool legacy = (header.version == LIST_VERSION_PLAIN_V1 || header.version == LIST_VERSION_GCM_V1);
+    size_t entries_len = header.count * (legacy ? sizeof(list_entry_v1_t) : sizeof(list_entry_t));
+    if (header.version == LIST_VERSION_PLAIN || header.version == LIST_VERSION_PLAIN_V1) {
+        if (len != sizeof(list_header_t) + entries_len) {
+            return ESP_ERR_INVALID_CRC;
+        }
+#if CONFIG_XN_BLUFI_STORAGE_ENCRYPT
+        // 开启加密前写入的明文列表，加载后会重新加密写入
+        memcpy(&s_blob, wire, len);
+#endif
+        if (legacy) {
+            list_expand_v1(header.count);
+        }
+        return ESP_OK;
+    }
+    
+#if CONFIG_XN_BLUFI_STORAGE_ENCRYPT
+    if (header.version == LIST_VERSION_GCM || header.version == LIST_VERSION_GCM_V1) {
+        if (len != sizeof(list_header_t) + sizeof(list_crypt_t) + entries_len) {
+            return ESP_ERR_INVALID_CRC;
+        }
+        ret = storage_decrypt(&header, legacy ? sizeof(list_entry_v1_t) : sizeof(list_entry_t));
+        if (ret == ESP_OK && legacy) {
+            list_expand_v1(header.count);
+        }
+        return ret;
+    }
+#endif
+
+    ESP_LOGW(TAG, "%s格式版本%d不受支持", LIST_KEYS[slot], header.version);
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+/* 将缓存整体写入备用槽位并提交 */
+static esp_err_t storage_persist(void)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "打开NVS失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    memset(&s_blob, 0, sizeof(s_blob));
+    s_blob.header.magic = LIST_MAGIC;
+    s_blob.header.version = LIST_VERSION;
+    s_blob.header.count = s_count;
+    s_blob.header.seq = s_seq + 1;
+    s_blob.header.clock = s_clock;
+    for (int i = 0; i < s_count; i++) {
+        list_entry_t *entry = &s_blob.entries[i];
+        memcpy(entry->ssid, s_configs[i].ssid, sizeof(entry->ssid));
+        memcpy(entry->password, s_configs[i].password, sizeof(entry->password));
+        entry->ssid_len = s_configs[i].ssid_len;
+        memcpy(entry->pmk, s_configs[i].pmk, sizeof(entry->pmk));
+        entry->pmk_valid = s_configs[i].pmk_valid;
+        entry->last_connected = s_configs[i].last_connected;
+        entry->success_count = s_configs[i].success_count;
+        entry->priority = s_configs[i].priority;
+    }
+    
+    size_t len = sizeof(list_header_t) + s_count * sizeof(list_entry_t);
+#if CONFIG_XN_BLUFI_STORAGE_ENCRYPT
+    ret = storage_encrypt(&len);
+#else
+    s_blob.header.crc = list_crc((const uint8_t *)&s_blob, len);
+#endif
+
+    int slot = (s_active_slot == 0) ? 1 : 0;
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(nvs_handle, LIST_KEYS[slot], LIST_WIRE_BUF, len);
+        storage_count_write(ret);
+    }
+    if (ret == ESP_OK) {
+        ret = storage_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+    memset(&s_blob, 0, sizeof(s_blob));
+    
+    if (ret == ESP_OK) {
+        s_active_slot = slot;
+        s_seq++;
+        s_unsaved_success = 0;
+    } else {
+        ESP_LOGE(TAG, "写入配置列表失败: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/* 比较连接优先顺序：用户优先级 > 最近连接 > 成功次数，返回true表示a优先于b */
+static bool config_preferred(const xn_wifi_config_t *a, const xn_wifi_config_t *b)
+{
+    if (a->priority != b->priority) {
+        return a->priority > b->priority;
+    }
+    if (a->last_connected != b->last_connected) {
+        return a->last_connected > b->last_connected;
+    }
+    return a->success_count > b->success_count;
+}
+
+/* 按连接优先顺序生成索引表（插入排序，最多10项） */
+static void storage_sort_order(uint8_t *order)
+{
+    for (int i = 0; i < s_count; i++) {
+        uint8_t slot = i;
+        int j = i - 1;
+        while (j >= 0 && config_preferred(&s_configs[slot], &s_configs[order[j]])) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = slot;
+    }
+}
+
+/* 查找SSID所在位置（按长度+字节比较），不存在返回-1 */
+static int storage_find(const void *ssid, size_t ssid_len)
+{
+    for (int i = 0; i < s_count; i++) {
+        if (s_configs[i].ssid_len == ssid_len && memcmp(s_configs[i].ssid, ssid, ssid_len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* 读取旧版按键存储（ssid_%d/pwd_%d/meta_%d）的配置，用于迁移 */
+static void storage_load_legacy(nvs_handle_t nvs_handle)
+{
+    uint8_t stored_count = 0;
+    nvs_get_u8(nvs_handle, "count", &stored_count);
+    nvs_get_u32(nvs_handle, "clock", &s_clock);
+    if (stored_count > MAX_WIFI_CONFIGS) {
+        stored_count = MAX_WIFI_CONFIGS;
+    }
+    
+    for (int i = 0; i < stored_count; i++) {
+        char ssid_key[16], pwd_key[16], meta_key[16];
+        snprintf(ssid_key, sizeof(ssid_key), "ssid_%d", i);
+        snprintf(pwd_key, sizeof(pwd_key), "pwd_%d", i);
+        snprintf(meta_key, sizeof(meta_key), "meta_%d", i);
+        
+        xn_wifi_config_t *config = &s_configs[s_count];
+        size_t len = sizeof(config->ssid);
+        if (nvs_get_str(nvs_handle, ssid_key, config->ssid, &len) != ESP_OK) {
+            continue;
+        }
+        len = sizeof(config->password);
+        nvs_get_str(nvs_handle, pwd_key, config->password, &len);
+        config->ssid_len = strlen(config->ssid);
+        config->password_len = strlen(config->password);
+        
+        struct {
+            uint32_t last_connected;
+            uint16_t success_count;
+            uint8_t priority;
+            uint8_t reserved;
+        } meta;
+        len = sizeof(meta);
+        if (nvs_get_blob(nvs_handle, meta_key, &meta, &len) == ESP_OK && len == sizeof(meta)) {
+            config->last_connected = meta.last_connected;
+            config->success_count = meta.success_count;
+            config->priority = meta.priority;
+        } else {
+            // 没有元数据：按插入顺序推算新旧，后插入的视为更近
+            config->last_connected = i + 1;
+            config->priority = XN_WIFI_PRIORITY_DEFAULT;
+        }
+        
+        if (config->last_connected > s_clock) {
+            s_clock = config->last_connected;
+        }
+        s_count++;
+    }
+}
+
+/* 擦除旧版按键存储 */
+static void storage_erase_legacy(void)
+{
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    
+    for (int i = 0; i < MAX_WIFI_CONFIGS; i++) {
+        char ssid_key[16], pwd_key[16], meta_key[16];
+        snprintf(ssid_key, sizeof(ssid_key), "ssid_%d", i);
+        snprintf(pwd_key, sizeof(pwd_key), "pwd_%d", i);
+        snprintf(meta_key, sizeof(meta_key), "meta_%d", i);
+        nvs_erase_key(nvs_handle, ssid_key);
+        nvs_erase_key(nvs_handle, pwd_key);
+        nvs_erase_key(nvs_handle, meta_key);
+    }
+    nvs_erase_key(nvs_handle, "count");
+    nvs_erase_key(nvs_handle, "clock");
+    
+    storage_commit(nvs_handle);
+    nvs_close(nvs_handle);
+}
+
+/* 从NVS恢复配置到缓存：选取序号最新且校验通过的槽位，两个槽位都不可用时迁移旧版数据 */
+static void storage_load_cache(void)
+{
+    nvs_handle_t nvs_handle;
+    
+    // 打开失败（首次启动命名空间不存在，或NVS异常）时保留当前缓存
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    
+    memset(s_configs, 0, sizeof(s_configs));
+    s_count = 0;
+    s_clock = 0;
+    s_unsaved_success = 0;
+    s_active_slot = -1;
+    s_seq = 0;
+    
+    esp_err_t slot_ret[2];
+    uint32_t slot_seq[2] = {0};
+    for (int slot = 0; slot < 2; slot++) {
+        slot_ret[slot] = list_read_slot(nvs_handle, slot);
+        slot_seq[slot] = s_blob.header.seq;
+    }
+    
+    int active = -1;
+    if (slot_ret[0] == ESP_OK && slot_ret[1] == ESP_OK) {
+        active = ((int32_t)(slot_seq[1] - slot_seq[0]) > 0) ? 1 : 0;
+    } else if (slot_ret[0] == ESP_OK) {
+        active = 0;
+    } else if (slot_ret[1] == ESP_OK) {
+        active = 1;
+    }
+    
+    bool migrated = false;
+    bool upgrade = false;
+    if (active >= 0) {
+        // s_blob中是最后读取的槽位，选中的不是它时重新读取
+        if (active != 1) {
+            list_read_slot(nvs_handle, active);
+        }
+        
+        upgrade = (s_blob.header.version != LIST_VERSION);
+        s_count = s_blob.header.count;
+        s_clock = s_blob.header.clock;
+        s_seq = s_blob.header.seq;
+        s_active_slot = active;
+        for (int i = 0; i < s_count; i++) {
+            const list_entry_t *entry = &s_blob.entries[i];
+            // 缓存数组比条目多1字节，满长度的SSID/密码也能保留结尾'\0'
+            memcpy(s_configs[i].ssid, entry->ssid, sizeof(entry->ssid));
+            memcpy(s_configs[i].password, entry->password, sizeof(entry->password));
+            s_configs[i].ssid_len = entry->ssid_len;
+            if (s_configs[i].ssid_len == 0 || s_configs[i].ssid_len > XN_WIFI_SSID_MAX_LEN) {
+                s_configs[i].ssid_len = strnlen(entry->ssid, sizeof(entry->ssid));
+            }
+            // 口令不含'\0'（十六进制PSK或可打印字符），长度按字符串计算
+            s_configs[i].password_len = strnlen(entry->password, sizeof(entry->password));
+            memcpy(s_configs[i].pmk, entry->pmk, sizeof(s_configs[i].pmk));
+            s_configs[i].pmk_valid = (entry->pmk_valid != 0);
+            s_configs[i].last_connected = entry->last_connected;
+            s_configs[i].success_count = entry->success_count;
+            s_configs[i].priority = entry->priority;
+        }
+        
+        if (slot_ret[!active] == ESP_ERR_INVALID_CRC) {
+            ESP_LOGW(TAG, "%s校验失败（可能是写入中途掉电），已恢复到%s (seq=%lu)",
+                     LIST_KEYS[!active], LIST_KEYS[active], (unsigned long)s_seq);
+        }
+    } else {
+        if (slot_ret[0] == ESP_ERR_INVALID_CRC || slot_ret[1] == ESP_ERR_INVALID_CRC) {
+            ESP_LOGE(TAG, "配置列表两个槽位均已损坏");
+        }
+        storage_load_legacy(nvs_handle);
+        migrated = (s_count > 0);
+    }
+    
+    nvs_close(nvs_handle);
+    memset(&s_blob, 0, sizeof(s_blob));
+    
+    // 先写入新格式再擦除旧键：迁移中途掉电，下次启动仍可从旧键或新槽位恢复
+    if (migrated && storage_persist() == ESP_OK) {
+        storage_erase_legacy();
+        ESP_LOGI(TAG, "已迁移%d个旧版WiFi配置", s_count);
+    }
+    
+    // 明文列表转为加密格式：两个槽位都重写一遍，有效数据中不再有明文副本；
+    // 被覆盖的旧条目仍留在Flash页上，直到NVS回收该页（要彻底清除需擦除NVS分区）
+    if (upgrade && storage_persist() == ESP_OK && storage_persist() == ESP_OK) {
+        ESP_LOGI(TAG, "配置列表已转换为格式版本%d", LIST_VERSION);
+    }
+}
 
 /* 初始化WiFi存储层 */
 esp_err_t xn_wifi_storage_init(void)
 {
+    int64_t stage_start = esp_timer_get_time();
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_LOGW(TAG, "NVS需要擦除，正在擦除...");
         ESP_ERROR_CHECK(nvs_flash_erase());
         ret = nvs_flash_init();
+        xn_boot_profile_record("nvs_erase_init", stage_start);
+    } else {
+        xn_boot_profile_record("nvs_init", stage_start);
     }
     
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "WiFi存储层初始化成功");
-    } else {
+    if (ret != ESP_OK) {
         ESP_LOGE(TAG, "WiFi存储层初始化失败: %s", esp_err_to_name(ret));
+        return ret;
     }
     
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutex();
+        if (s_lock == NULL) {
+            ESP_LOGE(TAG, "创建互斥锁失败");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    stage_start = esp_timer_get_time();
+#if CONFIG_XN_BLUFI_STORAGE_ENCRYPT
+    ret = storage_crypto_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+#endif
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    storage_load_cache();
+    xSemaphoreGive(s_lock);
+    xn_boot_profile_record("storage_load", stage_start);
+    
+    ESP_LOGI(TAG, "WiFi存储层初始化成功，已存储%d个配置", s_count);
     return ret;
 }
 
-/* 保存WiFi配置到NVS（添加到列表） */
+/* 保存WiFi配置到NVS（字符串接口） */
 esp_err_t xn_wifi_storage_save(const char *ssid, const char *password)
 {
     if (ssid == NULL) {
@@ -41,179 +666,251 @@ esp_err_t xn_wifi_storage_save(const char *ssid, const char *password)
         return ESP_ERR_INVALID_ARG;
     }
     
-    nvs_handle_t nvs_handle;
-    esp_err_t ret;
-    
-    // 打开NVS
-    ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    xn_wifi_cred_t cred;
+    esp_err_t ret = xn_wifi_cred_from_str(&cred, ssid, password);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "打开NVS失败: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "SSID或密码过长");
         return ret;
     }
     
-    // 读取当前配置数量
-    uint8_t count = 0;
-    nvs_get_u8(nvs_handle, "count", &count);
+    ret = xn_wifi_storage_save_cred(&cred);
+    memset(&cred, 0, sizeof(cred));
+    return ret;
+}
+
+/* 保存WiFi配置到NVS（添加到列表） */
+esp_err_t xn_wifi_storage_save_cred(const xn_wifi_cred_t *cred)
+{
+    if (cred == NULL || cred->ssid_len == 0 ||
+        cred->ssid_len > XN_WIFI_SSID_MAX_LEN || cred->password_len > XN_WIFI_PASSWORD_MAX_LEN) {
+        ESP_LOGE(TAG, "WiFi凭据无效");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    esp_err_t ret;
+    
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.save_requests++;
+    portEXIT_CRITICAL(&s_stats_lock);
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
     
     // 检查是否已存在相同SSID
-    int existing_index = -1;
-    for (int i = 0; i < count; i++) {
-        char key[16];
-        snprintf(key, sizeof(key), "ssid_%d", i);
-        
-        size_t len = 64;
-        char stored_ssid[64];
-        if (nvs_get_str(nvs_handle, key, stored_ssid, &len) == ESP_OK) {
-            if (strcmp(stored_ssid, ssid) == 0) {
-                existing_index = i;
-                break;
-            }
-        }
+    int existing_index = storage_find(cred->ssid, cred->ssid_len);
+    
+    // 已存在且密码未变化（例如重连到同一网络），跳过写入，避免无谓的Flash擦写；
+    // 只有首次拿到PMK（或PMK变化）时才需要补写
+    bool same_password = existing_index >= 0 &&
+                         s_configs[existing_index].password_len == cred->password_len &&
+                         memcmp(s_configs[existing_index].password, cred->password, cred->password_len) == 0;
+    bool pmk_changed = existing_index >= 0 && cred->pmk_valid &&
+                       (!s_configs[existing_index].pmk_valid ||
+                        memcmp(s_configs[existing_index].pmk, cred->pmk, XN_WIFI_PMK_LEN) != 0);
+    if (same_password && !pmk_changed) {
+        xSemaphoreGive(s_lock);
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats.save_skipped++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        ESP_LOGI(TAG, "WiFi配置未变化，跳过写入: %.*s", cred->ssid_len, (const char *)cred->ssid);
+        return ESP_OK;
     }
     
     // 如果已存在，更新密码；否则添加新配置
-    int index = (existing_index >= 0) ? existing_index : count;
-    
-    if (existing_index < 0 && count >= MAX_WIFI_CONFIGS) {
-        ESP_LOGW(TAG, "WiFi配置已满，删除最旧的配置");
-        // 删除第一个配置，所有配置前移
-        for (int i = 0; i < count - 1; i++) {
-            char old_ssid_key[16], old_pwd_key[16];
-            char new_ssid_key[16], new_pwd_key[16];
-            
-            snprintf(old_ssid_key, sizeof(old_ssid_key), "ssid_%d", i + 1);
-            snprintf(old_pwd_key, sizeof(old_pwd_key), "pwd_%d", i + 1);
-            snprintf(new_ssid_key, sizeof(new_ssid_key), "ssid_%d", i);
-            snprintf(new_pwd_key, sizeof(new_pwd_key), "pwd_%d", i);
-            
-            size_t len = 64;
-            char temp[64];
-            
-            if (nvs_get_str(nvs_handle, old_ssid_key, temp, &len) == ESP_OK) {
-                nvs_set_str(nvs_handle, new_ssid_key, temp);
-            }
-            
-            len = 64;
-            if (nvs_get_str(nvs_handle, old_pwd_key, temp, &len) == ESP_OK) {
-                nvs_set_str(nvs_handle, new_pwd_key, temp);
-            }
+    int index = existing_index;
+    
+    if (existing_index < 0) {
+        if (s_count >= MAX_WIFI_CONFIGS) {
+            // 列表已满：淘汰连接优先顺序最低的配置（同优先级下即最久未连接的）
+            uint8_t order[MAX_WIFI_CONFIGS];
+            storage_sort_order(order);
+            index = order[s_count - 1];
+            ESP_LOGW(TAG, "WiFi配置已满，淘汰最不常用的配置: %s", s_configs[index].ssid);
+        } else {
+            index = s_count++;
         }
-        index = count - 1;
-    } else if (existing_index < 0) {
-        count++;
+        
+        // 新配置视为最近使用，避免在首次连接成功前又被下一条新配置淘汰
+        memset(&s_configs[index], 0, sizeof(xn_wifi_config_t));
+        memcpy(s_configs[index].ssid, cred->ssid, cred->ssid_len);
+        s_configs[index].ssid_len = cred->ssid_len;
+        s_configs[index].last_connected = ++s_clock;
+        s_configs[index].priority = XN_WIFI_PRIORITY_DEFAULT;
     }
     
-    // 保存SSID和密码
-    char ssid_key[16], pwd_key[16];
-    snprintf(ssid_key, sizeof(ssid_key), "ssid_%d", index);
-    snprintf(pwd_key, sizeof(pwd_key), "pwd_%d", index);
+    memset(s_configs[index].password, 0, sizeof(s_configs[index].password));
+    memcpy(s_configs[index].password, cred->password, cred->password_len);
+    s_configs[index].password_len = cred->password_len;
     
-    ret = nvs_set_str(nvs_handle, ssid_key, ssid);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "保存SSID失败: %s", esp_err_to_name(ret));
-        nvs_close(nvs_handle);
-        return ret;
+    // PMK由SSID和密码决定，两者任一变化时旧PMK作废，只保留与本次凭据一起给出的PMK
+    memset(s_configs[index].pmk, 0, sizeof(s_configs[index].pmk));
+    s_configs[index].pmk_valid = cred->pmk_valid;
+    if (cred->pmk_valid) {
+        memcpy(s_configs[index].pmk, cred->pmk, sizeof(s_configs[index].pmk));
     }
     
-    if (password) {
-        ret = nvs_set_str(nvs_handle, pwd_key, password);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "保存密码失败: %s", esp_err_to_name(ret));
-            nvs_close(nvs_handle);
-            return ret;
-        }
+    // 整个列表一次写入备用槽位，失败时从Flash恢复缓存
+    ret = storage_persist();
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "WiFi配置已保存 [%d/%d]: %.*s", index + 1, s_count,
+                 cred->ssid_len, (const char *)cred->ssid);
     } else {
-        nvs_erase_key(nvs_handle, pwd_key);
+        storage_load_cache();
     }
     
-    // 保存配置数量
-    nvs_set_u8(nvs_handle, "count", count);
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+/* 由存储的配置生成连接凭据 */
+esp_err_t xn_wifi_config_to_cred(const xn_wifi_config_t *config, xn_wifi_cred_t *cred)
+{
+    if (config == NULL || cred == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    // 提交更改
-    ret = nvs_commit(nvs_handle);
-    nvs_close(nvs_handle);
+    esp_err_t ret = xn_wifi_cred_set(cred, (const uint8_t *)config->ssid, config->ssid_len,
+                                     (const uint8_t *)config->password, config->password_len);
+    if (ret == ESP_OK && config->pmk_valid) {
+        memcpy(cred->pmk, config->pmk, sizeof(cred->pmk));
+        cred->pmk_valid = true;
+    }
+    return ret;
+}
+
+/* 记录一次连接成功 */
+esp_err_t xn_wifi_storage_mark_connected(const uint8_t *ssid, uint8_t ssid_len)
+{
+    if (ssid == NULL || ssid_len == 0 || ssid_len > XN_WIFI_SSID_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    
+    int index = storage_find(ssid, ssid_len);
+    if (index < 0) {
+        xSemaphoreGive(s_lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    xn_wifi_config_t *config = &s_configs[index];
+    if (config->success_count < UINT16_MAX) {
+        config->success_count++;
+    }
     
+    // 已经是最近连接的网络时排序不变，只在内存中累计，达到阈值才落盘，
+    // 保证反复重连同一网络不会每次都擦写Flash
+    if (config->last_connected != s_clock) {
+        config->last_connected = ++s_clock;
+    } else if (++s_unsaved_success < META_FLUSH_THRESHOLD) {
+        xSemaphoreGive(s_lock);
+        return ESP_OK;
+    }
+    
+    esp_err_t ret = storage_persist();
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "连接记录已更新: %.*s (成功%d次)", ssid_len, (const char *)ssid, config->success_count);
+    }
+    
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+/* 设置已存储网络的用户优先级 */
+esp_err_t xn_wifi_storage_set_priority(const uint8_t *ssid, uint8_t ssid_len, uint8_t priority)
+{
+    if (ssid == NULL || ssid_len == 0 || ssid_len > XN_WIFI_SSID_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    
+    int index = storage_find(ssid, ssid_len);
+    if (index < 0) {
+        xSemaphoreGive(s_lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    if (s_configs[index].priority == priority) {
+        xSemaphoreGive(s_lock);
+        return ESP_OK;
+    }
+    
+    uint8_t old_priority = s_configs[index].priority;
+    s_configs[index].priority = priority;
+    
+    esp_err_t ret = storage_persist();
     if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "WiFi配置已保存 [%d/%d]: %s", index + 1, count, ssid);
+        ESP_LOGI(TAG, "优先级已更新: %.*s -> %d", ssid_len, (const char *)ssid, priority);
     } else {
-        ESP_LOGE(TAG, "提交NVS失败: %s", esp_err_to_name(ret));
+        s_configs[index].priority = old_priority;
     }
     
+    xSemaphoreGive(s_lock);
     return ret;
 }
 
-/* 从NVS加载第一个WiFi配置（兼容旧接口） */
+/* 加载最优先的WiFi配置（兼容旧接口） */
 esp_err_t xn_wifi_storage_load(xn_wifi_config_t *config)
 {
     if (config == NULL) {
         ESP_LOGE(TAG, "配置指针不能为空");
         return ESP_ERR_INVALID_ARG;
     }
-    
-    nvs_handle_t nvs_handle;
-    esp_err_t ret;
+    if (s_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
     
     memset(config, 0, sizeof(xn_wifi_config_t));
     
-    ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
-    if (ret != ESP_OK) {
-        return ret;
-    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
     
-    // 读取第一个配置
-    size_t len = sizeof(config->ssid);
-    ret = nvs_get_str(nvs_handle, "ssid_0", config->ssid, &len);
-    if (ret != ESP_OK) {
-        nvs_close(nvs_handle);
-        return ret;
+    if (s_count == 0) {
+        xSemaphoreGive(s_lock);
+        return ESP_ERR_NVS_NOT_FOUND;
     }
     
-    len = sizeof(config->password);
-    nvs_get_str(nvs_handle, "pwd_0", config->password, &len);
+    uint8_t order[MAX_WIFI_CONFIGS];
+    storage_sort_order(order);
+    *config = s_configs[order[0]];
     
-    nvs_close(nvs_handle);
+    xSemaphoreGive(s_lock);
     
     ESP_LOGI(TAG, "WiFi配置已加载: %s", config->ssid);
     return ESP_OK;
 }
 
-/* 加载所有WiFi配置 */
+/* 加载所有WiFi配置（按连接优先顺序） */
 esp_err_t xn_wifi_storage_load_all(xn_wifi_config_t *configs, uint8_t *count, uint8_t max_count)
 {
     if (configs == NULL || count == NULL) {
         ESP_LOGE(TAG, "参数不能为空");
         return ESP_ERR_INVALID_ARG;
     }
-    
-    nvs_handle_t nvs_handle;
-    esp_err_t ret;
+    if (s_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
     
     *count = 0;
     
-    ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
-    if (ret != ESP_OK) {
-        return ret;
-    }
-    
-    // 读取配置数量
-    uint8_t stored_count = 0;
-    nvs_get_u8(nvs_handle, "count", &stored_count);
+    xSemaphoreTake(s_lock, portMAX_DELAY);
     
-    // 读取所有配置
-    for (int i = 0; i < stored_count && i < max_count; i++) {
-        char ssid_key[16], pwd_key[16];
-        snprintf(ssid_key, sizeof(ssid_key), "ssid_%d", i);
-        snprintf(pwd_key, sizeof(pwd_key), "pwd_%d", i);
-        
-        size_t len = sizeof(configs[i].ssid);
-        if (nvs_get_str(nvs_handle, ssid_key, configs[i].ssid, &len) == ESP_OK) {
-            len = sizeof(configs[i].password);
-            nvs_get_str(nvs_handle, pwd_key, configs[i].password, &len);
-            (*count)++;
-        }
+    uint8_t order[MAX_WIFI_CONFIGS];
+    storage_sort_order(order);
+    for (int i = 0; i < s_count && i < max_count; i++) {
+        configs[i] = s_configs[order[i]];
+        (*count)++;
     }
     
-    nvs_close(nvs_handle);
+    xSemaphoreGive(s_lock);
     
     ESP_LOGI(TAG, "已加载%d个WiFi配置", *count);
     return ESP_OK;
@@ -222,124 +919,107 @@ esp_err_t xn_wifi_storage_load_all(xn_wifi_config_t *configs, uint8_t *count, ui
 /* 删除指定索引的WiFi配置 */
 esp_err_t xn_wifi_storage_delete_by_index(uint8_t index)
 {
-    nvs_handle_t nvs_handle;
-    esp_err_t ret;
-    
-    ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "打开NVS失败: %s", esp_err_to_name(ret));
-        return ret;
+    if (s_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
     
-    // 读取配置数量
-    uint8_t count = 0;
-    nvs_get_u8(nvs_handle, "count", &count);
+    esp_err_t ret;
     
-    if (index >= count) {
-        ESP_LOGW(TAG, "索引超出范围: %d >= %d", index, count);
-        nvs_close(nvs_handle);
-        return ESP_ERR_INVALID_ARG;
-    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
     
-    // 删除指定配置，后面的配置前移
-    for (int i = index; i < count - 1; i++) {
-        char old_ssid_key[16], old_pwd_key[16];
-        char new_ssid_key[16], new_pwd_key[16];
-        
-        snprintf(old_ssid_key, sizeof(old_ssid_key), "ssid_%d", i + 1);
-        snprintf(old_pwd_key, sizeof(old_pwd_key), "pwd_%d", i + 1);
-        snprintf(new_ssid_key, sizeof(new_ssid_key), "ssid_%d", i);
-        snprintf(new_pwd_key, sizeof(new_pwd_key), "pwd_%d", i);
-        
-        size_t len = 64;
-        char temp[64];
-        
-        if (nvs_get_str(nvs_handle, old_ssid_key, temp, &len) == ESP_OK) {
-            nvs_set_str(nvs_handle, new_ssid_key, temp);
-        }
-        
-        len = 64;
-        if (nvs_get_str(nvs_handle, old_pwd_key, temp, &len) == ESP_OK) {
-            nvs_set_str(nvs_handle, new_pwd_key, temp);
-        }
+    if (index >= s_count) {
+        ESP_LOGW(TAG, "索引超出范围: %d >= %d", index, s_count);
+        xSemaphoreGive(s_lock);
+        return ESP_ERR_INVALID_ARG;
     }
     
-    // 删除最后一个配置的键
-    char last_ssid_key[16], last_pwd_key[16];
-    snprintf(last_ssid_key, sizeof(last_ssid_key), "ssid_%d", count - 1);
-    snprintf(last_pwd_key, sizeof(last_pwd_key), "pwd_%d", count - 1);
-    nvs_erase_key(nvs_handle, last_ssid_key);
-    nvs_erase_key(nvs_handle, last_pwd_key);
+    // 索引按连接优先顺序计算，映射回缓存位置
+    uint8_t order[MAX_WIFI_CONFIGS];
+    storage_sort_order(order);
+    int pos = order[index];
     
-    // 更新数量
-    count--;
-    nvs_set_u8(nvs_handle, "count", count);
+    ESP_LOGI(TAG, "删除WiFi配置: %s", s_configs[pos].ssid);
     
-    ret = nvs_commit(nvs_handle);
-    nvs_close(nvs_handle);
+    // 后面的配置前移（只在内存中搬移，Flash上整块写入）
+    memmove(&s_configs[pos], &s_configs[pos + 1], (s_count - pos - 1) * sizeof(xn_wifi_config_t));
+    s_count--;
+    memset(&s_configs[s_count], 0, sizeof(xn_wifi_config_t));
     
+    ret = storage_persist();
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "WiFi配置已删除，索引: %d", index);
     } else {
         ESP_LOGE(TAG, "删除WiFi配置失败: %s", esp_err_to_name(ret));
+        storage_load_cache();
     }
     
+    xSemaphoreGive(s_lock);
     return ret;
 }
 
 /* 从NVS删除所有WiFi配置 */
 esp_err_t xn_wifi_storage_delete(void)
 {
+    if (s_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
     nvs_handle_t nvs_handle;
     esp_err_t ret;
     
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    
     ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
     if (ret != ESP_OK) {
+        xSemaphoreGive(s_lock);
         ESP_LOGW(TAG, "打开NVS失败: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    // 读取配置数量
-    uint8_t count = 0;
-    nvs_get_u8(nvs_handle, "count", &count);
-    
-    // 删除所有配置
-    for (int i = 0; i < count; i++) {
-        char ssid_key[16], pwd_key[16];
-        snprintf(ssid_key, sizeof(ssid_key), "ssid_%d", i);
-        snprintf(pwd_key, sizeof(pwd_key), "pwd_%d", i);
-        nvs_erase_key(nvs_handle, ssid_key);
-        nvs_erase_key(nvs_handle, pwd_key);
+    // 删除两个槽位：先删备用槽位里的上一版，再删当前槽位。
+    // 中途失败时剩下的是当前列表，不会在下次启动时退回到更旧的列表
+    int active = (s_active_slot == 1) ? 1 : 0;
+    ret = nvs_erase_key(nvs_handle, LIST_KEYS[!active]);
+    if (ret == ESP_OK || ret == ESP_ERR_NVS_NOT_FOUND) {
+        ret = nvs_erase_key(nvs_handle, LIST_KEYS[active]);
+    }
+    if (ret == ESP_OK || ret == ESP_ERR_NVS_NOT_FOUND) {
+        ret = storage_commit(nvs_handle);
     }
-    
-    nvs_erase_key(nvs_handle, "count");
-    
-    ret = nvs_commit(nvs_handle);
     nvs_close(nvs_handle);
     
     if (ret == ESP_OK) {
+        memset(s_configs, 0, sizeof(s_configs));
+        s_count = 0;
+        s_clock = 0;
+        s_unsaved_success = 0;
+        s_active_slot = -1;
+        s_seq = 0;
         ESP_LOGI(TAG, "所有WiFi配置已删除");
     } else {
         ESP_LOGE(TAG, "删除WiFi配置失败: %s", esp_err_to_name(ret));
+        storage_load_cache();
     }
     
+    xSemaphoreGive(s_lock);
     return ret;
 }
 
 /* 检查是否存在WiFi配置 */
 bool xn_wifi_storage_exists(void)
 {
-    nvs_handle_t nvs_handle;
-    esp_err_t ret;
-    
-    ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
-    if (ret != ESP_OK) {
-        return false;
+    return s_count > 0;
+}
+
+/* 获取写入统计 */
+esp_err_t xn_wifi_storage_get_stats(xn_wifi_storage_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    uint8_t count = 0;
-    ret = nvs_get_u8(nvs_handle, "count", &count);
-    nvs_close(nvs_handle);
-    
-    return (ret == ESP_OK && count > 0);
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+    return ESP_OK;
 }
@@ -0,0 +1,81 @@
+/*
+ * @Description: 回复/广播数据构建函数的fuzz目标 - 任意输出缓冲区大小和字段内容
+ *
+ * 输入格式：[选择, 输出缓冲区大小(2，大端), 字段内容...]。输出缓冲区按给定大小
+ * 分配在堆上，构建函数写出界能被ASan发现；缓冲区不足时必须返回0。
+ */
+
+#include "xn_fuzz.h"
+#include "xn_blufi_proto.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    xn_fuzz_input_t in = { data, size };
+
+    uint8_t select = xn_fuzz_u8(&in);
+    size_t out_size = xn_fuzz_u16(&in) % (XN_BLUFI_PROTO_MAX_RESPONSE + 64);
+    uint8_t *out = malloc(out_size ? out_size : 1);
+
+    switch (select % 5) {
+        case 0: {
+            static xn_wifi_config_t configs[10];
+            memset(configs, 0, sizeof(configs));
+            uint8_t count = xn_fuzz_u8(&in) % 11;
+            size_t need = 3;
+            for (int i = 0; i < count; i++) {
+                configs[i].ssid_len = xn_fuzz_u8(&in) % (XN_WIFI_SSID_MAX_LEN + 1);
+                configs[i].password_len = xn_fuzz_u8(&in) % (XN_WIFI_PASSWORD_MAX_LEN + 1);
+                xn_fuzz_take(&in, configs[i].ssid, configs[i].ssid_len);
+                xn_fuzz_take(&in, configs[i].password, configs[i].password_len);
+                need += 2 + configs[i].ssid_len + configs[i].password_len;
+            }
+            size_t len = xn_blufi_proto_build_config_list(count ? configs : NULL, count, out, out_size);
+            XN_FUZZ_CHECK(len == (need <= out_size ? need : 0));
+            break;
+        }
+
+        case 1: {
+            xn_blufi_status_report_t report;
+            xn_fuzz_take(&in, &report, sizeof(report));
+            size_t len = xn_blufi_proto_build_status_report(&report, out, out_size);
+            XN_FUZZ_CHECK(len == (out_size >= XN_BLUFI_PROTO_STATUS_REPORT_LEN ? XN_BLUFI_PROTO_STATUS_REPORT_LEN : 0));
+            break;
+        }
+
+        case 2: {
+            xn_blufi_adv_state_t state;
+            state.provisioned = xn_fuzz_u8(&in) & 1;
+            state.wifi_status = xn_fuzz_u8(&in);
+            xn_fuzz_take(&in, state.fw_version, sizeof(state.fw_version));
+            xn_fuzz_take(&in, state.mac_suffix, sizeof(state.mac_suffix));
+            size_t len = xn_blufi_proto_build_adv_data(&state, out, out_size);
+            XN_FUZZ_CHECK(len == (out_size >= XN_BLUFI_PROTO_ADV_DATA_LEN ? XN_BLUFI_PROTO_ADV_DATA_LEN : 0));
+            break;
+        }
+
+        case 3: {
+            uint8_t type = xn_fuzz_u8(&in);
+            uint8_t status = xn_fuzz_u8(&in);
+            size_t len = xn_blufi_proto_build_status(type, status, out, out_size);
+            XN_FUZZ_CHECK(len == (out_size >= 2 ? 2 : 0));
+            break;
+        }
+
+        default: {
+            // 固件版本字符串来自编译信息，按任意字节串测试解析
+            size_t len;
+            uint8_t *rest = xn_fuzz_rest(&in, &len);
+            char *version = malloc(len + 1);
+            memcpy(version, rest, len);
+            version[len] = '\0';
+            uint8_t parsed[3];
+            xn_blufi_proto_parse_version(version, parsed);
+            free(version);
+            free(rest);
+            break;
+        }
+    }
+
+    free(out);
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * @Description: SSID/密码复制路径的fuzz目标 - 长度由对端给出，可能为负或超出缓冲区
+ *
+ * 输入格式：[目标选择, 长度(2，大端，有符号), 数据]。目标缓冲区按设备端的
+ * SSID（33字节）/密码（65字节）或任意大小分配在堆上，源数据只有实际收到的字节。
+ */
+
+#include "xn_fuzz.h"
+#include "xn_blufi_proto.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    xn_fuzz_input_t in = { data, size };
+
+    uint8_t select = xn_fuzz_u8(&in);
+    size_t dst_size;
+    switch (select % 3) {
+        case 0:  dst_size = XN_WIFI_SSID_MAX_LEN + 1; break;
+        case 1:  dst_size = XN_WIFI_PASSWORD_MAX_LEN + 1; break;
+        default: dst_size = select / 3; break;
+    }
+    int16_t claimed = (int16_t)xn_fuzz_u16(&in);
+
+    size_t avail;
+    uint8_t *src = xn_fuzz_rest(&in, &avail);
+
+    // 声明的长度不能超过实际收到的数据（协议栈保证），负数原样传入
+    int len = claimed < 0 ? claimed : (int)((size_t)claimed < avail ? (size_t)claimed : avail);
+
+    uint8_t *dst = malloc(dst_size ? dst_size : 1);
+    memset(dst, 0xAA, dst_size);
+    esp_err_t ret = xn_blufi_proto_copy_field(dst_size ? dst : NULL, dst_size, len ? src : NULL, len);
+
+    if (dst_size == 0 || len < 0) {
+        XN_FUZZ_CHECK(ret == ESP_ERR_INVALID_ARG);
+    } else if ((size_t)len >= dst_size) {
+        XN_FUZZ_CHECK(ret == ESP_ERR_INVALID_SIZE);
+    } else {
+        // 成功时内容一致，其余字节全部为0（结尾有'\0'）
+        XN_FUZZ_CHECK(ret == ESP_OK);
+        XN_FUZZ_CHECK(memcmp(dst, src, len) == 0);
+        for (size_t i = len; i < dst_size; i++) {
+            XN_FUZZ_CHECK(dst[i] == 0);
+        }
+    }
+
+    free(dst);
+    free(src);
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * @Description: 自定义数据命令的fuzz目标 - 按设备端的分发流程解析命令并构建回复
+ *
+ * 输入格式：[帧长, 帧, 配置数, [SSID长度, 密码长度, SSID, 密码]..., 连接状态]。
+ * 帧是小程序发来的自定义数据，其余字节构造设备端的配置列表（长度在存储层保证的范围内）
+ * 和连接状态，覆盖解析失败、各命令的回复以及配置列表超出回复缓冲区时的回退。
+ * 配置列表回复会按协议重新解码，与构造的配置逐项比对。
+ */
+
+#include "xn_fuzz.h"
+#include "xn_blufi_proto.h"
+
+/* 按协议解码配置列表回复，与原配置比对 */
+static void check_config_list(const uint8_t *resp, size_t len, const xn_wifi_config_t *configs, uint8_t count)
+{
+    XN_FUZZ_CHECK(len >= 3);
+    XN_FUZZ_CHECK(resp[0] == XN_BLUFI_CMD_GET_CONFIGS);
+    if (resp[1] == XN_BLUFI_STATUS_FAIL) {
+        XN_FUZZ_CHECK(resp[2] == 0 && len == 3);
+        return;
+    }
+    XN_FUZZ_CHECK(resp[1] == XN_BLUFI_STATUS_OK && resp[2] == count);
+    size_t offset = 3;
+    for (int i = 0; i < count; i++) {
+        XN_FUZZ_CHECK(offset < len && resp[offset] == configs[i].ssid_len);
+        offset++;
+        XN_FUZZ_CHECK(offset + configs[i].ssid_len < len);
+        XN_FUZZ_CHECK(memcmp(&resp[offset], configs[i].ssid, configs[i].ssid_len) == 0);
+        offset += configs[i].ssid_len;
+        XN_FUZZ_CHECK(resp[offset] == configs[i].password_len);
+        offset++;
+        XN_FUZZ_CHECK(offset + configs[i].password_len <= len);
+        XN_FUZZ_CHECK(memcmp(&resp[offset], configs[i].password, configs[i].password_len) == 0);
+        offset += configs[i].password_len;
+    }
+    XN_FUZZ_CHECK(offset == len);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    xn_fuzz_input_t in = { data, size };
+
+    // 小程序发来的帧放在等长的堆缓冲区里，解析越界读能被ASan发现
+    uint8_t frame_len = xn_fuzz_u8(&in);
+    uint8_t *frame = malloc(frame_len ? frame_len : 1);
+    frame_len = (uint8_t)xn_fuzz_take(&in, frame, frame_len);
+
+    static xn_wifi_config_t configs[10];
+    memset(configs, 0, sizeof(configs));
+    uint8_t count = xn_fuzz_u8(&in) % 11;
+    for (int i = 0; i < count; i++) {
+        configs[i].ssid_len = xn_fuzz_u8(&in) % (XN_WIFI_SSID_MAX_LEN + 1);
+        configs[i].password_len = xn_fuzz_u8(&in) % (XN_WIFI_PASSWORD_MAX_LEN + 1);
+        xn_fuzz_take(&in, configs[i].ssid, configs[i].ssid_len);
+        xn_fuzz_take(&in, configs[i].password, configs[i].password_len);
+    }
+
+    xn_blufi_cmd_t cmd;
+    esp_err_t ret = xn_blufi_proto_parse(frame_len ? frame : NULL, frame_len, &cmd);
+    if (ret != ESP_OK) {
+        XN_FUZZ_CHECK(ret == ESP_ERR_INVALID_SIZE || ret == ESP_ERR_NOT_SUPPORTED);
+        free(frame);
+        return 0;
+    }
+    XN_FUZZ_CHECK(frame_len >= 1 && cmd.type == frame[0]);
+
+    switch (cmd.type) {
+        case XN_BLUFI_CMD_GET_CONFIGS: {
+            // 与设备端相同：超出回复缓冲区时改发"未找到"
+            uint8_t response[XN_BLUFI_PROTO_MAX_RESPONSE];
+            size_t len = xn_blufi_proto_build_config_list(configs, count, response, sizeof(response));
+            if (len == 0) {
+                len = xn_blufi_proto_build_config_list(NULL, 0, response, sizeof(response));
+                XN_FUZZ_CHECK(len == 3 && count > 0);
+                check_config_list(response, len, NULL, 0);
+            } else {
+                XN_FUZZ_CHECK(len <= sizeof(response));
+                check_config_list(response, len, configs, count);
+            }
+            break;
+        }
+
+        case XN_BLUFI_CMD_GET_STATUS: {
+            xn_blufi_status_report_t report;
+            xn_fuzz_take(&in, &report, sizeof(report));
+            uint8_t response[XN_BLUFI_PROTO_STATUS_REPORT_LEN];
+            size_t len = xn_blufi_proto_build_status_report(&report, response, sizeof(response));
+            XN_FUZZ_CHECK(len == XN_BLUFI_PROTO_STATUS_REPORT_LEN);
+            XN_FUZZ_CHECK(response[0] == XN_BLUFI_CMD_GET_STATUS && response[2] == report.wifi_status);
+            break;
+        }
+
+        case XN_BLUFI_CMD_DELETE_CONFIG: {
+            XN_FUZZ_CHECK(frame_len >= 2 && cmd.index == frame[1]);
+            uint8_t response[2];
+            size_t len = xn_blufi_proto_build_status(XN_BLUFI_CMD_DELETE_CONFIG,
+                                                     cmd.index < count ? XN_BLUFI_STATUS_OK : XN_BLUFI_STATUS_FAIL,
+                                                     response, sizeof(response));
+            XN_FUZZ_CHECK(len == 2 && response[0] == XN_BLUFI_CMD_DELETE_CONFIG);
+            break;
+        }
+
+        default:
+            XN_FUZZ_CHECK(!"parse accepted an unknown command");
+    }
+
+    free(frame);
+    return 0;
+}
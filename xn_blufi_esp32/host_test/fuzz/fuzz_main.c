@@ -0,0 +1,62 @@
+/*
+ * @Description: fuzz目标的回放入口 - 编译器不支持libFuzzer（GCC）时链接，
+ * 把参数中的文件和目录（不递归）逐个作为输入执行一遍，用于在ctest中回放种子语料和崩溃用例
+ */
+
+#include "xn_fuzz.h"
+#include <dirent.h>
+#include <sys/stat.h>
+
+static int run_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    static uint8_t buf[64 * 1024];
+    size_t len = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+
+    // 复制到等长的堆缓冲区，与libFuzzer一样让越界读能被ASan发现
+    uint8_t *data = malloc(len ? len : 1);
+    memcpy(data, buf, len);
+    LLVMFuzzerTestOneInput(data, len);
+    free(data);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int count = 0;
+    int failed = 0;
+    for (int i = 1; i < argc; i++) {
+        struct stat st;
+        if (stat(argv[i], &st) != 0) {
+            perror(argv[i]);
+            failed++;
+            continue;
+        }
+        if (!S_ISDIR(st.st_mode)) {
+            failed += run_file(argv[i]);
+            count++;
+            continue;
+        }
+        DIR *dir = opendir(argv[i]);
+        struct dirent *entry;
+        while (dir != NULL && (entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/%s", argv[i], entry->d_name);
+            failed += run_file(path);
+            count++;
+        }
+        if (dir != NULL) {
+            closedir(dir);
+        }
+    }
+    printf("executed %d inputs\n", count);
+    return (failed || count == 0) ? 1 : 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * @Description: fuzz目标的公共部分 - libFuzzer入口声明和按字节消费输入的读取器
+ *
+ * 输入不够时读取器返回0/空，目标照常执行，保证任意长度的输入都是合法用例。
+ * 断言失败直接abort()，libFuzzer和回放程序都把它当作崩溃。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#define XN_FUZZ_CHECK(cond)                                                         \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);\
+            abort();                                                                \
+        }                                                                           \
+    } while (0)
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+} xn_fuzz_input_t;
+
+static inline uint8_t xn_fuzz_u8(xn_fuzz_input_t *in)
+{
+    if (in->size == 0) {
+        return 0;
+    }
+    uint8_t v = in->data[0];
+    in->data++;
+    in->size--;
+    return v;
+}
+
+static inline uint16_t xn_fuzz_u16(xn_fuzz_input_t *in)
+{
+    uint16_t hi = xn_fuzz_u8(in);
+    return (uint16_t)((hi << 8) | xn_fuzz_u8(in));
+}
+
+static inline uint32_t xn_fuzz_u32(xn_fuzz_input_t *in)
+{
+    uint32_t hi = xn_fuzz_u16(in);
+    return (hi << 16) | xn_fuzz_u16(in);
+}
+
+/* 取至多len字节到dst，不足部分补0，返回实际取到的字节数 */
+static inline size_t xn_fuzz_take(xn_fuzz_input_t *in, void *dst, size_t len)
+{
+    size_t n = len < in->size ? len : in->size;
+    memcpy(dst, in->data, n);
+    memset((uint8_t *)dst + n, 0, len - n);
+    in->data += n;
+    in->size -= n;
+    return n;
+}
+
+/* 把剩余输入复制到恰好等长的堆缓冲区（越界读写能被ASan发现），调用者free */
+static inline uint8_t *xn_fuzz_rest(xn_fuzz_input_t *in, size_t *len)
+{
+    *len = in->size;
+    uint8_t *buf = malloc(in->size ? in->size : 1);
+    memcpy(buf, in->data, in->size);
+    in->data += in->size;
+    in->size = 0;
+    return buf;
+}
@@ -0,0 +1,273 @@
+/*
+ * @Description: 主机仿真环境 - 虚拟时间的协作式调度器，以及WiFi、NVS、BLE/BluFi手机端的仿真
+ *
+ * 所有FreeRTOS任务都是pthread，但同一时刻只有一个在运行（持有全局锁），
+ * 按优先级抢占、同优先级先进先出；没有可运行任务时虚拟时间直接跳到下一个到期点，
+ * 所以测试里等待30秒不需要真的等待，结果也是确定的。
+ * 测试用例本身作为优先级1的"main"任务运行。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_wifi.h"
+#include "esp_blufi_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== 调度器 ==================== */
+
+/* 启动仿真（测试框架在每个用例的子进程中调用），当前线程成为"main"任务 */
+void sim_start(void);
+
+/* 当前虚拟时间（微秒，与esp_timer_get_time()相同） */
+int64_t sim_now_us(void);
+
+/* 虚拟时间前进ms毫秒，期间其他任务照常运行 */
+void sim_run_ms(uint32_t ms);
+
+/* 运行直到cond(arg)为真或超时，返回cond是否满足 */
+bool sim_run_until(bool (*cond)(void *arg), void *arg, uint32_t timeout_ms);
+
+/* 当前运行任务名 */
+const char *sim_task_name(void);
+
+/* 任务创建参数 */
+typedef struct {
+    int priority;
+    int core;                               // xTaskCreatePinnedToCore()的核参数，不绑定为tskNO_AFFINITY
+    uint32_t stack_size;
+} sim_task_info_t;
+
+/* 按名查找未退出的任务（同名取最后创建的），不存在时返回false */
+bool sim_task_find(const char *name, sim_task_info_t *info);
+
+/* 设置任务的栈高水位（uxTaskGetStackHighWaterMark()的返回值，默认栈大小的一半） */
+bool sim_task_set_high_water(const char *name, uint32_t high_water);
+
+/* esp_restart()是否被调用过、调用它的任务和时间 */
+bool sim_restarted(const char **task, int64_t *at_us);
+
+/* 设置唤醒原因（快速唤醒测试） */
+void sim_set_wakeup_cause(int cause);
+
+/* 系统时间未校准（上电冷启动、SNTP之前），time()从1970年开始 */
+void sim_set_time_unset(bool unset);
+
+/* 日志级别：'E'/'W'/'I'/'D'，默认取环境变量XN_SIM_LOG，未设置时为'W' */
+void sim_set_log_level(char level);
+
+/* 把指定tag的日志正文（每条一行，不受日志级别限制）追加到buf，buf为NULL时停止 */
+void sim_log_capture(const char *tag, char *buf, size_t cap);
+
+/* ==================== 蓝牙/WiFi共存 ==================== */
+
+/* 当前共存偏好（esp_coex_preference_set()最后写入的值，初始为BALANCE），sets返回设置次数 */
+esp_coex_prefer_t sim_coex_preference(uint32_t *sets);
+
+/* ==================== 堆分配统计 ==================== */
+
+typedef struct {
+    uint32_t allocs;                        // malloc/calloc/realloc次数（含FreeRTOS/esp_timer对象的动态创建）
+    uint32_t frees;
+    size_t bytes;
+    char last_task[16];                     // 最后一次分配所在任务
+    size_t last_size;
+    uint32_t tasks;                         // 动态创建的任务数（栈在堆上），计入allocs
+    char last_new_task[16];                 // 最后一个动态创建的任务名
+} sim_heap_stats_t;
+
+/* 开始统计（清零），返回是否支持（ASan构建下不替换malloc，返回false） */
+bool sim_heap_trace_start(void);
+void sim_heap_trace_stop(sim_heap_stats_t *stats);
+
+/* 仿真内部和测试辅助代码的分配不计入统计 */
+void sim_heap_pause(void);
+void sim_heap_resume(void);
+
+/* 记一次"组件侧"分配（FreeRTOS对象/定时器的动态创建） */
+void sim_heap_note_alloc(size_t size);
+
+/* ==================== WiFi ==================== */
+
+typedef struct {
+    const char *ssid;
+    const char *password;                   // 开放网络为""
+    wifi_auth_mode_t authmode;
+    uint8_t bssid[6];
+    uint8_t channel;
+    int8_t rssi;
+    uint32_t lease_s;                       // DHCP租期
+    bool online;
+} sim_ap_t;
+
+typedef struct {
+    uint32_t scan_ms;                       // 全信道扫描（连接前和主动扫描）
+    uint32_t scan_channel_ms;               // 指定信道扫描
+    uint32_t auth_ms;                       // 认证+关联+四次握手
+    uint32_t dhcp_ms;                       // 关联后到获取IP
+    uint32_t leave_ms;                      // 主动断开到DISCONNECTED事件
+} sim_wifi_timing_t;
+
+typedef struct {
+    uint32_t connect_calls;                 // esp_wifi_connect()次数
+    uint32_t attempts;                      // 实际开始的连接尝试
+    uint32_t disconnect_calls;
+    uint32_t scans;                         // 主动扫描次数（不含连接前扫描）
+    uint32_t direct_connects;               // 带BSSID+信道、跳过扫描的尝试
+    uint32_t pmk_connects;                  // 以64位十六进制PMK连接的尝试
+    uint32_t set_config_calls;
+    uint32_t set_config_rejected;           // 连接过程中set_config被拒绝
+    uint32_t connect_rejected;              // 连接过程中connect被拒绝
+    uint32_t dhcp_leases;                   // DHCP分配地址的次数（静态地址不计）
+    uint32_t dhcp_unlocked_reads;           // 在TCP/IP任务之外（未经esp_netif_tcpip_exec）取lwIP DHCP状态
+    int last_ap;                            // 最近一次关联的AP下标，-1为无
+} sim_wifi_stats_t;
+
+/* 添加AP，返回下标 */
+int sim_wifi_add_ap(const sim_ap_t *ap);
+void sim_wifi_set_online(int ap, bool online);
+void sim_wifi_set_rssi(int ap, int8_t rssi);
+
+/* 修改时序（0表示保持不变） */
+void sim_wifi_set_timing(const sim_wifi_timing_t *timing);
+
+/* 接下来count次连接尝试以reason失败（在认证阶段结束时上报） */
+void sim_wifi_fail_next(uint32_t count, uint8_t reason);
+
+/* 已连接时断开（AP踢出/信号丢失），上报DISCONNECTED(reason) */
+void sim_wifi_drop_link(uint8_t reason);
+
+/* 上报一次BEACON_TIMEOUT */
+void sim_wifi_beacon_timeout(void);
+
+/* 当前连接的AP下标，未关联为-1 */
+int sim_wifi_connected_ap(void);
+
+/* 是否已获取IP */
+bool sim_wifi_has_ip(void);
+
+/* esp_wifi_start()之后、esp_wifi_stop()之前为true */
+bool sim_wifi_started(void);
+
+/* 下一次esp_wifi_init()返回err（WiFi初始化失败） */
+void sim_wifi_fail_init(esp_err_t err);
+
+void sim_wifi_get_stats(sim_wifi_stats_t *stats);
+
+/* 最近一次esp_wifi_set_config()写入的配置 */
+void sim_wifi_get_sta_config(wifi_sta_config_t *config);
+
+/* ==================== NVS ==================== */
+
+/* 从此刻起第n次（从1开始）写操作起（set_*、erase_*、commit）全部返回ESP_FAIL且不生效，0为关闭 */
+void sim_nvs_fail_after(uint32_t n);
+
+/* 已执行的写操作次数（含失败的） */
+uint32_t sim_nvs_write_ops(void);
+
+/* 最后一次写操作所在任务 */
+const char *sim_nvs_last_writer(void);
+
+/* 导出/导入整个NVS分区（跨进程模拟重启），返回字节数，cap不足返回0 */
+size_t sim_nvs_export(void *buf, size_t cap);
+void sim_nvs_import(const void *buf, size_t len);
+
+/* Flash原始写入日志中是否出现过指定字节序列（擦除/覆盖的旧数据在页回收前仍留在Flash上） */
+bool sim_nvs_raw_contains(const void *needle, size_t len);
+
+/* 当前有效数据中是否出现过指定字节序列 */
+bool sim_nvs_live_contains(const void *needle, size_t len);
+
+/* 读取一个blob（测试检查存储格式用），返回长度，不存在返回0 */
+size_t sim_nvs_peek_blob(const char *ns, const char *key, void *buf, size_t cap);
+
+/* ==================== BLE / BluFi手机端 ==================== */
+
+typedef enum {
+    SIM_MSG_CONN_REPORT,                    // esp_blufi_send_wifi_conn_report
+    SIM_MSG_WIFI_LIST,
+    SIM_MSG_CUSTOM,
+    SIM_MSG_ERROR,
+    SIM_MSG_NEG,                            // 协商数据
+} sim_msg_type_t;
+
+typedef struct {
+    sim_msg_type_t type;
+    int64_t at_us;                          // 设备发出的时间
+    bool encrypted;                         // 帧是否加密传输
+    uint8_t state;                          // 连接报告的连接状态/错误码
+    uint8_t ssid[33];                       // 连接报告中的SSID
+    uint8_t ssid_len;
+    uint8_t data[1024];                     // 原始负载（WiFi列表/自定义数据/协商数据）
+    size_t len;
+} sim_msg_t;
+
+typedef struct {
+    uint32_t adv_starts;
+    uint32_t adv_stops;
+    bool adv_active;
+    uint16_t itvl_min;                      // 当前广播间隔（0.625ms单位）
+    uint8_t mfg_data[31];                   // 扫描响应中的厂商数据
+    uint8_t mfg_len;
+    bool connected;
+    bool nimble_running;
+    char init_task[16];                     // 调用esp_nimble_init()的任务
+    bool blufi_ready;                       // 已收到INIT_FINISH
+    uint32_t errors;                        // 设备发出的错误报告数（sim_phone_wait丢弃的也计入）
+    uint8_t last_error;                     // 最近一次错误报告的esp_blufi_error_state_t
+} sim_ble_state_t;
+
+void sim_ble_get_state(sim_ble_state_t *state);
+
+/* 下一次esp_nimble_init()返回err（蓝牙初始化失败） */
+void sim_ble_fail_init(esp_err_t err);
+
+/* 手机连接/断开 */
+void sim_phone_connect(void);
+void sim_phone_disconnect(void);
+
+/* DH协商并开启加密+校验，返回是否成功 */
+bool sim_phone_negotiate(void);
+
+/* 协商时让手机发送指定长度的参数长度帧（fuzz/边界测试） */
+void sim_phone_send_param_len(uint16_t len);
+
+/* 配网帧 */
+void sim_phone_send_ssid(const void *ssid, size_t len);
+void sim_phone_send_password(const void *password, size_t len);
+void sim_phone_send_connect(void);
+void sim_phone_send_disconnect_ap(void);
+void sim_phone_send_get_status(void);
+void sim_phone_send_get_list(void);
+void sim_phone_send_custom(const void *data, size_t len);
+
+/* 取出下一条设备发来的消息，没有返回false */
+bool sim_phone_recv(sim_msg_t *msg);
+
+/* 等待某类消息（丢弃其他类型），超时返回false */
+bool sim_phone_wait(sim_msg_type_t type, sim_msg_t *msg, uint32_t timeout_ms);
+
+/* 设备发出的帧中是否出现过指定明文（检查密码是否明文上空） */
+bool sim_ble_air_contains(const void *needle, size_t len);
+
+/* ==================== mbedTLS ==================== */
+
+typedef struct {
+    uint32_t pbkdf2_calls;
+    char pbkdf2_task[16];                   // 最后一次PBKDF2所在任务
+    uint32_t setkey_calls;
+} sim_crypto_stats_t;
+
+void sim_crypto_get_stats(sim_crypto_stats_t *stats);
+
+/* 接下来count次mbedtls_aes_setkey_enc()返回错误 */
+void sim_crypto_fail_setkey(uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
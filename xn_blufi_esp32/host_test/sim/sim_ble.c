@@ -0,0 +1,1042 @@
+/*
+ * @Description: BLE/BluFi仿真 - BT控制器、NimBLE主机、GAP广播、BluFi帧收发，以及手机端
+ *
+ * 帧格式与ESP-IDF BluFi一致：[类型, 帧控制, 序号, 数据长度, 数据..., 校验和(2字节小端)]。
+ * 手机发来的帧放入主机队列，由"nimble_host"任务（组件创建）在nimble_port_run()中处理：
+ * 检查序号、解密、校验、重组分片后按类型回调BluFi事件，与IDF的btc_blufi_recv_handler相同。
+ * 设备发出的帧按安全模式加密/加校验后放入手机收件箱，手机端解密、校验后解析成sim_msg_t。
+ */
+
+#include "sim_internal.h"
+#include "esp_bt.h"
+#include "esp_blufi.h"
+#include "host/ble_hs.h"
+#include <openssl/evp.h>
+#include <openssl/bn.h>
+
+/* 帧类型（低2位为类型，高6位为子类型） */
+#define TYPE_CTRL                   0
+#define TYPE_DATA                   1
+#define BUILD_TYPE(type, sub)       (uint8_t)(((sub) << 2) | (type))
+#define CTRL_SET_SEC_MODE           0x01
+#define CTRL_SET_WIFI_OPMODE        0x02
+#define CTRL_CONNECT_WIFI           0x03
+#define CTRL_DISCONNECT_WIFI        0x04
+#define CTRL_GET_WIFI_STATUS        0x05
+#define CTRL_DEAUTHENTICATE_STA     0x06
+#define CTRL_DISCONNECT_BLE         0x08
+#define CTRL_GET_WIFI_LIST          0x09
+#define DATA_NEG                    0x00
+#define DATA_STA_BSSID              0x01
+#define DATA_STA_SSID               0x02
+#define DATA_STA_PASSWD             0x03
+#define DATA_WIFI_CONN_REPORT       0x0f
+#define DATA_WIFI_LIST              0x11
+#define DATA_ERROR_INFO             0x12
+#define DATA_CUSTOM_DATA            0x13
+
+/* 帧控制位 */
+#define FC_ENC                      0x01
+#define FC_CHECK                    0x02
+#define FC_DIR_DEVICE               0x04
+#define FC_FRAG                     0x10
+
+/* 安全模式 */
+#define SEC_DATA_CHECK              0x01
+#define SEC_DATA_ENC                0x02
+#define SEC_CTRL_CHECK              0x10
+#define SEC_CTRL_ENC                0x20
+
+#define FRAG_CHUNK                  128     // 每帧最大负载（不含分片长度）
+#define AGGR_MAX                    2048    // 分片重组缓冲区
+#define HOST_QUEUE_LEN              64
+#define INBOX_LEN                   64
+#define AIR_LOG_SIZE                (256 * 1024)
+
+typedef enum {
+    ACT_CONNECT,
+    ACT_DISCONNECT,
+    ACT_FRAME,
+} host_act_type_t;
+
+typedef struct {
+    host_act_type_t type;
+    uint8_t frame[4 + 255 + 2];
+    size_t len;
+} host_act_t;
+
+typedef struct {
+    uint8_t buf[AGGR_MAX];
+    size_t total;
+    size_t offset;
+} aggr_t;
+
+/* 设备端 */
+struct ble_hs_cfg ble_hs_cfg;
+static bool s_ctrl_init;
+static bool s_ctrl_enabled;
+static bool s_nimble_init;
+static esp_err_t s_nimble_init_error;    // sim_ble_fail_init()
+static bool s_running;
+static bool s_stop;
+static char s_dev_name[32] = "nimble";
+static esp_blufi_callbacks_t s_cbs;
+static sim_ble_state_t s_state;
+static ble_gap_event_fn *s_adv_cb;
+static void *s_adv_cb_arg;
+static ble_gap_event_fn *s_conn_cb;
+static void *s_conn_cb_arg;
+static uint8_t s_sec_mode;
+static uint8_t s_recv_seq;
+static uint8_t s_send_seq;
+static aggr_t s_dev_aggr;
+static host_act_t s_actions[HOST_QUEUE_LEN];
+static uint32_t s_act_head;
+static uint32_t s_act_count;
+
+/* 手机端 */
+static sim_msg_t s_inbox[INBOX_LEN];
+static uint32_t s_inbox_head;
+static uint32_t s_inbox_count;
+static uint8_t s_phone_seq;
+static uint8_t s_phone_recv_seq;
+static bool s_phone_has_key;
+static uint8_t s_phone_key[16];
+static aggr_t s_phone_aggr;
+static uint8_t s_air[AIR_LOG_SIZE];
+static size_t s_air_len;
+
+static void air_log(const uint8_t *data, size_t len)
+{
+    if (s_air_len + len <= sizeof(s_air)) {
+        memcpy(s_air + s_air_len, data, len);
+        s_air_len += len;
+    }
+}
+
+bool sim_ble_air_contains(const void *needle, size_t len)
+{
+    return len > 0 && memmem(s_air, s_air_len, needle, len) != NULL;
+}
+
+void sim_ble_get_state(sim_ble_state_t *state)
+{
+    *state = s_state;
+}
+
+/* ==================== BT控制器 / NimBLE ==================== */
+
+void sim_ble_fail_init(esp_err_t err)
+{
+    s_nimble_init_error = err;
+}
+
+bool sim_ble_controller_enabled(void)
+{
+    return s_ctrl_enabled;
+}
+
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *config)
+{
+    if (s_ctrl_init) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_ctrl_init = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode)
+{
+    if (!s_ctrl_init || s_ctrl_enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_ctrl_enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_disable(void)
+{
+    if (!s_ctrl_enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_ctrl_enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_deinit(void)
+{
+    if (!s_ctrl_init || s_ctrl_enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_ctrl_init = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_nimble_init(void)
+{
+    if (!s_ctrl_enabled || s_nimble_init) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_nimble_init_error != ESP_OK) {
+        esp_err_t err = s_nimble_init_error;
+        s_nimble_init_error = ESP_OK;
+        return err;
+    }
+    s_nimble_init = true;
+    snprintf(s_state.init_task, sizeof(s_state.init_task), "%s", sim_task_name());
+    return ESP_OK;
+}
+
+esp_err_t esp_nimble_deinit(void)
+{
+    s_nimble_init = false;
+    return ESP_OK;
+}
+
+static bool host_wake(void *arg)
+{
+    return s_act_count > 0 || s_stop;
+}
+
+static void host_handle(host_act_t *act);
+
+void nimble_port_run(void)
+{
+    s_running = true;
+    s_stop = false;
+    s_state.nimble_running = true;
+    if (ble_hs_cfg.sync_cb != NULL) {
+        ble_hs_cfg.sync_cb();
+    }
+    for (;;) {
+        sim_block(host_wake, NULL, -1);
+        if (s_stop) {
+            break;
+        }
+        host_act_t *act = &s_actions[s_act_head];
+        host_handle(act);
+        s_act_head = (s_act_head + 1) % HOST_QUEUE_LEN;
+        s_act_count--;
+    }
+    s_running = false;
+    s_state.nimble_running = false;
+}
+
+static bool host_stopped(void *arg)
+{
+    return !s_running;
+}
+
+int nimble_port_stop(void)
+{
+    if (!s_running) {
+        return ESP_FAIL;
+    }
+    s_stop = true;
+    sim_block(host_stopped, NULL, -1);
+    return 0;
+}
+
+void nimble_port_deinit(void)
+{
+}
+
+void nimble_port_freertos_deinit(void)
+{
+}
+
+int ble_store_util_status_rr(void *event, void *arg)
+{
+    return 0;
+}
+
+int ble_svc_gap_device_name_set(const char *name)
+{
+    if (name == NULL || strlen(name) >= sizeof(s_dev_name)) {
+        return BLE_HS_EBUSY;
+    }
+    snprintf(s_dev_name, sizeof(s_dev_name), "%s", name);
+    return 0;
+}
+
+const char *ble_svc_gap_device_name(void)
+{
+    return s_dev_name;
+}
+
+int ble_hs_id_infer_auto(int privacy, uint8_t *out_addr_type)
+{
+    *out_addr_type = BLE_ADDR_PUBLIC;
+    return 0;
+}
+
+int ble_hs_id_copy_addr(uint8_t id_addr_type, uint8_t *out_id_addr, int *out_is_nrpa)
+{
+    esp_read_mac(out_id_addr, ESP_MAC_BT);
+    if (out_is_nrpa != NULL) {
+        *out_is_nrpa = 0;
+    }
+    return 0;
+}
+
+/* ==================== GAP广播 ==================== */
+
+int ble_gap_adv_set_fields(const struct ble_hs_adv_fields *fields)
+{
+    return fields != NULL ? 0 : BLE_HS_EBUSY;
+}
+
+int ble_gap_adv_rsp_set_fields(const struct ble_hs_adv_fields *fields)
+{
+    if (fields == NULL || fields->mfg_data_len > sizeof(s_state.mfg_data)) {
+        return BLE_HS_EBUSY;
+    }
+    memcpy(s_state.mfg_data, fields->mfg_data, fields->mfg_data_len);
+    s_state.mfg_len = fields->mfg_data_len;
+    return 0;
+}
+
+int ble_gap_adv_start(uint8_t own_addr_type, const void *direct_addr, int32_t duration_ms,
+                      const struct ble_gap_adv_params *params, ble_gap_event_fn *cb, void *cb_arg)
+{
+    if (!s_running) {
+        return BLE_HS_EBUSY;
+    }
+    if (s_state.adv_active) {
+        return BLE_HS_EALREADY;
+    }
+    s_state.adv_active = true;
+    s_state.adv_starts++;
+    s_state.itvl_min = params != NULL ? params->itvl_min : 0;
+    s_adv_cb = cb;
+    s_adv_cb_arg = cb_arg;
+    return 0;
+}
+
+int ble_gap_adv_stop(void)
+{
+    if (!s_state.adv_active) {
+        return BLE_HS_EALREADY;
+    }
+    s_state.adv_active = false;
+    s_state.adv_stops++;
+    return 0;
+}
+
+int ble_gap_adv_active(void)
+{
+    return s_state.adv_active;
+}
+
+/* ==================== BluFi设备端 ==================== */
+
+esp_err_t esp_blufi_register_callbacks(esp_blufi_callbacks_t *callbacks)
+{
+    if (callbacks == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_cbs = *callbacks;
+    return ESP_OK;
+}
+
+void esp_blufi_gatt_svr_register_cb(struct ble_gatt_register_ctxt *ctxt, void *arg)
+{
+}
+
+int esp_blufi_gatt_svr_init(void)
+{
+    return 0;
+}
+
+int esp_blufi_gatt_svr_deinit(void)
+{
+    return 0;
+}
+
+void esp_blufi_btc_init(void)
+{
+}
+
+void esp_blufi_btc_deinit(void)
+{
+}
+
+static void blufi_event(esp_blufi_cb_event_t event, esp_blufi_cb_param_t *param)
+{
+    if (s_cbs.event_cb != NULL) {
+        s_cbs.event_cb(event, param);
+    }
+}
+
+esp_err_t esp_blufi_profile_init(void)
+{
+    s_state.blufi_ready = true;
+    blufi_event(ESP_BLUFI_EVENT_INIT_FINISH, NULL);
+    return ESP_OK;
+}
+
+esp_err_t esp_blufi_profile_deinit(void)
+{
+    s_state.blufi_ready = false;
+    blufi_event(ESP_BLUFI_EVENT_DEINIT_FINISH, NULL);
+    return ESP_OK;
+}
+
+/* 与IDF一致：按BluFi默认参数广播，GAP事件交给esp_blufi_handle_gap_events */
+void esp_blufi_adv_start(void)
+{
+    struct ble_gap_adv_params params = {
+        .conn_mode = BLE_GAP_CONN_MODE_UND,
+        .disc_mode = BLE_GAP_DISC_MODE_GEN,
+    };
+    ble_gap_adv_start(BLE_ADDR_PUBLIC, NULL, BLE_HS_FOREVER, &params, esp_blufi_handle_gap_events, NULL);
+}
+
+void esp_blufi_adv_stop(void)
+{
+    ble_gap_adv_stop();
+}
+
+int esp_blufi_handle_gap_events(struct ble_gap_event *event, void *arg)
+{
+    esp_blufi_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    switch (event->type) {
+    case BLE_GAP_EVENT_CONNECT:
+        if (event->connect.status == 0) {
+            param.connect.conn_id = event->connect.conn_handle;
+            blufi_event(ESP_BLUFI_EVENT_BLE_CONNECT, &param);
+        } else {
+            esp_blufi_adv_start();
+        }
+        break;
+    case BLE_GAP_EVENT_DISCONNECT:
+        blufi_event(ESP_BLUFI_EVENT_BLE_DISCONNECT, &param);
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+static void report_error(esp_blufi_error_state_t state)
+{
+    esp_blufi_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.report_error.state = state;
+    blufi_event(ESP_BLUFI_EVENT_REPORT_ERROR, &param);
+}
+
+/* ==================== 帧编解码 ==================== */
+
+static uint16_t frame_checksum(const uint8_t *frame)
+{
+    // 覆盖序号、长度和明文数据，与esp_blufi_checksum一致
+    return esp_crc16_be(0, &frame[2], frame[3] + 2);
+}
+
+/* 手机端AES-128-CFB，IV首字节为帧序号 */
+static void phone_crypt(bool encrypt, uint8_t seq, uint8_t *data, size_t len)
+{
+    uint8_t iv[16] = { seq };
+    sim_heap_pause();
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int outl = 0;
+    EVP_CipherInit_ex(ctx, EVP_aes_128_cfb128(), NULL, s_phone_key, iv, encrypt ? 1 : 0);
+    EVP_CipherUpdate(ctx, data, &outl, data, (int)len);
+    EVP_CIPHER_CTX_free(ctx);
+    sim_heap_resume();
+}
+
+/* 设备端发送：按安全模式分片、加校验、加密后放入手机收件箱 */
+static void phone_deliver(const uint8_t *frame);
+
+static esp_err_t device_send(uint8_t type, const uint8_t *data, size_t len)
+{
+    if (!s_state.connected) {
+        return ESP_OK;
+    }
+    bool ctrl = (type & 0x03) == TYPE_CTRL;
+    bool check = (s_sec_mode & (ctrl ? SEC_CTRL_CHECK : SEC_DATA_CHECK)) && s_cbs.checksum_func != NULL;
+    bool enc = (s_sec_mode & (ctrl ? SEC_CTRL_ENC : SEC_DATA_ENC)) && s_cbs.encrypt_func != NULL;
+    size_t remain = len;
+    do {
+        uint8_t frame[4 + 255 + 2];
+        bool frag = remain > FRAG_CHUNK;
+        size_t chunk = frag ? FRAG_CHUNK : remain;
+        size_t off = 0;
+        frame[0] = type;
+        frame[1] = FC_DIR_DEVICE | (check ? FC_CHECK : 0) | (enc ? FC_ENC : 0) | (frag ? FC_FRAG : 0);
+        frame[2] = s_send_seq++;
+        if (frag) {
+            frame[4] = (uint8_t)(remain & 0xff);
+            frame[5] = (uint8_t)(remain >> 8);
+            off = 2;
+        }
+        memcpy(&frame[4 + off], data + (len - remain), chunk);
+        frame[3] = (uint8_t)(chunk + off);
+        uint16_t sum = 0;
+        if (check) {
+            sum = s_cbs.checksum_func(frame[2], &frame[2], frame[3] + 2);
+        }
+        if (enc && s_cbs.encrypt_func(frame[2], &frame[4], frame[3]) != frame[3]) {
+            return ESP_FAIL;
+        }
+        size_t flen = 4 + frame[3];
+        if (check) {
+            frame[flen++] = (uint8_t)(sum & 0xff);
+            frame[flen++] = (uint8_t)(sum >> 8);
+        }
+        air_log(frame, flen);
+        phone_deliver(frame);
+        remain -= chunk;
+    } while (remain > 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_blufi_send_wifi_conn_report(wifi_mode_t opmode, esp_blufi_sta_conn_state_t sta_conn_state,
+                                          uint8_t softap_conn_num, esp_blufi_extra_info_t *extra_info)
+{
+    uint8_t buf[128];
+    size_t len = 0;
+    buf[len++] = (uint8_t)opmode;
+    buf[len++] = (uint8_t)sta_conn_state;
+    buf[len++] = softap_conn_num;
+    if (extra_info != NULL) {
+        if (extra_info->sta_bssid_set) {
+            buf[len++] = DATA_STA_BSSID;
+            buf[len++] = 6;
+            memcpy(&buf[len], extra_info->sta_bssid, 6);
+            len += 6;
+        }
+        if (extra_info->sta_ssid != NULL && extra_info->sta_ssid_len > 0 && extra_info->sta_ssid_len <= 32) {
+            buf[len++] = DATA_STA_SSID;
+            buf[len++] = (uint8_t)extra_info->sta_ssid_len;
+            memcpy(&buf[len], extra_info->sta_ssid, extra_info->sta_ssid_len);
+            len += extra_info->sta_ssid_len;
+        }
+    }
+    return device_send(BUILD_TYPE(TYPE_DATA, DATA_WIFI_CONN_REPORT), buf, len);
+}
+
+esp_err_t esp_blufi_send_wifi_list(uint16_t apCount, esp_blufi_ap_record_t *list)
+{
+    uint8_t buf[1024];
+    size_t len = 0;
+    for (uint16_t i = 0; i < apCount; i++) {
+        size_t ssid_len = strnlen((const char *)list[i].ssid, 32);
+        if (len + 2 + ssid_len > sizeof(buf)) {
+            break;
+        }
+        buf[len++] = (uint8_t)(ssid_len + 1);
+        buf[len++] = (uint8_t)list[i].rssi;
+        memcpy(&buf[len], list[i].ssid, ssid_len);
+        len += ssid_len;
+    }
+    return device_send(BUILD_TYPE(TYPE_DATA, DATA_WIFI_LIST), buf, len);
+}
+
+esp_err_t esp_blufi_send_custom_data(uint8_t *data, uint32_t data_len)
+{
+    if (data == NULL || data_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return device_send(BUILD_TYPE(TYPE_DATA, DATA_CUSTOM_DATA), data, data_len);
+}
+
+esp_err_t esp_blufi_send_error_info(esp_blufi_error_state_t state)
+{
+    uint8_t value = (uint8_t)state;
+    return device_send(BUILD_TYPE(TYPE_DATA, DATA_ERROR_INFO), &value, 1);
+}
+
+/* 设备端按类型分发一条完整的消息，与IDF的btc_blufi_protocol_handler一致 */
+static void device_dispatch(uint8_t type, uint8_t *data, size_t len)
+{
+    esp_blufi_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    uint8_t sub = type >> 2;
+    if ((type & 0x03) == TYPE_CTRL) {
+        switch (sub) {
+        case CTRL_SET_SEC_MODE:
+            if (len >= 1) {
+                s_sec_mode = data[0];
+            }
+            break;
+        case CTRL_SET_WIFI_OPMODE:
+            param.wifi_mode.op_mode = len >= 1 ? (wifi_mode_t)data[0] : WIFI_MODE_STA;
+            blufi_event(ESP_BLUFI_EVENT_SET_WIFI_OPMODE, &param);
+            break;
+        case CTRL_CONNECT_WIFI:
+            blufi_event(ESP_BLUFI_EVENT_REQ_CONNECT_TO_AP, NULL);
+            break;
+        case CTRL_DISCONNECT_WIFI:
+            blufi_event(ESP_BLUFI_EVENT_REQ_DISCONNECT_FROM_AP, NULL);
+            break;
+        case CTRL_GET_WIFI_STATUS:
+            blufi_event(ESP_BLUFI_EVENT_GET_WIFI_STATUS, NULL);
+            break;
+        case CTRL_DEAUTHENTICATE_STA:
+            blufi_event(ESP_BLUFI_EVENT_DEAUTHENTICATE_STA, NULL);
+            break;
+        case CTRL_DISCONNECT_BLE:
+            blufi_event(ESP_BLUFI_EVENT_RECV_SLAVE_DISCONNECT_BLE, NULL);
+            break;
+        case CTRL_GET_WIFI_LIST:
+            blufi_event(ESP_BLUFI_EVENT_GET_WIFI_LIST, NULL);
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+    switch (sub) {
+    case DATA_NEG: {
+        uint8_t *out = NULL;
+        int out_len = 0;
+        bool need_free = false;
+        if (s_cbs.negotiate_data_handler != NULL) {
+            s_cbs.negotiate_data_handler(data, (int)len, &out, &out_len, &need_free);
+        }
+        if (out != NULL && out_len > 0) {
+            device_send(BUILD_TYPE(TYPE_DATA, DATA_NEG), out, (size_t)out_len);
+        }
+        if (need_free) {
+            free(out);
+        }
+        break;
+    }
+    case DATA_STA_BSSID:
+        if (len >= 6) {
+            memcpy(param.sta_bssid.bssid, data, 6);
+            blufi_event(ESP_BLUFI_EVENT_RECV_STA_BSSID, &param);
+        }
+        break;
+    case DATA_STA_SSID:
+        param.sta_ssid.ssid = data;
+        param.sta_ssid.ssid_len = (int)len;
+        blufi_event(ESP_BLUFI_EVENT_RECV_STA_SSID, &param);
+        break;
+    case DATA_STA_PASSWD:
+        param.sta_passwd.passwd = data;
+        param.sta_passwd.passwd_len = (int)len;
+        blufi_event(ESP_BLUFI_EVENT_RECV_STA_PASSWD, &param);
+        break;
+    case DATA_CUSTOM_DATA:
+        param.custom_data.data = data;
+        param.custom_data.data_len = (uint32_t)len;
+        blufi_event(ESP_BLUFI_EVENT_RECV_CUSTOM_DATA, &param);
+        break;
+    default:
+        break;
+    }
+}
+
+/* 设备端收帧：序号、解密、校验、分片重组，与IDF的btc_blufi_recv_handler一致 */
+static void device_recv(uint8_t *frame, size_t flen)
+{
+    if (flen < 4 || flen < (size_t)4 + frame[3]) {
+        report_error(ESP_BLUFI_DATA_FORMAT_ERROR);
+        return;
+    }
+    uint8_t fc = frame[1];
+    uint8_t seq = frame[2];
+    uint8_t dlen = frame[3];
+    uint8_t *data = &frame[4];
+    if (seq != s_recv_seq) {
+        report_error(ESP_BLUFI_SEQUENCE_ERROR);
+        return;
+    }
+    s_recv_seq++;
+    if (fc & FC_ENC) {
+        if (s_cbs.decrypt_func == NULL || s_cbs.decrypt_func(seq, data, dlen) != dlen) {
+            report_error(ESP_BLUFI_DECRYPT_ERROR);
+            return;
+        }
+    }
+    if ((fc & FC_CHECK) && s_cbs.checksum_func != NULL) {
+        if (flen < (size_t)4 + dlen + 2) {
+            report_error(ESP_BLUFI_CHECKSUM_ERROR);
+            return;
+        }
+        uint16_t sum = s_cbs.checksum_func(seq, &frame[2], dlen + 2);
+        uint16_t pkt = (uint16_t)(data[dlen] | (data[dlen + 1] << 8));
+        if (sum != pkt) {
+            report_error(ESP_BLUFI_CHECKSUM_ERROR);
+            return;
+        }
+    }
+    aggr_t *ag = &s_dev_aggr;
+    if (fc & FC_FRAG) {
+        if (dlen < 2) {
+            report_error(ESP_BLUFI_DATA_FORMAT_ERROR);
+            return;
+        }
+        if (ag->offset == 0) {
+            ag->total = (size_t)(data[0] | (data[1] << 8));
+        }
+        if (ag->total > AGGR_MAX || ag->offset + dlen - 2 > ag->total) {
+            ag->offset = 0;
+            report_error(ESP_BLUFI_DATA_FORMAT_ERROR);
+            return;
+        }
+        memcpy(ag->buf + ag->offset, data + 2, dlen - 2);
+        ag->offset += dlen - 2;
+        return;
+    }
+    if (ag->offset > 0) {
+        if (ag->offset + dlen > ag->total) {
+            ag->offset = 0;
+            report_error(ESP_BLUFI_DATA_FORMAT_ERROR);
+            return;
+        }
+        memcpy(ag->buf + ag->offset, data, dlen);
+        size_t total = ag->offset + dlen;
+        ag->offset = 0;
+        device_dispatch(frame[0], ag->buf, total);
+        return;
+    }
+    device_dispatch(frame[0], data, dlen);
+}
+
+static void host_handle(host_act_t *act)
+{
+    struct ble_gap_event event;
+    memset(&event, 0, sizeof(event));
+    switch (act->type) {
+    case ACT_CONNECT:
+        // 只有正在广播时手机才能连上
+        if (s_state.connected || !s_state.adv_active) {
+            sim_log('W', "sim", "phone connect ignored (connected=%d adv=%d)", s_state.connected,
+                    s_state.adv_active);
+            return;
+        }
+        s_state.adv_active = false;
+        s_state.connected = true;
+        s_sec_mode = 0;
+        s_recv_seq = 0;
+        s_send_seq = 0;
+        s_dev_aggr.offset = 0;
+        s_conn_cb = s_adv_cb;
+        s_conn_cb_arg = s_adv_cb_arg;
+        event.type = BLE_GAP_EVENT_CONNECT;
+        event.connect.status = 0;
+        event.connect.conn_handle = 1;
+        if (s_conn_cb != NULL) {
+            s_conn_cb(&event, s_conn_cb_arg);
+        }
+        break;
+    case ACT_DISCONNECT:
+        if (!s_state.connected) {
+            return;
+        }
+        s_state.connected = false;
+        s_sec_mode = 0;
+        event.type = BLE_GAP_EVENT_DISCONNECT;
+        event.disconnect.reason = 0x213;
+        if (s_conn_cb != NULL) {
+            s_conn_cb(&event, s_conn_cb_arg);
+        }
+        break;
+    case ACT_FRAME:
+        if (s_state.connected) {
+            device_recv(act->frame, act->len);
+        }
+        break;
+    }
+}
+
+/* ==================== 手机端 ==================== */
+
+static void host_post(host_act_type_t type, const uint8_t *frame, size_t len)
+{
+    if (s_act_count >= HOST_QUEUE_LEN) {
+        fprintf(stderr, "[sim] BLE host queue overflow\n");
+        abort();
+    }
+    host_act_t *act = &s_actions[(s_act_head + s_act_count) % HOST_QUEUE_LEN];
+    act->type = type;
+    act->len = len;
+    if (len > 0) {
+        memcpy(act->frame, frame, len);
+    }
+    s_act_count++;
+    sim_preempt();
+}
+
+void sim_phone_connect(void)
+{
+    s_phone_seq = 0;
+    s_phone_recv_seq = 0;
+    s_phone_has_key = false;
+    s_phone_aggr.offset = 0;
+    host_post(ACT_CONNECT, NULL, 0);
+}
+
+void sim_phone_disconnect(void)
+{
+    s_phone_has_key = false;
+    host_post(ACT_DISCONNECT, NULL, 0);
+}
+
+/* 手机发送一条消息：超长时分片，协商完成后加密并加校验 */
+static void phone_send(uint8_t type, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    bool secure = s_phone_has_key;
+    size_t remain = len;
+    do {
+        uint8_t frame[4 + 255 + 2];
+        bool frag = remain > FRAG_CHUNK;
+        size_t chunk = frag ? FRAG_CHUNK : remain;
+        size_t off = 0;
+        frame[0] = type;
+        frame[1] = (secure ? FC_ENC | FC_CHECK : 0) | (frag ? FC_FRAG : 0);
+        frame[2] = s_phone_seq++;
+        if (frag) {
+            frame[4] = (uint8_t)(remain & 0xff);
+            frame[5] = (uint8_t)(remain >> 8);
+            off = 2;
+        }
+        if (chunk > 0) {
+            memcpy(&frame[4 + off], p + (len - remain), chunk);
+        }
+        frame[3] = (uint8_t)(chunk + off);
+        size_t flen = 4 + frame[3];
+        if (secure) {
+            uint16_t sum = frame_checksum(frame);
+            phone_crypt(true, frame[2], &frame[4], frame[3]);
+            frame[flen++] = (uint8_t)(sum & 0xff);
+            frame[flen++] = (uint8_t)(sum >> 8);
+        }
+        air_log(frame, flen);
+        host_post(ACT_FRAME, frame, flen);
+        remain -= chunk;
+    } while (remain > 0);
+}
+
+/* 手机端收帧：解密、校验、重组后解析 */
+static void phone_deliver(const uint8_t *in)
+{
+    uint8_t frame[4 + 255 + 2];
+    memcpy(frame, in, 4 + in[3] + ((in[1] & FC_CHECK) ? 2 : 0));
+    uint8_t fc = frame[1];
+    uint8_t dlen = frame[3];
+    uint8_t *data = &frame[4];
+    if (frame[2] != s_phone_recv_seq) {
+        fprintf(stderr, "[sim] phone: unexpected seq %u (want %u)\n", frame[2], s_phone_recv_seq);
+        abort();
+    }
+    s_phone_recv_seq++;
+    if (fc & FC_ENC) {
+        if (!s_phone_has_key) {
+            fprintf(stderr, "[sim] phone: encrypted frame before negotiation\n");
+            abort();
+        }
+        phone_crypt(false, frame[2], data, dlen);
+    }
+    if ((fc & FC_CHECK) && frame_checksum(frame) != (uint16_t)(data[dlen] | (data[dlen + 1] << 8))) {
+        fprintf(stderr, "[sim] phone: checksum mismatch on seq %u\n", frame[2]);
+        abort();
+    }
+    aggr_t *ag = &s_phone_aggr;
+    const uint8_t *payload = data;
+    size_t plen = dlen;
+    if (fc & FC_FRAG) {
+        if (ag->offset == 0) {
+            ag->total = (size_t)(data[0] | (data[1] << 8));
+        }
+        memcpy(ag->buf + ag->offset, data + 2, dlen - 2);
+        ag->offset += dlen - 2;
+        return;
+    }
+    if (ag->offset > 0) {
+        memcpy(ag->buf + ag->offset, data, dlen);
+        plen = ag->offset + dlen;
+        payload = ag->buf;
+        ag->offset = 0;
+    }
+
+    if (s_inbox_count >= INBOX_LEN) {
+        fprintf(stderr, "[sim] phone inbox overflow\n");
+        abort();
+    }
+    sim_msg_t *msg = &s_inbox[(s_inbox_head + s_inbox_count) % INBOX_LEN];
+    memset(msg, 0, sizeof(*msg));
+    msg->at_us = sim_now_us();
+    msg->encrypted = (fc & FC_ENC) != 0;
+    msg->len = plen < sizeof(msg->data) ? plen : sizeof(msg->data);
+    memcpy(msg->data, payload, msg->len);
+    switch (frame[0] >> 2) {
+    case DATA_NEG:
+        msg->type = SIM_MSG_NEG;
+        break;
+    case DATA_WIFI_CONN_REPORT:
+        msg->type = SIM_MSG_CONN_REPORT;
+        msg->state = plen >= 2 ? payload[1] : 0xff;
+        for (size_t i = 3; i + 2 <= plen; i += 2 + payload[i + 1]) {
+            if (payload[i] == DATA_STA_SSID && payload[i + 1] <= 32 && i + 2 + payload[i + 1] <= plen) {
+                msg->ssid_len = payload[i + 1];
+                memcpy(msg->ssid, &payload[i + 2], msg->ssid_len);
+            }
+        }
+        break;
+    case DATA_WIFI_LIST:
+        msg->type = SIM_MSG_WIFI_LIST;
+        break;
+    case DATA_ERROR_INFO:
+        msg->type = SIM_MSG_ERROR;
+        msg->state = plen >= 1 ? payload[0] : 0xff;
+        s_state.errors++;
+        s_state.last_error = msg->state;
+        break;
+    default:
+        msg->type = SIM_MSG_CUSTOM;
+        break;
+    }
+    s_inbox_count++;
+}
+
+bool sim_phone_recv(sim_msg_t *msg)
+{
+    if (s_inbox_count == 0) {
+        return false;
+    }
+    *msg = s_inbox[s_inbox_head];
+    s_inbox_head = (s_inbox_head + 1) % INBOX_LEN;
+    s_inbox_count--;
+    return true;
+}
+
+static bool inbox_pending(void *arg)
+{
+    return s_inbox_count > 0;
+}
+
+bool sim_phone_wait(sim_msg_type_t type, sim_msg_t *msg, uint32_t timeout_ms)
+{
+    int64_t deadline = sim_now_us() + (int64_t)timeout_ms * 1000;
+    for (;;) {
+        int64_t left = deadline - sim_now_us();
+        if (left < 0 || !sim_run_until(inbox_pending, NULL, (uint32_t)((left + 999) / 1000))) {
+            return false;
+        }
+        sim_phone_recv(msg);
+        if (msg->type == type) {
+            return true;
+        }
+    }
+}
+
+void sim_phone_send_param_len(uint16_t len)
+{
+    uint8_t neg[3] = { 0x00, (uint8_t)(len >> 8), (uint8_t)(len & 0xff) };
+    phone_send(BUILD_TYPE(TYPE_DATA, DATA_NEG), neg, sizeof(neg));
+}
+
+static size_t put_mpi(uint8_t *out, const BIGNUM *bn)
+{
+    int n = BN_num_bytes(bn);
+    out[0] = (uint8_t)(n >> 8);
+    out[1] = (uint8_t)(n & 0xff);
+    BN_bn2bin(bn, out + 2);
+    return 2 + (size_t)n;
+}
+
+bool sim_phone_negotiate(void)
+{
+    if (!s_state.connected) {
+        return false;
+    }
+    // 与官方客户端相同：1024位MODP群（RFC 2409第2组），G=2
+    sim_heap_pause();
+    BN_CTX *bn = BN_CTX_new();
+    BIGNUM *p = BN_get_rfc2409_prime_1024(NULL);
+    BIGNUM *g = BN_new();
+    BIGNUM *x = BN_new();
+    BIGNUM *gx = BN_new();
+    BN_set_word(g, 2);
+    uint8_t rnd[32];
+    esp_fill_random(rnd, sizeof(rnd));
+    BN_bin2bn(rnd, sizeof(rnd), x);
+    BN_mod_exp(gx, g, x, p, bn);
+    uint8_t param[1 + 3 * (2 + 128)];
+    size_t len = 1;
+    param[0] = 0x01;
+    len += put_mpi(&param[len], p);
+    len += put_mpi(&param[len], g);
+    len += put_mpi(&param[len], gx);
+    sim_heap_resume();
+
+    sim_phone_send_param_len((uint16_t)(len - 1));
+    phone_send(BUILD_TYPE(TYPE_DATA, DATA_NEG), param, len);
+
+    sim_msg_t msg;
+    bool ok = sim_phone_wait(SIM_MSG_NEG, &msg, 5000);
+    sim_heap_pause();
+    if (ok) {
+        BIGNUM *gy = BN_bin2bn(msg.data, (int)msg.len, NULL);
+        BIGNUM *k = BN_new();
+        BN_mod_exp(k, gy, x, p, bn);
+        uint8_t secret[128];
+        int slen = BN_bn2bin(k, secret);
+        EVP_Digest(secret, (size_t)slen, s_phone_key, NULL, EVP_md5(), NULL);
+        BN_free(gy);
+        BN_clear_free(k);
+    }
+    BN_free(p);
+    BN_free(g);
+    BN_clear_free(x);
+    BN_free(gx);
+    BN_CTX_free(bn);
+    sim_heap_resume();
+    if (!ok) {
+        return false;
+    }
+
+    // 之后手机发出的帧都加密并加校验，再让设备对数据帧和控制帧也这样做
+    s_phone_has_key = true;
+    uint8_t mode = SEC_DATA_CHECK | SEC_DATA_ENC | SEC_CTRL_CHECK | SEC_CTRL_ENC;
+    phone_send(BUILD_TYPE(TYPE_CTRL, CTRL_SET_SEC_MODE), &mode, 1);
+    return true;
+}
+
+void sim_phone_send_ssid(const void *ssid, size_t len)
+{
+    phone_send(BUILD_TYPE(TYPE_DATA, DATA_STA_SSID), ssid, len);
+}
+
+void sim_phone_send_password(const void *password, size_t len)
+{
+    phone_send(BUILD_TYPE(TYPE_DATA, DATA_STA_PASSWD), password, len);
+}
+
+void sim_phone_send_connect(void)
+{
+    phone_send(BUILD_TYPE(TYPE_CTRL, CTRL_CONNECT_WIFI), NULL, 0);
+}
+
+void sim_phone_send_disconnect_ap(void)
+{
+    phone_send(BUILD_TYPE(TYPE_CTRL, CTRL_DISCONNECT_WIFI), NULL, 0);
+}
+
+void sim_phone_send_get_status(void)
+{
+    phone_send(BUILD_TYPE(TYPE_CTRL, CTRL_GET_WIFI_STATUS), NULL, 0);
+}
+
+void sim_phone_send_get_list(void)
+{
+    phone_send(BUILD_TYPE(TYPE_CTRL, CTRL_GET_WIFI_LIST), NULL, 0);
+}
+
+void sim_phone_send_custom(const void *data, size_t len)
+{
+    phone_send(BUILD_TYPE(TYPE_DATA, DATA_CUSTOM_DATA), data, len);
+}
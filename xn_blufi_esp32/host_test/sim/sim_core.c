@@ -0,0 +1,1018 @@
+/*
+ * @Description: 仿真调度器 - FreeRTOS任务/队列/信号量/事件组、esp_timer和默认事件循环
+ *
+ * 每个任务一个pthread，全局锁g_mu由正在运行的任务持有，切换任务时通过条件变量交接。
+ * 调度规则：可运行任务中优先级最高者运行，同优先级按进入等待的先后；
+ * 发送队列、释放信号量、置位事件组和创建任务后检查抢占。
+ * 全部任务都在等待时，虚拟时间跳到最近的超时/定时器到期点。
+ */
+
+#include "sim_internal.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef enum {
+    TASK_READY,
+    TASK_BLOCKED,
+    TASK_DEAD,
+} task_state_t;
+
+struct sim_task {
+    pthread_t thread;
+    pthread_cond_t cond;
+    bool go;                                // 轮到该任务运行
+    char name[16];
+    int priority;
+    task_state_t state;
+    sim_pred_t pred;                        // 阻塞条件
+    void *pred_arg;
+    int64_t deadline;                       // 阻塞超时（绝对时间，-1为不超时）
+    uint64_t seq;                           // 进入等待的顺序，同优先级先进先出
+    TaskFunction_t fn;
+    void *arg;
+    uint32_t stack_size;
+    int core;                               // 创建时指定的核（tskNO_AFFINITY为不绑定）
+    uint32_t high_water;                    // 栈高水位，0为默认值（栈大小的一半）
+    struct sim_task *next;
+};
+
+struct sim_queue {
+    uint32_t length;
+    uint32_t item_size;
+    uint32_t count;
+    uint32_t head;
+    uint8_t *buf;
+    bool is_mutex;
+};
+
+struct sim_event_group {
+    EventBits_t bits;
+};
+
+struct sim_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    char name[24];
+    int lane;                               // 0：esp_timer任务，1：wifi任务
+    bool armed;
+    int64_t expiry;
+    uint64_t period;
+    uint64_t seq;
+    struct sim_timer *next;
+};
+
+static pthread_mutex_t g_mu = PTHREAD_MUTEX_INITIALIZER;
+static struct sim_task *g_tasks;
+static struct sim_task *g_cur;
+static int64_t g_now;
+static uint64_t g_seq;
+static struct sim_timer *g_timers;
+static bool g_restarted;
+static char g_restart_task[16];
+static int64_t g_restart_at;
+static char g_log_level = 'W';
+static const char *g_capture_tag;   // sim_log_capture()
+static char *g_capture_buf;
+static size_t g_capture_cap;
+
+/* ==================== 内部分配 ==================== */
+
+#ifndef SIM_NO_HEAP_HOOK
+extern void *__libc_malloc(size_t size);
+extern void __libc_free(void *ptr);
+#endif
+
+void *sim_alloc(size_t size)
+{
+#ifndef SIM_NO_HEAP_HOOK
+    void *p = __libc_malloc(size);
+#else
+    void *p = malloc(size);
+#endif
+    if (p == NULL) {
+        abort();
+    }
+    memset(p, 0, size);
+    return p;
+}
+
+void sim_free(void *ptr)
+{
+#ifndef SIM_NO_HEAP_HOOK
+    __libc_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+/* ==================== 调度 ==================== */
+
+static bool task_runnable(const struct sim_task *t)
+{
+    if (t->state == TASK_READY) {
+        return true;
+    }
+    if (t->state != TASK_BLOCKED) {
+        return false;
+    }
+    if (t->pred != NULL && t->pred(t->pred_arg)) {
+        return true;
+    }
+    return t->deadline >= 0 && t->deadline <= g_now;
+}
+
+static bool timer_lane_due(void *arg)
+{
+    int lane = (int)(intptr_t)arg;
+    for (struct sim_timer *tm = g_timers; tm != NULL; tm = tm->next) {
+        if (tm->armed && tm->lane == lane && tm->expiry <= g_now) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int64_t next_wakeup(void)
+{
+    int64_t next = -1;
+    for (struct sim_task *t = g_tasks; t != NULL; t = t->next) {
+        if (t->state == TASK_BLOCKED && t->deadline >= 0 && (next < 0 || t->deadline < next)) {
+            next = t->deadline;
+        }
+    }
+    for (struct sim_timer *tm = g_timers; tm != NULL; tm = tm->next) {
+        if (tm->armed && (next < 0 || tm->expiry < next)) {
+            next = tm->expiry;
+        }
+    }
+    return next;
+}
+
+static void dump_tasks(void)
+{
+    fprintf(stderr, "[sim] t=%.3fms tasks:\n", g_now / 1000.0);
+    for (struct sim_task *t = g_tasks; t != NULL; t = t->next) {
+        fprintf(stderr, "  %-16s prio=%2d state=%d deadline=%lld%s\n", t->name, t->priority, t->state,
+                (long long)t->deadline, t == g_cur ? " (current)" : "");
+    }
+}
+
+static struct sim_task *pick_next(bool yield)
+{
+    struct sim_task *best = NULL;
+    uint64_t best_seq = 0;
+    for (struct sim_task *t = g_tasks; t != NULL; t = t->next) {
+        if (!task_runnable(t)) {
+            continue;
+        }
+        /* 当前任务未主动让出时排在同优先级的最前面 */
+        uint64_t seq = (t == g_cur && !yield) ? 0 : t->seq;
+        if (best == NULL || t->priority > best->priority || (t->priority == best->priority && seq < best_seq)) {
+            best = t;
+            best_seq = seq;
+        }
+    }
+    return best;
+}
+
+static void switch_to(struct sim_task *next)
+{
+    struct sim_task *me = g_cur;
+    g_cur = next;
+    next->go = true;
+    pthread_cond_signal(&next->cond);
+    if (me->state == TASK_DEAD) {
+        return;
+    }
+    me->go = false;
+    while (!me->go) {
+        pthread_cond_wait(&me->cond, &g_mu);
+    }
+}
+
+static void schedule(bool yield)
+{
+    if (yield) {
+        g_cur->seq = ++g_seq;
+    }
+    struct sim_task *next;
+    while ((next = pick_next(yield)) == NULL) {
+        int64_t wake = next_wakeup();
+        if (wake < 0) {
+            fprintf(stderr, "[sim] deadlock: no runnable task and no pending timeout\n");
+            dump_tasks();
+            abort();
+        }
+        if (wake > g_now) {
+            g_now = wake;
+        }
+    }
+    if (next != g_cur) {
+        switch_to(next);
+    }
+}
+
+bool sim_block(sim_pred_t pred, void *arg, int64_t deadline_us)
+{
+    struct sim_task *me = g_cur;
+    me->pred = pred;
+    me->pred_arg = arg;
+    me->deadline = deadline_us;
+    me->seq = ++g_seq;
+    me->state = TASK_BLOCKED;
+    schedule(false);
+    me->state = TASK_READY;
+    me->deadline = -1;
+    me->pred = NULL;
+    return pred != NULL ? pred(arg) : true;
+}
+
+void sim_preempt(void)
+{
+    schedule(false);
+}
+
+int64_t sim_deadline(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        return -1;
+    }
+    return g_now + (int64_t)ticks * 1000;
+}
+
+static void task_exit_locked(void)
+{
+    g_cur->state = TASK_DEAD;
+    schedule(false);
+    pthread_mutex_unlock(&g_mu);
+    pthread_exit(NULL);
+}
+
+static void *task_thread(void *param)
+{
+    struct sim_task *t = param;
+    pthread_mutex_lock(&g_mu);
+    while (!t->go) {
+        pthread_cond_wait(&t->cond, &g_mu);
+    }
+    t->fn(t->arg);
+    task_exit_locked();
+    return NULL;
+}
+
+static struct sim_task *task_new(const char *name, int priority)
+{
+    struct sim_task *t = sim_alloc(sizeof(*t));
+    pthread_cond_init(&t->cond, NULL);
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    t->priority = priority;
+    t->state = TASK_READY;
+    t->deadline = -1;
+    t->seq = ++g_seq;
+    struct sim_task **pp = &g_tasks;
+    while (*pp != NULL) {
+        pp = &(*pp)->next;
+    }
+    *pp = t;
+    return t;
+}
+
+static struct sim_task *task_spawn(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg, int priority)
+{
+    struct sim_task *t = task_new(name, priority);
+    t->fn = fn;
+    t->arg = arg;
+    t->stack_size = stack_size;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 256 * 1024);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    sim_heap_pause();
+    int rc = pthread_create(&t->thread, &attr, task_thread, t);
+    sim_heap_resume();
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        abort();
+    }
+    return t;
+}
+
+/* ==================== esp_timer / 内部定时器任务 ==================== */
+
+static void timer_lane_task(void *arg)
+{
+    int lane = (int)(intptr_t)arg;
+    for (;;) {
+        sim_block(timer_lane_due, arg, -1);
+        struct sim_timer *due = NULL;
+        for (struct sim_timer *tm = g_timers; tm != NULL; tm = tm->next) {
+            if (!tm->armed || tm->lane != lane || tm->expiry > g_now) {
+                continue;
+            }
+            if (due == NULL || tm->expiry < due->expiry || (tm->expiry == due->expiry && tm->seq < due->seq)) {
+                due = tm;
+            }
+        }
+        if (due == NULL) {
+            continue;
+        }
+        if (due->period > 0) {
+            due->expiry += (int64_t)due->period;
+            due->seq = ++g_seq;
+        } else {
+            due->armed = false;
+        }
+        due->callback(due->arg);
+    }
+}
+
+static struct sim_timer *timer_new(esp_timer_cb_t callback, void *arg, const char *name, int lane)
+{
+    struct sim_timer *tm = sim_alloc(sizeof(*tm));
+    tm->callback = callback;
+    tm->arg = arg;
+    tm->lane = lane;
+    snprintf(tm->name, sizeof(tm->name), "%s", name != NULL ? name : "timer");
+    tm->next = g_timers;
+    g_timers = tm;
+    return tm;
+}
+
+esp_timer_handle_t sim_job_create(esp_timer_cb_t callback, void *arg, const char *name)
+{
+    return timer_new(callback, arg, name, 1);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    if (args == NULL || args->callback == NULL || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sim_heap_note_alloc(sizeof(struct sim_timer));
+    *out = timer_new(args->callback, args->arg, args->name, 0);
+    return ESP_OK;
+}
+
+static esp_err_t timer_arm(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = true;
+    timer->expiry = g_now + (int64_t)timeout_us;
+    timer->period = period_us;
+    timer->seq = ++g_seq;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_arm(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (period_us == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return timer_arm(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (struct sim_timer **pp = &g_timers; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == timer) {
+            *pp = timer->next;
+            break;
+        }
+    }
+    sim_free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer != NULL && timer->armed;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return g_now;
+}
+
+/* ==================== 默认事件循环 ==================== */
+
+#define SIM_EVENT_HANDLERS 16
+
+typedef struct sim_event {
+    esp_event_base_t base;
+    int32_t id;
+    size_t size;
+    struct sim_event *next;
+    uint8_t data[];
+} sim_event_t;
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void *arg;
+} sim_handler_t;
+
+esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t const IP_EVENT = "IP_EVENT";
+
+static bool s_loop_created;
+static sim_event_t *s_events_head;
+static sim_event_t *s_events_tail;
+static sim_handler_t s_handlers[SIM_EVENT_HANDLERS];
+
+static bool events_pending(void *arg)
+{
+    return s_events_head != NULL;
+}
+
+static void event_loop_task(void *arg)
+{
+    for (;;) {
+        sim_block(events_pending, NULL, -1);
+        sim_event_t *ev = s_events_head;
+        s_events_head = ev->next;
+        if (s_events_head == NULL) {
+            s_events_tail = NULL;
+        }
+        sim_handler_t handlers[SIM_EVENT_HANDLERS];
+        memcpy(handlers, s_handlers, sizeof(handlers));
+        for (int i = 0; i < SIM_EVENT_HANDLERS; i++) {
+            if (handlers[i].handler != NULL && handlers[i].base == ev->base &&
+                (handlers[i].id == ESP_EVENT_ANY_ID || handlers[i].id == ev->id)) {
+                handlers[i].handler(handlers[i].arg, ev->base, ev->id, ev->size > 0 ? ev->data : NULL);
+            }
+        }
+        sim_free(ev);
+    }
+}
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    if (s_loop_created) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_loop_created = true;
+    task_spawn(event_loop_task, "sys_evt", 2304, NULL, 20);
+    sim_preempt();
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void *arg)
+{
+    for (int i = 0; i < SIM_EVENT_HANDLERS; i++) {
+        if (s_handlers[i].handler == NULL) {
+            s_handlers[i] = (sim_handler_t){ base, id, handler, arg };
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t base, int32_t id, esp_event_handler_t handler)
+{
+    for (int i = 0; i < SIM_EVENT_HANDLERS; i++) {
+        if (s_handlers[i].handler == handler && s_handlers[i].base == base && s_handlers[i].id == id) {
+            memset(&s_handlers[i], 0, sizeof(s_handlers[i]));
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+void sim_event_post(esp_event_base_t base, int32_t id, const void *data, size_t size)
+{
+    if (!s_loop_created) {
+        return;
+    }
+    sim_event_t *ev = sim_alloc(sizeof(*ev) + size);
+    ev->base = base;
+    ev->id = id;
+    ev->size = size;
+    if (size > 0) {
+        memcpy(ev->data, data, size);
+    }
+    if (s_events_tail != NULL) {
+        s_events_tail->next = ev;
+    } else {
+        s_events_head = ev;
+    }
+    s_events_tail = ev;
+    sim_preempt();
+}
+
+/* ==================== 任务 ==================== */
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+    sim_heap_note_task(name, stack_size);
+    struct sim_task *t = task_spawn(fn, name, stack_size, arg, (int)priority);
+    t->core = (int)core;
+    if (handle != NULL) {
+        *handle = t;
+    }
+    sim_preempt();
+    return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                                           UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb,
+                                           BaseType_t core)
+{
+    if (stack == NULL || tcb == NULL) {
+        return NULL;
+    }
+    struct sim_task *t = task_spawn(fn, name, stack_size, arg, (int)priority);
+    t->core = (int)core;
+    sim_preempt();
+    return t;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL || task == g_cur) {
+        task_exit_locked();
+    }
+    task->state = TASK_DEAD;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == 0) {
+        schedule(true);
+        return;
+    }
+    sim_block(NULL, NULL, g_now + (int64_t)ticks * 1000);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(g_now / 1000);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    struct sim_task *t = task != NULL ? task : g_cur;
+    return t->high_water != 0 ? t->high_water : t->stack_size / 2;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return g_cur;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    struct sim_task *t = task != NULL ? task : g_cur;
+    return t->name;
+}
+
+int xPortGetCoreID(void)
+{
+    return 0;
+}
+
+/* 按名查找最后创建的、未退出的任务 */
+static struct sim_task *task_find(const char *name)
+{
+    struct sim_task *found = NULL;
+    for (struct sim_task *t = g_tasks; t != NULL; t = t->next) {
+        if (t->state != TASK_DEAD && strcmp(t->name, name) == 0) {
+            found = t;
+        }
+    }
+    return found;
+}
+
+bool sim_task_find(const char *name, sim_task_info_t *info)
+{
+    struct sim_task *t = task_find(name);
+    if (t == NULL) {
+        return false;
+    }
+    info->priority = t->priority;
+    info->core = t->core;
+    info->stack_size = t->stack_size;
+    return true;
+}
+
+bool sim_task_set_high_water(const char *name, uint32_t high_water)
+{
+    struct sim_task *t = task_find(name);
+    if (t == NULL) {
+        return false;
+    }
+    t->high_water = high_water;
+    return true;
+}
+
+const char *sim_current_name(void)
+{
+    return g_cur != NULL ? g_cur->name : "-";
+}
+
+const char *sim_task_name(void)
+{
+    return sim_current_name();
+}
+
+/* ==================== 队列 / 信号量 ==================== */
+
+static struct sim_queue *queue_new(uint32_t length, uint32_t item_size)
+{
+    struct sim_queue *q = sim_alloc(sizeof(*q));
+    q->length = length;
+    q->item_size = item_size;
+    if (item_size > 0) {
+        q->buf = sim_alloc((size_t)length * item_size);
+    }
+    return q;
+}
+
+static bool queue_not_full(void *arg)
+{
+    struct sim_queue *q = arg;
+    return q->count < q->length;
+}
+
+static bool queue_not_empty(void *arg)
+{
+    struct sim_queue *q = arg;
+    return q->count > 0;
+}
+
+static BaseType_t queue_send(struct sim_queue *q, const void *item, TickType_t ticks, bool front)
+{
+    int64_t deadline = sim_deadline(ticks);
+    while (q->count >= q->length) {
+        if (ticks == 0 || !sim_block(queue_not_full, q, deadline)) {
+            return pdFALSE;
+        }
+    }
+    if (q->item_size > 0 && item != NULL) {
+        uint32_t slot;
+        if (front) {
+            q->head = (q->head + q->length - 1) % q->length;
+            slot = q->head;
+        } else {
+            slot = (q->head + q->count) % q->length;
+        }
+        memcpy(q->buf + (size_t)slot * q->item_size, item, q->item_size);
+    }
+    q->count++;
+    sim_preempt();
+    return pdTRUE;
+}
+
+static BaseType_t queue_receive(struct sim_queue *q, void *item, TickType_t ticks)
+{
+    int64_t deadline = sim_deadline(ticks);
+    while (q->count == 0) {
+        if (ticks == 0 || !sim_block(queue_not_empty, q, deadline)) {
+            return pdFALSE;
+        }
+    }
+    if (q->item_size > 0) {
+        memcpy(item, q->buf + (size_t)q->head * q->item_size, q->item_size);
+        q->head = (q->head + 1) % q->length;
+    }
+    q->count--;
+    return pdTRUE;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    sim_heap_note_alloc(sizeof(struct sim_queue) + (size_t)length * item_size);
+    return queue_new(length, item_size);
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *buffer)
+{
+    if (buffer == NULL || (item_size > 0 && storage == NULL)) {
+        return NULL;
+    }
+    return queue_new(length, item_size);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    return queue_send(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    return queue_send(queue, item, ticks, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    return queue_receive(queue, item, ticks);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue != NULL) {
+        sim_free(queue->buf);
+        sim_free(queue);
+    }
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    sim_heap_note_alloc(sizeof(struct sim_queue));
+    struct sim_queue *q = queue_new(1, 0);
+    q->count = 1;
+    q->is_mutex = true;
+    return q;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer)
+{
+    if (buffer == NULL) {
+        return NULL;
+    }
+    struct sim_queue *q = queue_new(1, 0);
+    q->count = 1;
+    q->is_mutex = true;
+    return q;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    sim_heap_note_alloc(sizeof(struct sim_queue));
+    return queue_new(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer)
+{
+    if (buffer == NULL) {
+        return NULL;
+    }
+    return queue_new(1, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    return queue_receive(sem, NULL, ticks);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    return queue_send(sem, NULL, 0, false);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    vQueueDelete(sem);
+}
+
+/* ==================== 事件组 ==================== */
+
+typedef struct {
+    struct sim_event_group *group;
+    EventBits_t bits;
+    bool all;
+} bits_wait_t;
+
+static bool bits_satisfied(void *arg)
+{
+    bits_wait_t *w = arg;
+    EventBits_t have = w->group->bits & w->bits;
+    return w->all ? have == w->bits : have != 0;
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    sim_heap_note_alloc(sizeof(struct sim_event_group));
+    return sim_alloc(sizeof(struct sim_event_group));
+}
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buffer)
+{
+    if (buffer == NULL) {
+        return NULL;
+    }
+    return sim_alloc(sizeof(struct sim_event_group));
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    sim_free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    group->bits |= bits;
+    EventBits_t result = group->bits;
+    sim_preempt();
+    return result;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks)
+{
+    bits_wait_t w = { group, bits, wait_for_all != pdFALSE };
+    bool ok = bits_satisfied(&w);
+    if (!ok && ticks > 0) {
+        ok = sim_block(bits_satisfied, &w, sim_deadline(ticks));
+    }
+    EventBits_t result = group->bits;
+    if (ok && clear_on_exit) {
+        group->bits &= ~bits;
+    }
+    return result;
+}
+
+/* ==================== 启动 / 时间 / 复位 ==================== */
+
+void sim_start(void)
+{
+    const char *level = getenv("XN_SIM_LOG");
+    if (level != NULL && level[0] != '\0') {
+        g_log_level = level[0];
+    }
+    pthread_mutex_lock(&g_mu);
+    struct sim_task *main_task = task_new("main", 1);
+    main_task->thread = pthread_self();
+    main_task->go = true;
+    g_cur = main_task;
+    task_spawn(timer_lane_task, "esp_timer", 4096, (void *)(intptr_t)0, 22);
+    task_spawn(timer_lane_task, "wifi", 6656, (void *)(intptr_t)1, 23);
+    sim_preempt();
+}
+
+int64_t sim_now_us(void)
+{
+    return g_now;
+}
+
+void sim_run_ms(uint32_t ms)
+{
+    sim_block(NULL, NULL, g_now + (int64_t)ms * 1000);
+}
+
+typedef struct {
+    bool (*cond)(void *arg);
+    void *arg;
+} run_until_t;
+
+static bool run_until_pred(void *arg)
+{
+    run_until_t *r = arg;
+    return g_restarted || r->cond(r->arg);
+}
+
+bool sim_run_until(bool (*cond)(void *arg), void *arg, uint32_t timeout_ms)
+{
+    run_until_t r = { cond, arg };
+    if (cond(arg)) {
+        return true;
+    }
+    sim_block(run_until_pred, &r, g_now + (int64_t)timeout_ms * 1000);
+    return cond(arg);
+}
+
+void esp_restart(void)
+{
+    g_restarted = true;
+    snprintf(g_restart_task, sizeof(g_restart_task), "%s", g_cur->name);
+    g_restart_at = g_now;
+    sim_log('W', "sim", "esp_restart() called from task %s", g_cur->name);
+    /* 重启后只保留测试主任务，其余任务不再被调度 */
+    for (struct sim_task *t = g_tasks; t != NULL; t = t->next) {
+        if (strcmp(t->name, "main") != 0) {
+            t->state = TASK_DEAD;
+        }
+    }
+    for (struct sim_timer *tm = g_timers; tm != NULL; tm = tm->next) {
+        tm->armed = false;
+    }
+    if (strcmp(g_cur->name, "main") == 0) {
+        fprintf(stderr, "[sim] esp_restart() called from the test task\n");
+        abort();
+    }
+    task_exit_locked();
+    abort();
+}
+
+bool sim_restarted(const char **task, int64_t *at_us)
+{
+    if (task != NULL) {
+        *task = g_restart_task;
+    }
+    if (at_us != NULL) {
+        *at_us = g_restart_at;
+    }
+    return g_restarted;
+}
+
+/* ==================== 日志 / 错误 ==================== */
+
+static int level_rank(char level)
+{
+    switch (level) {
+    case 'E': return 0;
+    case 'W': return 1;
+    case 'I': return 2;
+    case 'D': return 3;
+    default: return 4;
+    }
+}
+
+void sim_set_log_level(char level)
+{
+    g_log_level = level;
+}
+
+void sim_log_capture(const char *tag, char *buf, size_t cap)
+{
+    g_capture_tag = tag;
+    g_capture_buf = buf;
+    g_capture_cap = cap;
+    if (buf != NULL && cap > 0) {
+        buf[0] = '\0';
+    }
+}
+
+void sim_log(char level, const char *tag, const char *fmt, ...)
+{
+    bool capture = g_capture_buf != NULL && strcmp(tag, g_capture_tag) == 0;
+    if (!capture && level_rank(level) > level_rank(g_log_level)) {
+        return;
+    }
+    sim_heap_pause();
+    char line[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    if (capture) {
+        size_t used = strlen(g_capture_buf);
+        snprintf(g_capture_buf + used, g_capture_cap - used, "%s\n", line);
+    }
+    if (level_rank(level) > level_rank(g_log_level)) {
+        sim_heap_resume();
+        return;
+    }
+    printf("[%9.3f] %c (%s) %s: %s\n", g_now / 1000.0, level, sim_current_name(), tag, line);
+    fflush(stdout);
+    sim_heap_resume();
+}
+
+void sim_error_check_failed(esp_err_t rc, const char *expr, const char *file, int line)
+{
+    fprintf(stderr, "ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d\nexpression: %s\n", rc,
+            esp_err_to_name(rc), file, line, expr);
+    abort();
+}
@@ -0,0 +1,348 @@
+/*
+ * @Description: mbedTLS接口的OpenSSL实现 - AES-CFB128、DHM、MD5、SHA256、PBKDF2、AES-GCM
+ *
+ * 只实现组件用到的函数，语义（参数格式、输出长度、错误返回）与mbedTLS一致。
+ * OpenSSL内部的分配不计入堆统计（对应真机上mbedTLS的内部分配，不属于组件）。
+ */
+
+#include "sim_internal.h"
+#include "mbedtls/aes.h"
+#include "mbedtls/dhm.h"
+#include <openssl/evp.h>
+#include <openssl/bn.h>
+
+static sim_crypto_stats_t s_stats;
+static uint32_t s_setkey_failures;
+
+void sim_crypto_get_stats(sim_crypto_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+void sim_crypto_fail_setkey(uint32_t count)
+{
+    s_setkey_failures = count;
+}
+
+/* ==================== AES ==================== */
+
+static const EVP_CIPHER *aes_ecb(unsigned int keybits)
+{
+    switch (keybits) {
+    case 128: return EVP_aes_128_ecb();
+    case 192: return EVP_aes_192_ecb();
+    case 256: return EVP_aes_256_ecb();
+    default: return NULL;
+    }
+}
+
+void mbedtls_aes_init(mbedtls_aes_context *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_aes_free(mbedtls_aes_context *ctx)
+{
+    if (ctx == NULL) {
+        return;
+    }
+    sim_heap_pause();
+    EVP_CIPHER_CTX_free(ctx->evp);
+    sim_heap_resume();
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits)
+{
+    s_stats.setkey_calls++;
+    const EVP_CIPHER *cipher = aes_ecb(keybits);
+    if (cipher == NULL) {
+        return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
+    }
+    if (s_setkey_failures > 0) {
+        s_setkey_failures--;
+        return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
+    }
+    sim_heap_pause();
+    if (ctx->evp == NULL) {
+        ctx->evp = EVP_CIPHER_CTX_new();
+    }
+    int ok = EVP_EncryptInit_ex(ctx->evp, cipher, NULL, key, NULL);
+    EVP_CIPHER_CTX_set_padding(ctx->evp, 0);
+    sim_heap_resume();
+    if (!ok) {
+        return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
+    }
+    memcpy(ctx->key, key, keybits / 8);
+    ctx->keybits = keybits;
+    return 0;
+}
+
+static void aes_block(mbedtls_aes_context *ctx, unsigned char block[16])
+{
+    int outl = 0;
+    EVP_EncryptUpdate(ctx->evp, block, &outl, block, 16);
+}
+
+int mbedtls_aes_crypt_cfb128(mbedtls_aes_context *ctx, int mode, size_t length, size_t *iv_off,
+                             unsigned char iv[16], const unsigned char *input, unsigned char *output)
+{
+    if (ctx->evp == NULL || *iv_off > 15) {
+        return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
+    }
+    size_t n = *iv_off;
+    while (length--) {
+        if (n == 0) {
+            aes_block(ctx, iv);
+        }
+        unsigned char c = *input++;
+        if (mode == MBEDTLS_AES_DECRYPT) {
+            *output++ = c ^ iv[n];
+            iv[n] = c;
+        } else {
+            iv[n] = *output++ = c ^ iv[n];
+        }
+        n = (n + 1) & 0x0F;
+    }
+    *iv_off = n;
+    return 0;
+}
+
+/* ==================== DHM ==================== */
+
+void mbedtls_dhm_init(mbedtls_dhm_context *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_dhm_free(mbedtls_dhm_context *ctx)
+{
+    if (ctx == NULL) {
+        return;
+    }
+    sim_heap_pause();
+    BN_free(ctx->p);
+    BN_free(ctx->g);
+    BN_clear_free(ctx->x);
+    BN_free(ctx->gx);
+    BN_free(ctx->gy);
+    BN_clear_free(ctx->k);
+    sim_heap_resume();
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+static int read_mpi(BIGNUM **out, unsigned char **p, const unsigned char *end)
+{
+    if (end - *p < 2) {
+        return MBEDTLS_ERR_DHM_BAD_INPUT_DATA;
+    }
+    size_t n = ((size_t)(*p)[0] << 8) | (*p)[1];
+    *p += 2;
+    if ((size_t)(end - *p) < n) {
+        return MBEDTLS_ERR_DHM_BAD_INPUT_DATA;
+    }
+    BN_free(*out);
+    *out = BN_bin2bn(*p, (int)n, NULL);
+    *p += n;
+    return *out != NULL ? 0 : MBEDTLS_ERR_DHM_BAD_INPUT_DATA;
+}
+
+int mbedtls_dhm_read_params(mbedtls_dhm_context *ctx, unsigned char **p, const unsigned char *end)
+{
+    sim_heap_pause();
+    int ret = read_mpi((BIGNUM **)&ctx->p, p, end);
+    if (ret == 0) {
+        ret = read_mpi((BIGNUM **)&ctx->g, p, end);
+    }
+    if (ret == 0) {
+        ret = read_mpi((BIGNUM **)&ctx->gy, p, end);
+    }
+    // 与mbedTLS一致：对端公钥必须在[2, P-2]之间
+    if (ret == 0) {
+        BIGNUM *limit = BN_dup(ctx->p);
+        BN_sub_word(limit, 2);
+        if (BN_is_zero(ctx->p) || BN_cmp(ctx->gy, BN_value_one()) <= 0 || BN_cmp(ctx->gy, limit) > 0) {
+            ret = MBEDTLS_ERR_DHM_BAD_INPUT_DATA;
+        }
+        BN_free(limit);
+    }
+    sim_heap_resume();
+    return ret;
+}
+
+size_t mbedtls_dhm_get_len(const mbedtls_dhm_context *ctx)
+{
+    return ctx->p != NULL ? (size_t)BN_num_bytes((const BIGNUM *)ctx->p) : 0;
+}
+
+int mbedtls_dhm_make_public(mbedtls_dhm_context *ctx, int x_size, unsigned char *output, size_t olen,
+                            int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
+{
+    if (ctx->p == NULL || olen < 1 || olen > mbedtls_dhm_get_len(ctx) || x_size <= 0) {
+        return MBEDTLS_ERR_DHM_BAD_INPUT_DATA;
+    }
+    unsigned char rnd[512];
+    if ((size_t)x_size > sizeof(rnd) || f_rng(p_rng, rnd, (size_t)x_size) != 0) {
+        return MBEDTLS_ERR_DHM_MAKE_PUBLIC_FAILED;
+    }
+    sim_heap_pause();
+    BN_CTX *bn = BN_CTX_new();
+    BN_clear_free(ctx->x);
+    ctx->x = BN_bin2bn(rnd, x_size, NULL);
+    BN_mod(ctx->x, ctx->x, ctx->p, bn);
+    if (BN_cmp(ctx->x, BN_value_one()) <= 0) {
+        BN_set_word(ctx->x, 2);
+    }
+    BN_free(ctx->gx);
+    ctx->gx = BN_new();
+    int ok = BN_mod_exp(ctx->gx, ctx->g, ctx->x, ctx->p, bn);
+    BN_CTX_free(bn);
+    if (ok) {
+        ok = BN_bn2binpad(ctx->gx, output, (int)olen) > 0;
+    }
+    sim_heap_resume();
+    memset(rnd, 0, sizeof(rnd));
+    return ok ? 0 : MBEDTLS_ERR_DHM_MAKE_PUBLIC_FAILED;
+}
+
+int mbedtls_dhm_calc_secret(mbedtls_dhm_context *ctx, unsigned char *output, size_t output_size, size_t *olen,
+                            int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
+{
+    if (ctx->x == NULL || ctx->gy == NULL || output_size < mbedtls_dhm_get_len(ctx)) {
+        return MBEDTLS_ERR_DHM_BAD_INPUT_DATA;
+    }
+    sim_heap_pause();
+    BN_CTX *bn = BN_CTX_new();
+    BN_clear_free(ctx->k);
+    ctx->k = BN_new();
+    int ok = BN_mod_exp(ctx->k, ctx->gy, ctx->x, ctx->p, bn);
+    BN_CTX_free(bn);
+    if (ok) {
+        *olen = (size_t)BN_bn2bin(ctx->k, output);
+    }
+    sim_heap_resume();
+    return ok ? 0 : MBEDTLS_ERR_DHM_CALC_SECRET_FAILED;
+}
+
+/* ==================== 摘要 / 派生 ==================== */
+
+static int digest(const EVP_MD *md, const unsigned char *input, size_t ilen, unsigned char *output)
+{
+    sim_heap_pause();
+    int ok = EVP_Digest(input, ilen, output, NULL, md, NULL);
+    sim_heap_resume();
+    return ok ? 0 : -1;
+}
+
+int mbedtls_md5(const unsigned char *input, size_t ilen, unsigned char output[16])
+{
+    return digest(EVP_md5(), input, ilen, output);
+}
+
+int mbedtls_sha256(const unsigned char *input, size_t ilen, unsigned char *output, int is224)
+{
+    return digest(is224 ? EVP_sha224() : EVP_sha256(), input, ilen, output);
+}
+
+int mbedtls_pkcs5_pbkdf2_hmac_ext(mbedtls_md_type_t md_type, const unsigned char *password, size_t plen,
+                                  const unsigned char *salt, size_t slen, unsigned int iteration_count,
+                                  uint32_t key_length, unsigned char *output)
+{
+    if (md_type != MBEDTLS_MD_SHA1 && md_type != MBEDTLS_MD_SHA256) {
+        return -1;
+    }
+    s_stats.pbkdf2_calls++;
+    snprintf(s_stats.pbkdf2_task, sizeof(s_stats.pbkdf2_task), "%s", sim_current_name());
+    sim_heap_pause();
+    int ok = PKCS5_PBKDF2_HMAC((const char *)password, (int)plen, salt, (int)slen, (int)iteration_count,
+                               md_type == MBEDTLS_MD_SHA1 ? EVP_sha1() : EVP_sha256(), (int)key_length, output);
+    sim_heap_resume();
+    return ok ? 0 : -1;
+}
+
+/* ==================== AES-GCM ==================== */
+
+static const EVP_CIPHER *aes_gcm(unsigned int keybits)
+{
+    switch (keybits) {
+    case 128: return EVP_aes_128_gcm();
+    case 192: return EVP_aes_192_gcm();
+    case 256: return EVP_aes_256_gcm();
+    default: return NULL;
+    }
+}
+
+void mbedtls_gcm_init(mbedtls_gcm_context *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_gcm_free(mbedtls_gcm_context *ctx)
+{
+    if (ctx != NULL) {
+        memset(ctx, 0, sizeof(*ctx));
+    }
+}
+
+int mbedtls_gcm_setkey(mbedtls_gcm_context *ctx, int cipher, const unsigned char *key, unsigned int keybits)
+{
+    if (cipher != MBEDTLS_CIPHER_ID_AES || aes_gcm(keybits) == NULL) {
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+    }
+    memcpy(ctx->key, key, keybits / 8);
+    ctx->keybits = keybits;
+    return 0;
+}
+
+static int gcm_run(mbedtls_gcm_context *ctx, bool encrypt, size_t length, const unsigned char *iv, size_t iv_len,
+                   const unsigned char *add, size_t add_len, const unsigned char *input, unsigned char *output,
+                   size_t tag_len, unsigned char *tag)
+{
+    const EVP_CIPHER *cipher = aes_gcm(ctx->keybits);
+    if (cipher == NULL || tag_len < 4 || tag_len > 16) {
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+    }
+    sim_heap_pause();
+    EVP_CIPHER_CTX *c = EVP_CIPHER_CTX_new();
+    int outl = 0;
+    int ok = EVP_CipherInit_ex(c, cipher, NULL, NULL, NULL, encrypt ? 1 : 0) &&
+             EVP_CIPHER_CTX_ctrl(c, EVP_CTRL_GCM_SET_IVLEN, (int)iv_len, NULL) &&
+             EVP_CipherInit_ex(c, NULL, NULL, ctx->key, iv, encrypt ? 1 : 0);
+    if (ok && add_len > 0) {
+        ok = EVP_CipherUpdate(c, NULL, &outl, add, (int)add_len);
+    }
+    if (ok && length > 0) {
+        ok = EVP_CipherUpdate(c, output, &outl, input, (int)length);
+    }
+    if (ok && !encrypt) {
+        ok = EVP_CIPHER_CTX_ctrl(c, EVP_CTRL_GCM_SET_TAG, (int)tag_len, tag);
+    }
+    int final_ok = ok && EVP_CipherFinal_ex(c, output + length, &outl);
+    if (final_ok && encrypt) {
+        final_ok = EVP_CIPHER_CTX_ctrl(c, EVP_CTRL_GCM_GET_TAG, (int)tag_len, tag);
+    }
+    EVP_CIPHER_CTX_free(c);
+    sim_heap_resume();
+    if (!ok) {
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+    }
+    return final_ok ? 0 : MBEDTLS_ERR_GCM_AUTH_FAILED;
+}
+
+int mbedtls_gcm_crypt_and_tag(mbedtls_gcm_context *ctx, int mode, size_t length, const unsigned char *iv,
+                              size_t iv_len, const unsigned char *add, size_t add_len, const unsigned char *input,
+                              unsigned char *output, size_t tag_len, unsigned char *tag)
+{
+    return gcm_run(ctx, mode == MBEDTLS_GCM_ENCRYPT, length, iv, iv_len, add, add_len, input, output, tag_len, tag);
+}
+
+int mbedtls_gcm_auth_decrypt(mbedtls_gcm_context *ctx, size_t length, const unsigned char *iv, size_t iv_len,
+                             const unsigned char *add, size_t add_len, const unsigned char *tag, size_t tag_len,
+                             const unsigned char *input, unsigned char *output)
+{
+    int ret = gcm_run(ctx, false, length, iv, iv_len, add, add_len, input, output, tag_len, (unsigned char *)tag);
+    if (ret == MBEDTLS_ERR_GCM_AUTH_FAILED) {
+        memset(output, 0, length);
+    }
+    return ret;
+}
@@ -0,0 +1,105 @@
+/*
+ * @Description: 堆分配统计 - 替换malloc/calloc/realloc/free，统计期间记录次数和所在任务
+ *
+ * ASan/UBSan构建（SIM_NO_HEAP_HOOK）不替换分配函数，sim_heap_trace_start()返回false。
+ */
+
+#include "sim_internal.h"
+
+static bool s_tracing;
+static int s_paused;
+static sim_heap_stats_t s_stats;
+
+void sim_heap_pause(void)
+{
+    s_paused++;
+}
+
+void sim_heap_resume(void)
+{
+    s_paused--;
+}
+
+static void note_alloc(size_t size)
+{
+    if (!s_tracing || s_paused > 0) {
+        return;
+    }
+    s_stats.allocs++;
+    s_stats.bytes += size;
+    s_stats.last_size = size;
+    snprintf(s_stats.last_task, sizeof(s_stats.last_task), "%s", sim_current_name());
+}
+
+void sim_heap_note_alloc(size_t size)
+{
+    note_alloc(size);
+}
+
+void sim_heap_note_task(const char *name, size_t stack_size)
+{
+    if (!s_tracing || s_paused > 0) {
+        return;
+    }
+    note_alloc(stack_size);
+    s_stats.tasks++;
+    snprintf(s_stats.last_new_task, sizeof(s_stats.last_new_task), "%s", name);
+}
+
+#ifndef SIM_NO_HEAP_HOOK
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size)
+{
+    note_alloc(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    note_alloc(n * size);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    note_alloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    if (ptr != NULL && s_tracing && s_paused == 0) {
+        s_stats.frees++;
+    }
+    __libc_free(ptr);
+}
+
+bool sim_heap_trace_start(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_tracing = true;
+    return true;
+}
+
+#else
+
+bool sim_heap_trace_start(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    return false;
+}
+
+#endif
+
+void sim_heap_trace_stop(sim_heap_stats_t *stats)
+{
+    s_tracing = false;
+    if (stats != NULL) {
+        *stats = s_stats;
+    }
+}
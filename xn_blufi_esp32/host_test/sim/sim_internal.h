@@ -0,0 +1,41 @@
+/*
+ * @Description: 仿真模块之间共用的内部接口
+ */
+
+#pragma once
+
+#include "sim.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_event.h"
+
+/* 任务阻塞条件，在调度器选择任务时求值，不能有副作用 */
+typedef bool (*sim_pred_t)(void *arg);
+
+/* 阻塞当前任务直到pred(arg)为真或到达deadline_us（-1为不超时），返回pred是否满足 */
+bool sim_block(sim_pred_t pred, void *arg, int64_t deadline_us);
+
+/* 有更高优先级任务就绪时让出CPU */
+void sim_preempt(void);
+
+/* TickType_t超时转为绝对时间，portMAX_DELAY为-1 */
+int64_t sim_deadline(TickType_t ticks);
+
+/* 仿真内部分配，不计入堆统计 */
+void *sim_alloc(size_t size);
+void sim_free(void *ptr);
+
+/* 仿真内部定时器，在"wifi"任务（优先级23）中回调，用于驱动侧的时序 */
+esp_timer_handle_t sim_job_create(esp_timer_cb_t callback, void *arg, const char *name);
+
+/* 投递系统事件（数据被复制），由"sys_evt"任务分发 */
+void sim_event_post(esp_event_base_t base, int32_t id, const void *data, size_t size);
+
+/* 当前任务名，未启动仿真时为"-" */
+const char *sim_current_name(void);
+
+/* 记一次动态任务创建（栈在堆上） */
+void sim_heap_note_task(const char *name, size_t stack_size);
+
+/* 蓝牙控制器是否已使能（WiFi省电模式的共存限制） */
+bool sim_ble_controller_enabled(void);
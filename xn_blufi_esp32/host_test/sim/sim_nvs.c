@@ -0,0 +1,457 @@
+/*
+ * @Description: NVS仿真 - 键值按命名空间存放，每次set/erase单独生效（与NVS条目写入的原子性一致）
+ *
+ * 另外记录一份只追加的原始写入日志：NVS覆盖或擦除条目时只是把旧条目标记为已擦除，
+ * 数据在页回收之前仍留在Flash上，测试用它检查敏感数据是否落过盘。
+ */
+
+#include "sim_internal.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#define NVS_MAX_ENTRIES     64
+#define NVS_MAX_HANDLES     16
+#define NVS_RAW_CAP         (256 * 1024)
+
+typedef enum {
+    NVS_TYPE_U8 = 1,
+    NVS_TYPE_U32 = 4,
+    NVS_TYPE_STR = 0x21,
+    NVS_TYPE_BLOB = 0x42,
+} nvs_type_t;
+
+typedef struct {
+    bool used;
+    char ns[16];
+    char key[16];
+    uint8_t type;
+    uint32_t len;
+    uint8_t *data;
+} nvs_entry_t;
+
+typedef struct {
+    bool used;
+    char ns[16];
+    nvs_open_mode_t mode;
+} nvs_open_t;
+
+static bool s_inited;
+static nvs_entry_t s_entries[NVS_MAX_ENTRIES];
+static char s_namespaces[NVS_MAX_ENTRIES][16];
+static nvs_open_t s_handles[NVS_MAX_HANDLES];
+static uint8_t *s_raw;
+static size_t s_raw_len;
+static uint32_t s_write_ops;
+static uint32_t s_fail_at;
+static char s_last_writer[16];
+
+/* ==================== 内部 ==================== */
+
+static void raw_append(const void *data, size_t len)
+{
+    if (s_raw == NULL) {
+        s_raw = sim_alloc(NVS_RAW_CAP);
+    }
+    if (s_raw_len + len > NVS_RAW_CAP) {
+        len = NVS_RAW_CAP - s_raw_len;
+    }
+    memcpy(s_raw + s_raw_len, data, len);
+    s_raw_len += len;
+}
+
+static bool ns_exists(const char *ns)
+{
+    for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+        if (strcmp(s_namespaces[i], ns) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void ns_add(const char *ns)
+{
+    if (ns_exists(ns)) {
+        return;
+    }
+    for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+        if (s_namespaces[i][0] == '\0') {
+            snprintf(s_namespaces[i], sizeof(s_namespaces[i]), "%s", ns);
+            return;
+        }
+    }
+}
+
+static nvs_open_t *handle_get(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > NVS_MAX_HANDLES || !s_handles[handle - 1].used) {
+        return NULL;
+    }
+    return &s_handles[handle - 1];
+}
+
+static nvs_entry_t *entry_find(const char *ns, const char *key)
+{
+    for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+        if (s_entries[i].used && strcmp(s_entries[i].ns, ns) == 0 && strcmp(s_entries[i].key, key) == 0) {
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void entry_drop(nvs_entry_t *e)
+{
+    sim_free(e->data);
+    memset(e, 0, sizeof(*e));
+}
+
+/* 写操作公共检查：句柄、只读、故障注入，返回ESP_OK表示可以执行 */
+static esp_err_t write_begin(nvs_handle_t handle, nvs_open_t **out)
+{
+    nvs_open_t *h = handle_get(handle);
+    if (h == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (h->mode == NVS_READONLY) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    s_write_ops++;
+    snprintf(s_last_writer, sizeof(s_last_writer), "%s", sim_current_name());
+    if (s_fail_at != 0 && s_write_ops >= s_fail_at) {
+        return ESP_FAIL;
+    }
+    *out = h;
+    return ESP_OK;
+}
+
+static esp_err_t entry_set(nvs_handle_t handle, const char *key, uint8_t type, const void *data, size_t len)
+{
+    if (key == NULL || strlen(key) > 15) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    nvs_open_t *h;
+    esp_err_t ret = write_begin(handle, &h);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    nvs_entry_t *e = entry_find(h->ns, key);
+    if (e == NULL) {
+        for (int i = 0; i < NVS_MAX_ENTRIES && e == NULL; i++) {
+            if (!s_entries[i].used) {
+                e = &s_entries[i];
+            }
+        }
+        if (e == NULL) {
+            return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+    } else {
+        sim_free(e->data);
+    }
+    e->used = true;
+    snprintf(e->ns, sizeof(e->ns), "%s", h->ns);
+    snprintf(e->key, sizeof(e->key), "%s", key);
+    e->type = type;
+    e->len = (uint32_t)len;
+    e->data = sim_alloc(len > 0 ? len : 1);
+    memcpy(e->data, data, len);
+    raw_append(key, strlen(key));
+    raw_append(data, len);
+    return ESP_OK;
+}
+
+static esp_err_t entry_get(nvs_handle_t handle, const char *key, uint8_t type, void *out, size_t *len, bool exact)
+{
+    nvs_open_t *h = handle_get(handle);
+    if (h == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    nvs_entry_t *e = entry_find(h->ns, key);
+    if (e == NULL || e->type != type) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (exact) {
+        memcpy(out, e->data, e->len);
+        return ESP_OK;
+    }
+    if (out == NULL) {
+        *len = e->len;
+        return ESP_OK;
+    }
+    if (*len < e->len) {
+        *len = e->len;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out, e->data, e->len);
+    *len = e->len;
+    return ESP_OK;
+}
+
+/* ==================== nvs_flash ==================== */
+
+esp_err_t nvs_flash_init(void)
+{
+    s_inited = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+        if (s_entries[i].used) {
+            entry_drop(&s_entries[i]);
+        }
+    }
+    memset(s_namespaces, 0, sizeof(s_namespaces));
+    s_raw_len = 0;
+    return ESP_OK;
+}
+
+/* ==================== nvs ==================== */
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle)
+{
+    if (!s_inited) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (name == NULL || strlen(name) > 15) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    if (mode == NVS_READONLY && !ns_exists(name)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    for (int i = 0; i < NVS_MAX_HANDLES; i++) {
+        if (!s_handles[i].used) {
+            s_handles[i].used = true;
+            s_handles[i].mode = mode;
+            snprintf(s_handles[i].ns, sizeof(s_handles[i].ns), "%s", name);
+            if (mode == NVS_READWRITE) {
+                ns_add(name);
+            }
+            *handle = (nvs_handle_t)(i + 1);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    nvs_open_t *h = handle_get(handle);
+    if (h != NULL) {
+        memset(h, 0, sizeof(*h));
+    }
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    nvs_open_t *h;
+    return write_begin(handle, &h);
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *value)
+{
+    return entry_get(handle, key, NVS_TYPE_U8, value, NULL, true);
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value)
+{
+    return entry_set(handle, key, NVS_TYPE_U8, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *value)
+{
+    return entry_get(handle, key, NVS_TYPE_U32, value, NULL, true);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value)
+{
+    return entry_set(handle, key, NVS_TYPE_U32, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *value, size_t *length)
+{
+    return entry_get(handle, key, NVS_TYPE_STR, value, length, false);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    return entry_set(handle, key, NVS_TYPE_STR, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value, size_t *length)
+{
+    return entry_get(handle, key, NVS_TYPE_BLOB, value, length, false);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return entry_set(handle, key, NVS_TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    nvs_open_t *h;
+    esp_err_t ret = write_begin(handle, &h);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    nvs_entry_t *e = entry_find(h->ns, key);
+    if (e == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    entry_drop(e);
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    nvs_open_t *h;
+    esp_err_t ret = write_begin(handle, &h);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+        if (s_entries[i].used && strcmp(s_entries[i].ns, h->ns) == 0) {
+            entry_drop(&s_entries[i]);
+        }
+    }
+    return ESP_OK;
+}
+
+/* ==================== 测试接口 ==================== */
+
+void sim_nvs_fail_after(uint32_t n)
+{
+    s_fail_at = n == 0 ? 0 : s_write_ops + n;
+}
+
+uint32_t sim_nvs_write_ops(void)
+{
+    return s_write_ops;
+}
+
+const char *sim_nvs_last_writer(void)
+{
+    return s_last_writer;
+}
+
+static bool mem_contains(const uint8_t *hay, size_t hay_len, const void *needle, size_t len)
+{
+    if (len == 0 || hay_len < len) {
+        return false;
+    }
+    for (size_t i = 0; i + len <= hay_len; i++) {
+        if (memcmp(hay + i, needle, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool sim_nvs_raw_contains(const void *needle, size_t len)
+{
+    return s_raw != NULL && mem_contains(s_raw, s_raw_len, needle, len);
+}
+
+bool sim_nvs_live_contains(const void *needle, size_t len)
+{
+    for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+        if (s_entries[i].used && mem_contains(s_entries[i].data, s_entries[i].len, needle, len)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t sim_nvs_peek_blob(const char *ns, const char *key, void *buf, size_t cap)
+{
+    nvs_entry_t *e = entry_find(ns, key);
+    if (e == NULL || e->type != NVS_TYPE_BLOB) {
+        return 0;
+    }
+    memcpy(buf, e->data, e->len < cap ? e->len : cap);
+    return e->len;
+}
+
+/*
+ * 导出格式：命名空间表、条目（ns、key、type、len、data）、原始日志，
+ * 只在同一台机器的进程之间传递，不考虑字节序
+ */
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    bool overflow;
+} writer_t;
+
+static void put(writer_t *w, const void *data, size_t len)
+{
+    if (w->len + len > w->cap) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+size_t sim_nvs_export(void *buf, size_t cap)
+{
+    writer_t w = { buf, cap, 0, false };
+    put(&w, s_namespaces, sizeof(s_namespaces));
+    uint32_t count = 0;
+    for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+        count += s_entries[i].used;
+    }
+    put(&w, &count, sizeof(count));
+    for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+        const nvs_entry_t *e = &s_entries[i];
+        if (!e->used) {
+            continue;
+        }
+        put(&w, e->ns, sizeof(e->ns));
+        put(&w, e->key, sizeof(e->key));
+        put(&w, &e->type, sizeof(e->type));
+        put(&w, &e->len, sizeof(e->len));
+        put(&w, e->data, e->len);
+    }
+    uint32_t raw_len = (uint32_t)s_raw_len;
+    put(&w, &raw_len, sizeof(raw_len));
+    if (raw_len > 0) {
+        put(&w, s_raw, raw_len);
+    }
+    return w.overflow ? 0 : w.len;
+}
+
+void sim_nvs_import(const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    nvs_flash_erase();
+    memcpy(s_namespaces, p, sizeof(s_namespaces));
+    p += sizeof(s_namespaces);
+    uint32_t count;
+    memcpy(&count, p, sizeof(count));
+    p += sizeof(count);
+    for (uint32_t i = 0; i < count && i < NVS_MAX_ENTRIES; i++) {
+        nvs_entry_t *e = &s_entries[i];
+        e->used = true;
+        memcpy(e->ns, p, sizeof(e->ns));
+        p += sizeof(e->ns);
+        memcpy(e->key, p, sizeof(e->key));
+        p += sizeof(e->key);
+        memcpy(&e->type, p, sizeof(e->type));
+        p += sizeof(e->type);
+        memcpy(&e->len, p, sizeof(e->len));
+        p += sizeof(e->len);
+        e->data = sim_alloc(e->len > 0 ? e->len : 1);
+        memcpy(e->data, p, e->len);
+        p += e->len;
+    }
+    uint32_t raw_len;
+    memcpy(&raw_len, p, sizeof(raw_len));
+    p += sizeof(raw_len);
+    if (raw_len > 0) {
+        raw_append(p, raw_len);
+    }
+    (void)len;
+}
@@ -0,0 +1,147 @@
+/*
+ * @Description: 系统接口仿真 - 错误码名称、随机数、CRC、MAC、应用描述、唤醒原因、系统时间和共存
+ */
+
+#include "sim_internal.h"
+#include <time.h>
+
+static uint64_t s_rng_state = 0x9e3779b97f4a7c15ull;
+static int s_wakeup_cause;
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_NVS_NOT_INITIALIZED: return "ESP_ERR_NVS_NOT_INITIALIZED";
+    case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_INVALID_HANDLE: return "ESP_ERR_NVS_INVALID_HANDLE";
+    case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+    case ESP_ERR_WIFI_NOT_INIT: return "ESP_ERR_WIFI_NOT_INIT";
+    case ESP_ERR_WIFI_NOT_STARTED: return "ESP_ERR_WIFI_NOT_STARTED";
+    case ESP_ERR_WIFI_STATE: return "ESP_ERR_WIFI_STATE";
+    case ESP_ERR_WIFI_CONN: return "ESP_ERR_WIFI_CONN";
+    case ESP_ERR_WIFI_NOT_CONNECT: return "ESP_ERR_WIFI_NOT_CONNECT";
+    default: return "UNKNOWN ERROR";
+    }
+}
+
+/* 固定种子的xorshift，保证每次运行结果相同 */
+void esp_fill_random(void *buf, size_t len)
+{
+    uint8_t *p = buf;
+    for (size_t i = 0; i < len; i++) {
+        s_rng_state ^= s_rng_state << 13;
+        s_rng_state ^= s_rng_state >> 7;
+        s_rng_state ^= s_rng_state << 17;
+        p[i] = (uint8_t)(s_rng_state >> 24);
+    }
+}
+
+/* 与ROM实现一致：输入输出取反的反射CRC32 */
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+/* 与esp_crc16_be一致：多项式0x1021，输入输出取反 */
+uint16_t esp_crc16_be(uint16_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = (uint16_t)~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)(buf[i] << 8);
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return (uint16_t)~crc;
+}
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type)
+{
+    static const uint8_t base[6] = { 0x24, 0x0a, 0xc4, 0x12, 0x34, 0x56 };
+    if (mac == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(mac, base, sizeof(base));
+    if (type == ESP_MAC_BT) {
+        mac[5] += 2;
+    }
+    return ESP_OK;
+}
+
+const esp_app_desc_t *esp_app_get_description(void)
+{
+    static const esp_app_desc_t desc = { .version = "1.2.3", .project_name = "xn_blufi_host" };
+    return &desc;
+}
+
+esp_err_t esp_hmac_calculate(hmac_key_id_t key_id, const void *message, size_t message_len, uint8_t *hmac)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void sim_set_wakeup_cause(int cause)
+{
+    s_wakeup_cause = cause;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void)
+{
+    return (esp_sleep_wakeup_cause_t)s_wakeup_cause;
+}
+
+static bool s_time_unset;
+
+void sim_set_time_unset(bool unset)
+{
+    s_time_unset = unset;
+}
+
+/* 系统时间从2023-11-14开始随虚拟时间走，租约和连接时间戳都依赖它；
+ * 未校时时从1970年开始（上电后既没有SNTP也没有RTC保持的时间） */
+time_t time(time_t *out)
+{
+    time_t now = (time_t)((s_time_unset ? 0 : 1700000000) + sim_now_us() / 1000000);
+    if (out != NULL) {
+        *out = now;
+    }
+    return now;
+}
+
+static esp_coex_prefer_t s_coex_prefer = ESP_COEX_PREFER_BALANCE;
+static uint32_t s_coex_sets;
+
+esp_err_t esp_coex_preference_set(esp_coex_prefer_t prefer)
+{
+    if (prefer >= ESP_COEX_PREFER_NUM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_coex_prefer = prefer;
+    s_coex_sets++;
+    return ESP_OK;
+}
+
+esp_coex_prefer_t sim_coex_preference(uint32_t *sets)
+{
+    if (sets != NULL) {
+        *sets = s_coex_sets;
+    }
+    return s_coex_prefer;
+}
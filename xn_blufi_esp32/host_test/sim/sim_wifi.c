@@ -0,0 +1,883 @@
+/*
+ * @Description: WiFi驱动和网络接口仿真
+ *
+ * 连接流程：esp_wifi_connect() → （扫描）→ 认证关联 → STA_CONNECTED → DHCP → IP_EVENT_STA_GOT_IP，
+ * 失败时上报STA_DISCONNECTED(reason)。与真实驱动一致的几个行为：
+ * - 连接/已连接时调用esp_wifi_disconnect()，稍后会收到一个ASSOC_LEAVE(8)的DISCONNECTED；
+ * - 连接过程中esp_wifi_set_config()返回ESP_ERR_WIFI_STATE，esp_wifi_connect()返回ESP_ERR_WIFI_CONN；
+ * - 口令为64位十六进制时按PMK处理，WPA3 AP不接受PMK；
+ * - 蓝牙控制器使能时esp_wifi_set_ps(WIFI_PS_NONE)失败；
+ * - esp_netif_dhcpc_stop()后关联不再自动获取IP，esp_netif_set_ip_info()设置静态地址并上报GOT_IP，
+ *   esp_netif_dhcpc_start()清空地址后重新走DHCP；ping只有目标为当前网关时有回复。
+ * 驱动侧的回调在"wifi"任务（优先级23）中执行，事件由"sys_evt"任务分发。
+ */
+
+#include "sim_internal.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "lwip/dhcp.h"
+#include <openssl/evp.h>
+
+#define SIM_MAX_AP      8
+#define SIM_MAX_SCAN    16
+
+typedef enum {
+    LINK_IDLE,
+    LINK_CONNECTING,
+    LINK_CONNECTED,
+} link_state_t;
+
+typedef struct {
+    sim_ap_t ap;
+    char ssid[33];
+    char password[65];
+    uint8_t pmk[32];
+} ap_slot_t;
+
+struct esp_netif_obj {
+    int dummy;
+};
+
+struct netif {
+    int dummy;
+};
+
+static ap_slot_t s_aps[SIM_MAX_AP];
+static int s_ap_count;
+static sim_wifi_timing_t s_timing = {
+    .scan_ms = 1500,
+    .scan_channel_ms = 120,
+    .auth_ms = 150,
+    .dhcp_ms = 300,
+    .leave_ms = 5,
+};
+static sim_wifi_stats_t s_stats = { .last_ap = -1 };
+
+static bool s_inited;
+static bool s_started;
+static esp_err_t s_init_error;        // sim_wifi_fail_init()
+static wifi_mode_t s_mode;
+static wifi_config_t s_config;
+static wifi_ps_type_t s_ps = WIFI_PS_MIN_MODEM;
+static wifi_bandwidth_t s_bw = WIFI_BW_HT20;
+static int8_t s_tx_power = 80;
+
+static link_state_t s_link;
+static int s_cur_ap = -1;
+static bool s_has_ip;
+static wifi_sta_config_t s_attempt;
+static uint32_t s_fail_count;
+static uint8_t s_fail_reason;
+static uint8_t s_leave_reason;
+static int32_t s_rssi_threshold;
+static bool s_threshold_armed;
+
+static bool s_scanning;
+static wifi_scan_config_t s_scan_filter;
+static uint8_t s_scan_ssid[33];
+static wifi_ap_record_t s_scan_results[SIM_MAX_SCAN];
+static uint16_t s_scan_count;
+
+static esp_timer_handle_t s_connect_job;
+static esp_timer_handle_t s_dhcp_job;
+static esp_timer_handle_t s_leave_job;
+static esp_timer_handle_t s_scan_job;
+
+static struct esp_netif_obj s_netif;
+static struct netif s_lwip_netif;
+static struct dhcp s_dhcp;
+static bool s_in_tcpip;                     // 正在执行esp_netif_tcpip_exec()的回调
+static bool s_dhcpc_stopped;                // esp_netif_dhcpc_stop()后为true
+
+typedef struct {
+    esp_ping_config_t config;
+    esp_ping_callbacks_t cbs;
+    esp_timer_handle_t job;
+    uint32_t replies;
+} sim_ping_t;
+static esp_netif_ip_info_t s_ip_info;
+
+/* ==================== 测试接口 ==================== */
+
+int sim_wifi_add_ap(const sim_ap_t *ap)
+{
+    if (s_ap_count >= SIM_MAX_AP) {
+        abort();
+    }
+    ap_slot_t *slot = &s_aps[s_ap_count];
+    slot->ap = *ap;
+    snprintf(slot->ssid, sizeof(slot->ssid), "%s", ap->ssid);
+    snprintf(slot->password, sizeof(slot->password), "%s", ap->password != NULL ? ap->password : "");
+    slot->ap.ssid = slot->ssid;
+    slot->ap.password = slot->password;
+    if (slot->ap.lease_s == 0) {
+        slot->ap.lease_s = 7200;
+    }
+    sim_heap_pause();
+    PKCS5_PBKDF2_HMAC_SHA1(slot->password, (int)strlen(slot->password), (const unsigned char *)slot->ssid,
+                           (int)strlen(slot->ssid), 4096, sizeof(slot->pmk), slot->pmk);
+    sim_heap_resume();
+    return s_ap_count++;
+}
+
+void sim_wifi_set_online(int ap, bool online)
+{
+    s_aps[ap].ap.online = online;
+}
+
+void sim_wifi_set_timing(const sim_wifi_timing_t *timing)
+{
+    if (timing->scan_ms) {
+        s_timing.scan_ms = timing->scan_ms;
+    }
+    if (timing->scan_channel_ms) {
+        s_timing.scan_channel_ms = timing->scan_channel_ms;
+    }
+    if (timing->auth_ms) {
+        s_timing.auth_ms = timing->auth_ms;
+    }
+    if (timing->dhcp_ms) {
+        s_timing.dhcp_ms = timing->dhcp_ms;
+    }
+    if (timing->leave_ms) {
+        s_timing.leave_ms = timing->leave_ms;
+    }
+}
+
+void sim_wifi_fail_next(uint32_t count, uint8_t reason)
+{
+    s_fail_count = count;
+    s_fail_reason = reason;
+}
+
+int sim_wifi_connected_ap(void)
+{
+    return s_link == LINK_CONNECTED ? s_cur_ap : -1;
+}
+
+bool sim_wifi_has_ip(void)
+{
+    return s_has_ip;
+}
+
+void sim_wifi_get_stats(sim_wifi_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+void sim_wifi_get_sta_config(wifi_sta_config_t *config)
+{
+    *config = s_config.sta;
+}
+
+/* ==================== 驱动内部 ==================== */
+
+static void post_disconnected(uint8_t reason, const uint8_t *ssid)
+{
+    wifi_event_sta_disconnected_t ev = { .reason = reason, .rssi = -127 };
+    size_t len = strnlen((const char *)ssid, sizeof(ev.ssid));
+    memcpy(ev.ssid, ssid, len);
+    ev.ssid_len = (uint8_t)len;
+    sim_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &ev, sizeof(ev));
+}
+
+static void link_down(void)
+{
+    esp_timer_stop(s_connect_job);
+    esp_timer_stop(s_dhcp_job);
+    s_link = LINK_IDLE;
+    s_has_ip = false;
+    memset(&s_ip_info, 0, sizeof(s_ip_info));
+}
+
+static bool is_pmk(const uint8_t *password)
+{
+    for (int i = 0; i < 64; i++) {
+        char c = (char)password[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* 认证结果：0成功，否则为断开原因 */
+static uint8_t check_credentials(const ap_slot_t *slot, const wifi_sta_config_t *sta)
+{
+    if (slot->ap.authmode == WIFI_AUTH_OPEN) {
+        return 0;
+    }
+    if (is_pmk(sta->password)) {
+        if (slot->ap.authmode == WIFI_AUTH_WPA3_PSK) {
+            return WIFI_REASON_AUTH_FAIL;
+        }
+        uint8_t pmk[32];
+        for (int i = 0; i < 32; i++) {
+            unsigned hi, lo;
+            sscanf((const char *)&sta->password[i * 2], "%1x%1x", &hi, &lo);
+            pmk[i] = (uint8_t)(hi << 4 | lo);
+        }
+        return memcmp(pmk, slot->pmk, sizeof(pmk)) == 0 ? 0 : WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT;
+    }
+    size_t len = strnlen((const char *)sta->password, sizeof(sta->password));
+    if (len != strlen(slot->password) || memcmp(sta->password, slot->password, len) != 0) {
+        return WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT;
+    }
+    return 0;
+}
+
+static bool ssid_matches(const ap_slot_t *slot, const uint8_t *ssid, size_t cap)
+{
+    size_t len = strnlen((const char *)ssid, cap);
+    return len == strlen(slot->ssid) && memcmp(ssid, slot->ssid, len) == 0;
+}
+
+static void connect_job(void *arg)
+{
+    if (s_link != LINK_CONNECTING) {
+        return;
+    }
+    if (s_fail_count > 0) {
+        s_fail_count--;
+        link_down();
+        post_disconnected(s_fail_reason, s_attempt.ssid);
+        return;
+    }
+
+    int found = -1;
+    for (int i = 0; i < s_ap_count; i++) {
+        const ap_slot_t *slot = &s_aps[i];
+        if (!slot->ap.online || !ssid_matches(slot, s_attempt.ssid, sizeof(s_attempt.ssid))) {
+            continue;
+        }
+        if (s_attempt.bssid_set && (memcmp(slot->ap.bssid, s_attempt.bssid, 6) != 0 ||
+                                    (s_attempt.channel != 0 && slot->ap.channel != s_attempt.channel))) {
+            continue;
+        }
+        if (found < 0 || slot->ap.rssi > s_aps[found].ap.rssi) {
+            found = i;
+        }
+    }
+    if (found < 0) {
+        link_down();
+        post_disconnected(WIFI_REASON_NO_AP_FOUND, s_attempt.ssid);
+        return;
+    }
+
+    uint8_t reason = check_credentials(&s_aps[found], &s_attempt);
+    if (reason != 0) {
+        link_down();
+        post_disconnected(reason, s_attempt.ssid);
+        return;
+    }
+
+    const ap_slot_t *slot = &s_aps[found];
+    s_link = LINK_CONNECTED;
+    s_cur_ap = found;
+    s_stats.last_ap = found;
+    wifi_event_sta_connected_t ev = {
+        .channel = slot->ap.channel,
+        .authmode = slot->ap.authmode,
+        .aid = 1,
+    };
+    ev.ssid_len = (uint8_t)strlen(slot->ssid);
+    memcpy(ev.ssid, slot->ssid, ev.ssid_len);
+    memcpy(ev.bssid, slot->ap.bssid, 6);
+    if (!s_dhcpc_stopped) {
+        esp_timer_start_once(s_dhcp_job, (uint64_t)s_timing.dhcp_ms * 1000);
+    }
+    sim_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &ev, sizeof(ev));
+}
+
+static void dhcp_job(void *arg)
+{
+    if (s_link != LINK_CONNECTED) {
+        return;
+    }
+    s_has_ip = true;
+    s_stats.dhcp_leases++;
+    s_ip_info.ip.addr = ESP_IP4TOADDR(192, 168, 1, 100 + s_cur_ap);
+    s_ip_info.gw.addr = ESP_IP4TOADDR(192, 168, 1, 1);
+    s_ip_info.netmask.addr = ESP_IP4TOADDR(255, 255, 255, 0);
+    s_dhcp.offered_t0_lease = s_aps[s_cur_ap].ap.lease_s;
+    ip_event_got_ip_t ev = { .esp_netif = &s_netif, .ip_info = s_ip_info, .ip_changed = true };
+    sim_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &ev, sizeof(ev));
+}
+
+static void leave_job(void *arg)
+{
+    post_disconnected(s_leave_reason, s_attempt.ssid);
+}
+
+static int cmp_rssi(const void *a, const void *b)
+{
+    return ((const wifi_ap_record_t *)b)->rssi - ((const wifi_ap_record_t *)a)->rssi;
+}
+
+static void scan_job(void *arg)
+{
+    s_scanning = false;
+    s_scan_count = 0;
+    for (int i = 0; i < s_ap_count && s_scan_count < SIM_MAX_SCAN; i++) {
+        const ap_slot_t *slot = &s_aps[i];
+        if (!slot->ap.online) {
+            continue;
+        }
+        if (s_scan_filter.ssid != NULL && !ssid_matches(slot, s_scan_ssid, sizeof(s_scan_ssid))) {
+            continue;
+        }
+        if (s_scan_filter.channel != 0 && slot->ap.channel != s_scan_filter.channel) {
+            continue;
+        }
+        wifi_ap_record_t *rec = &s_scan_results[s_scan_count++];
+        memset(rec, 0, sizeof(*rec));
+        memcpy(rec->bssid, slot->ap.bssid, 6);
+        memcpy(rec->ssid, slot->ssid, strlen(slot->ssid));
+        rec->primary = slot->ap.channel;
+        rec->rssi = slot->ap.rssi;
+        rec->authmode = slot->ap.authmode;
+    }
+    qsort(s_scan_results, s_scan_count, sizeof(s_scan_results[0]), cmp_rssi);
+    wifi_event_sta_scan_done_t ev = { .status = 0, .number = (uint8_t)s_scan_count };
+    sim_event_post(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, &ev, sizeof(ev));
+}
+
+/* ==================== 链路控制 ==================== */
+
+void sim_wifi_drop_link(uint8_t reason)
+{
+    if (s_link != LINK_CONNECTED) {
+        return;
+    }
+    link_down();
+    post_disconnected(reason, s_attempt.ssid);
+}
+
+void sim_wifi_beacon_timeout(void)
+{
+    if (s_link == LINK_CONNECTED) {
+        sim_event_post(WIFI_EVENT, WIFI_EVENT_STA_BEACON_TIMEOUT, NULL, 0);
+    }
+}
+
+static void check_rssi_threshold(void)
+{
+    if (s_link != LINK_CONNECTED || !s_threshold_armed || s_rssi_threshold == 0) {
+        return;
+    }
+    int8_t rssi = s_aps[s_cur_ap].ap.rssi;
+    if (rssi < s_rssi_threshold) {
+        s_threshold_armed = false;
+        wifi_event_bss_rssi_low_t ev = { .rssi = rssi };
+        sim_event_post(WIFI_EVENT, WIFI_EVENT_STA_BSS_RSSI_LOW, &ev, sizeof(ev));
+    }
+}
+
+void sim_wifi_set_rssi(int ap, int8_t rssi)
+{
+    s_aps[ap].ap.rssi = rssi;
+    if (ap == s_cur_ap) {
+        check_rssi_threshold();
+    }
+}
+
+/* ==================== esp_wifi ==================== */
+
+bool sim_wifi_started(void)
+{
+    return s_started;
+}
+
+void sim_wifi_fail_init(esp_err_t err)
+{
+    s_init_error = err;
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config)
+{
+    if (s_init_error != ESP_OK) {
+        esp_err_t err = s_init_error;
+        s_init_error = ESP_OK;
+        return err;
+    }
+    if (s_inited) {
+        return ESP_OK;
+    }
+    s_connect_job = sim_job_create(connect_job, NULL, "connect");
+    s_dhcp_job = sim_job_create(dhcp_job, NULL, "dhcp");
+    s_leave_job = sim_job_create(leave_job, NULL, "leave");
+    s_scan_job = sim_job_create(scan_job, NULL, "scan");
+    s_inited = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_deinit(void)
+{
+    if (s_started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    s_inited = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    if (!s_inited) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    s_mode = mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode)
+{
+    if (!s_inited) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    *mode = s_mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    if (!s_inited) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    s_started = true;
+    sim_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_stop(void)
+{
+    if (!s_inited) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    link_down();
+    s_started = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void)
+{
+    if (!s_inited) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (!s_started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    s_stats.connect_calls++;
+    if (s_link != LINK_IDLE) {
+        s_stats.connect_rejected++;
+        return ESP_ERR_WIFI_CONN;
+    }
+    if (s_scanning) {
+        // 连接会中止进行中的扫描，扫描以失败状态结束
+        esp_timer_stop(s_scan_job);
+        s_scanning = false;
+        s_scan_count = 0;
+        wifi_event_sta_scan_done_t ev = { .status = 1 };
+        sim_event_post(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, &ev, sizeof(ev));
+    }
+    s_attempt = s_config.sta;
+    s_link = LINK_CONNECTING;
+    s_stats.attempts++;
+    uint32_t delay_ms = s_timing.auth_ms;
+    if (s_attempt.bssid_set && s_attempt.channel != 0) {
+        s_stats.direct_connects++;
+    } else {
+        delay_ms += s_timing.scan_ms;
+    }
+    if (is_pmk(s_attempt.password)) {
+        s_stats.pmk_connects++;
+    }
+    esp_timer_start_once(s_connect_job, (uint64_t)delay_ms * 1000);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_disconnect(void)
+{
+    if (!s_inited) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (!s_started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    s_stats.disconnect_calls++;
+    if (s_link == LINK_IDLE) {
+        return ESP_OK;
+    }
+    link_down();
+    s_leave_reason = WIFI_REASON_ASSOC_LEAVE;
+    esp_timer_stop(s_leave_job);
+    esp_timer_start_once(s_leave_job, (uint64_t)s_timing.leave_ms * 1000);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t iface, wifi_config_t *config)
+{
+    if (!s_inited) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_stats.set_config_calls++;
+    if (s_link == LINK_CONNECTING) {
+        s_stats.set_config_rejected++;
+        return ESP_ERR_WIFI_STATE;
+    }
+    s_config = *config;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t iface, wifi_config_t *config)
+{
+    if (!s_inited) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    *config = s_config;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t *config, bool block)
+{
+    if (!s_started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    if (s_scanning || s_link == LINK_CONNECTING) {
+        return ESP_ERR_WIFI_STATE;
+    }
+    memset(&s_scan_filter, 0, sizeof(s_scan_filter));
+    memset(s_scan_ssid, 0, sizeof(s_scan_ssid));
+    if (config != NULL) {
+        s_scan_filter = *config;
+        if (config->ssid != NULL) {
+            memcpy(s_scan_ssid, config->ssid, strnlen((const char *)config->ssid, 32));
+        }
+    }
+    s_scanning = true;
+    s_stats.scans++;
+    uint32_t ms = s_scan_filter.channel != 0 ? s_timing.scan_channel_ms : s_timing.scan_ms;
+    esp_timer_start_once(s_scan_job, (uint64_t)ms * 1000);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_stop(void)
+{
+    if (s_scanning) {
+        esp_timer_stop(s_scan_job);
+        s_scanning = false;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t *number)
+{
+    *number = s_scan_count;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *records)
+{
+    uint16_t n = *number < s_scan_count ? *number : s_scan_count;
+    memcpy(records, s_scan_results, n * sizeof(records[0]));
+    *number = n;
+    s_scan_count = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_clear_ap_list(void)
+{
+    s_scan_count = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *info)
+{
+    if (s_link != LINK_CONNECTED) {
+        return ESP_ERR_WIFI_NOT_CONNECT;
+    }
+    const ap_slot_t *slot = &s_aps[s_cur_ap];
+    memset(info, 0, sizeof(*info));
+    memcpy(info->bssid, slot->ap.bssid, 6);
+    memcpy(info->ssid, slot->ssid, strlen(slot->ssid));
+    info->primary = slot->ap.channel;
+    info->rssi = slot->ap.rssi;
+    info->authmode = slot->ap.authmode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_rssi(int *rssi)
+{
+    if (s_link != LINK_CONNECTED) {
+        return ESP_ERR_WIFI_NOT_CONNECT;
+    }
+    *rssi = s_aps[s_cur_ap].ap.rssi;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_negotiated_phymode(wifi_phy_mode_t *phymode)
+{
+    if (s_link != LINK_CONNECTED) {
+        return ESP_ERR_WIFI_NOT_CONNECT;
+    }
+    *phymode = s_bw == WIFI_BW_HT40 ? WIFI_PHY_MODE_HT40 : WIFI_PHY_MODE_HT20;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+    /* 与真实驱动一致：蓝牙控制器使能时不允许关闭Modem-sleep */
+    if (type == WIFI_PS_NONE && sim_ble_controller_enabled()) {
+        return ESP_FAIL;
+    }
+    s_ps = type;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t *type)
+{
+    *type = s_ps;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_bandwidth(wifi_interface_t iface, wifi_bandwidth_t bw)
+{
+    s_bw = bw;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_bandwidth(wifi_interface_t iface, wifi_bandwidth_t *bw)
+{
+    *bw = s_bw;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_protocol(wifi_interface_t iface, uint8_t protocol)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_max_tx_power(int8_t power)
+{
+    if (!s_started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    s_tx_power = power;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_max_tx_power(int8_t *power)
+{
+    *power = s_tx_power;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_rssi_threshold(int32_t rssi)
+{
+    s_rssi_threshold = rssi;
+    s_threshold_armed = true;
+    check_rssi_threshold();
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_storage(int storage)
+{
+    return ESP_OK;
+}
+
+/* 仿真的AP不支持11k/11v，漫游走扫描路径 */
+int esp_rrm_send_neighbor_report_request(void)
+{
+    return -1;
+}
+
+bool esp_rrm_is_rrm_supported_connection(void)
+{
+    return false;
+}
+
+int esp_wnm_send_bss_transition_mgmt_query(enum btm_query_reason query_reason, const char *btm_candidates, int cand_list)
+{
+    return -1;
+}
+
+bool esp_wnm_is_btm_supported_connection(void)
+{
+    return false;
+}
+
+/* ==================== esp_netif / lwIP ==================== */
+
+esp_err_t esp_netif_init(void)
+{
+    return ESP_OK;
+}
+
+esp_netif_t *esp_netif_create_default_wifi_sta(void)
+{
+    return &s_netif;
+}
+
+void esp_netif_destroy_default_wifi(void *netif)
+{
+}
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t *netif, esp_netif_ip_info_t *info)
+{
+    *info = s_ip_info;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t *netif, const esp_netif_ip_info_t *info)
+{
+    /* 与esp_netif一致：DHCP客户端运行时不能设置地址，设置成功且已关联时上报GOT_IP */
+    if (!s_dhcpc_stopped) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_ip_info = *info;
+    if (s_link == LINK_CONNECTED && info->ip.addr != 0) {
+        s_has_ip = true;
+        ip_event_got_ip_t ev = { .esp_netif = &s_netif, .ip_info = s_ip_info, .ip_changed = true };
+        sim_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &ev, sizeof(ev));
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t *netif)
+{
+    s_dhcpc_stopped = true;
+    esp_timer_stop(s_dhcp_job);
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_dhcpc_start(esp_netif_t *netif)
+{
+    if (!s_dhcpc_stopped) {
+        return ESP_OK;
+    }
+    s_dhcpc_stopped = false;
+    s_has_ip = false;
+    memset(&s_ip_info, 0, sizeof(s_ip_info));
+    if (s_link == LINK_CONNECTED) {
+        esp_timer_start_once(s_dhcp_job, (uint64_t)s_timing.dhcp_ms * 1000);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_get_dns_info(esp_netif_t *netif, esp_netif_dns_type_t type, esp_netif_dns_info_t *dns)
+{
+    memset(dns, 0, sizeof(*dns));
+    dns->ip.type = ESP_IPADDR_TYPE_V4;
+    if (type == ESP_NETIF_DNS_MAIN && s_has_ip) {
+        dns->ip.u_addr.ip4 = s_ip_info.gw;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_dns_info(esp_netif_t *netif, esp_netif_dns_type_t type, esp_netif_dns_info_t *dns)
+{
+    return ESP_OK;
+}
+
+void *esp_netif_get_netif_impl(esp_netif_t *netif)
+{
+    return &s_lwip_netif;
+}
+
+esp_err_t esp_netif_tcpip_exec(esp_netif_callback_fn fn, void *ctx)
+{
+    /* 真实实现把回调投递到TCP/IP任务并等待完成；仿真中lwIP状态只在此期间视为已加锁 */
+    s_in_tcpip = true;
+    esp_err_t rc = fn(ctx);
+    s_in_tcpip = false;
+    return rc;
+}
+
+struct dhcp *netif_dhcp_data(struct netif *netif)
+{
+    if (!s_in_tcpip) {
+        s_stats.dhcp_unlocked_reads++;
+    }
+    return &s_dhcp;
+}
+
+/* ==================== esp_ping ==================== */
+
+/* 全部请求发完后结束会话，只有目标为当前网关时每个请求都有回复 */
+static void ping_job(void *arg)
+{
+    sim_ping_t *ping = arg;
+    bool reachable = s_has_ip && s_ip_info.gw.addr != 0 &&
+                     ping->config.target_addr.u_addr.ip4.addr == s_ip_info.gw.addr;
+    ping->replies = reachable ? ping->config.count : 0;
+    if (ping->cbs.on_ping_end != NULL) {
+        ping->cbs.on_ping_end(ping, ping->cbs.cb_args);
+    }
+}
+
+esp_err_t esp_ping_new_session(const esp_ping_config_t *config, const esp_ping_callbacks_t *cbs,
+                               esp_ping_handle_t *hdl_out)
+{
+    if (config == NULL || hdl_out == NULL || config->count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sim_ping_t *ping = calloc(1, sizeof(*ping));
+    if (ping == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ping->config = *config;
+    if (cbs != NULL) {
+        ping->cbs = *cbs;
+    }
+    ping->job = sim_job_create(ping_job, ping, "ping");
+    *hdl_out = ping;
+    return ESP_OK;
+}
+
+esp_err_t esp_ping_delete_session(esp_ping_handle_t hdl)
+{
+    sim_ping_t *ping = hdl;
+    if (ping == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer_stop(ping->job);
+    esp_timer_delete(ping->job);
+    free(ping);
+    return ESP_OK;
+}
+
+esp_err_t esp_ping_start(esp_ping_handle_t hdl)
+{
+    sim_ping_t *ping = hdl;
+    if (ping == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t duration_ms = (ping->config.count - 1) * ping->config.interval_ms + ping->config.timeout_ms;
+    esp_timer_start_once(ping->job, (uint64_t)duration_ms * 1000);
+    return ESP_OK;
+}
+
+esp_err_t esp_ping_stop(esp_ping_handle_t hdl)
+{
+    sim_ping_t *ping = hdl;
+    if (ping == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer_stop(ping->job);
+    return ESP_OK;
+}
+
+esp_err_t esp_ping_get_profile(esp_ping_handle_t hdl, esp_ping_profile_t profile, void *data, uint32_t size)
+{
+    sim_ping_t *ping = hdl;
+    if (ping == NULL || data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (profile != ESP_PING_PROF_REPLY || size < sizeof(uint32_t)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    *(uint32_t *)data = ping->replies;
+    return ESP_OK;
+}
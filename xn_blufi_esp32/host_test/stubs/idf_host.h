@@ -0,0 +1,721 @@
+/*
+ * @Description: 主机测试用ESP-IDF接口声明 - 只包含组件用到的类型和函数，实现在sim/中
+ *
+ * 各IDF头文件（esp_wifi.h、freertos/queue.h等）都只包含本文件，
+ * 类型布局按组件实际访问的字段裁剪，不追求与IDF二进制兼容。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== esp_err ==================== */
+
+typedef int esp_err_t;
+
+#define ESP_OK                          0
+#define ESP_FAIL                        -1
+#define ESP_ERR_NO_MEM                  0x101
+#define ESP_ERR_INVALID_ARG             0x102
+#define ESP_ERR_INVALID_STATE           0x103
+#define ESP_ERR_INVALID_SIZE            0x104
+#define ESP_ERR_NOT_FOUND               0x105
+#define ESP_ERR_NOT_SUPPORTED           0x106
+#define ESP_ERR_TIMEOUT                 0x107
+#define ESP_ERR_INVALID_RESPONSE        0x108
+#define ESP_ERR_INVALID_CRC             0x109
+#define ESP_ERR_NVS_BASE                0x1100
+#define ESP_ERR_NVS_NOT_INITIALIZED     0x1101
+#define ESP_ERR_NVS_NOT_FOUND           0x1102
+#define ESP_ERR_NVS_TYPE_MISMATCH       0x1103
+#define ESP_ERR_NVS_READ_ONLY           0x1104
+#define ESP_ERR_NVS_NOT_ENOUGH_SPACE    0x1105
+#define ESP_ERR_NVS_INVALID_NAME        0x1106
+#define ESP_ERR_NVS_INVALID_HANDLE      0x1107
+#define ESP_ERR_NVS_INVALID_LENGTH      0x110c
+#define ESP_ERR_NVS_NO_FREE_PAGES       0x110d
+#define ESP_ERR_NVS_NEW_VERSION_FOUND   0x1110
+#define ESP_ERR_WIFI_BASE               0x3000
+#define ESP_ERR_WIFI_NOT_INIT           0x3001
+#define ESP_ERR_WIFI_NOT_STARTED        0x3002
+#define ESP_ERR_WIFI_STATE              0x3006
+#define ESP_ERR_WIFI_CONN               0x3007
+#define ESP_ERR_WIFI_NOT_CONNECT        0x300f
+
+const char *esp_err_to_name(esp_err_t code);
+void sim_error_check_failed(esp_err_t rc, const char *expr, const char *file, int line);
+
+#define ESP_ERROR_CHECK(x) do {                                         \
+        esp_err_t err_rc_ = (x);                                        \
+        if (err_rc_ != ESP_OK) {                                        \
+            sim_error_check_failed(err_rc_, #x, __FILE__, __LINE__);    \
+        }                                                               \
+    } while (0)
+
+/* ==================== esp_log ==================== */
+
+void sim_log(char level, const char *tag, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE(tag, fmt, ...) sim_log('E', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) sim_log('W', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) sim_log('I', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) sim_log('D', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) sim_log('V', tag, fmt, ##__VA_ARGS__)
+
+#define BIT0 0x00000001
+#define BIT1 0x00000002
+#define BIT2 0x00000004
+#define BIT3 0x00000008
+#define BIT4 0x00000010
+#define BIT5 0x00000020
+#define BIT6 0x00000040
+#define BIT7 0x00000080
+
+/* ==================== esp_system / esp_mac / esp_app_desc / esp_sleep ==================== */
+
+#define RTC_DATA_ATTR
+
+void esp_restart(void) __attribute__((noreturn));
+void esp_fill_random(void *buf, size_t len);
+
+typedef enum { ESP_MAC_WIFI_STA, ESP_MAC_WIFI_SOFTAP, ESP_MAC_BT, ESP_MAC_ETH } esp_mac_type_t;
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type);
+
+typedef struct {
+    char version[32];
+    char project_name[32];
+} esp_app_desc_t;
+const esp_app_desc_t *esp_app_get_description(void);
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+} esp_sleep_wakeup_cause_t;
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void);
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
+uint16_t esp_crc16_be(uint16_t crc, const uint8_t *buf, uint32_t len);
+
+typedef enum { HMAC_KEY0 = 0, HMAC_KEY1, HMAC_KEY2, HMAC_KEY3, HMAC_KEY4, HMAC_KEY5 } hmac_key_id_t;
+esp_err_t esp_hmac_calculate(hmac_key_id_t key_id, const void *message, size_t message_len, uint8_t *hmac);
+
+/* ==================== FreeRTOS ==================== */
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t EventBits_t;
+typedef struct sim_event_group *EventGroupHandle_t;
+typedef struct sim_queue *QueueHandle_t;
+typedef struct sim_queue *SemaphoreHandle_t;
+typedef struct sim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+typedef struct { void *p[8]; } StaticEventGroup_t;
+typedef struct { void *p[16]; } StaticQueue_t;
+typedef StaticQueue_t StaticSemaphore_t;
+typedef struct { void *p[64]; } StaticTask_t;
+typedef uint8_t StackType_t;
+typedef struct { int owner; } portMUX_TYPE;
+
+/* 模拟调度器是协作式的，临界区内不会发生任务切换 */
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portMUX_INITIALIZE(m) ((m)->owner = 0)
+#define portENTER_CRITICAL(m) ((void)(m))
+#define portEXIT_CRITICAL(m) ((void)(m))
+#define portMAX_DELAY 0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define portNUM_PROCESSORS 2
+#define pdMS_TO_TICKS(x) ((TickType_t)(x))
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define tskNO_AFFINITY 0x7fffffff
+#define configMAX_PRIORITIES 25
+#define tskIDLE_PRIORITY 0
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buffer);
+void vEventGroupDelete(EventGroupHandle_t group);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks);
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *buffer);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+void vQueueDelete(QueueHandle_t queue);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                                           UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb,
+                                           BaseType_t core);
+#define xTaskCreate(fn, name, stack, arg, prio, handle) \
+    xTaskCreatePinnedToCore(fn, name, stack, arg, prio, handle, tskNO_AFFINITY)
+#define xTaskCreateStatic(fn, name, stack_size, arg, prio, stack, tcb) \
+    xTaskCreateStaticPinnedToCore(fn, name, stack_size, arg, prio, stack, tcb, tskNO_AFFINITY)
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char *pcTaskGetName(TaskHandle_t task);
+int xPortGetCoreID(void);
+
+/* ==================== esp_timer ==================== */
+
+typedef struct sim_timer *esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void *arg);
+typedef enum { ESP_TIMER_TASK, ESP_TIMER_ISR } esp_timer_dispatch_t;
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+esp_err_t esp_timer_delete(esp_timer_handle_t timer);
+bool esp_timer_is_active(esp_timer_handle_t timer);
+int64_t esp_timer_get_time(void);
+
+/* ==================== esp_coexist ==================== */
+
+typedef enum { ESP_COEX_PREFER_WIFI = 0, ESP_COEX_PREFER_BT, ESP_COEX_PREFER_BALANCE, ESP_COEX_PREFER_NUM } esp_coex_prefer_t;
+esp_err_t esp_coex_preference_set(esp_coex_prefer_t prefer);
+
+/* ==================== esp_event ==================== */
+
+typedef const char *esp_event_base_t;
+typedef void (*esp_event_handler_t)(void *arg, esp_event_base_t base, int32_t id, void *data);
+typedef void *esp_event_handler_instance_t;
+extern esp_event_base_t const WIFI_EVENT;
+extern esp_event_base_t const IP_EVENT;
+#define ESP_EVENT_ANY_ID -1
+
+esp_err_t esp_event_loop_create_default(void);
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void *arg);
+esp_err_t esp_event_handler_unregister(esp_event_base_t base, int32_t id, esp_event_handler_t handler);
+
+/* ==================== esp_netif ==================== */
+
+typedef struct { uint32_t addr; } esp_ip4_addr_t;
+typedef struct { esp_ip4_addr_t ip, netmask, gw; } esp_netif_ip_info_t;
+typedef struct esp_netif_obj esp_netif_t;
+typedef struct { union { esp_ip4_addr_t ip4; } u_addr; uint8_t type; } esp_ip_addr_t;
+typedef struct { esp_ip_addr_t ip; } esp_netif_dns_info_t;
+typedef enum { ESP_NETIF_DNS_MAIN = 0, ESP_NETIF_DNS_BACKUP, ESP_NETIF_DNS_FALLBACK } esp_netif_dns_type_t;
+#define ESP_IPADDR_TYPE_V4 0
+
+esp_err_t esp_netif_init(void);
+esp_netif_t *esp_netif_create_default_wifi_sta(void);
+void esp_netif_destroy_default_wifi(void *netif);
+esp_err_t esp_netif_get_ip_info(esp_netif_t *netif, esp_netif_ip_info_t *info);
+esp_err_t esp_netif_set_ip_info(esp_netif_t *netif, const esp_netif_ip_info_t *info);
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t *netif);
+esp_err_t esp_netif_dhcpc_start(esp_netif_t *netif);
+esp_err_t esp_netif_get_dns_info(esp_netif_t *netif, esp_netif_dns_type_t type, esp_netif_dns_info_t *dns);
+esp_err_t esp_netif_set_dns_info(esp_netif_t *netif, esp_netif_dns_type_t type, esp_netif_dns_info_t *dns);
+void *esp_netif_get_netif_impl(esp_netif_t *netif);
+typedef esp_err_t (*esp_netif_callback_fn)(void *ctx);
+esp_err_t esp_netif_tcpip_exec(esp_netif_callback_fn fn, void *ctx);
+
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(ipaddr) (int)((ipaddr)->addr & 0xff), (int)(((ipaddr)->addr >> 8) & 0xff), \
+    (int)(((ipaddr)->addr >> 16) & 0xff), (int)(((ipaddr)->addr >> 24) & 0xff)
+#define ESP_IP4TOADDR(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+typedef struct {
+    int if_index;
+    esp_netif_t *esp_netif;
+    esp_netif_ip_info_t ip_info;
+    bool ip_changed;
+} ip_event_got_ip_t;
+enum { IP_EVENT_STA_GOT_IP, IP_EVENT_STA_LOST_IP };
+
+/* ==================== lwIP ==================== */
+
+struct netif;
+struct dhcp { uint32_t offered_t0_lease; };
+struct dhcp *netif_dhcp_data(struct netif *netif);
+
+typedef struct { union { esp_ip4_addr_t ip4; } u_addr; uint8_t type; } ip_addr_t;
+#define ip_addr_set_ip4_u32(ipaddr, val) do { (ipaddr)->u_addr.ip4.addr = (val); (ipaddr)->type = 0; } while (0)
+
+/* ==================== esp_ping ==================== */
+
+typedef void *esp_ping_handle_t;
+typedef struct {
+    void *cb_args;
+    void (*on_ping_success)(esp_ping_handle_t hdl, void *args);
+    void (*on_ping_timeout)(esp_ping_handle_t hdl, void *args);
+    void (*on_ping_end)(esp_ping_handle_t hdl, void *args);
+} esp_ping_callbacks_t;
+typedef struct {
+    uint32_t count;
+    uint32_t interval_ms;
+    uint32_t timeout_ms;
+    uint32_t data_size;
+    ip_addr_t target_addr;
+} esp_ping_config_t;
+#define ESP_PING_DEFAULT_CONFIG() { .count = 5, .interval_ms = 1000, .timeout_ms = 1000, .data_size = 64 }
+typedef enum {
+    ESP_PING_PROF_SEQNO,
+    ESP_PING_PROF_TTL,
+    ESP_PING_PROF_REQUEST,
+    ESP_PING_PROF_REPLY,
+    ESP_PING_PROF_IPADDR,
+    ESP_PING_PROF_SIZE,
+    ESP_PING_PROF_TIMEGAP,
+    ESP_PING_PROF_DURATION,
+} esp_ping_profile_t;
+
+esp_err_t esp_ping_new_session(const esp_ping_config_t *config, const esp_ping_callbacks_t *cbs,
+                               esp_ping_handle_t *hdl_out);
+esp_err_t esp_ping_delete_session(esp_ping_handle_t hdl);
+esp_err_t esp_ping_start(esp_ping_handle_t hdl);
+esp_err_t esp_ping_stop(esp_ping_handle_t hdl);
+esp_err_t esp_ping_get_profile(esp_ping_handle_t hdl, esp_ping_profile_t profile, void *data, uint32_t size);
+
+/* ==================== esp_wifi ==================== */
+
+typedef enum { WIFI_MODE_NULL, WIFI_MODE_STA, WIFI_MODE_AP, WIFI_MODE_APSTA } wifi_mode_t;
+typedef enum { WIFI_IF_STA, WIFI_IF_AP } wifi_interface_t;
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_ENTERPRISE,
+    WIFI_AUTH_WPA3_PSK,
+    WIFI_AUTH_WPA2_WPA3_PSK,
+    WIFI_AUTH_MAX
+} wifi_auth_mode_t;
+typedef enum { WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM } wifi_ps_type_t;
+typedef enum { WIFI_BW_HT20 = 1, WIFI_BW_HT40 } wifi_bandwidth_t;
+typedef enum { WIFI_ALL_CHANNEL_SCAN, WIFI_FAST_SCAN } wifi_scan_method_t;
+typedef enum { WIFI_CONNECT_AP_BY_SIGNAL, WIFI_CONNECT_AP_BY_SECURITY } wifi_sort_method_t;
+typedef enum {
+    WIFI_PHY_MODE_LR,
+    WIFI_PHY_MODE_11B,
+    WIFI_PHY_MODE_11G,
+    WIFI_PHY_MODE_11A,
+    WIFI_PHY_MODE_HT20,
+    WIFI_PHY_MODE_HT40,
+    WIFI_PHY_MODE_HE20
+} wifi_phy_mode_t;
+#define WIFI_PROTOCOL_11B 1
+#define WIFI_PROTOCOL_11G 2
+#define WIFI_PROTOCOL_11N 4
+#define WIFI_PROTOCOL_LR 8
+
+typedef enum {
+    WIFI_REASON_UNSPECIFIED = 1,
+    WIFI_REASON_AUTH_EXPIRE = 2,
+    WIFI_REASON_ASSOC_LEAVE = 8,
+    WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT = 15,
+    WIFI_REASON_BEACON_TIMEOUT = 200,
+    WIFI_REASON_NO_AP_FOUND = 201,
+    WIFI_REASON_AUTH_FAIL = 202,
+    WIFI_REASON_ASSOC_FAIL = 203,
+    WIFI_REASON_HANDSHAKE_TIMEOUT = 204,
+} wifi_err_reason_t;
+
+typedef struct { int8_t rssi; wifi_auth_mode_t authmode; } wifi_scan_threshold_t;
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    wifi_scan_method_t scan_method;
+    bool bssid_set;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint16_t listen_interval;
+    wifi_sort_method_t sort_method;
+    wifi_scan_threshold_t threshold;
+    uint32_t rm_enabled:1, btm_enabled:1, mbo_enabled:1, ft_enabled:1, owe_enabled:1, transition_disable:1;
+    uint8_t failure_retry_cnt;
+} wifi_sta_config_t;
+typedef union { wifi_sta_config_t sta; } wifi_config_t;
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t ssid[33];
+    uint8_t primary;
+    int second;
+    int8_t rssi;
+    wifi_auth_mode_t authmode;
+} wifi_ap_record_t;
+typedef struct {
+    uint8_t *ssid;
+    uint8_t *bssid;
+    uint8_t channel;
+    bool show_hidden;
+    int scan_type;
+} wifi_scan_config_t;
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t channel;
+    wifi_auth_mode_t authmode;
+    uint16_t aid;
+} wifi_event_sta_connected_t;
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+    int8_t rssi;
+} wifi_event_sta_disconnected_t;
+typedef struct { int32_t rssi; } wifi_event_bss_rssi_low_t;
+typedef struct { uint8_t report[1400]; uint16_t report_len; } wifi_event_neighbor_report_t;
+typedef struct { uint32_t status; uint8_t number; uint8_t scan_id; } wifi_event_sta_scan_done_t;
+typedef struct { int magic; } wifi_init_config_t;
+#define WIFI_INIT_CONFIG_DEFAULT() { 0 }
+enum {
+    WIFI_EVENT_WIFI_READY,
+    WIFI_EVENT_SCAN_DONE,
+    WIFI_EVENT_STA_START,
+    WIFI_EVENT_STA_STOP,
+    WIFI_EVENT_STA_CONNECTED,
+    WIFI_EVENT_STA_DISCONNECTED,
+    WIFI_EVENT_STA_BSS_RSSI_LOW,
+    WIFI_EVENT_STA_BEACON_TIMEOUT,
+    WIFI_EVENT_STA_NEIGHBOR_REP,
+};
+
+#define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"
+#define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+esp_err_t esp_wifi_deinit(void);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_stop(void);
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_disconnect(void);
+esp_err_t esp_wifi_set_config(wifi_interface_t iface, wifi_config_t *config);
+esp_err_t esp_wifi_get_config(wifi_interface_t iface, wifi_config_t *config);
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t *config, bool block);
+esp_err_t esp_wifi_scan_stop(void);
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t *number);
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *records);
+esp_err_t esp_wifi_clear_ap_list(void);
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *info);
+esp_err_t esp_wifi_sta_get_rssi(int *rssi);
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t *type);
+esp_err_t esp_wifi_set_bandwidth(wifi_interface_t iface, wifi_bandwidth_t bw);
+esp_err_t esp_wifi_get_bandwidth(wifi_interface_t iface, wifi_bandwidth_t *bw);
+esp_err_t esp_wifi_set_protocol(wifi_interface_t iface, uint8_t protocol);
+esp_err_t esp_wifi_set_max_tx_power(int8_t power);
+esp_err_t esp_wifi_get_max_tx_power(int8_t *power);
+esp_err_t esp_wifi_set_rssi_threshold(int32_t rssi);
+esp_err_t esp_wifi_sta_get_negotiated_phymode(wifi_phy_mode_t *phymode);
+esp_err_t esp_wifi_set_storage(int storage);
+#define WIFI_STORAGE_RAM 1
+
+/* 802.11k/v */
+int esp_rrm_send_neighbor_report_request(void);
+bool esp_rrm_is_rrm_supported_connection(void);
+enum btm_query_reason {
+    REASON_UNSPECIFIED = 0,
+    REASON_FRAME_LOSS = 1,
+    REASON_DELAY = 2,
+    REASON_BANDWIDTH = 3,
+    REASON_LOAD_BALANCE = 4,
+    REASON_RSSI = 5
+};
+int esp_wnm_send_bss_transition_mgmt_query(enum btm_query_reason query_reason, const char *btm_candidates, int cand_list);
+bool esp_wnm_is_btm_supported_connection(void);
+
+/* ==================== nvs ==================== */
+
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle);
+void nvs_close(nvs_handle_t handle);
+esp_err_t nvs_commit(nvs_handle_t handle);
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *value);
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value);
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *value);
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value);
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *value, size_t *length);
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value, size_t *length);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key);
+esp_err_t nvs_erase_all(nvs_handle_t handle);
+
+/* ==================== BT控制器 / NimBLE ==================== */
+
+typedef enum { ESP_BT_MODE_IDLE, ESP_BT_MODE_BLE, ESP_BT_MODE_CLASSIC_BT, ESP_BT_MODE_BTDM } esp_bt_mode_t;
+typedef struct { int magic; } esp_bt_controller_config_t;
+#define BT_CONTROLLER_INIT_CONFIG_DEFAULT() { 0 }
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode);
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *config);
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode);
+esp_err_t esp_bt_controller_disable(void);
+esp_err_t esp_bt_controller_deinit(void);
+esp_err_t esp_nimble_init(void);
+esp_err_t esp_nimble_deinit(void);
+void nimble_port_run(void);
+int nimble_port_stop(void);
+void nimble_port_deinit(void);
+void nimble_port_freertos_deinit(void);
+
+struct ble_gatt_register_ctxt;
+typedef int ble_store_status_fn(void *event, void *arg);
+struct ble_hs_cfg {
+    void (*reset_cb)(int reason);
+    void (*sync_cb)(void);
+    void (*gatts_register_cb)(struct ble_gatt_register_ctxt *ctxt, void *arg);
+    ble_store_status_fn *store_status_cb;
+};
+extern struct ble_hs_cfg ble_hs_cfg;
+int ble_store_util_status_rr(void *event, void *arg);
+int ble_svc_gap_device_name_set(const char *name);
+const char *ble_svc_gap_device_name(void);
+int ble_hs_id_infer_auto(int privacy, uint8_t *out_addr_type);
+int ble_hs_id_copy_addr(uint8_t id_addr_type, uint8_t *out_id_addr, int *out_is_nrpa);
+
+typedef struct { uint8_t type; uint16_t value; } ble_uuid16_t;
+#define BLE_UUID16_INIT(v) { .type = 16, .value = (v) }
+struct ble_hs_adv_fields {
+    uint8_t flags;
+    const ble_uuid16_t *uuids16;
+    uint8_t num_uuids16;
+    unsigned uuids16_is_complete:1;
+    const uint8_t *name;
+    uint8_t name_len;
+    unsigned name_is_complete:1;
+    int8_t tx_pwr_lvl;
+    unsigned tx_pwr_lvl_is_present:1;
+    const uint8_t *mfg_data;
+    uint8_t mfg_data_len;
+};
+struct ble_gap_adv_params {
+    uint8_t conn_mode;
+    uint8_t disc_mode;
+    uint16_t itvl_min;
+    uint16_t itvl_max;
+    uint8_t channel_map;
+    uint8_t filter_policy;
+    uint8_t high_duty_cycle:1;
+};
+struct ble_gap_event {
+    uint8_t type;
+    union {
+        struct { int status; uint16_t conn_handle; } connect;
+        struct { int reason; } disconnect;
+    };
+};
+typedef int ble_gap_event_fn(struct ble_gap_event *event, void *arg);
+#define BLE_GAP_EVENT_CONNECT 0
+#define BLE_GAP_EVENT_DISCONNECT 1
+#define BLE_GAP_EVENT_ADV_COMPLETE 9
+#define BLE_GAP_CONN_MODE_UND 2
+#define BLE_GAP_DISC_MODE_GEN 2
+#define BLE_HS_ADV_F_DISC_GEN 0x02
+#define BLE_HS_ADV_F_BREDR_UNSUP 0x04
+#define BLE_HS_ADV_TX_PWR_LVL_AUTO (-128)
+#define BLE_HS_FOREVER INT32_MAX
+#define BLE_HS_EALREADY 2
+#define BLE_HS_EBUSY 15
+#define BLE_GAP_ADV_ITVL_MS(t) ((t) * 1000 / 625)
+#define BLE_ADDR_PUBLIC 0
+#define BLE_ADDR_RANDOM 1
+int ble_gap_adv_set_fields(const struct ble_hs_adv_fields *fields);
+int ble_gap_adv_rsp_set_fields(const struct ble_hs_adv_fields *fields);
+int ble_gap_adv_start(uint8_t own_addr_type, const void *direct_addr, int32_t duration_ms,
+                      const struct ble_gap_adv_params *params, ble_gap_event_fn *cb, void *cb_arg);
+int ble_gap_adv_stop(void);
+int ble_gap_adv_active(void);
+
+/* ==================== BluFi ==================== */
+
+void esp_blufi_gatt_svr_register_cb(struct ble_gatt_register_ctxt *ctxt, void *arg);
+int esp_blufi_gatt_svr_init(void);
+int esp_blufi_gatt_svr_deinit(void);
+void esp_blufi_btc_init(void);
+void esp_blufi_btc_deinit(void);
+void esp_blufi_adv_start(void);
+void esp_blufi_adv_stop(void);
+esp_err_t esp_blufi_profile_init(void);
+esp_err_t esp_blufi_profile_deinit(void);
+int esp_blufi_handle_gap_events(struct ble_gap_event *event, void *arg);
+
+typedef enum {
+    ESP_BLUFI_EVENT_INIT_FINISH = 0,
+    ESP_BLUFI_EVENT_DEINIT_FINISH,
+    ESP_BLUFI_EVENT_SET_WIFI_OPMODE,
+    ESP_BLUFI_EVENT_BLE_CONNECT,
+    ESP_BLUFI_EVENT_BLE_DISCONNECT,
+    ESP_BLUFI_EVENT_REQ_CONNECT_TO_AP,
+    ESP_BLUFI_EVENT_REQ_DISCONNECT_FROM_AP,
+    ESP_BLUFI_EVENT_GET_WIFI_STATUS,
+    ESP_BLUFI_EVENT_DEAUTHENTICATE_STA,
+    ESP_BLUFI_EVENT_RECV_STA_BSSID,
+    ESP_BLUFI_EVENT_RECV_STA_SSID,
+    ESP_BLUFI_EVENT_RECV_STA_PASSWD,
+    ESP_BLUFI_EVENT_RECV_SLAVE_DISCONNECT_BLE,
+    ESP_BLUFI_EVENT_GET_WIFI_LIST,
+    ESP_BLUFI_EVENT_REPORT_ERROR,
+    ESP_BLUFI_EVENT_RECV_CUSTOM_DATA
+} esp_blufi_cb_event_t;
+
+typedef union {
+    struct { wifi_mode_t op_mode; } wifi_mode;
+    struct { uint8_t *ssid; int ssid_len; } sta_ssid;
+    struct { uint8_t *passwd; int passwd_len; } sta_passwd;
+    struct { uint8_t bssid[6]; } sta_bssid;
+    struct { uint8_t *data; uint32_t data_len; } custom_data;
+    struct { uint8_t remote_bda[6]; uint8_t server_if; uint16_t conn_id; } connect;
+    struct { int state; } report_error;
+} esp_blufi_cb_param_t;
+
+typedef void (*esp_blufi_event_cb_t)(esp_blufi_cb_event_t event, esp_blufi_cb_param_t *param);
+typedef void (*esp_blufi_negotiate_data_handler_t)(uint8_t *data, int len, uint8_t **output_data, int *output_len, bool *need_free);
+typedef int (*esp_blufi_encrypt_func_t)(uint8_t iv8, uint8_t *crypt_data, int crypt_len);
+typedef int (*esp_blufi_decrypt_func_t)(uint8_t iv8, uint8_t *crypt_data, int crypt_len);
+typedef uint16_t (*esp_blufi_checksum_func_t)(uint8_t iv8, uint8_t *data, int len);
+typedef struct {
+    esp_blufi_event_cb_t event_cb;
+    esp_blufi_negotiate_data_handler_t negotiate_data_handler;
+    esp_blufi_encrypt_func_t encrypt_func;
+    esp_blufi_decrypt_func_t decrypt_func;
+    esp_blufi_checksum_func_t checksum_func;
+} esp_blufi_callbacks_t;
+esp_err_t esp_blufi_register_callbacks(esp_blufi_callbacks_t *callbacks);
+
+typedef struct { uint8_t ssid[33]; int8_t rssi; } esp_blufi_ap_record_t;
+typedef struct {
+    uint8_t sta_bssid[6];
+    bool sta_bssid_set;
+    uint8_t *sta_ssid;
+    int sta_ssid_len;
+    uint8_t *sta_passwd;
+    int sta_passwd_len;
+} esp_blufi_extra_info_t;
+typedef enum {
+    ESP_BLUFI_STA_CONN_SUCCESS = 0,
+    ESP_BLUFI_STA_CONN_FAIL,
+    ESP_BLUFI_STA_CONNECTING,
+    ESP_BLUFI_STA_NO_IP
+} esp_blufi_sta_conn_state_t;
+typedef enum {
+    ESP_BLUFI_SEQUENCE_ERROR = 0,
+    ESP_BLUFI_CHECKSUM_ERROR,
+    ESP_BLUFI_DECRYPT_ERROR,
+    ESP_BLUFI_ENCRYPT_ERROR,
+    ESP_BLUFI_INIT_SECURITY_ERROR,
+    ESP_BLUFI_DH_MALLOC_ERROR,
+    ESP_BLUFI_DH_PARAM_ERROR,
+    ESP_BLUFI_READ_PARAM_ERROR,
+    ESP_BLUFI_MAKE_PUBLIC_ERROR,
+    ESP_BLUFI_DATA_FORMAT_ERROR,
+    ESP_BLUFI_CALC_MD5_ERROR,
+    ESP_BLUFI_WIFI_SCAN_FAIL,
+    ESP_BLUFI_MSG_STATE_ERROR
+} esp_blufi_error_state_t;
+esp_err_t esp_blufi_send_wifi_conn_report(wifi_mode_t opmode, esp_blufi_sta_conn_state_t sta_conn_state,
+                                          uint8_t softap_conn_num, esp_blufi_extra_info_t *extra_info);
+esp_err_t esp_blufi_send_wifi_list(uint16_t apCount, esp_blufi_ap_record_t *list);
+esp_err_t esp_blufi_send_custom_data(uint8_t *data, uint32_t data_len);
+esp_err_t esp_blufi_send_error_info(esp_blufi_error_state_t state);
+
+/* ==================== mbedTLS ==================== */
+
+#define MBEDTLS_ERR_AES_INVALID_KEY_LENGTH  -0x0020
+#define MBEDTLS_ERR_DHM_BAD_INPUT_DATA      -0x3080
+#define MBEDTLS_ERR_DHM_MAKE_PUBLIC_FAILED  -0x3280
+#define MBEDTLS_ERR_DHM_CALC_SECRET_FAILED  -0x3300
+#define MBEDTLS_ERR_GCM_AUTH_FAILED         -0x0012
+#define MBEDTLS_ERR_GCM_BAD_INPUT           -0x0014
+#define MBEDTLS_AES_ENCRYPT 1
+#define MBEDTLS_AES_DECRYPT 0
+#define MBEDTLS_CIPHER_ID_AES 2
+#define MBEDTLS_GCM_ENCRYPT 1
+#define MBEDTLS_GCM_DECRYPT 0
+
+typedef struct {
+    void *evp;
+    unsigned char key[32];
+    unsigned int keybits;
+} mbedtls_aes_context;
+typedef struct {
+    void *p, *g, *x, *gx, *gy, *k;
+} mbedtls_dhm_context;
+typedef struct {
+    unsigned char key[32];
+    unsigned int keybits;
+} mbedtls_gcm_context;
+typedef enum { MBEDTLS_MD_NONE = 0, MBEDTLS_MD_MD5 = 3, MBEDTLS_MD_SHA1 = 4, MBEDTLS_MD_SHA256 = 9 } mbedtls_md_type_t;
+
+void mbedtls_aes_init(mbedtls_aes_context *ctx);
+void mbedtls_aes_free(mbedtls_aes_context *ctx);
+int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits);
+int mbedtls_aes_crypt_cfb128(mbedtls_aes_context *ctx, int mode, size_t length, size_t *iv_off,
+                             unsigned char iv[16], const unsigned char *input, unsigned char *output);
+void mbedtls_dhm_init(mbedtls_dhm_context *ctx);
+void mbedtls_dhm_free(mbedtls_dhm_context *ctx);
+int mbedtls_dhm_read_params(mbedtls_dhm_context *ctx, unsigned char **p, const unsigned char *end);
+size_t mbedtls_dhm_get_len(const mbedtls_dhm_context *ctx);
+int mbedtls_dhm_make_public(mbedtls_dhm_context *ctx, int x_size, unsigned char *output, size_t olen,
+                            int (*f_rng)(void *, unsigned char *, size_t), void *p_rng);
+int mbedtls_dhm_calc_secret(mbedtls_dhm_context *ctx, unsigned char *output, size_t output_size, size_t *olen,
+                            int (*f_rng)(void *, unsigned char *, size_t), void *p_rng);
+int mbedtls_md5(const unsigned char *input, size_t ilen, unsigned char output[16]);
+int mbedtls_sha256(const unsigned char *input, size_t ilen, unsigned char *output, int is224);
+int mbedtls_pkcs5_pbkdf2_hmac_ext(mbedtls_md_type_t md_type, const unsigned char *password, size_t plen,
+                                  const unsigned char *salt, size_t slen, unsigned int iteration_count,
+                                  uint32_t key_length, unsigned char *output);
+void mbedtls_gcm_init(mbedtls_gcm_context *ctx);
+void mbedtls_gcm_free(mbedtls_gcm_context *ctx);
+int mbedtls_gcm_setkey(mbedtls_gcm_context *ctx, int cipher, const unsigned char *key, unsigned int keybits);
+int mbedtls_gcm_crypt_and_tag(mbedtls_gcm_context *ctx, int mode, size_t length, const unsigned char *iv,
+                              size_t iv_len, const unsigned char *add, size_t add_len, const unsigned char *input,
+                              unsigned char *output, size_t tag_len, unsigned char *tag);
+int mbedtls_gcm_auth_decrypt(mbedtls_gcm_context *ctx, size_t length, const unsigned char *iv, size_t iv_len,
+                             const unsigned char *add, size_t add_len, const unsigned char *tag, size_t tag_len,
+                             const unsigned char *input, unsigned char *output);
+
+#ifdef __cplusplus
+}
+#endif
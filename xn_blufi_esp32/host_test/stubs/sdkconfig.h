@@ -0,0 +1,105 @@
+/*
+ * @Description: 主机测试用sdkconfig - 与Kconfig默认值一致，各测试变体通过-D覆盖
+ */
+
+#pragma once
+
+#ifndef CONFIG_XN_BLUFI_SECURITY
+#define CONFIG_XN_BLUFI_SECURITY 1
+#endif
+#ifndef CONFIG_XN_BLUFI_STORAGE_ENCRYPT
+#define CONFIG_XN_BLUFI_STORAGE_ENCRYPT 0
+#endif
+#ifndef CONFIG_XN_BLUFI_PARALLEL_INIT
+#define CONFIG_XN_BLUFI_PARALLEL_INIT 1
+#endif
+#ifndef CONFIG_XN_BLUFI_AUTO_CONNECT
+#define CONFIG_XN_BLUFI_AUTO_CONNECT 1
+#endif
+#ifndef CONFIG_XN_BLUFI_LEASE_CACHE
+#define CONFIG_XN_BLUFI_LEASE_CACHE 1
+#endif
+#ifndef CONFIG_XN_BLUFI_LEASE_STATIC_IP
+#define CONFIG_XN_BLUFI_LEASE_STATIC_IP 0
+#endif
+#ifndef CONFIG_XN_BLUFI_FAST_WAKE
+#define CONFIG_XN_BLUFI_FAST_WAKE 0
+#endif
+#ifndef CONFIG_XN_BLUFI_ROAMING
+#define CONFIG_XN_BLUFI_ROAMING 0
+#endif
+#ifndef CONFIG_XN_BLUFI_ROAM_RSSI_THRESHOLD
+#define CONFIG_XN_BLUFI_ROAM_RSSI_THRESHOLD -70
+#endif
+#ifndef CONFIG_XN_BLUFI_ROAM_RSSI_GAIN
+#define CONFIG_XN_BLUFI_ROAM_RSSI_GAIN 8
+#endif
+#ifndef CONFIG_XN_BLUFI_ROAM_INTERVAL
+#define CONFIG_XN_BLUFI_ROAM_INTERVAL 30
+#endif
+#ifndef CONFIG_XN_BLUFI_LINK_MONITOR
+#define CONFIG_XN_BLUFI_LINK_MONITOR 1
+#endif
+#ifndef CONFIG_XN_BLUFI_LINK_SAMPLE_INTERVAL
+#define CONFIG_XN_BLUFI_LINK_SAMPLE_INTERVAL 2000
+#endif
+#ifndef CONFIG_XN_BLUFI_LINK_DEGRADED_RSSI
+#define CONFIG_XN_BLUFI_LINK_DEGRADED_RSSI -75
+#endif
+#ifndef CONFIG_XN_BLUFI_LINK_HYSTERESIS
+#define CONFIG_XN_BLUFI_LINK_HYSTERESIS 5
+#endif
+#ifndef CONFIG_XN_BLUFI_STATIC_ALLOC
+#define CONFIG_XN_BLUFI_STATIC_ALLOC 0
+#endif
+#ifndef CONFIG_XN_BLUFI_SCAN_MAX_AP
+#define CONFIG_XN_BLUFI_SCAN_MAX_AP 20
+#endif
+#ifndef CONFIG_XN_BLUFI_ADV_SCHEDULE
+#define CONFIG_XN_BLUFI_ADV_SCHEDULE 1
+#endif
+#ifndef CONFIG_XN_BLUFI_ADV_FAST_INTERVAL
+#define CONFIG_XN_BLUFI_ADV_FAST_INTERVAL 40
+#endif
+#ifndef CONFIG_XN_BLUFI_ADV_FAST_DURATION
+#define CONFIG_XN_BLUFI_ADV_FAST_DURATION 30
+#endif
+#ifndef CONFIG_XN_BLUFI_ADV_SLOW_INTERVAL
+#define CONFIG_XN_BLUFI_ADV_SLOW_INTERVAL 1000
+#endif
+#ifndef CONFIG_XN_BLUFI_ADV_SLOW_DURATION
+#define CONFIG_XN_BLUFI_ADV_SLOW_DURATION 300
+#endif
+#ifndef CONFIG_XN_BLUFI_BOOT_PROFILE
+#define CONFIG_XN_BLUFI_BOOT_PROFILE 0
+#endif
+#if !defined(CONFIG_XN_BLUFI_WIFI_PROFILE_MAX_THROUGHPUT) && !defined(CONFIG_XN_BLUFI_WIFI_PROFILE_LOW_POWER)
+#define CONFIG_XN_BLUFI_WIFI_PROFILE_BALANCED 1
+#endif
+#ifndef CONFIG_XN_BLUFI_HOST_TASK_CORE
+#define CONFIG_XN_BLUFI_HOST_TASK_CORE 0
+#endif
+#ifndef CONFIG_XN_BLUFI_HOST_TASK_PRIORITY
+#define CONFIG_XN_BLUFI_HOST_TASK_PRIORITY 21
+#endif
+#ifndef CONFIG_XN_BLUFI_HOST_TASK_STACK_SIZE
+#define CONFIG_XN_BLUFI_HOST_TASK_STACK_SIZE 4096
+#endif
+#ifndef CONFIG_XN_BLUFI_WIFI_WORKER_CORE
+#define CONFIG_XN_BLUFI_WIFI_WORKER_CORE 0
+#endif
+#ifndef CONFIG_XN_BLUFI_WIFI_WORKER_PRIORITY
+#define CONFIG_XN_BLUFI_WIFI_WORKER_PRIORITY 5
+#endif
+#ifndef CONFIG_XN_BLUFI_WIFI_WORKER_STACK_SIZE
+#define CONFIG_XN_BLUFI_WIFI_WORKER_STACK_SIZE 4096
+#endif
+#ifndef CONFIG_XN_BLUFI_WIFI_SUB_TASK_PRIORITY
+#define CONFIG_XN_BLUFI_WIFI_SUB_TASK_PRIORITY 6
+#endif
+#ifndef CONFIG_XN_BLUFI_WIFI_SUB_TASK_STACK_SIZE
+#define CONFIG_XN_BLUFI_WIFI_SUB_TASK_STACK_SIZE 3072
+#endif
+#ifndef CONFIG_LWIP_DHCP_RESTORE_LAST_IP
+#define CONFIG_LWIP_DHCP_RESTORE_LAST_IP 1
+#endif
@@ -0,0 +1,82 @@
+/*
+ * @Description: PMK缓存基准 - get_connected_cred()补算PMK（PBKDF2-SHA1 4096轮）的耗时，
+ * 与用缓存PMK重新连接的耗时对比（主机真实时间）
+ *
+ * 仿真的WiFi驱动不在站点侧运行PBKDF2，口令连接在仿真中不付出设备上的派生开销；
+ * 打印的派生耗时即设备上每次口令连接由PMK缓存省下的计算量。用例只检查结果正确，不对耗时设门限。
+ */
+
+#include "xn_steps.h"
+#include <time.h>
+
+#define SSID        "xn-bench"
+#define PASSWORD    "correct-horse-battery"
+#define ROUNDS      10
+
+static int64_t wall_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t pbkdf2_calls(void)
+{
+    sim_crypto_stats_t stats;
+    sim_crypto_get_stats(&stats);
+    return stats.pbkdf2_calls;
+}
+
+static uint32_t pmk_connects(void)
+{
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    return stats.pmk_connects;
+}
+
+XN_TEST(bench_pmk_derive_vs_cached_connect)
+{
+    // 每轮切换连接都会打印断开警告，基准输出只保留结果
+    sim_set_log_level('E');
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    xn_wifi_manager_t *manager = xn_steps_manager_start();
+
+    int64_t derive_us = 0, passphrase_us = 0, pmk_us = 0;
+    for (int i = 0; i < ROUNDS; i++) {
+        // 口令连接：获取IP后取凭据时补算PMK
+        xn_wifi_cred_t cred;
+        XN_ASSERT_OK(xn_wifi_cred_from_str(&cred, SSID, PASSWORD));
+        int64_t start = wall_us();
+        XN_ASSERT_OK(xn_wifi_manager_connect_cred(manager, &cred));
+        XN_ASSERT(xn_steps_manager_wait_ip(manager, 20000));
+        passphrase_us += wall_us() - start;
+
+        uint32_t calls = pbkdf2_calls();
+        start = wall_us();
+        XN_ASSERT_OK(xn_wifi_manager_get_connected_cred(manager, &cred));
+        derive_us += wall_us() - start;
+        XN_ASSERT(cred.pmk_valid);
+        XN_ASSERT_EQ(pbkdf2_calls() - calls, 1);
+
+        // 把取到的PMK交回管理器重新连接：驱动收到十六进制PMK，取凭据时不再派生
+        uint32_t pmk_before = pmk_connects();
+        calls = pbkdf2_calls();
+        start = wall_us();
+        XN_ASSERT_OK(xn_wifi_manager_connect_cred(manager, &cred));
+        XN_ASSERT(xn_steps_manager_wait_ip(manager, 20000));
+        xn_wifi_cred_t connected;
+        XN_ASSERT_OK(xn_wifi_manager_get_connected_cred(manager, &connected));
+        pmk_us += wall_us() - start;
+        XN_ASSERT(connected.pmk_valid);
+        XN_ASSERT(memcmp(connected.pmk, cred.pmk, sizeof(cred.pmk)) == 0);
+        XN_ASSERT_EQ(pmk_connects() - pmk_before, 1);
+        XN_ASSERT_EQ(pbkdf2_calls() - calls, 0);
+    }
+
+    printf("  get_connected_cred PMK derivation: avg %lld us over %d rounds\n",
+           (long long)(derive_us / ROUNDS), ROUNDS);
+    printf("  passphrase connect (sim driver, no derivation): avg %lld us\n",
+           (long long)(passphrase_us / ROUNDS));
+    printf("  cached PMK connect + get_connected_cred: avg %lld us\n",
+           (long long)(pmk_us / ROUNDS));
+}
@@ -0,0 +1,140 @@
+/*
+ * @Description: BluFi安全层基准 - DH密钥协商耗时和逐帧AES加解密吞吐（主机真实时间）
+ *
+ * 直接调用安全层回调，不经过仿真的BLE链路；数值只用于比较改动前后，
+ * 与目标芯片上的耗时没有固定比例。用例只检查结果正确，不对耗时设门限。
+ */
+
+#include "xn_test.h"
+#include "xn_blufi_internal.h"
+#include <time.h>
+#include <openssl/bn.h>
+
+#define NEGOTIATE_ROUNDS    20
+#define CRYPT_BYTES         (256 * 1024)
+
+static int64_t wall_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static size_t put_mpi(uint8_t *out, const BIGNUM *bn)
+{
+    int n = BN_num_bytes(bn);
+    out[0] = (uint8_t)(n >> 8);
+    out[1] = (uint8_t)(n & 0xff);
+    BN_bn2bin(bn, out + 2);
+    return 2 + (size_t)n;
+}
+
+/* 按手机端的格式构造1024位DH参数帧（类型+P、G、公钥），返回长度 */
+static size_t build_dh_param(uint8_t *frame)
+{
+    BN_CTX *bn = BN_CTX_new();
+    BIGNUM *p = BN_get_rfc2409_prime_1024(NULL);
+    BIGNUM *g = BN_new();
+    BIGNUM *x = BN_new();
+    BIGNUM *gx = BN_new();
+    BN_set_word(g, 2);
+    BN_rand(x, 256, BN_RAND_TOP_ANY, BN_RAND_BOTTOM_ANY);
+    BN_mod_exp(gx, g, x, p, bn);
+    size_t len = 1;
+    frame[0] = 0x01;
+    len += put_mpi(&frame[len], p);
+    len += put_mpi(&frame[len], g);
+    len += put_mpi(&frame[len], gx);
+    BN_free(p);
+    BN_free(g);
+    BN_clear_free(x);
+    BN_free(gx);
+    BN_CTX_free(bn);
+    return len;
+}
+
+/* 完成一次协商，返回耗时（微秒） */
+static int64_t negotiate_once(const uint8_t *frame, size_t len)
+{
+    uint8_t param_len[3] = { 0x00, (uint8_t)((len - 1) >> 8), (uint8_t)((len - 1) & 0xff) };
+    uint8_t data[1 + 3 * (2 + 128)];
+    memcpy(data, frame, len);
+
+    uint8_t *out = NULL;
+    int out_len = 0;
+    bool need_free = false;
+    int64_t start = wall_us();
+    xn_blufi_security_negotiate(param_len, sizeof(param_len), &out, &out_len, &need_free);
+    xn_blufi_security_negotiate(data, (int)len, &out, &out_len, &need_free);
+    int64_t elapsed = wall_us() - start;
+    XN_ASSERT(out != NULL);
+    XN_ASSERT_EQ(out_len, 128);
+    if (need_free) {
+        free(out);
+    }
+    return elapsed;
+}
+
+XN_TEST(bench_negotiate)
+{
+    uint8_t frame[1 + 3 * (2 + 128)];
+    size_t len = build_dh_param(frame);
+
+    int64_t total = 0;
+    int64_t worst = 0;
+    for (int i = 0; i < NEGOTIATE_ROUNDS; i++) {
+        XN_ASSERT_OK(xn_blufi_security_init());
+        int64_t us = negotiate_once(frame, len);
+        xn_blufi_security_deinit();
+        total += us;
+        worst = us > worst ? us : worst;
+    }
+    printf("  negotiate (1024-bit DH): avg %lld us, max %lld us over %d rounds\n",
+           (long long)(total / NEGOTIATE_ROUNDS), (long long)worst, NEGOTIATE_ROUNDS);
+}
+
+XN_TEST(bench_frame_crypt)
+{
+    uint8_t frame[1 + 3 * (2 + 128)];
+    size_t len = build_dh_param(frame);
+    XN_ASSERT_OK(xn_blufi_security_init());
+    negotiate_once(frame, len);
+
+    // BluFi帧负载最大约为MTU减去帧头，按常见的几种帧长测
+    static const int sizes[] = { 16, 64, 128, 244, 512 };
+    static uint8_t plain[512];
+    static uint8_t buf[512];
+    for (size_t i = 0; i < sizeof(plain); i++) {
+        plain[i] = (uint8_t)(i * 7 + 3);
+    }
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int size = sizes[s];
+        int frames = CRYPT_BYTES / size;
+        int64_t enc_us = 0;
+        int64_t dec_us = 0;
+        for (int i = 0; i < frames; i++) {
+            uint8_t iv8 = (uint8_t)i;
+            memcpy(buf, plain, size);
+            int64_t t0 = wall_us();
+            XN_ASSERT_EQ(xn_blufi_security_encrypt(iv8, buf, size), size);
+            int64_t t1 = wall_us();
+            XN_ASSERT_EQ(xn_blufi_security_decrypt(iv8, buf, size), size);
+            int64_t t2 = wall_us();
+            enc_us += t1 - t0;
+            dec_us += t2 - t1;
+        }
+        // 最后一帧加密再解密后与明文一致
+        XN_ASSERT(memcmp(buf, plain, size) == 0);
+        printf("  %3d-byte frames: encrypt %.2f MB/s, decrypt %.2f MB/s (%d frames)\n", size,
+               enc_us ? (double)frames * size / enc_us : 0.0,
+               dec_us ? (double)frames * size / dec_us : 0.0, frames);
+    }
+
+    xn_blufi_security_stats_t stats;
+    xn_blufi_security_get_stats(&stats);
+    XN_ASSERT_EQ(stats.negotiations, 1);
+    XN_ASSERT(stats.encrypt_frames > 0);
+    XN_ASSERT_EQ(stats.encrypt_frames, stats.decrypt_frames);
+    xn_blufi_security_deinit();
+}
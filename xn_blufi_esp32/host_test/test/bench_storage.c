@@ -0,0 +1,87 @@
+/*
+ * @Description: WiFi配置存储基准 - 满列表的写入（序列化+加密+NVS）和启动加载（解密）耗时（主机真实时间）
+ *
+ * 同一份源码分别链接明文和加密存储（CONFIG_XN_BLUFI_STORAGE_ENCRYPT）变体，
+ * 两者的差值即为GCM加解密的开销。用例只检查结果正确，不对耗时设门限。
+ */
+
+#include "xn_test.h"
+#include "xn_wifi_storage.h"
+#include "nvs_flash.h"
+#include <time.h>
+
+#define CONFIG_COUNT    10      // 填满存储上限
+#define ROUNDS          200
+
+static int64_t wall_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* 保存CONFIG_COUNT个网络，返回首次初始化（含存储密钥派生）耗时 */
+static int64_t fill_storage(void)
+{
+    XN_ASSERT_OK(nvs_flash_init());
+    int64_t start = wall_us();
+    XN_ASSERT_OK(xn_wifi_storage_init());
+    int64_t init_us = wall_us() - start;
+
+    for (int i = 0; i < CONFIG_COUNT; i++) {
+        char ssid[16];
+        snprintf(ssid, sizeof(ssid), "xn-bench-%d", i);
+        XN_ASSERT_OK(xn_wifi_storage_save(ssid, "correct-horse-battery"));
+    }
+    return init_us;
+}
+
+XN_TEST(bench_storage_write)
+{
+    int64_t init_us = fill_storage();
+
+    // 修改优先级不改变列表长度，每次都完整写一遍列表
+    xn_wifi_storage_stats_t before, after;
+    XN_ASSERT_OK(xn_wifi_storage_get_stats(&before));
+    int64_t start = wall_us();
+    for (int i = 0; i < ROUNDS; i++) {
+        XN_ASSERT_OK(xn_wifi_storage_set_priority((const uint8_t *)"xn-bench-0", 10, (uint8_t)(1 + i % 2)));
+    }
+    int64_t elapsed = wall_us() - start;
+    XN_ASSERT_OK(xn_wifi_storage_get_stats(&after));
+    XN_ASSERT_EQ(after.commits - before.commits, ROUNDS);
+#if CONFIG_XN_BLUFI_STORAGE_ENCRYPT
+    XN_ASSERT_EQ(after.encrypt_count - before.encrypt_count, ROUNDS);
+#endif
+
+    printf("  first init (key setup): %lld us\n", (long long)init_us);
+    printf("  write %d configs: avg %lld us over %d rounds\n", CONFIG_COUNT,
+           (long long)(elapsed / ROUNDS), ROUNDS);
+}
+
+XN_TEST(bench_storage_load)
+{
+    fill_storage();
+    XN_ASSERT_OK(xn_wifi_storage_set_priority((const uint8_t *)"xn-bench-3", 10, 200));
+
+    // 重新初始化会从NVS读回并解密整个列表
+    int64_t start = wall_us();
+    for (int i = 0; i < ROUNDS; i++) {
+        XN_ASSERT_OK(xn_wifi_storage_init());
+    }
+    int64_t elapsed = wall_us() - start;
+
+    xn_wifi_config_t configs[CONFIG_COUNT];
+    uint8_t count = 0;
+    XN_ASSERT_OK(xn_wifi_storage_load_all(configs, &count, CONFIG_COUNT));
+    XN_ASSERT_EQ(count, CONFIG_COUNT);
+    XN_ASSERT(strcmp((const char *)configs[0].ssid, "xn-bench-3") == 0);
+    XN_ASSERT_EQ(configs[0].priority, 200);
+    XN_ASSERT(strcmp(configs[0].password, "correct-horse-battery") == 0);
+#if CONFIG_XN_BLUFI_STORAGE_ENCRYPT
+    XN_ASSERT(!sim_nvs_live_contains("correct-horse-battery", 21));
+#endif
+
+    printf("  load %d configs: avg %lld us over %d rounds\n", CONFIG_COUNT,
+           (long long)(elapsed / ROUNDS), ROUNDS);
+}
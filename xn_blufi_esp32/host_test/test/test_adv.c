@@ -0,0 +1,239 @@
+/*
+ * @Description: 蓝牙广播调度（CONFIG_XN_BLUFI_ADV_SCHEDULE） - 快速→慢速→停止的超时切换，
+ * 以及按键唤醒、蓝牙断开、WiFi断开后重新快速广播；扫描响应中的厂商数据随设备状态更新
+ */
+
+#include "xn_steps.h"
+#include "xn_blufi_proto.h"
+
+#define SSID        "xn-home"
+#define PASSWORD    "correct-horse"
+
+/* 各阶段参数，与sdkconfig中的默认值一致 */
+#define FAST_MS     (CONFIG_XN_BLUFI_ADV_FAST_DURATION * 1000)
+#define SLOW_MS     (CONFIG_XN_BLUFI_ADV_SLOW_DURATION * 1000)
+#define FAST_ITVL   BLE_GAP_ADV_ITVL_MS(CONFIG_XN_BLUFI_ADV_FAST_INTERVAL)
+#define SLOW_ITVL   BLE_GAP_ADV_ITVL_MS(CONFIG_XN_BLUFI_ADV_SLOW_INTERVAL)
+
+static xn_blufi_t *s_blufi;
+
+static void adv_boot(void)
+{
+    s_blufi = xn_steps_boot_component();
+}
+
+static sim_ble_state_t ble_state(void)
+{
+    sim_ble_state_t state;
+    sim_ble_get_state(&state);
+    return state;
+}
+
+static xn_blufi_adv_stats_t adv_stats(void)
+{
+    xn_blufi_adv_stats_t stats;
+    XN_ASSERT_OK(xn_blufi_get_adv_stats(s_blufi, &stats));
+    return stats;
+}
+
+/* 检查广播阶段与仿真层看到的广播状态一致 */
+#define XN_ASSERT_PHASE(expected, itvl) do {                            \
+        sim_ble_state_t _state = ble_state();                           \
+        XN_ASSERT_EQ(adv_stats().phase, (expected));                    \
+        XN_ASSERT_EQ(_state.adv_active, (itvl) != 0);                   \
+        if ((itvl) != 0) {                                              \
+            XN_ASSERT_EQ(_state.itvl_min, (itvl));                      \
+        }                                                               \
+    } while (0)
+
+/* 运行到广播超时停止（从快速阶段开始计） */
+static void run_to_off(void)
+{
+    sim_run_ms(FAST_MS + SLOW_MS + 100);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_OFF, 0);
+}
+
+XN_TEST(fast_then_slow_then_stop)
+{
+    adv_boot();
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_FAST, FAST_ITVL);
+
+    sim_run_ms(FAST_MS - 100);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_FAST, FAST_ITVL);
+
+    sim_run_ms(200);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_SLOW, SLOW_ITVL);
+
+    sim_run_ms(SLOW_MS - 200);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_SLOW, SLOW_ITVL);
+
+    sim_run_ms(200);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_OFF, 0);
+
+    // 停止后不再自行恢复
+    sim_run_ms(FAST_MS + SLOW_MS);
+    sim_ble_state_t state = ble_state();
+    XN_ASSERT(!state.adv_active);
+    XN_ASSERT_EQ(state.adv_starts, 2);
+    XN_ASSERT_EQ(state.adv_stops, 2);
+
+    // 各阶段累计时间与超时一致
+    xn_blufi_adv_stats_t stats = adv_stats();
+    XN_ASSERT_RANGE(stats.fast_ms, FAST_MS, FAST_MS + 10);
+    XN_ASSERT_RANGE(stats.slow_ms, SLOW_MS, SLOW_MS + 10);
+    XN_ASSERT_EQ(stats.interval_ms, 0);
+    XN_ASSERT_EQ(stats.phase_duty_permille, 0);
+    XN_ASSERT_EQ(stats.fast_starts, 1);
+    XN_ASSERT(stats.adv_events > 0);
+}
+
+XN_TEST(wake_restarts_fast_phase)
+{
+    adv_boot();
+    run_to_off();
+
+    XN_ASSERT_OK(xn_blufi_adv_wake(s_blufi));
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_FAST, FAST_ITVL);
+    XN_ASSERT_EQ(adv_stats().fast_starts, 2);
+
+    // 唤醒后重新计时：完整的快速阶段后才转慢速
+    sim_run_ms(FAST_MS - 100);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_FAST, FAST_ITVL);
+    sim_run_ms(200);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_SLOW, SLOW_ITVL);
+
+    // 慢速阶段中唤醒同样回到快速阶段
+    XN_ASSERT_OK(xn_blufi_adv_wake(s_blufi));
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_FAST, FAST_ITVL);
+    sim_run_ms(FAST_MS - 100);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_FAST, FAST_ITVL);
+    sim_run_ms(200);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_SLOW, SLOW_ITVL);
+
+    // 快速阶段中途唤醒：旧的超时作废，从唤醒时刻重新计完整的快速阶段
+    XN_ASSERT_OK(xn_blufi_adv_wake(s_blufi));
+    sim_run_ms(FAST_MS / 2);
+    XN_ASSERT_OK(xn_blufi_adv_wake(s_blufi));
+    XN_ASSERT_EQ(adv_stats().fast_starts, 5);
+    sim_run_ms(FAST_MS - 100);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_FAST, FAST_ITVL);
+    sim_run_ms(200);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_SLOW, SLOW_ITVL);
+
+    XN_ASSERT_EQ(xn_blufi_adv_wake(NULL), ESP_ERR_INVALID_ARG);
+}
+
+XN_TEST(ble_connection_stops_and_disconnect_restarts)
+{
+    adv_boot();
+    sim_run_ms(FAST_MS + 100);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_SLOW, SLOW_ITVL);
+
+    // 连接期间不广播，阶段超时也不会重新开始广播，按键唤醒不打断连接
+    sim_phone_connect();
+    XN_ASSERT(ble_state().connected);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_OFF, 0);
+    XN_ASSERT_OK(xn_blufi_adv_wake(s_blufi));
+    sim_run_ms(FAST_MS + SLOW_MS);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_OFF, 0);
+
+    // 断开后从快速阶段重新开始
+    sim_phone_disconnect();
+    sim_run_ms(10);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_FAST, FAST_ITVL);
+    XN_ASSERT_EQ(adv_stats().fast_starts, 2);
+    sim_run_ms(FAST_MS + 100);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_SLOW, SLOW_ITVL);
+}
+
+XN_TEST(wifi_loss_restarts_fast_phase)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    adv_boot();
+    xn_steps_phone_open();
+    xn_steps_provision(SSID, PASSWORD);
+    XN_ASSERT(xn_steps_wait_ip(20000));
+    sim_phone_disconnect();
+    run_to_off();
+
+    // 已获取IP的网络断开：重新快速广播，便于重新配网
+    sim_wifi_drop_link(WIFI_REASON_BEACON_TIMEOUT);
+    sim_run_ms(100);
+    XN_ASSERT_PHASE(XN_BLUFI_ADV_FAST, FAST_ITVL);
+    XN_ASSERT_EQ(adv_stats().fast_starts, 3);
+}
+
+XN_TEST(wifi_failure_without_ip_keeps_phase)
+{
+    int ap = xn_steps_add_ap(SSID, PASSWORD, -50);
+    sim_wifi_set_online(ap, false);
+    adv_boot();
+    xn_steps_phone_open();
+    xn_steps_provision(SSID, PASSWORD);
+    sim_phone_disconnect();
+    run_to_off();
+
+    // 从未获取过IP，连接失败不算"WiFi断开"，不重新广播
+    sim_ble_state_t state = ble_state();
+    XN_ASSERT(!sim_wifi_has_ip());
+    XN_ASSERT_EQ(adv_stats().fast_starts, 2);
+    XN_ASSERT_EQ(state.adv_starts, 3);
+}
+
+/* 仿真设备的固件版本"1.2.3"，蓝牙MAC为基地址+2 */
+static const uint8_t s_mfg_template[XN_BLUFI_PROTO_ADV_DATA_LEN] = {
+    0xE5, 0x02, XN_BLUFI_ADV_FRAME_VERSION, 0, XN_WIFI_DISCONNECTED, 1, 2, 3, 0x12, 0x34, 0x58,
+};
+
+/* 检查扫描响应中的厂商数据：标志和WiFi状态，其余字段固定 */
+static void assert_mfg(uint8_t flags, uint8_t wifi_status)
+{
+    uint8_t expected[XN_BLUFI_PROTO_ADV_DATA_LEN];
+    memcpy(expected, s_mfg_template, sizeof(expected));
+    expected[3] = flags;
+    expected[4] = wifi_status;
+
+    sim_ble_state_t state = ble_state();
+    XN_ASSERT_EQ(state.mfg_len, sizeof(expected));
+    XN_ASSERT(memcmp(state.mfg_data, expected, sizeof(expected)) == 0);
+}
+
+XN_TEST(mfg_data_tracks_saved_configs)
+{
+    adv_boot();
+    assert_mfg(0, XN_WIFI_DISCONNECTED);
+
+    // 广播进行中保存/删除配置：扫描响应原地更新，不重新开始广播
+    uint32_t starts = ble_state().adv_starts;
+    XN_ASSERT_OK(xn_blufi_wifi_save(s_blufi, SSID, PASSWORD));
+    assert_mfg(XN_BLUFI_ADV_FLAG_PROVISIONED, XN_WIFI_DISCONNECTED);
+    XN_ASSERT_OK(xn_blufi_wifi_delete(s_blufi));
+    assert_mfg(0, XN_WIFI_DISCONNECTED);
+
+    sim_ble_state_t state = ble_state();
+    XN_ASSERT(state.adv_active);
+    XN_ASSERT_EQ(state.adv_starts, starts);
+}
+
+XN_TEST(mfg_data_tracks_wifi_status)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    adv_boot();
+    XN_ASSERT_OK(xn_blufi_wifi_save(s_blufi, SSID, PASSWORD));
+
+    // 连接期间不广播，状态变化先保存，重新广播时写入扫描响应
+    xn_steps_phone_open();
+    xn_steps_provision(SSID, PASSWORD);
+    XN_ASSERT(xn_steps_wait_ip(20000));
+    sim_run_ms(100);
+    sim_phone_disconnect();
+    sim_run_ms(10);
+    XN_ASSERT(ble_state().adv_active);
+    assert_mfg(XN_BLUFI_ADV_FLAG_PROVISIONED, XN_WIFI_GOT_IP);
+
+    // WiFi断开后重新广播，厂商数据同时更新
+    sim_wifi_drop_link(WIFI_REASON_BEACON_TIMEOUT);
+    sim_run_ms(100);
+    XN_ASSERT(ble_state().adv_active);
+    assert_mfg(XN_BLUFI_ADV_FLAG_PROVISIONED, XN_WIFI_DISCONNECTED);
+}
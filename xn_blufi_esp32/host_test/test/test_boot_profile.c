@@ -0,0 +1,155 @@
+/*
+ * @Description: 启动耗时分析（CONFIG_XN_BLUFI_BOOT_PROFILE） - 启动各阶段的记录、
+ * 首次连接后结束记录，按耗时排序的打印结果，容量溢出计数和读取接口
+ */
+
+#include "xn_steps.h"
+#include "app_blufi.h"
+#include "xn_boot_profile.h"
+#include "xn_wifi_storage.h"
+
+#define SSID        "xn-home"
+#define PASSWORD    "correct-horse"
+
+/* 全信道扫描+认证关联+DHCP */
+#define CONNECT_MS  (1500 + 150 + 300)
+
+static xn_boot_profile_t get_profile(void)
+{
+    xn_boot_profile_t profile;
+    XN_ASSERT_OK(xn_boot_profile_get(&profile));
+    return profile;
+}
+
+static const xn_boot_stage_t *find_stage(const xn_boot_profile_t *profile, const char *name)
+{
+    for (int i = 0; i < profile->count; i++) {
+        if (strcmp(profile->stages[i].name, name) == 0) {
+            return &profile->stages[i];
+        }
+    }
+    return NULL;
+}
+
+/* 记录一个持续ms毫秒的阶段 */
+static void record_ms(const char *name, uint32_t ms)
+{
+    int64_t start = sim_now_us();
+    sim_run_ms(ms);
+    xn_boot_profile_record(name, start);
+}
+
+XN_TEST(boot_records_stages_until_first_connect)
+{
+    // 已保存网络的启动：从上电到首次获取IP
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    XN_ASSERT_OK(nvs_flash_init());
+    XN_ASSERT_OK(xn_wifi_storage_init());
+    XN_ASSERT_OK(xn_wifi_storage_save(SSID, PASSWORD));
+    sim_run_ms(10);
+    xn_steps_boot();
+    XN_ASSERT(!get_profile().finished);
+    XN_ASSERT(xn_steps_wait_ip(20000));
+    sim_run_ms(100);
+
+    xn_boot_profile_t profile = get_profile();
+    XN_ASSERT(profile.finished);
+    XN_ASSERT_EQ(profile.dropped, 0);
+    static const char *const expected[] = {
+        "app_create", "nvs_init", "storage_load", "bt_controller", "nimble_init",
+        "gatt_blufi_register", "nimble_enable", "ble_init_total", "netif_event_loop",
+        "wifi_init", "wifi_start", "load_config", "first_connect",
+    };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        if (find_stage(&profile, expected[i]) == NULL) {
+            XN_FAIL("stage %s not recorded", expected[i]);
+        }
+    }
+
+    // 首次连接是整个启动的最后一段，各阶段都在结束时间之前
+    const xn_boot_stage_t *connect = find_stage(&profile, "first_connect");
+    XN_ASSERT_RANGE(connect->duration_us / 1000, CONNECT_MS, CONNECT_MS + 50);
+    XN_ASSERT_EQ(profile.end_us, connect->start_us + connect->duration_us);
+    for (int i = 0; i < profile.count; i++) {
+        XN_ASSERT(profile.stages[i].start_us + profile.stages[i].duration_us <= profile.end_us);
+    }
+
+    // 结束后的记录被忽略
+    record_ms("late", 5);
+    XN_ASSERT_EQ(get_profile().count, profile.count);
+}
+
+XN_TEST(unprovisioned_boot_finishes_at_advertising)
+{
+    // 没有保存的网络：启动过程到开始等待配网为止，没有首次连接阶段
+    xn_steps_boot();
+    xn_boot_profile_t profile = get_profile();
+    XN_ASSERT(profile.finished);
+    XN_ASSERT(find_stage(&profile, "ble_init_total") != NULL);
+    XN_ASSERT(find_stage(&profile, "first_connect") == NULL);
+}
+
+XN_TEST(finish_prints_stages_by_duration)
+{
+    sim_run_ms(10);
+    record_ms("five", 5);
+    record_ms("twenty", 20);
+    record_ms("ten", 10);
+    xn_boot_profile_t profile = get_profile();
+    XN_ASSERT_EQ(profile.count, 3);
+    XN_ASSERT(strcmp(profile.stages[0].name, "five") == 0);
+    XN_ASSERT_EQ(profile.stages[0].start_us, 10000);
+    XN_ASSERT_EQ(profile.stages[0].duration_us, 5000);
+    XN_ASSERT_EQ(profile.end_us, 45000);
+
+    // 打印按耗时从大到小，百分比相对上电到结束的总时间；读取接口保持记录顺序
+    static char log[1024];
+    sim_log_capture("XN_BOOT", log, sizeof(log));
+    xn_boot_profile_finish();
+    sim_log_capture(NULL, NULL, 0);
+    const char *twenty = strstr(log, "twenty");
+    const char *ten = strstr(log, "ten ");
+    const char *five = strstr(log, "five");
+    XN_ASSERT(strstr(log, "共45 ms") != NULL);
+    XN_ASSERT(twenty != NULL && ten != NULL && five != NULL);
+    XN_ASSERT(twenty < ten && ten < five);
+    XN_ASSERT(strstr(twenty, "20000 us   44%  @15 ms") != NULL);
+    XN_ASSERT(strstr(five, "5000 us   11%  @10 ms") != NULL);
+    XN_ASSERT(strcmp(get_profile().stages[0].name, "five") == 0);
+
+    // 只打印一次
+    sim_log_capture("XN_BOOT", log, sizeof(log));
+    xn_boot_profile_finish();
+    sim_log_capture(NULL, NULL, 0);
+    XN_ASSERT_EQ(strlen(log), 0);
+}
+
+XN_TEST(overflow_counts_dropped_stages)
+{
+    static char log[4096];
+    for (int i = 0; i < XN_BOOT_PROFILE_MAX_STAGES + 6; i++) {
+        record_ms("stage", 1);
+    }
+    xn_boot_profile_t profile = get_profile();
+    XN_ASSERT_EQ(profile.count, XN_BOOT_PROFILE_MAX_STAGES);
+    XN_ASSERT_EQ(profile.dropped, 6);
+
+    // 丢弃的阶段仍计入结束时间，打印时提示
+    XN_ASSERT_EQ(profile.end_us, (XN_BOOT_PROFILE_MAX_STAGES + 6) * 1000);
+    sim_log_capture("XN_BOOT", log, sizeof(log));
+    xn_boot_profile_finish();
+    sim_log_capture(NULL, NULL, 0);
+    XN_ASSERT(strstr(log, "另有6个阶段超出记录容量") != NULL);
+}
+
+XN_TEST(get_rejects_null)
+{
+    XN_ASSERT_EQ(xn_boot_profile_get(NULL), ESP_ERR_INVALID_ARG);
+    xn_boot_profile_t profile;
+    XN_ASSERT_EQ(xn_blufi_get_boot_profile(NULL, &profile), ESP_ERR_INVALID_ARG);
+
+    // 未开始记录时为空
+    profile = get_profile();
+    XN_ASSERT_EQ(profile.count, 0);
+    XN_ASSERT(!profile.finished);
+}
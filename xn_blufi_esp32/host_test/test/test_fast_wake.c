@@ -0,0 +1,208 @@
+/*
+ * @Description: 深度睡眠快速唤醒（CONFIG_XN_BLUFI_FAST_WAKE，同时开启租约静态地址） - 直连上次的AP；
+ * 连接失败时等管理器重试用尽才由应用层任务重启；唤醒到获取IP的耗时与上电冷启动对比
+ */
+
+#include "xn_steps.h"
+#include "app_blufi.h"
+#include "xn_fast_wake.h"
+#include "xn_wifi_storage.h"
+#include <sys/mman.h>
+
+#define SSID        "xn-home"
+#define PASSWORD    "correct-horse"
+
+/* 每次失败的尝试：认证阶段结束时上报失败 */
+#define ATTEMPT_MS  150
+
+/* 关联后到获取IP，快速唤醒用缓存的地址时省掉 */
+#define DHCP_MS     300
+
+
+/* 模拟上次睡眠前保存的状态（xn_steps_add_ap添加的第一个AP），并设置唤醒原因 */
+static void wake_from_sleep(void)
+{
+    xn_fast_wake_state_t state = {0};
+    XN_ASSERT_OK(xn_wifi_cred_from_str(&state.cred, SSID, PASSWORD));
+    XN_ASSERT_OK(xn_wifi_cred_derive_pmk(&state.cred));
+    const uint8_t bssid[6] = { 0x02, 0x11, 0x22, 0x33, 0x44, 1 };
+    memcpy(state.lease.bssid, bssid, sizeof(bssid));
+    state.lease.channel = 6;
+    XN_ASSERT_OK(xn_fast_wake_save(&state));
+    sim_set_wakeup_cause(ESP_SLEEP_WAKEUP_TIMER);
+    XN_ASSERT_OK(app_blufi_init());
+}
+
+static bool fast_wake_cleared(void)
+{
+    xn_fast_wake_state_t state;
+    return xn_fast_wake_load(&state) == ESP_ERR_NOT_FOUND;
+}
+
+XN_TEST(fast_wake_connects_directly)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    wake_from_sleep();
+    XN_ASSERT(xn_steps_wait_ip(2000));
+
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.attempts, 1);
+    XN_ASSERT_EQ(stats.direct_connects, 1);
+    XN_ASSERT_EQ(stats.pmk_connects, 1);
+    XN_ASSERT(!sim_restarted(NULL, NULL));
+}
+
+XN_TEST(fast_wake_retries_before_giving_up)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    sim_wifi_fail_next(3, WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT);
+    wake_from_sleep();
+    XN_ASSERT(xn_steps_wait_ip(20000));
+    sim_run_ms(1000);
+
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.attempts, 4);
+    XN_ASSERT(!sim_restarted(NULL, NULL));
+    XN_ASSERT(!fast_wake_cleared());
+}
+
+static bool associated_without_ip(void *arg)
+{
+    return sim_wifi_connected_ap() >= 0 && !sim_wifi_has_ip();
+}
+
+XN_TEST(fast_wake_drop_before_ip_is_retried)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    wake_from_sleep();
+
+    // 关联后、获取IP前被AP踢出：管理器按失败重试，应用层不能在第一次断开时就重启
+    XN_ASSERT(sim_run_until(associated_without_ip, NULL, 2000));
+    sim_wifi_drop_link(WIFI_REASON_AUTH_EXPIRE);
+    XN_ASSERT(xn_steps_wait_ip(20000));
+    sim_run_ms(1000);
+
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.attempts, 2);
+    XN_ASSERT_EQ(stats.pmk_connects, 2);    // 已经关联成功过，PMK没有作废
+    XN_ASSERT(!sim_restarted(NULL, NULL));
+}
+
+XN_TEST(fast_wake_restarts_after_retries_exhausted)
+{
+    int ap = xn_steps_add_ap(SSID, PASSWORD, -50);
+    sim_wifi_set_online(ap, false);
+    int64_t start = sim_now_us();
+    wake_from_sleep();
+    sim_run_ms(30000);
+
+    // 首次直连加5次重试都失败后，才在应用层的事件处理任务中重启
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.attempts, 6);
+
+    const char *task = NULL;
+    int64_t at_us = 0;
+    XN_ASSERT(sim_restarted(&task, &at_us));
+    XN_ASSERT(strcmp(task, "app_blufi_evt") == 0);
+    XN_ASSERT((at_us - start) / 1000 >= 6 * ATTEMPT_MS);
+    XN_ASSERT(fast_wake_cleared());
+}
+
+/* 唤醒耗时对比：第一个进程连接后导出NVS和睡眠前保存的RTC状态，之后的进程分别以
+ * 上电冷启动和定时器唤醒启动 */
+typedef struct {
+    uint8_t flash[256 * 1024];
+    size_t flash_len;
+    xn_fast_wake_state_t rtc;
+    uint32_t cold_ms;
+    uint32_t fast_ms;
+} wake_compare_t;
+
+static wake_compare_t *s_compare;
+
+/* app_blufi_init()并运行到获取IP，返回耗时（毫秒） */
+static uint32_t init_to_ip_ms(void)
+{
+    sim_run_ms(10);
+    int64_t start = sim_now_us();
+    XN_ASSERT_OK(app_blufi_init());
+    XN_ASSERT(xn_steps_wait_ip(20000));
+    return (uint32_t)((sim_now_us() - start) / 1000);
+}
+
+static void compare_phase_provision(void)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    XN_ASSERT_OK(nvs_flash_init());
+    XN_ASSERT_OK(xn_wifi_storage_init());
+    XN_ASSERT_OK(xn_wifi_storage_save(SSID, PASSWORD));
+    init_to_ip_ms();
+    sim_run_ms(500);
+    s_compare->flash_len = sim_nvs_export(s_compare->flash, sizeof(s_compare->flash));
+    XN_ASSERT(s_compare->flash_len > 0);
+    // 睡眠前保存的RTC状态交给唤醒进程（只有唤醒后才能读出）
+    XN_ASSERT_OK(app_blufi_prepare_deep_sleep());
+    sim_set_wakeup_cause(ESP_SLEEP_WAKEUP_TIMER);
+    XN_ASSERT_OK(xn_fast_wake_load(&s_compare->rtc));
+    XN_ASSERT(s_compare->rtc.fresh_s > 0);
+}
+
+static void compare_phase_cold(void)
+{
+    // 上电启动：系统时间未校准，缓存的租约无法判断是否过期，直连后仍走DHCP
+    sim_nvs_import(s_compare->flash, s_compare->flash_len);
+    sim_set_time_unset(true);
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    s_compare->cold_ms = init_to_ip_ms();
+
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.direct_connects, 1);
+    XN_ASSERT_EQ(stats.dhcp_leases, 1);
+}
+
+static void compare_phase_fast(void)
+{
+    // 定时器唤醒：同样的NVS内容，RTC内存保留了睡眠前的状态
+    sim_nvs_import(s_compare->flash, s_compare->flash_len);
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    XN_ASSERT_OK(xn_fast_wake_save(&s_compare->rtc));
+    sim_set_wakeup_cause(ESP_SLEEP_WAKEUP_TIMER);
+    s_compare->fast_ms = init_to_ip_ms();
+
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.attempts, 1);
+    XN_ASSERT_EQ(stats.direct_connects, 1);
+    XN_ASSERT_EQ(stats.pmk_connects, 1);
+
+    // 租约未过T1，直接用上次的地址；网关校验通过后地址保持不变
+    esp_netif_ip_info_t ip_info;
+    esp_netif_get_ip_info(NULL, &ip_info);
+    XN_ASSERT_EQ(ip_info.ip.addr, s_compare->rtc.lease.ip);
+    sim_run_ms(5000);
+    XN_ASSERT(sim_wifi_has_ip());
+    esp_netif_get_ip_info(NULL, &ip_info);
+    XN_ASSERT_EQ(ip_info.ip.addr, s_compare->rtc.lease.ip);
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.dhcp_leases, 0);
+}
+
+XN_TEST_RAW(fast_wake_beats_cold_boot)
+{
+    s_compare = mmap(NULL, sizeof(*s_compare), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    XN_ASSERT(s_compare != MAP_FAILED);
+    XN_ASSERT(xn_test_run_child(compare_phase_provision));
+    XN_ASSERT(xn_test_run_child(compare_phase_cold));
+    XN_ASSERT(xn_test_run_child(compare_phase_fast));
+
+    printf("  wake-to-IP: cold boot %u ms, fast wake %u ms\n",
+           (unsigned)s_compare->cold_ms, (unsigned)s_compare->fast_ms);
+    XN_ASSERT(s_compare->fast_ms > 0);
+    XN_ASSERT(s_compare->fast_ms < s_compare->cold_ms);
+    XN_ASSERT(s_compare->fast_ms + DHCP_MS <= s_compare->cold_ms);
+}
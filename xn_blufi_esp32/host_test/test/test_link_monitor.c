@@ -0,0 +1,146 @@
+/*
+ * @Description: 链路质量监测（CONFIG_XN_BLUFI_LINK_MONITOR） - 信号强度平滑、迟滞判断变差/恢复、
+ * beacon丢失立即采样，以及断开后复位
+ */
+
+#include "xn_steps.h"
+
+#define SSID        "xn-home"
+#define PASSWORD    "correct-horse"
+
+/* 采样间隔，与sdkconfig中的默认值一致 */
+#define SAMPLE_MS   CONFIG_XN_BLUFI_LINK_SAMPLE_INTERVAL
+
+static xn_wifi_manager_t *s_manager;
+static int s_ap;
+
+/* 记录链路事件和发生时间 */
+typedef struct {
+    uint32_t degraded;
+    uint32_t recovered;
+    int64_t last_at_us;
+} link_events_t;
+
+static link_events_t s_events;
+
+static void link_event_cb(xn_wifi_event_t event, void *user_ctx)
+{
+    link_events_t *events = (link_events_t *)user_ctx;
+    if (event == XN_WIFI_EVENT_LINK_DEGRADED) {
+        events->degraded++;
+    } else if (event == XN_WIFI_EVENT_LINK_RECOVERED) {
+        events->recovered++;
+    }
+    events->last_at_us = sim_now_us();
+}
+
+static void link_connect(int8_t rssi)
+{
+    s_ap = xn_steps_add_ap(SSID, PASSWORD, rssi);
+    s_manager = xn_steps_manager_start();
+    int sub_id;
+    XN_ASSERT_OK(xn_wifi_manager_subscribe(s_manager, link_event_cb, &s_events, XN_WIFI_EVENT_MASK_LINK, &sub_id));
+    xn_steps_manager_connect(s_manager, SSID, PASSWORD);
+}
+
+static xn_wifi_link_info_t link_info(void)
+{
+    xn_wifi_link_info_t info;
+    XN_ASSERT_OK(xn_wifi_manager_get_link_info(s_manager, &info));
+    return info;
+}
+
+static bool link_degraded(void *arg)
+{
+    return s_events.degraded > 0;
+}
+
+XN_TEST(single_dip_is_smoothed)
+{
+    link_connect(-50);
+    sim_run_ms(3 * SAMPLE_MS);
+
+    // 只持续一个采样周期的深度衰落，平滑后仍在门限以上
+    sim_wifi_set_rssi(s_ap, -90);
+    sim_run_ms(SAMPLE_MS);
+    sim_wifi_set_rssi(s_ap, -50);
+    sim_run_ms(5 * SAMPLE_MS);
+
+    XN_ASSERT_EQ(s_events.degraded, 0);
+    xn_wifi_link_info_t info = link_info();
+    XN_ASSERT(!info.degraded);
+    XN_ASSERT(info.samples >= 8);
+    XN_ASSERT_EQ(info.rssi, -50);
+}
+
+XN_TEST(sustained_drop_degrades_then_hysteresis_holds)
+{
+    link_connect(-50);
+    sim_run_ms(2 * SAMPLE_MS);
+
+    // 持续低于门限：平滑后需要几个采样周期才跟上
+    sim_wifi_set_rssi(s_ap, -85);
+    int64_t start = sim_now_us();
+    XN_ASSERT(sim_run_until(link_degraded, NULL, 20 * SAMPLE_MS));
+    XN_ASSERT((s_events.last_at_us - start) / 1000 >= 2 * SAMPLE_MS);
+    xn_wifi_link_info_t info = link_info();
+    XN_ASSERT(info.degraded);
+    XN_ASSERT(info.rssi_avg < CONFIG_XN_BLUFI_LINK_DEGRADED_RSSI);
+
+    xn_wifi_snapshot_t snapshot;
+    XN_ASSERT_OK(xn_wifi_manager_get_snapshot(s_manager, &snapshot));
+    XN_ASSERT(snapshot.link_degraded);
+
+    // 回到门限以上但不到门限+迟滞：保持变差，不来回抖动
+    sim_wifi_set_rssi(s_ap, CONFIG_XN_BLUFI_LINK_DEGRADED_RSSI + CONFIG_XN_BLUFI_LINK_HYSTERESIS - 2);
+    sim_run_ms(20 * SAMPLE_MS);
+    XN_ASSERT_EQ(s_events.degraded, 1);
+    XN_ASSERT_EQ(s_events.recovered, 0);
+    XN_ASSERT(link_info().degraded);
+
+    // 明显回升后恢复，只上报一次
+    sim_wifi_set_rssi(s_ap, -55);
+    sim_run_ms(20 * SAMPLE_MS);
+    XN_ASSERT_EQ(s_events.recovered, 1);
+    info = link_info();
+    XN_ASSERT(!info.degraded);
+    XN_ASSERT_EQ(info.degraded_count, 1);
+    XN_ASSERT_OK(xn_wifi_manager_get_snapshot(s_manager, &snapshot));
+    XN_ASSERT(!snapshot.link_degraded);
+}
+
+XN_TEST(beacon_loss_degrades_immediately)
+{
+    link_connect(-50);
+    sim_run_ms(SAMPLE_MS / 2);
+
+    // 不等下一个采样周期
+    int64_t start = sim_now_us();
+    sim_wifi_beacon_timeout();
+    sim_run_ms(10);
+    XN_ASSERT_EQ(s_events.degraded, 1);
+    XN_ASSERT_EQ(link_info().beacon_timeouts, 1);
+
+    // 信号良好时连续3次采样无beacon丢失才恢复
+    sim_run_ms(10 * SAMPLE_MS);
+    XN_ASSERT_EQ(s_events.recovered, 1);
+    XN_ASSERT_RANGE((s_events.last_at_us - start) / 1000, 2 * SAMPLE_MS, 3 * SAMPLE_MS + 10);
+}
+
+XN_TEST(disconnect_resets_link_state)
+{
+    link_connect(-50);
+    sim_wifi_beacon_timeout();
+    sim_run_ms(10);
+    XN_ASSERT(link_info().degraded);
+
+    // 断开后不再处于变差状态，也不再采样
+    sim_wifi_drop_link(WIFI_REASON_AUTH_EXPIRE);
+    sim_run_ms(10);
+    xn_wifi_link_info_t info = link_info();
+    XN_ASSERT(!info.degraded);
+    uint32_t samples = info.samples;
+    sim_run_ms(5 * SAMPLE_MS);
+    XN_ASSERT_EQ(link_info().samples, samples);
+    XN_ASSERT_EQ(s_events.recovered, 0);
+}
@@ -0,0 +1,196 @@
+/*
+ * @Description: 自定义数据协议编解码 - 命令解析、SSID/密码复制的长度校验，
+ * 配置列表、扩展状态回复和广播厂商数据的格式，以及固件版本解析
+ */
+
+#include "xn_test.h"
+#include "xn_blufi_proto.h"
+#include "xn_wifi_manager.h"
+
+XN_TEST_RAW(parse_commands)
+{
+    xn_blufi_cmd_t cmd;
+    const uint8_t get_configs[] = { XN_BLUFI_CMD_GET_CONFIGS };
+    XN_ASSERT_OK(xn_blufi_proto_parse(get_configs, sizeof(get_configs), &cmd));
+    XN_ASSERT_EQ(cmd.type, XN_BLUFI_CMD_GET_CONFIGS);
+
+    const uint8_t delete_config[] = { XN_BLUFI_CMD_DELETE_CONFIG, 3 };
+    XN_ASSERT_OK(xn_blufi_proto_parse(delete_config, sizeof(delete_config), &cmd));
+    XN_ASSERT_EQ(cmd.index, 3);
+
+    // 删除命令缺少索引、空帧、未知命令
+    XN_ASSERT_EQ(xn_blufi_proto_parse(delete_config, 1, &cmd), ESP_ERR_INVALID_SIZE);
+    XN_ASSERT_EQ(xn_blufi_proto_parse(NULL, 0, &cmd), ESP_ERR_INVALID_SIZE);
+    XN_ASSERT_EQ(xn_blufi_proto_parse(get_configs, 0, &cmd), ESP_ERR_INVALID_SIZE);
+    const uint8_t unknown[] = { 0x7f, 0 };
+    XN_ASSERT_EQ(xn_blufi_proto_parse(unknown, sizeof(unknown), &cmd), ESP_ERR_NOT_SUPPORTED);
+    XN_ASSERT_EQ(xn_blufi_proto_parse(get_configs, 1, NULL), ESP_ERR_INVALID_ARG);
+}
+
+XN_TEST_RAW(copy_field_bounds)
+{
+    uint8_t ssid[XN_WIFI_SSID_MAX_LEN + 1];
+    uint8_t src[XN_WIFI_SSID_MAX_LEN + 1];
+    memset(src, 'x', sizeof(src));
+
+    // 最长32字节的SSID放得下，并补'\0'
+    memset(ssid, 0xAA, sizeof(ssid));
+    XN_ASSERT_OK(xn_blufi_proto_copy_field(ssid, sizeof(ssid), src, XN_WIFI_SSID_MAX_LEN));
+    XN_ASSERT(memcmp(ssid, src, XN_WIFI_SSID_MAX_LEN) == 0);
+    XN_ASSERT_EQ(ssid[XN_WIFI_SSID_MAX_LEN], 0);
+
+    // 超长拒绝，不截断，目标缓冲区不被修改
+    memset(ssid, 0xAA, sizeof(ssid));
+    XN_ASSERT_EQ(xn_blufi_proto_copy_field(ssid, sizeof(ssid), src, XN_WIFI_SSID_MAX_LEN + 1), ESP_ERR_INVALID_SIZE);
+    XN_ASSERT_EQ(ssid[0], 0xAA);
+
+    // 负长度、有长度无数据
+    XN_ASSERT_EQ(xn_blufi_proto_copy_field(ssid, sizeof(ssid), src, -1), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_EQ(xn_blufi_proto_copy_field(ssid, sizeof(ssid), NULL, 4), ESP_ERR_INVALID_ARG);
+
+    // 空字段合法，结果为全0
+    XN_ASSERT_OK(xn_blufi_proto_copy_field(ssid, sizeof(ssid), NULL, 0));
+    XN_ASSERT_EQ(ssid[0], 0);
+
+    // 口令最长64字节（十六进制PSK）
+    uint8_t password[XN_WIFI_PASSWORD_MAX_LEN + 1];
+    uint8_t psk[XN_WIFI_PASSWORD_MAX_LEN + 1];
+    memset(psk, 'f', sizeof(psk));
+    XN_ASSERT_OK(xn_blufi_proto_copy_field(password, sizeof(password), psk, XN_WIFI_PASSWORD_MAX_LEN));
+    XN_ASSERT_EQ(password[XN_WIFI_PASSWORD_MAX_LEN], 0);
+    XN_ASSERT_EQ(xn_blufi_proto_copy_field(password, sizeof(password), psk, sizeof(psk)), ESP_ERR_INVALID_SIZE);
+}
+
+XN_TEST_RAW(config_list_layout)
+{
+    xn_wifi_config_t configs[2];
+    memset(configs, 0, sizeof(configs));
+    // SSID可含'\0'，按记录的长度发送
+    memcpy(configs[0].ssid, "ab\0cd", 5);
+    configs[0].ssid_len = 5;
+    memcpy(configs[0].password, "pw", 2);
+    configs[0].password_len = 2;
+    memcpy(configs[1].ssid, "xn", 2);
+    configs[1].ssid_len = 2;
+
+    uint8_t out[XN_BLUFI_PROTO_MAX_RESPONSE];
+    size_t len = xn_blufi_proto_build_config_list(configs, 2, out, sizeof(out));
+    const uint8_t expected[] = {
+        XN_BLUFI_CMD_GET_CONFIGS, XN_BLUFI_STATUS_OK, 2,
+        5, 'a', 'b', 0, 'c', 'd', 2, 'p', 'w',
+        2, 'x', 'n', 0,
+    };
+    XN_ASSERT_EQ(len, sizeof(expected));
+    XN_ASSERT(memcmp(out, expected, sizeof(expected)) == 0);
+
+    // 恰好放得下与差一个字节
+    XN_ASSERT_EQ(xn_blufi_proto_build_config_list(configs, 2, out, sizeof(expected)), sizeof(expected));
+    XN_ASSERT_EQ(xn_blufi_proto_build_config_list(configs, 2, out, sizeof(expected) - 1), 0);
+
+    // 没有配置时回复"未找到"
+    len = xn_blufi_proto_build_config_list(NULL, 0, out, sizeof(out));
+    XN_ASSERT_EQ(len, 3);
+    XN_ASSERT_EQ(out[1], XN_BLUFI_STATUS_FAIL);
+    XN_ASSERT_EQ(out[2], 0);
+    XN_ASSERT_EQ(xn_blufi_proto_build_config_list(configs, 1, out, 2), 0);
+}
+
+XN_TEST_RAW(full_config_list_exceeds_response)
+{
+    // 10个最长的配置（10*(2+32+64)字节）超出单条回复，构建失败由调用者回退
+    static xn_wifi_config_t configs[10];
+    for (int i = 0; i < 10; i++) {
+        memset(configs[i].ssid, 'a' + i, XN_WIFI_SSID_MAX_LEN);
+        configs[i].ssid_len = XN_WIFI_SSID_MAX_LEN;
+        memset(configs[i].password, 'A' + i, XN_WIFI_PASSWORD_MAX_LEN);
+        configs[i].password_len = XN_WIFI_PASSWORD_MAX_LEN;
+    }
+    uint8_t out[XN_BLUFI_PROTO_MAX_RESPONSE];
+    XN_ASSERT_EQ(xn_blufi_proto_build_config_list(configs, 10, out, sizeof(out)), 0);
+    XN_ASSERT_EQ(xn_blufi_proto_build_config_list(configs, 5, out, sizeof(out)), 3 + 5 * (2 + 32 + 64));
+}
+
+XN_TEST_RAW(status_report_layout)
+{
+    xn_blufi_status_report_t report = {
+        .wifi_status = 3,
+        .rssi = -61,
+        .channel = 11,
+        .authmode = 3,
+        .bssid = { 0x02, 0x11, 0x22, 0x33, 0x44, 0x55 },
+        .uptime_s = 0x01020304,
+        .reconnect_count = 7,
+    };
+    // 网络字节序：内存中即为a.b.c.d
+    const uint8_t ip[4] = { 192, 168, 1, 100 };
+    const uint8_t gw[4] = { 192, 168, 1, 1 };
+    memcpy(&report.ip, ip, 4);
+    memcpy(&report.gw, gw, 4);
+
+    uint8_t out[XN_BLUFI_PROTO_STATUS_REPORT_LEN];
+    XN_ASSERT_EQ(xn_blufi_proto_build_status_report(&report, out, sizeof(out)), XN_BLUFI_PROTO_STATUS_REPORT_LEN);
+    const uint8_t expected[XN_BLUFI_PROTO_STATUS_REPORT_LEN] = {
+        XN_BLUFI_CMD_GET_STATUS, XN_BLUFI_STATUS_OK, 3, (uint8_t)-61, 11, 3,
+        0x02, 0x11, 0x22, 0x33, 0x44, 0x55,
+        192, 168, 1, 100,
+        192, 168, 1, 1,
+        0x04, 0x03, 0x02, 0x01,
+        7, 0, 0, 0,
+    };
+    XN_ASSERT(memcmp(out, expected, sizeof(expected)) == 0);
+
+    XN_ASSERT_EQ(xn_blufi_proto_build_status_report(&report, out, sizeof(out) - 1), 0);
+    XN_ASSERT_EQ(xn_blufi_proto_build_status_report(NULL, out, sizeof(out)), 0);
+}
+
+XN_TEST_RAW(adv_data_layout)
+{
+    xn_blufi_adv_state_t state = {
+        .provisioned = true,
+        .wifi_status = XN_WIFI_GOT_IP,
+        .fw_version = { 1, 2, 3 },
+        .mac_suffix = { 0xAB, 0xCD, 0xEF },
+    };
+    uint8_t out[XN_BLUFI_PROTO_ADV_DATA_LEN];
+    XN_ASSERT_EQ(xn_blufi_proto_build_adv_data(&state, out, sizeof(out)), XN_BLUFI_PROTO_ADV_DATA_LEN);
+    const uint8_t expected[XN_BLUFI_PROTO_ADV_DATA_LEN] = {
+        0xE5, 0x02, XN_BLUFI_ADV_FRAME_VERSION, XN_BLUFI_ADV_FLAG_PROVISIONED, XN_WIFI_GOT_IP,
+        1, 2, 3,
+        0xAB, 0xCD, 0xEF,
+    };
+    XN_ASSERT(memcmp(out, expected, sizeof(expected)) == 0);
+
+    // 未配网时标志位清零
+    state.provisioned = false;
+    state.wifi_status = XN_WIFI_DISCONNECTED;
+    XN_ASSERT_EQ(xn_blufi_proto_build_adv_data(&state, out, sizeof(out)), XN_BLUFI_PROTO_ADV_DATA_LEN);
+    XN_ASSERT_EQ(out[3], 0);
+    XN_ASSERT_EQ(out[4], XN_WIFI_DISCONNECTED);
+
+    XN_ASSERT_EQ(xn_blufi_proto_build_adv_data(&state, out, sizeof(out) - 1), 0);
+    XN_ASSERT_EQ(xn_blufi_proto_build_adv_data(NULL, out, sizeof(out)), 0);
+}
+
+/* 解析版本并与期望的主、次、修订号比较 */
+static bool version_is(const char *version, uint8_t major, uint8_t minor, uint8_t patch)
+{
+    uint8_t out[3] = { 0xAA, 0xAA, 0xAA };
+    xn_blufi_proto_parse_version(version, out);
+    return out[0] == major && out[1] == minor && out[2] == patch;
+}
+
+XN_TEST_RAW(parse_version)
+{
+    XN_ASSERT(version_is("1.2.3", 1, 2, 3));
+    XN_ASSERT(version_is("v1.2.3-4-gabcdef", 1, 2, 3));
+    XN_ASSERT(version_is("V10.0.7", 10, 0, 7));
+    XN_ASSERT(version_is("2.5", 2, 5, 0));
+    XN_ASSERT(version_is("3", 3, 0, 0));
+    XN_ASSERT(version_is("1.2.3.4", 1, 2, 3));
+    XN_ASSERT(version_is("1.2-dirty", 1, 2, 0));
+    XN_ASSERT(version_is("300.1.99999", 255, 1, 255));
+    XN_ASSERT(version_is("1.4294967301", 1, 255, 0));   // 2^32+5，不能溢出回绕成5
+    XN_ASSERT(version_is("", 0, 0, 0));
+    XN_ASSERT(version_is("abc", 0, 0, 0));
+    XN_ASSERT(version_is(NULL, 0, 0, 0));
+}
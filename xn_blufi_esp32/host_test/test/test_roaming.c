@@ -0,0 +1,76 @@
+/*
+ * @Description: AP漫游（CONFIG_XN_BLUFI_ROAMING） - 重新连接不计入漫游统计，信号变差后切换到同一网络更强的AP
+ */
+
+#include "xn_steps.h"
+
+#define SSID        "xn-home"
+#define PASSWORD    "correct-horse"
+
+static xn_wifi_manager_t *s_manager;
+
+/* 已连接时按PMK和缓存的AP重新连接同一网络 */
+static void reconnect_with_lease(void)
+{
+    xn_wifi_cred_t cred;
+    xn_wifi_lease_t lease;
+    XN_ASSERT_OK(xn_wifi_manager_get_connected_cred(s_manager, &cred));
+    XN_ASSERT_OK(xn_wifi_manager_get_lease(s_manager, &lease, NULL));
+    XN_ASSERT_OK(xn_wifi_manager_connect_lease(s_manager, &cred, &lease, 0));
+    XN_ASSERT(xn_steps_manager_wait_ip(s_manager, 20000));
+}
+
+XN_TEST(reconnect_not_counted_as_roam)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    s_manager = xn_steps_manager_start();
+    xn_steps_manager_connect(s_manager, SSID, PASSWORD);
+
+    sim_wifi_stats_t before;
+    sim_wifi_get_stats(&before);
+    reconnect_with_lease();
+
+    // 断开旧连接产生的事件不能走直连失败/漫游失败的路径
+    sim_wifi_stats_t after;
+    sim_wifi_get_stats(&after);
+    XN_ASSERT_EQ(after.attempts - before.attempts, 1);
+    XN_ASSERT_EQ(after.direct_connects - before.direct_connects, 1);
+    XN_ASSERT_EQ(after.connect_rejected, 0);
+
+    xn_wifi_roam_stats_t roam;
+    XN_ASSERT_OK(xn_wifi_manager_get_roam_stats(s_manager, &roam));
+    XN_ASSERT_EQ(roam.roam_count, 0);
+    XN_ASSERT_EQ(roam.roam_failures, 0);
+
+    xn_wifi_snapshot_t snapshot;
+    XN_ASSERT_OK(xn_wifi_manager_get_snapshot(s_manager, &snapshot));
+    XN_ASSERT_EQ(snapshot.retry_count, 0);
+    XN_ASSERT_EQ(snapshot.reconnect_count, 0);
+}
+
+XN_TEST(roams_to_stronger_ap_after_reconnect)
+{
+    int near = xn_steps_add_ap(SSID, PASSWORD, -60);
+    int far = xn_steps_add_ap(SSID, PASSWORD, -45);
+    sim_wifi_set_online(far, false);
+    s_manager = xn_steps_manager_start();
+    xn_steps_manager_connect(s_manager, SSID, PASSWORD);
+    XN_ASSERT_EQ(sim_wifi_connected_ap(), near);
+    reconnect_with_lease();
+
+    // 信号低于门限后扫描同一网络，切换到明显更强的AP
+    sim_wifi_set_online(far, true);
+    sim_wifi_set_rssi(near, -80);
+    sim_run_ms(5000);
+    XN_ASSERT_EQ(sim_wifi_connected_ap(), far);
+    XN_ASSERT(sim_wifi_has_ip());
+
+    xn_wifi_roam_stats_t roam;
+    XN_ASSERT_OK(xn_wifi_manager_get_roam_stats(s_manager, &roam));
+    XN_ASSERT_EQ(roam.roam_count, 1);
+    XN_ASSERT_EQ(roam.roam_failures, 0);
+
+    xn_wifi_snapshot_t snapshot;
+    XN_ASSERT_OK(xn_wifi_manager_get_snapshot(s_manager, &snapshot));
+    XN_ASSERT_EQ(snapshot.reconnect_count, 0);
+}
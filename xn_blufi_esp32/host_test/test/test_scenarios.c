@@ -0,0 +1,520 @@
+/*
+ * @Description: 端到端配网场景 - 手机经BluFi下发配置，仿真WiFi按设定的时序和失败原因响应，
+ * 检查手机收到的报告、耗时、NVS中保存的结果，以及重启后的自动连接
+ */
+
+#include "xn_steps.h"
+#include "app_blufi.h"
+#include "xn_wifi_storage.h"
+#include "xn_blufi_proto.h"
+#include <sys/mman.h>
+
+#define SSID        "xn-home"
+#define PASSWORD    "correct-horse"
+
+/* 连接命令到成功报告：全信道扫描+认证关联+DHCP，再留出事件分发的余量 */
+#define CONNECT_MS  (1500 + 150 + 300)
+
+XN_TEST(provision_success)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    xn_steps_boot();
+    xn_steps_phone_open();
+
+    int64_t start = sim_now_us();
+    xn_steps_provision(SSID, PASSWORD);
+
+    sim_msg_t msg;
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_SUCCESS, &msg, 10000));
+    XN_ASSERT_RANGE((msg.at_us - start) / 1000, CONNECT_MS, CONNECT_MS + 50);
+    XN_ASSERT_EQ(msg.ssid_len, strlen(SSID));
+    XN_ASSERT(memcmp(msg.ssid, SSID, msg.ssid_len) == 0);
+#if CONFIG_XN_BLUFI_SECURITY
+    XN_ASSERT(msg.encrypted);
+    XN_ASSERT(!sim_ble_air_contains(PASSWORD, strlen(PASSWORD)));
+#endif
+    XN_ASSERT(sim_wifi_has_ip());
+
+    // 保存在应用层的GOT_IP处理中完成
+    sim_run_ms(100);
+    xn_wifi_config_t configs[4];
+    uint8_t count = 0;
+    XN_ASSERT_OK(xn_wifi_storage_load_all(configs, &count, 4));
+    XN_ASSERT_EQ(count, 1);
+    XN_ASSERT(strcmp((const char *)configs[0].ssid, SSID) == 0);
+
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.attempts, 1);
+}
+
+XN_TEST(provision_slow_dhcp)
+{
+    sim_wifi_timing_t timing = { .dhcp_ms = 4000 };
+    sim_wifi_set_timing(&timing);
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    xn_steps_boot();
+    xn_steps_phone_open();
+
+    int64_t start = sim_now_us();
+    xn_steps_provision(SSID, PASSWORD);
+
+    sim_msg_t msg;
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_SUCCESS, &msg, 15000));
+    XN_ASSERT_RANGE((msg.at_us - start) / 1000, 1500 + 150 + 4000, 1500 + 150 + 4000 + 50);
+}
+
+XN_TEST(provision_wrong_password)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    xn_steps_boot();
+    xn_steps_phone_open();
+
+    int64_t start = sim_now_us();
+    xn_steps_provision(SSID, "wrong-password");
+
+    // 首次尝试加5次重试，每次都在扫描+认证后以原因15失败，之后才上报失败
+    sim_msg_t msg;
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_FAIL, &msg, 60000));
+    XN_ASSERT_RANGE((msg.at_us - start) / 1000, 6 * (1500 + 150), 6 * (1500 + 150) + 100);
+    XN_ASSERT(!sim_wifi_has_ip());
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.attempts, 6);
+
+    sim_run_ms(1000);
+    xn_wifi_config_t configs[4];
+    uint8_t count = 0;
+    xn_wifi_storage_load_all(configs, &count, 4);
+    XN_ASSERT_EQ(count, 0);
+}
+
+XN_TEST(provision_ap_missing)
+{
+    xn_steps_boot();
+    xn_steps_phone_open();
+
+    xn_steps_provision("nobody-home", PASSWORD);
+
+    sim_msg_t msg;
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_FAIL, &msg, 60000));
+    XN_ASSERT(!sim_wifi_has_ip());
+}
+
+XN_TEST(provision_recovers_after_transient_failure)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    sim_wifi_fail_next(1, WIFI_REASON_AUTH_EXPIRE);
+    xn_steps_boot();
+    xn_steps_phone_open();
+
+    xn_steps_provision(SSID, PASSWORD);
+
+    sim_msg_t msg;
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_SUCCESS, &msg, 30000));
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.attempts, 2);
+}
+
+XN_TEST(status_query_after_connect)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    xn_steps_boot();
+    xn_steps_phone_open();
+    xn_steps_provision(SSID, PASSWORD);
+
+    sim_msg_t msg;
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_SUCCESS, &msg, 10000));
+
+    sim_phone_send_get_status();
+    XN_ASSERT(sim_phone_wait(SIM_MSG_CONN_REPORT, &msg, 100));
+    XN_ASSERT_EQ(msg.state, ESP_BLUFI_STA_CONN_SUCCESS);
+    XN_ASSERT(memcmp(msg.ssid, SSID, strlen(SSID)) == 0);
+}
+
+/* 发送扩展状态查询（自定义数据0x03），等待28字节的回复 */
+static void query_status_report(sim_msg_t *msg)
+{
+    const uint8_t cmd[] = { XN_BLUFI_CMD_GET_STATUS };
+    sim_phone_send_custom(cmd, sizeof(cmd));
+    XN_ASSERT(sim_phone_wait(SIM_MSG_CUSTOM, msg, 100));
+    XN_ASSERT_EQ(msg->len, XN_BLUFI_PROTO_STATUS_REPORT_LEN);
+    XN_ASSERT_EQ(msg->data[0], XN_BLUFI_CMD_GET_STATUS);
+    XN_ASSERT_EQ(msg->data[1], XN_BLUFI_STATUS_OK);
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+XN_TEST(extended_status_report)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    xn_steps_boot();
+    xn_steps_phone_open();
+
+    // 未连接：只有状态，其余字段为0
+    sim_msg_t msg;
+    query_status_report(&msg);
+    XN_ASSERT_EQ(msg.data[2], XN_WIFI_DISCONNECTED);
+    static const uint8_t zero[4] = {0};
+    XN_ASSERT(memcmp(&msg.data[12], zero, 4) == 0);
+
+    // 第一次尝试失败后重连成功，连接5秒后查询
+    sim_wifi_fail_next(1, WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT);
+    xn_steps_provision(SSID, PASSWORD);
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_SUCCESS, &msg, 30000));
+    sim_run_ms(5000);
+
+    query_status_report(&msg);
+#if CONFIG_XN_BLUFI_SECURITY
+    XN_ASSERT(msg.encrypted);
+#endif
+
+    const uint8_t bssid[6] = { 0x02, 0x11, 0x22, 0x33, 0x44, 1 };
+    const uint8_t ip[4] = { 192, 168, 1, 100 };
+    const uint8_t gw[4] = { 192, 168, 1, 1 };
+    XN_ASSERT_EQ(msg.data[2], XN_WIFI_GOT_IP);
+    XN_ASSERT_EQ((int8_t)msg.data[3], CONFIG_XN_BLUFI_LINK_MONITOR ? -50 : 0);
+    XN_ASSERT_EQ(msg.data[4], 6);
+    XN_ASSERT_EQ(msg.data[5], WIFI_AUTH_WPA2_PSK);
+    XN_ASSERT(memcmp(&msg.data[6], bssid, 6) == 0);
+    XN_ASSERT(memcmp(&msg.data[12], ip, 4) == 0);
+    XN_ASSERT(memcmp(&msg.data[16], gw, 4) == 0);
+    XN_ASSERT_RANGE(get_le32(&msg.data[20]), 5, 6);
+    XN_ASSERT_EQ(get_le32(&msg.data[24]), 1);
+}
+
+XN_TEST(stored_config_list_reply)
+{
+    xn_steps_boot();
+    xn_steps_phone_open();
+    const uint8_t cmd[] = { XN_BLUFI_CMD_GET_CONFIGS };
+
+    // 没有存储的配置
+    sim_msg_t msg;
+    sim_phone_send_custom(cmd, sizeof(cmd));
+    XN_ASSERT(sim_phone_wait(SIM_MSG_CUSTOM, &msg, 100));
+    const uint8_t empty[] = { XN_BLUFI_CMD_GET_CONFIGS, XN_BLUFI_STATUS_FAIL, 0 };
+    XN_ASSERT_EQ(msg.len, sizeof(empty));
+    XN_ASSERT(memcmp(msg.data, empty, sizeof(empty)) == 0);
+
+    // 存满10条：全部按连接优先顺序（最近保存的在前）返回
+    char ssid[8];
+    for (int i = 0; i < 10; i++) {
+        snprintf(ssid, sizeof(ssid), "net-%d", i);
+        XN_ASSERT_OK(xn_wifi_storage_save(ssid, PASSWORD));
+    }
+    sim_phone_send_custom(cmd, sizeof(cmd));
+    XN_ASSERT(sim_phone_wait(SIM_MSG_CUSTOM, &msg, 100));
+    XN_ASSERT_EQ(msg.data[0], XN_BLUFI_CMD_GET_CONFIGS);
+    XN_ASSERT_EQ(msg.data[1], XN_BLUFI_STATUS_OK);
+    XN_ASSERT_EQ(msg.data[2], 10);
+    XN_ASSERT_EQ(msg.len, 3 + 10 * (2 + 5 + strlen(PASSWORD)));
+    size_t offset = 3;
+    for (int i = 9; i >= 0; i--) {
+        snprintf(ssid, sizeof(ssid), "net-%d", i);
+        XN_ASSERT_EQ(msg.data[offset], 5);
+        XN_ASSERT(memcmp(&msg.data[offset + 1], ssid, 5) == 0);
+        offset += 1 + 5;
+        XN_ASSERT_EQ(msg.data[offset], strlen(PASSWORD));
+        XN_ASSERT(memcmp(&msg.data[offset + 1], PASSWORD, strlen(PASSWORD)) == 0);
+        offset += 1 + strlen(PASSWORD);
+    }
+}
+
+/* 重启场景：第一个进程配网后导出NVS，第二个进程导入后启动，不经蓝牙自动连接 */
+static uint8_t *s_flash;
+static size_t *s_flash_len;
+
+static void reboot_phase_provision(void)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    xn_steps_boot();
+    xn_steps_phone_open();
+    xn_steps_provision(SSID, PASSWORD);
+    sim_msg_t msg;
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_SUCCESS, &msg, 10000));
+    sim_run_ms(500);
+    *s_flash_len = sim_nvs_export(s_flash, 256 * 1024);
+    XN_ASSERT(*s_flash_len > 0);
+}
+
+static void reboot_phase_auto_connect(void)
+{
+    sim_nvs_import(s_flash, *s_flash_len);
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    XN_ASSERT_OK(app_blufi_init());
+    XN_ASSERT(xn_steps_wait_ip(5000));
+
+    // 保存的凭据带BSSID和信道，直接连接跳过全信道扫描
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.attempts, 1);
+    XN_ASSERT_EQ(stats.direct_connects, 1);
+    XN_ASSERT(sim_now_us() / 1000 < 1500);
+}
+
+XN_TEST_RAW(reboot_auto_connects_saved_network)
+{
+    s_flash = mmap(NULL, 256 * 1024 + sizeof(size_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    XN_ASSERT(s_flash != MAP_FAILED);
+    s_flash_len = (size_t *)(s_flash + 256 * 1024);
+    XN_ASSERT(xn_test_run_child(reboot_phase_provision));
+    XN_ASSERT(xn_test_run_child(reboot_phase_auto_connect));
+}
+
+XN_TEST(got_ip_work_runs_off_wifi_worker)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    xn_steps_boot();
+    xn_steps_phone_open();
+    xn_steps_provision(SSID, PASSWORD);
+
+    sim_msg_t msg;
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_SUCCESS, &msg, 10000));
+    sim_run_ms(1000);
+
+    // PMK计算（PBKDF2）和保存配置在应用层的事件处理任务中，不占用WiFi管理器工作任务
+    sim_crypto_stats_t crypto;
+    sim_crypto_get_stats(&crypto);
+    XN_ASSERT(crypto.pbkdf2_calls >= 1);
+    XN_ASSERT(strcmp(crypto.pbkdf2_task, "app_blufi_evt") == 0);
+    XN_ASSERT(strcmp(sim_nvs_last_writer(), "app_blufi_evt") == 0);
+
+    // 保存的配置带PMK，连接记录已更新
+    xn_wifi_config_t configs[4];
+    uint8_t count = 0;
+    XN_ASSERT_OK(xn_wifi_storage_load_all(configs, &count, 4));
+    XN_ASSERT_EQ(count, 1);
+    XN_ASSERT_EQ(configs[0].success_count, 1);
+    XN_ASSERT(configs[0].pmk_valid);
+}
+
+/* 当前共存偏好 */
+static esp_coex_prefer_t coex_now(void)
+{
+    return sim_coex_preference(NULL);
+}
+
+static xn_blufi_coex_stats_t coex_stats(xn_blufi_t *blufi)
+{
+    xn_blufi_coex_stats_t stats;
+    XN_ASSERT_OK(xn_blufi_get_coex_stats(blufi, &stats));
+    return stats;
+}
+
+/* 手机发送扩展状态查询并取走回复 */
+static void send_status_query(void)
+{
+    sim_msg_t msg;
+    query_status_report(&msg);
+}
+
+/* BLE突发发送后保持偏向蓝牙的时间，与组件内的设置一致 */
+#define COEX_HOLD_MS    300
+
+/* 启动组件并连上手机；组件以开始时间0表示阶段未激活，而仿真时间从0开始，先前进一点 */
+static xn_blufi_t *coex_boot(void)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    sim_run_ms(10);
+    xn_blufi_t *blufi = xn_steps_boot_component();
+    xn_steps_phone_open();
+    return blufi;
+}
+
+XN_TEST(coex_phases_follow_provisioning)
+{
+    xn_blufi_t *blufi = coex_boot();
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_BALANCE);
+
+    // 关联期间偏向WiFi，回复帧的突发发送不能抢走优先级
+    xn_steps_provision(SSID, PASSWORD);
+    sim_run_ms(100);
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_WIFI);
+    send_status_query();
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_WIFI);
+
+    // 获取IP后关联阶段结束，突发阶段也早已结束，回到均衡
+    XN_ASSERT(xn_steps_wait_ip(20000));
+    sim_run_ms(COEX_HOLD_MS);
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_BALANCE);
+    xn_blufi_coex_stats_t stats = coex_stats(blufi);
+    XN_ASSERT_EQ(stats.wifi_connect.count, 1);
+    XN_ASSERT_RANGE(stats.wifi_connect.total_us / 1000, CONNECT_MS - 100, CONNECT_MS);
+    XN_ASSERT_EQ(stats.ble_burst.count, 1);
+
+    // 状态回复：偏向蓝牙，最后一次发送后保持一段时间再退出
+    send_status_query();
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_BT);
+    sim_run_ms(COEX_HOLD_MS / 2);
+    send_status_query();
+    sim_run_ms(COEX_HOLD_MS - 10);
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_BT);
+    sim_run_ms(20);
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_BALANCE);
+    stats = coex_stats(blufi);
+    XN_ASSERT_EQ(stats.ble_burst.count, 2);
+    XN_ASSERT_RANGE(stats.ble_burst.max_us / 1000, COEX_HOLD_MS * 3 / 2, COEX_HOLD_MS * 3 / 2 + 20);
+
+    // 扫描期间偏向WiFi，列表发送时偏向蓝牙
+    sim_phone_send_get_list();
+    sim_run_ms(100);
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_WIFI);
+    sim_msg_t msg;
+    XN_ASSERT(sim_phone_wait(SIM_MSG_WIFI_LIST, &msg, 5000));
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_BT);
+    sim_run_ms(COEX_HOLD_MS + 10);
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_BALANCE);
+    stats = coex_stats(blufi);
+    XN_ASSERT_EQ(stats.wifi_scan.count, 1);
+    XN_ASSERT_EQ(stats.ble_burst.count, 3);
+
+    // 统计的切换次数与实际设置次数一致
+    uint32_t sets;
+    sim_coex_preference(&sets);
+    XN_ASSERT_EQ(stats.prefer_switches, sets);
+}
+
+XN_TEST(coex_fixed_policy_overrides_phases)
+{
+    xn_blufi_t *blufi = coex_boot();
+
+    XN_ASSERT_OK(xn_blufi_set_coex_policy(blufi, XN_BLUFI_COEX_PREFER_BT));
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_BT);
+
+    // 固定策略下阶段照常统计，但不切换偏好
+    xn_steps_provision(SSID, PASSWORD);
+    sim_run_ms(100);
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_BT);
+    XN_ASSERT(xn_steps_wait_ip(20000));
+    XN_ASSERT_EQ(coex_stats(blufi).wifi_connect.count, 1);
+
+    XN_ASSERT_OK(xn_blufi_set_coex_policy(blufi, XN_BLUFI_COEX_AUTO));
+    XN_ASSERT_EQ(coex_now(), ESP_COEX_PREFER_BALANCE);
+    XN_ASSERT_EQ(xn_blufi_set_coex_policy(blufi, XN_BLUFI_COEX_PREFER_BT + 1), ESP_ERR_INVALID_ARG);
+}
+
+/* 并行初始化：保存一个网络后直接初始化组件，返回初始化结果 */
+static esp_err_t parallel_init(xn_blufi_t **out)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    XN_ASSERT_OK(nvs_flash_init());
+    XN_ASSERT_OK(xn_wifi_storage_init());
+    XN_ASSERT_OK(xn_wifi_storage_save(SSID, PASSWORD));
+    xn_blufi_t *blufi = xn_blufi_create("xn-test");
+    XN_ASSERT(blufi != NULL);
+    *out = blufi;
+    return xn_blufi_init(blufi);
+}
+
+XN_TEST(parallel_init_joins_ble_task)
+{
+    xn_blufi_t *blufi;
+    XN_ASSERT_OK(parallel_init(&blufi));
+
+    // 蓝牙在单独的初始化任务中完成，返回时已汇合；自动连接不等蓝牙，此时已经发起
+    sim_ble_state_t state;
+    sim_ble_get_state(&state);
+    XN_ASSERT(strcmp(state.init_task, "xn_ble_init") == 0);
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.connect_calls, 1);
+    XN_ASSERT(sim_wifi_started());
+
+    XN_ASSERT(xn_steps_wait_ip(CONNECT_MS + 100));
+    sim_ble_get_state(&state);
+    XN_ASSERT(state.blufi_ready);
+}
+
+XN_TEST(parallel_init_ble_failure_stops_wifi)
+{
+    // 蓝牙初始化失败：初始化返回蓝牙的错误，已发起的自动连接被停止
+    sim_ble_fail_init(ESP_ERR_NO_MEM);
+    xn_blufi_t *blufi;
+    XN_ASSERT_EQ(parallel_init(&blufi), ESP_ERR_NO_MEM);
+    XN_ASSERT(!sim_wifi_started());
+
+    sim_run_ms(CONNECT_MS * 3);
+    XN_ASSERT(!sim_wifi_has_ip());
+    XN_ASSERT_EQ(sim_wifi_connected_ap(), -1);
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.connect_calls, 1);
+
+    sim_ble_state_t state;
+    sim_ble_get_state(&state);
+    XN_ASSERT(!state.nimble_running);
+    xn_blufi_destroy(blufi);
+}
+
+XN_TEST(parallel_init_wifi_failure_still_joins)
+{
+    // WiFi初始化失败：仍等蓝牙任务结束（它用的是调用者栈上的参数），再返回WiFi的错误
+    sim_wifi_fail_init(ESP_ERR_NO_MEM);
+    xn_blufi_t *blufi;
+    XN_ASSERT_EQ(parallel_init(&blufi), ESP_ERR_NO_MEM);
+
+    sim_ble_state_t state;
+    sim_ble_get_state(&state);
+    XN_ASSERT(strcmp(state.init_task, "xn_ble_init") == 0);
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.connect_calls, 0);
+}
+
+XN_TEST(task_stats_default_placement)
+{
+    // 默认配置：两个任务都绑定核0，报告的配置与实际创建参数一致
+    xn_blufi_t *blufi = xn_steps_boot_component();
+    sim_task_info_t host, worker;
+    XN_ASSERT(sim_task_find("nimble_host", &host));
+    XN_ASSERT(sim_task_find("xn_wifi_worker", &worker));
+    XN_ASSERT_EQ(host.core, 0);
+    XN_ASSERT_EQ(host.priority, CONFIG_XN_BLUFI_HOST_TASK_PRIORITY);
+    XN_ASSERT_EQ(worker.core, 0);
+    XN_ASSERT_EQ(worker.priority, CONFIG_XN_BLUFI_WIFI_WORKER_PRIORITY);
+
+    xn_blufi_task_stats_t stats;
+    XN_ASSERT_OK(xn_blufi_get_task_stats(blufi, &stats));
+    XN_ASSERT(stats.ble_host.running);
+    XN_ASSERT_EQ(stats.ble_host.core, 0);
+    XN_ASSERT_EQ(stats.ble_host.priority, host.priority);
+    XN_ASSERT_EQ(stats.ble_host.stack_size, host.stack_size);
+    XN_ASSERT(stats.wifi_worker.running);
+    XN_ASSERT_EQ(stats.wifi_worker.core, 0);
+    XN_ASSERT_EQ(stats.wifi_worker.priority, worker.priority);
+    XN_ASSERT_EQ(stats.wifi_worker.stack_size, worker.stack_size);
+
+    // 未设置时仿真的高水位为栈大小的一半
+    XN_ASSERT_EQ(stats.ble_host.stack_high_water, host.stack_size / 2);
+    XN_ASSERT_EQ(stats.wifi_worker.stack_high_water, worker.stack_size / 2);
+}
+
+XN_TEST(max_throughput_keeps_modem_sleep_with_ble)
+{
+    xn_blufi_t *blufi = xn_steps_boot_component();
+    xn_wifi_profile_info_t info;
+
+    // 低功耗档位不受共存限制
+    XN_ASSERT_OK(xn_blufi_wifi_set_profile(blufi, XN_WIFI_PROFILE_LOW_POWER));
+    sim_run_ms(10);
+    XN_ASSERT_OK(xn_blufi_wifi_get_profile_info(blufi, &info));
+    XN_ASSERT_EQ(info.ps_type, WIFI_PS_MAX_MODEM);
+    XN_ASSERT_EQ(info.bandwidth, WIFI_BW_HT20);
+    XN_ASSERT_EQ(info.tx_power, 52);
+
+    // 蓝牙开启时驱动拒绝关闭Modem-sleep：MAX_THROUGHPUT退回MIN_MODEM（而不是停在上一档的MAX_MODEM），
+    // 带宽和发射功率照常生效
+    XN_ASSERT_OK(xn_blufi_wifi_set_profile(blufi, XN_WIFI_PROFILE_MAX_THROUGHPUT));
+    sim_run_ms(10);
+    XN_ASSERT_OK(xn_blufi_wifi_get_profile_info(blufi, &info));
+    XN_ASSERT_EQ(info.id, XN_WIFI_PROFILE_MAX_THROUGHPUT);
+    XN_ASSERT_EQ(info.config.ps_type, WIFI_PS_NONE);
+    XN_ASSERT_EQ(info.ps_type, WIFI_PS_MIN_MODEM);
+    XN_ASSERT_EQ(info.bandwidth, WIFI_BW_HT40);
+    XN_ASSERT_EQ(info.tx_power, 84);
+}
@@ -0,0 +1,65 @@
+/*
+ * @Description: BluFi安全层 - 密钥协商失败的处理（AES密钥装载失败时不能宣布协商完成）
+ */
+
+#include "xn_steps.h"
+#include "xn_blufi_internal.h"
+
+#define SSID        "xn-home"
+#define PASSWORD    "correct-horse"
+
+XN_TEST(setkey_failure_fails_negotiation)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    xn_steps_boot();
+    sim_phone_connect();
+
+    // AES密钥装载失败：向手机报错，不回复公钥，也不计为成功的协商
+    sim_crypto_fail_setkey(1);
+    XN_ASSERT(!sim_phone_negotiate());
+
+    sim_ble_state_t state;
+    sim_ble_get_state(&state);
+    XN_ASSERT_EQ(state.errors, 1);
+    XN_ASSERT_EQ(state.last_error, ESP_BLUFI_INIT_SECURITY_ERROR);
+
+    xn_blufi_security_stats_t stats;
+    xn_blufi_security_get_stats(&stats);
+    XN_ASSERT_EQ(stats.negotiations, 0);
+    XN_ASSERT_EQ(stats.negotiate_failures, 1);
+
+    // 手机重新协商后可以正常加密配网
+    XN_ASSERT(sim_phone_negotiate());
+    xn_steps_provision(SSID, PASSWORD);
+    sim_msg_t msg;
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_SUCCESS, &msg, 10000));
+    XN_ASSERT(msg.encrypted);
+    XN_ASSERT(!sim_ble_air_contains(PASSWORD, strlen(PASSWORD)));
+
+    xn_blufi_security_get_stats(&stats);
+    XN_ASSERT_EQ(stats.negotiations, 1);
+}
+
+XN_TEST(oversized_dh_param_len_rejected)
+{
+    xn_steps_boot();
+    sim_phone_connect();
+
+    // 参数长度由手机给出，超过1024位DH所需的长度时直接报错，不按该长度申请内存
+    bool traced = sim_heap_trace_start();
+    sim_phone_send_param_len(0xffff);
+    sim_run_ms(100);
+    sim_heap_stats_t heap;
+    sim_heap_trace_stop(&heap);
+    if (traced) {
+        XN_ASSERT(heap.bytes < 0xffff);
+    }
+
+    sim_ble_state_t state;
+    sim_ble_get_state(&state);
+    XN_ASSERT_EQ(state.errors, 1);
+    XN_ASSERT_EQ(state.last_error, ESP_BLUFI_DH_MALLOC_ERROR);
+
+    // 之后按正常长度协商不受影响
+    XN_ASSERT(sim_phone_negotiate());
+}
@@ -0,0 +1,76 @@
+/*
+ * @Description: 静态分配模式（CONFIG_XN_BLUFI_STATIC_ALLOC） - 初始化之后的配网、重连、重新协商和读取配置列表不申请堆内存
+ */
+
+#include "xn_steps.h"
+#include "app_blufi.h"
+#include "xn_blufi_proto.h"
+
+#define SSID        "xn-home"
+#define PASSWORD    "correct-horse"
+
+XN_TEST(steady_state_makes_no_heap_allocations)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    xn_steps_boot();
+
+    // ASan/UBSan构建不替换malloc，无法统计
+    if (!sim_heap_trace_start()) {
+        printf("  heap tracing unavailable in this build, skipped\n");
+        return;
+    }
+
+    // 手机连接、协商、配网；前两次尝试失败，走管理器的重试
+    sim_wifi_fail_next(2, WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT);
+    xn_steps_phone_open();
+    xn_steps_provision(SSID, PASSWORD);
+    sim_msg_t msg;
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_SUCCESS, &msg, 20000));
+    sim_run_ms(1000);
+
+    // AP踢出后手机让设备重新连接
+    sim_wifi_drop_link(WIFI_REASON_AUTH_EXPIRE);
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_FAIL, &msg, 2000));
+    sim_phone_send_connect();
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_SUCCESS, &msg, 20000));
+    sim_run_ms(1000);
+
+    // 手机断开后重新连接并再次协商
+    sim_phone_disconnect();
+    sim_run_ms(100);
+    xn_steps_phone_open();
+    sim_phone_send_get_status();
+    XN_ASSERT(xn_steps_wait_report(ESP_BLUFI_STA_CONN_SUCCESS, &msg, 2000));
+
+    // 读取存储的配置列表：回复缓冲区在实例中，不在堆上
+    const uint8_t get_configs[] = { XN_BLUFI_CMD_GET_CONFIGS };
+    sim_phone_send_custom(get_configs, sizeof(get_configs));
+    XN_ASSERT(sim_phone_wait(SIM_MSG_CUSTOM, &msg, 100));
+    XN_ASSERT_EQ(msg.data[0], XN_BLUFI_CMD_GET_CONFIGS);
+    XN_ASSERT_EQ(msg.data[1], XN_BLUFI_STATUS_OK);
+
+    sim_heap_stats_t heap;
+    sim_heap_trace_stop(&heap);
+    if (heap.allocs != 0) {
+        XN_FAIL("%u heap allocations (%zu bytes), last %zu bytes in %s", heap.allocs, heap.bytes,
+                heap.last_size, heap.last_task);
+    }
+}
+
+XN_TEST(init_creates_no_dynamic_tasks)
+{
+    xn_steps_add_ap(SSID, PASSWORD, -50);
+    if (!sim_heap_trace_start()) {
+        printf("  heap tracing unavailable in this build, skipped\n");
+        return;
+    }
+
+    // 初始化期间的任务（含并行初始化的蓝牙任务）都使用静态栈
+    xn_steps_boot();
+
+    sim_heap_stats_t heap;
+    sim_heap_trace_stop(&heap);
+    if (heap.tasks != 0) {
+        XN_FAIL("%u tasks created on the heap, last %s", heap.tasks, heap.last_new_task);
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * @Description: 任务配置（核/优先级/栈大小） - 非默认配置下NimBLE主机任务和WiFi工作任务
+ * 按配置创建，xn_blufi_get_task_stats()报告的配置和栈高水位与实际任务一致
+ */
+
+#include "xn_steps.h"
+
+/* 与CMakeLists中task_placement变体的配置一致 */
+#define HOST_CORE       1
+#define HOST_PRIORITY   18
+#define HOST_STACK      5120
+#define WORKER_PRIORITY 7
+#define WORKER_STACK    6144
+
+static sim_task_info_t find_task(const char *name)
+{
+    sim_task_info_t info;
+    XN_ASSERT(sim_task_find(name, &info));
+    return info;
+}
+
+static xn_blufi_task_stats_t task_stats(xn_blufi_t *blufi)
+{
+    xn_blufi_task_stats_t stats;
+    XN_ASSERT_OK(xn_blufi_get_task_stats(blufi, &stats));
+    return stats;
+}
+
+XN_TEST(host_task_uses_configured_placement)
+{
+    xn_blufi_t *blufi = xn_steps_boot_component();
+
+    sim_task_info_t task = find_task("nimble_host");
+    XN_ASSERT_EQ(task.core, HOST_CORE);
+    XN_ASSERT_EQ(task.priority, HOST_PRIORITY);
+    XN_ASSERT_EQ(task.stack_size, HOST_STACK);
+
+    xn_blufi_task_stats_t stats = task_stats(blufi);
+    XN_ASSERT(stats.ble_host.running);
+    XN_ASSERT_EQ(stats.ble_host.core, HOST_CORE);
+    XN_ASSERT_EQ(stats.ble_host.priority, HOST_PRIORITY);
+    XN_ASSERT_EQ(stats.ble_host.stack_size, HOST_STACK);
+}
+
+XN_TEST(worker_core_minus_one_means_no_affinity)
+{
+    xn_blufi_t *blufi = xn_steps_boot_component();
+
+    sim_task_info_t task = find_task("xn_wifi_worker");
+    XN_ASSERT_EQ(task.core, tskNO_AFFINITY);
+    XN_ASSERT_EQ(task.priority, WORKER_PRIORITY);
+    XN_ASSERT_EQ(task.stack_size, WORKER_STACK);
+
+    // 订阅者回调任务跟随工作任务的核
+    XN_ASSERT_EQ(find_task("xn_wifi_sub0").core, tskNO_AFFINITY);
+
+    xn_blufi_task_stats_t stats = task_stats(blufi);
+    XN_ASSERT(stats.wifi_worker.running);
+    XN_ASSERT_EQ(stats.wifi_worker.core, -1);
+    XN_ASSERT_EQ(stats.wifi_worker.priority, WORKER_PRIORITY);
+    XN_ASSERT_EQ(stats.wifi_worker.stack_size, WORKER_STACK);
+}
+
+XN_TEST(stack_high_water_read_from_each_task)
+{
+    xn_blufi_t *blufi = xn_steps_boot_component();
+
+    // 两个任务设置不同的高水位，报告值不能对调或取自调用者
+    XN_ASSERT(sim_task_set_high_water("nimble_host", 1234));
+    XN_ASSERT(sim_task_set_high_water("xn_wifi_worker", 2345));
+    xn_blufi_task_stats_t stats = task_stats(blufi);
+    XN_ASSERT_EQ(stats.ble_host.stack_high_water, 1234);
+    XN_ASSERT_EQ(stats.wifi_worker.stack_high_water, 2345);
+
+    // 高水位随任务运行变化，每次读取都取当前值
+    XN_ASSERT(sim_task_set_high_water("xn_wifi_worker", 512));
+    stats = task_stats(blufi);
+    XN_ASSERT_EQ(stats.wifi_worker.stack_high_water, 512);
+}
+
+XN_TEST(task_stats_rejects_null)
+{
+    xn_blufi_t *blufi = xn_steps_boot_component();
+    xn_blufi_task_stats_t stats;
+    XN_ASSERT_EQ(xn_blufi_get_task_stats(NULL, &stats), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_EQ(xn_blufi_get_task_stats(blufi, NULL), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_EQ(xn_wifi_manager_get_stack_high_water(NULL), 0);
+}
@@ -0,0 +1,479 @@
+/*
+ * @Description: WiFi管理器 - 直接驱动管理器（不经过BluFi），检查重连计数、PMK/直连提示的保留和耗时
+ */
+
+#include "xn_steps.h"
+
+#define SSID_A      "xn-home"
+#define SSID_B      "xn-office"
+#define PASSWORD    "correct-horse"
+
+/* 全信道扫描+认证关联+DHCP */
+#define CONNECT_MS  (1500 + 150 + 300)
+
+static xn_wifi_manager_t *s_manager;
+
+XN_TEST(switch_network_ignores_stale_disconnect)
+{
+    xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    xn_steps_add_ap(SSID_B, PASSWORD, -55);
+    s_manager = xn_steps_manager_start();
+    xn_steps_manager_connect(s_manager, SSID_A, PASSWORD);
+
+    sim_wifi_stats_t before;
+    sim_wifi_get_stats(&before);
+
+    // 已连接时切换网络：断开A产生的DISCONNECTED不能算作B的失败尝试
+    uint32_t elapsed = xn_steps_manager_connect(s_manager, SSID_B, PASSWORD);
+    XN_ASSERT_RANGE(elapsed, CONNECT_MS, CONNECT_MS + 50);
+    XN_ASSERT_EQ(sim_wifi_connected_ap(), 1);
+
+    sim_wifi_stats_t after;
+    sim_wifi_get_stats(&after);
+    XN_ASSERT_EQ(after.attempts - before.attempts, 1);
+    XN_ASSERT_EQ(after.connect_rejected, 0);
+
+    xn_wifi_snapshot_t snapshot;
+    XN_ASSERT_OK(xn_wifi_manager_get_snapshot(s_manager, &snapshot));
+    XN_ASSERT_EQ(snapshot.retry_count, 0);
+    XN_ASSERT_EQ(snapshot.reconnect_count, 0);
+    XN_ASSERT_EQ(snapshot.time_to_ip_ms, elapsed);
+}
+
+XN_TEST(connect_during_attempt_ignores_stale_disconnect)
+{
+    xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    xn_steps_add_ap(SSID_B, PASSWORD, -55);
+    s_manager = xn_steps_manager_start();
+
+    // A还在扫描时改连B，中断A的尝试产生的DISCONNECTED同样不计入B的重试
+    xn_wifi_cred_t cred;
+    XN_ASSERT_OK(xn_wifi_cred_from_str(&cred, SSID_A, PASSWORD));
+    XN_ASSERT_OK(xn_wifi_manager_connect_cred(s_manager, &cred));
+    sim_run_ms(500);
+
+    uint32_t elapsed = xn_steps_manager_connect(s_manager, SSID_B, PASSWORD);
+    XN_ASSERT_RANGE(elapsed, CONNECT_MS, CONNECT_MS + 50);
+    XN_ASSERT_EQ(sim_wifi_connected_ap(), 1);
+
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.attempts, 2);
+    XN_ASSERT_EQ(stats.connect_rejected, 0);
+
+    xn_wifi_snapshot_t snapshot;
+    XN_ASSERT_OK(xn_wifi_manager_get_snapshot(s_manager, &snapshot));
+    XN_ASSERT_EQ(snapshot.reconnect_count, 0);
+}
+
+XN_TEST(real_failure_after_switch_still_retries)
+{
+    xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    xn_steps_add_ap(SSID_B, PASSWORD, -55);
+    s_manager = xn_steps_manager_start();
+    xn_steps_manager_connect(s_manager, SSID_A, PASSWORD);
+
+    // 旧连接的事件被忽略后，新尝试自己的失败仍按重试处理
+    sim_wifi_fail_next(1, WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT);
+    xn_steps_manager_connect(s_manager, SSID_B, PASSWORD);
+
+    xn_wifi_snapshot_t snapshot;
+    XN_ASSERT_OK(xn_wifi_manager_get_snapshot(s_manager, &snapshot));
+    XN_ASSERT_EQ(snapshot.reconnect_count, 1);
+}
+
+XN_TEST(reconnect_keeps_pmk_and_ap_hint)
+{
+    xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    s_manager = xn_steps_manager_start();
+    xn_steps_manager_connect(s_manager, SSID_A, PASSWORD);
+
+    // 已连接时按PMK和缓存的AP重新连接（例如应用层重新下发同一网络）
+    xn_wifi_cred_t cred;
+    XN_ASSERT_OK(xn_wifi_manager_get_connected_cred(s_manager, &cred));
+    XN_ASSERT(cred.pmk_valid);
+    xn_wifi_lease_t lease;
+    XN_ASSERT_OK(xn_wifi_manager_get_lease(s_manager, &lease, NULL));
+
+    sim_wifi_stats_t before;
+    sim_wifi_get_stats(&before);
+    int64_t start = sim_now_us();
+    XN_ASSERT_OK(xn_wifi_manager_connect_lease(s_manager, &cred, &lease, 0));
+    XN_ASSERT(xn_steps_manager_wait_ip(s_manager, 20000));
+    uint32_t elapsed = (uint32_t)((sim_now_us() - start) / 1000);
+
+    // 断开旧连接的事件不能作废PMK、丢掉直连提示：只有一次尝试，且用PMK直连
+    sim_wifi_stats_t after;
+    sim_wifi_get_stats(&after);
+    XN_ASSERT_EQ(after.attempts - before.attempts, 1);
+    XN_ASSERT_EQ(after.pmk_connects - before.pmk_connects, 1);
+    XN_ASSERT_EQ(after.direct_connects - before.direct_connects, 1);
+    XN_ASSERT(elapsed < CONNECT_MS);
+
+    wifi_sta_config_t config;
+    sim_wifi_get_sta_config(&config);
+    XN_ASSERT(config.bssid_set);
+    XN_ASSERT(memcmp(config.bssid, lease.bssid, sizeof(lease.bssid)) == 0);
+
+    // PMK仍有效，取凭据时不需要重新计算PBKDF2
+    sim_crypto_stats_t crypto_before, crypto_after;
+    sim_crypto_get_stats(&crypto_before);
+    xn_wifi_cred_t connected;
+    XN_ASSERT_OK(xn_wifi_manager_get_connected_cred(s_manager, &connected));
+    XN_ASSERT(connected.pmk_valid);
+    sim_crypto_get_stats(&crypto_after);
+    XN_ASSERT_EQ(crypto_after.pbkdf2_calls - crypto_before.pbkdf2_calls, 0);
+}
+
+XN_TEST(lease_read_in_tcpip_context)
+{
+    sim_ap_t ap = {
+        .ssid = SSID_A, .password = PASSWORD, .authmode = WIFI_AUTH_WPA2_PSK,
+        .channel = 6, .bssid = { 0x02, 0x11, 0x22, 0x33, 0x44, 0x55 },
+        .rssi = -50, .lease_s = 3600, .online = true,
+    };
+    sim_wifi_add_ap(&ap);
+    s_manager = xn_steps_manager_start();
+    xn_steps_manager_connect(s_manager, SSID_A, PASSWORD);
+
+    // 租期取自DHCP客户端，且只在TCP/IP任务中读取lwIP状态
+    xn_wifi_lease_t lease;
+    XN_ASSERT_OK(xn_wifi_manager_get_lease(s_manager, &lease, NULL));
+    XN_ASSERT_EQ(lease.lease_s, 3600);
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT_EQ(stats.dhcp_unlocked_reads, 0);
+}
+
+/* 慢速订阅者：回调中睡眠，模拟回调执行期间被其他任务抢占 */
+typedef struct {
+    uint32_t calls;
+    bool in_callback;
+    int sub_id;
+    bool unsubscribe_self;
+} slow_sub_t;
+
+static void slow_sub_cb(xn_wifi_event_t event, void *user_ctx)
+{
+    slow_sub_t *ctx = (slow_sub_t *)user_ctx;
+    ctx->in_callback = true;
+    ctx->calls++;
+    vTaskDelay(pdMS_TO_TICKS(100));
+    ctx->in_callback = false;
+    if (ctx->unsubscribe_self) {
+        XN_ASSERT_OK(xn_wifi_manager_unsubscribe(s_manager, ctx->sub_id));
+    }
+}
+
+XN_TEST(unsubscribe_waits_for_running_callback)
+{
+    xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    s_manager = xn_steps_manager_start();
+
+    slow_sub_t *ctx = calloc(1, sizeof(*ctx));
+    XN_ASSERT_OK(xn_wifi_manager_subscribe(s_manager, slow_sub_cb, ctx, XN_WIFI_EVENT_MASK_STATUS, &ctx->sub_id));
+
+    xn_wifi_cred_t cred;
+    XN_ASSERT_OK(xn_wifi_cred_from_str(&cred, SSID_A, PASSWORD));
+    XN_ASSERT_OK(xn_wifi_manager_connect_cred(s_manager, &cred));
+    sim_run_ms(10);
+    XN_ASSERT(ctx->in_callback);
+
+    // 回调执行中取消订阅：返回时回调已结束，之后可以立即释放上下文
+    int64_t start = sim_now_us();
+    XN_ASSERT_OK(xn_wifi_manager_unsubscribe(s_manager, ctx->sub_id));
+    XN_ASSERT(!ctx->in_callback);
+    XN_ASSERT_RANGE((sim_now_us() - start) / 1000, 80, 100);
+    XN_ASSERT_EQ(ctx->calls, 1);
+    free(ctx);
+
+    // 槽位可以重新使用，后续事件不再投递给已取消的订阅者
+    XN_ASSERT(xn_steps_manager_wait_ip(s_manager, 20000));
+    XN_ASSERT_EQ(xn_wifi_manager_unsubscribe(s_manager, 0), ESP_ERR_NOT_FOUND);
+}
+
+XN_TEST(unsubscribe_from_own_callback)
+{
+    xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    s_manager = xn_steps_manager_start();
+
+    // 回调中取消自己的订阅不等待自己（否则投递任务死锁）
+    slow_sub_t ctx = { .unsubscribe_self = true };
+    XN_ASSERT_OK(xn_wifi_manager_subscribe(s_manager, slow_sub_cb, &ctx, XN_WIFI_EVENT_MASK_STATUS, &ctx.sub_id));
+    xn_steps_manager_connect(s_manager, SSID_A, PASSWORD);
+    XN_ASSERT_EQ(ctx.calls, 1);
+}
+
+/* 记录收到的事件及时间 */
+typedef struct {
+    xn_wifi_event_t events[8];
+    int64_t times_us[8];
+    uint32_t count;
+    uint32_t block_ms;
+} record_sub_t;
+
+static void record_sub_cb(xn_wifi_event_t event, void *user_ctx)
+{
+    record_sub_t *ctx = (record_sub_t *)user_ctx;
+    if (ctx->count < 8) {
+        ctx->events[ctx->count] = event;
+        ctx->times_us[ctx->count] = sim_now_us();
+    }
+    ctx->count++;
+    if (ctx->block_ms) {
+        vTaskDelay(pdMS_TO_TICKS(ctx->block_ms));
+    }
+}
+
+XN_TEST(blocking_callback_does_not_delay_others)
+{
+    xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    s_manager = xn_steps_manager_start();
+
+    // 每个事件阻塞2秒的订阅者排在前面，不能拖住状态机和后面的订阅者
+    static record_sub_t slow = { .block_ms = 2000 };
+    static record_sub_t fast;
+    int slow_id, fast_id;
+    XN_ASSERT_OK(xn_wifi_manager_subscribe(s_manager, record_sub_cb, &slow, XN_WIFI_EVENT_MASK_STATUS, &slow_id));
+    XN_ASSERT_OK(xn_wifi_manager_subscribe(s_manager, record_sub_cb, &fast, XN_WIFI_EVENT_MASK_STATUS, &fast_id));
+
+    int64_t start = sim_now_us();
+    uint32_t elapsed = xn_steps_manager_connect(s_manager, SSID_A, PASSWORD);
+    XN_ASSERT_RANGE(elapsed, CONNECT_MS, CONNECT_MS + 50);
+
+    // 快速订阅者按时收到全部事件，GOT_IP与获取IP同时到达
+    XN_ASSERT_EQ(fast.count, 3);
+    XN_ASSERT_EQ(fast.events[0], XN_WIFI_EVENT_CONNECTING);
+    XN_ASSERT_EQ(fast.events[1], XN_WIFI_EVENT_CONNECTED);
+    XN_ASSERT_EQ(fast.events[2], XN_WIFI_EVENT_GOT_IP);
+    XN_ASSERT_RANGE((fast.times_us[2] - start) / 1000, CONNECT_MS, elapsed);
+    XN_ASSERT_EQ(slow.count, 1);
+
+    // 慢速订阅者之后按顺序收到全部事件，没有丢弃
+    sim_run_ms(3 * 2000);
+    XN_ASSERT_EQ(slow.count, 3);
+    XN_ASSERT_EQ(slow.events[0], XN_WIFI_EVENT_CONNECTING);
+    XN_ASSERT_EQ(slow.events[1], XN_WIFI_EVENT_CONNECTED);
+    XN_ASSERT_EQ(slow.events[2], XN_WIFI_EVENT_GOT_IP);
+    XN_ASSERT_RANGE((slow.times_us[2] - slow.times_us[0]) / 1000, 4000, 4010);
+    XN_ASSERT_EQ(xn_wifi_manager_get_dropped_events(s_manager, slow_id), 0);
+    XN_ASSERT_EQ(xn_wifi_manager_get_dropped_events(s_manager, fast_id), 0);
+    XN_ASSERT_EQ(fast.count, 3);
+}
+
+XN_TEST(unsubscribe_queue_then_delete)
+{
+    xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    s_manager = xn_steps_manager_start();
+
+    QueueHandle_t queue = xQueueCreate(1, sizeof(xn_wifi_event_t));
+    int sub_id;
+    XN_ASSERT_OK(xn_wifi_manager_subscribe_queue(s_manager, queue, XN_WIFI_EVENT_MASK_STATUS, &sub_id));
+    xn_wifi_cred_t cred;
+    XN_ASSERT_OK(xn_wifi_cred_from_str(&cred, SSID_A, PASSWORD));
+    XN_ASSERT_OK(xn_wifi_manager_connect_cred(s_manager, &cred));
+    sim_run_ms(10);
+
+    // 取消后立即删除队列，后续状态变化不再投递
+    XN_ASSERT_OK(xn_wifi_manager_unsubscribe(s_manager, sub_id));
+    vQueueDelete(queue);
+    XN_ASSERT(xn_steps_manager_wait_ip(s_manager, 20000));
+    XN_ASSERT_EQ(xn_wifi_manager_get_dropped_events(s_manager, sub_id), 0);
+}
+
+/* 阻塞等待接口：在测试任务中调用，经过的仿真时间即等待时间 */
+static uint32_t elapsed_ms(int64_t start_us)
+{
+    return (uint32_t)((sim_now_us() - start_us) / 1000);
+}
+
+XN_TEST(wait_for_ip_and_disconnect)
+{
+    xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    s_manager = xn_steps_manager_start();
+
+    // 初始化后未连接：等待IP超时，超时时间按实际经过
+    int64_t start = sim_now_us();
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_ip(s_manager, pdMS_TO_TICKS(200)), ESP_ERR_TIMEOUT);
+    XN_ASSERT_RANGE(elapsed_ms(start), 200, 201);
+
+    // 发起连接后阻塞到获取IP，耗时与完整连接一致
+    xn_wifi_cred_t cred;
+    XN_ASSERT_OK(xn_wifi_cred_from_str(&cred, SSID_A, PASSWORD));
+    start = sim_now_us();
+    XN_ASSERT_OK(xn_wifi_manager_connect_cred(s_manager, &cred));
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_disconnect(s_manager, 0), ESP_ERR_TIMEOUT);
+    XN_ASSERT_OK(xn_wifi_manager_wait_for_ip(s_manager, portMAX_DELAY));
+    XN_ASSERT_RANGE(elapsed_ms(start), CONNECT_MS, CONNECT_MS + 50);
+    XN_ASSERT_EQ(xn_wifi_manager_get_status(s_manager), XN_WIFI_GOT_IP);
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_disconnect(s_manager, 0), ESP_ERR_TIMEOUT);
+
+    // 主动断开：等待断开立即返回，IP位同时清除
+    XN_ASSERT_OK(xn_wifi_manager_disconnect(s_manager));
+    XN_ASSERT_OK(xn_wifi_manager_wait_for_disconnect(s_manager, pdMS_TO_TICKS(1000)));
+    XN_ASSERT_EQ(xn_wifi_manager_get_status(s_manager), XN_WIFI_DISCONNECTED);
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_ip(s_manager, 0), ESP_ERR_TIMEOUT);
+
+    // 重新连接时清除旧的断开状态，等待者不会读到过期结果
+    XN_ASSERT_OK(xn_wifi_manager_connect_cred(s_manager, &cred));
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_disconnect(s_manager, 0), ESP_ERR_TIMEOUT);
+    XN_ASSERT_OK(xn_wifi_manager_wait_for_ip(s_manager, pdMS_TO_TICKS(20000)));
+}
+
+XN_TEST(wait_for_disconnect_after_retries_exhausted)
+{
+    int ap = xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    sim_wifi_set_online(ap, false);
+    s_manager = xn_steps_manager_start();
+
+    xn_wifi_cred_t cred;
+    XN_ASSERT_OK(xn_wifi_cred_from_str(&cred, SSID_A, PASSWORD));
+    XN_ASSERT_OK(xn_wifi_manager_connect_cred(s_manager, &cred));
+
+    // 重连期间不算断开，次数用尽后等待断开返回，等待IP一直超时
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_disconnect(s_manager, pdMS_TO_TICKS(CONNECT_MS)), ESP_ERR_TIMEOUT);
+    XN_ASSERT_OK(xn_wifi_manager_wait_for_disconnect(s_manager, pdMS_TO_TICKS(120000)));
+    XN_ASSERT_EQ(xn_wifi_manager_get_status(s_manager), XN_WIFI_DISCONNECTED);
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_ip(s_manager, 0), ESP_ERR_TIMEOUT);
+
+    sim_wifi_stats_t stats;
+    sim_wifi_get_stats(&stats);
+    XN_ASSERT(stats.attempts > 1);
+}
+
+static uint32_t s_scan_callbacks;
+
+static void count_scan_cb(uint16_t ap_count, wifi_ap_record_t *ap_list)
+{
+    (void)ap_count;
+    (void)ap_list;
+    s_scan_callbacks++;
+}
+
+XN_TEST(wait_for_scan_done)
+{
+    xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    s_manager = xn_steps_manager_start();
+
+    // 没有扫描进行中时立即返回
+    XN_ASSERT_OK(xn_wifi_manager_wait_for_scan_done(s_manager, 0));
+
+    // 扫描期间等待超时，扫描回调执行完毕后返回
+    int64_t start = sim_now_us();
+    XN_ASSERT_OK(xn_wifi_manager_scan(s_manager, count_scan_cb));
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_scan_done(s_manager, 0), ESP_ERR_TIMEOUT);
+    XN_ASSERT_OK(xn_wifi_manager_wait_for_scan_done(s_manager, portMAX_DELAY));
+    XN_ASSERT_EQ(s_scan_callbacks, 1);
+    XN_ASSERT_RANGE(elapsed_ms(start), 1500, 1550);
+    XN_ASSERT_OK(xn_wifi_manager_wait_for_scan_done(s_manager, 0));
+}
+
+XN_TEST(wait_apis_reject_bad_state)
+{
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_ip(NULL, 0), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_disconnect(NULL, 0), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_scan_done(NULL, 0), ESP_ERR_INVALID_ARG);
+
+    // 事件组在初始化时创建，初始化前等待返回状态错误而不是一直阻塞
+    XN_ASSERT_OK(nvs_flash_init());
+    xn_wifi_manager_t *manager = xn_wifi_manager_create();
+    XN_ASSERT(manager != NULL);
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_ip(manager, portMAX_DELAY), ESP_ERR_INVALID_STATE);
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_disconnect(manager, portMAX_DELAY), ESP_ERR_INVALID_STATE);
+    XN_ASSERT_EQ(xn_wifi_manager_wait_for_scan_done(manager, portMAX_DELAY), ESP_ERR_INVALID_STATE);
+    xn_wifi_manager_destroy(manager);
+}
+
+/* 预置档位应当下发给驱动的设置 */
+typedef struct {
+    xn_wifi_profile_id_t id;
+    wifi_ps_type_t ps_type;
+    wifi_bandwidth_t bandwidth;
+    int8_t tx_power;
+    uint16_t listen_interval;
+} profile_expect_t;
+
+static const profile_expect_t s_profile_expect[] = {
+    { XN_WIFI_PROFILE_MAX_THROUGHPUT, WIFI_PS_NONE, WIFI_BW_HT40, 84, 0 },
+    { XN_WIFI_PROFILE_BALANCED, WIFI_PS_MIN_MODEM, WIFI_BW_HT20, 84, 3 },
+    { XN_WIFI_PROFILE_LOW_POWER, WIFI_PS_MAX_MODEM, WIFI_BW_HT20, 52, 10 },
+};
+
+/* 检查驱动中生效的设置，以及get_profile_info()报告的值 */
+static void assert_profile_applied(const profile_expect_t *expect)
+{
+    wifi_ps_type_t ps;
+    wifi_bandwidth_t bw;
+    int8_t tx_power;
+    XN_ASSERT_OK(esp_wifi_get_ps(&ps));
+    XN_ASSERT_OK(esp_wifi_get_bandwidth(WIFI_IF_STA, &bw));
+    XN_ASSERT_OK(esp_wifi_get_max_tx_power(&tx_power));
+    XN_ASSERT_EQ(ps, expect->ps_type);
+    XN_ASSERT_EQ(bw, expect->bandwidth);
+    XN_ASSERT_EQ(tx_power, expect->tx_power);
+
+    xn_wifi_profile_info_t info;
+    XN_ASSERT_OK(xn_wifi_manager_get_profile_info(s_manager, &info));
+    XN_ASSERT_EQ(info.id, expect->id);
+    XN_ASSERT_EQ(info.ps_type, expect->ps_type);
+    XN_ASSERT_EQ(info.bandwidth, expect->bandwidth);
+    XN_ASSERT_EQ(info.tx_power, expect->tx_power);
+    XN_ASSERT_EQ(info.config.listen_interval, expect->listen_interval);
+}
+
+XN_TEST(profiles_apply_ps_bandwidth_tx_power)
+{
+    xn_steps_add_ap(SSID_A, PASSWORD, -50);
+    s_manager = xn_steps_manager_start();
+
+    // 默认档位在初始化时下发
+    assert_profile_applied(&s_profile_expect[XN_WIFI_PROFILE_BALANCED]);
+
+    // 运行时切换：省电模式、带宽、发射功率立即生效，监听间隔在下次关联时写入站点配置
+    for (size_t i = 0; i < sizeof(s_profile_expect) / sizeof(s_profile_expect[0]); i++) {
+        const profile_expect_t *expect = &s_profile_expect[i];
+        XN_ASSERT_OK(xn_wifi_manager_set_profile(s_manager, expect->id));
+        sim_run_ms(10);
+        assert_profile_applied(expect);
+
+        xn_steps_manager_connect(s_manager, SSID_A, PASSWORD);
+        wifi_sta_config_t config;
+        sim_wifi_get_sta_config(&config);
+        XN_ASSERT_EQ(config.listen_interval, expect->listen_interval);
+        assert_profile_applied(expect);
+    }
+
+    XN_ASSERT_EQ(xn_wifi_manager_set_profile(s_manager, XN_WIFI_PROFILE_CUSTOM), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_EQ(xn_wifi_manager_set_profile(NULL, XN_WIFI_PROFILE_BALANCED), ESP_ERR_INVALID_ARG);
+}
+
+XN_TEST(custom_profile_applied_and_validated)
+{
+    s_manager = xn_steps_manager_start();
+
+    xn_wifi_profile_t custom = {
+        .ps_type = WIFI_PS_MAX_MODEM,
+        .listen_interval = 5,
+        .bandwidth = WIFI_BW_HT40,
+        .protocol = WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N,
+        .max_tx_power = 40,
+    };
+    XN_ASSERT_OK(xn_wifi_manager_set_custom_profile(s_manager, &custom));
+    sim_run_ms(10);
+    const profile_expect_t expect = { XN_WIFI_PROFILE_CUSTOM, WIFI_PS_MAX_MODEM, WIFI_BW_HT40, 40, 5 };
+    assert_profile_applied(&expect);
+
+    // 非法参数不改变当前设置
+    xn_wifi_profile_t bad = custom;
+    bad.max_tx_power = 100;
+    XN_ASSERT_EQ(xn_wifi_manager_set_custom_profile(s_manager, &bad), ESP_ERR_INVALID_ARG);
+    bad = custom;
+    bad.protocol = WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G;
+    XN_ASSERT_EQ(xn_wifi_manager_set_custom_profile(s_manager, &bad), ESP_ERR_INVALID_ARG);
+    bad = custom;
+    bad.bandwidth = (wifi_bandwidth_t)7;
+    XN_ASSERT_EQ(xn_wifi_manager_set_custom_profile(s_manager, &bad), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_EQ(xn_wifi_manager_set_custom_profile(s_manager, NULL), ESP_ERR_INVALID_ARG);
+    sim_run_ms(10);
+    assert_profile_applied(&expect);
+}
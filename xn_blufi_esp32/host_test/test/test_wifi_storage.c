@@ -0,0 +1,444 @@
+/*
+ * @Description: WiFi配置存储 - 按原始字节（带长度）的SSID查找、优先级和连接记录，
+ * 连接优先顺序和满额淘汰，未变化配置的写入跳过和写入统计，以及写入中途失败后A/B槽位的恢复
+ */
+
+#include "xn_steps.h"
+#include "xn_wifi_storage.h"
+#include "nvs_flash.h"
+#include <sys/mman.h>
+
+#define PASSWORD    "correct-horse"
+
+/* "ab\0cd"和"ab"：按C字符串比较时是同一个网络 */
+static const uint8_t SSID_NUL[] = { 'a', 'b', 0, 'c', 'd' };
+static const uint8_t SSID_SHORT[] = { 'a', 'b' };
+
+static void storage_start(void)
+{
+    XN_ASSERT_OK(nvs_flash_init());
+    XN_ASSERT_OK(xn_wifi_storage_init());
+}
+
+static void save_raw(const uint8_t *ssid, size_t ssid_len)
+{
+    xn_wifi_cred_t cred;
+    XN_ASSERT_OK(xn_wifi_cred_set(&cred, ssid, ssid_len, (const uint8_t *)PASSWORD, strlen(PASSWORD)));
+    XN_ASSERT_OK(xn_wifi_storage_save_cred(&cred));
+}
+
+/* 按SSID字节查找已加载的配置，没有返回NULL */
+static const xn_wifi_config_t *find_config(const xn_wifi_config_t *configs, uint8_t count,
+                                           const uint8_t *ssid, uint8_t ssid_len)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        if (configs[i].ssid_len == ssid_len && memcmp(configs[i].ssid, ssid, ssid_len) == 0) {
+            return &configs[i];
+        }
+    }
+    return NULL;
+}
+
+XN_TEST(mark_connected_uses_ssid_length)
+{
+    storage_start();
+    save_raw(SSID_NUL, sizeof(SSID_NUL));
+    save_raw(SSID_SHORT, sizeof(SSID_SHORT));
+
+    XN_ASSERT_OK(xn_wifi_storage_mark_connected(SSID_NUL, sizeof(SSID_NUL)));
+
+    xn_wifi_config_t configs[4];
+    uint8_t count = 0;
+    XN_ASSERT_OK(xn_wifi_storage_load_all(configs, &count, 4));
+    XN_ASSERT_EQ(count, 2);
+    XN_ASSERT_EQ(find_config(configs, count, SSID_NUL, sizeof(SSID_NUL))->success_count, 1);
+    XN_ASSERT_EQ(find_config(configs, count, SSID_SHORT, sizeof(SSID_SHORT))->success_count, 0);
+
+    // 最近连接的网络排在前面
+    XN_ASSERT_EQ(configs[0].ssid_len, sizeof(SSID_NUL));
+}
+
+XN_TEST(set_priority_uses_ssid_length)
+{
+    storage_start();
+    save_raw(SSID_NUL, sizeof(SSID_NUL));
+    save_raw(SSID_SHORT, sizeof(SSID_SHORT));
+
+    XN_ASSERT_OK(xn_wifi_storage_set_priority(SSID_NUL, sizeof(SSID_NUL), 200));
+
+    xn_wifi_config_t configs[4];
+    uint8_t count = 0;
+    XN_ASSERT_OK(xn_wifi_storage_load_all(configs, &count, 4));
+    XN_ASSERT_EQ(find_config(configs, count, SSID_NUL, sizeof(SSID_NUL))->priority, 200);
+    XN_ASSERT_EQ(find_config(configs, count, SSID_SHORT, sizeof(SSID_SHORT))->priority,
+                 XN_WIFI_PRIORITY_DEFAULT);
+
+    // 前缀相同但长度不同的SSID不是同一个网络
+    XN_ASSERT_EQ(xn_wifi_storage_set_priority((const uint8_t *)"abc", 3, 10), ESP_ERR_NOT_FOUND);
+}
+
+XN_TEST(ssid_length_out_of_range_rejected)
+{
+    storage_start();
+    save_raw(SSID_SHORT, sizeof(SSID_SHORT));
+
+    uint8_t long_ssid[XN_WIFI_SSID_MAX_LEN + 1] = { 'a', 'b' };
+    XN_ASSERT_EQ(xn_wifi_storage_mark_connected(SSID_SHORT, 0), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_EQ(xn_wifi_storage_mark_connected(long_ssid, sizeof(long_ssid)), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_EQ(xn_wifi_storage_mark_connected(NULL, 2), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_EQ(xn_wifi_storage_set_priority(SSID_SHORT, 0, 1), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_EQ(xn_wifi_storage_set_priority(long_ssid, sizeof(long_ssid), 1), ESP_ERR_INVALID_ARG);
+}
+
+/* ==================== 连接优先顺序 ==================== */
+
+static void save_str(const char *ssid)
+{
+    save_raw((const uint8_t *)ssid, strlen(ssid));
+}
+
+/* 按连接优先顺序列出SSID，以','分隔 */
+static const char *order_str(void)
+{
+    static char buf[128];
+    xn_wifi_config_t configs[10];
+    uint8_t count = 0;
+    XN_ASSERT_OK(xn_wifi_storage_load_all(configs, &count, 10));
+    buf[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        strncat(buf, i ? "," : "", sizeof(buf) - strlen(buf) - 1);
+        strncat(buf, (const char *)configs[i].ssid, sizeof(buf) - strlen(buf) - 1);
+    }
+    return buf;
+}
+
+#define XN_ASSERT_ORDER(expected)                                                   \
+    do {                                                                            \
+        const char *xn_order_ = order_str();                                        \
+        if (strcmp(xn_order_, expected) != 0) {                                     \
+            XN_FAIL("order %s, expected %s", xn_order_, expected);                  \
+        }                                                                           \
+    } while (0)
+
+static void mark_str(const char *ssid)
+{
+    XN_ASSERT_OK(xn_wifi_storage_mark_connected((const uint8_t *)ssid, strlen(ssid)));
+}
+
+XN_TEST(order_by_priority_then_recency)
+{
+    storage_start();
+    save_str("a");
+    save_str("b");
+    save_str("c");
+
+    // 同优先级：最近保存/连接的在前
+    XN_ASSERT_ORDER("c,b,a");
+    mark_str("a");
+    XN_ASSERT_ORDER("a,c,b");
+
+    // 用户优先级高于最近连接
+    XN_ASSERT_OK(xn_wifi_storage_set_priority((const uint8_t *)"b", 1, 200));
+    XN_ASSERT_ORDER("b,a,c");
+    mark_str("c");
+    XN_ASSERT_ORDER("b,c,a");
+
+    // load()返回最优先的配置，顺序在重新加载后保持不变
+    xn_wifi_config_t first;
+    XN_ASSERT_OK(xn_wifi_storage_load(&first));
+    XN_ASSERT(strcmp((const char *)first.ssid, "b") == 0);
+    XN_ASSERT_OK(xn_wifi_storage_init());
+    XN_ASSERT_ORDER("b,c,a");
+
+    // 删除索引按连接优先顺序计算
+    XN_ASSERT_OK(xn_wifi_storage_delete_by_index(1));
+    XN_ASSERT_ORDER("b,a");
+}
+
+XN_TEST(full_list_evicts_least_preferred)
+{
+    storage_start();
+    const char *names[10] = { "n0", "n1", "n2", "n3", "n4", "n5", "n6", "n7", "n8", "n9" };
+    for (int i = 0; i < 10; i++) {
+        save_str(names[i]);
+    }
+    // 最早保存的n0设了高优先级，n1最近连接过：淘汰的应是n2（默认优先级中最久未连接的）
+    XN_ASSERT_OK(xn_wifi_storage_set_priority((const uint8_t *)"n0", 2, 200));
+    mark_str("n1");
+
+    save_str("new");
+    XN_ASSERT_ORDER("n0,new,n1,n9,n8,n7,n6,n5,n4,n3");
+
+    // 新保存的配置视为最近使用，下一条新配置淘汰的是n3而不是它
+    save_str("newer");
+    XN_ASSERT_ORDER("n0,newer,new,n1,n9,n8,n7,n6,n5,n4");
+}
+
+XN_TEST(repeat_connections_batch_metadata_writes)
+{
+    storage_start();
+    save_str("a");
+    save_str("b");
+
+    // 连接到不是最近的网络：排序变化，立即落盘
+    xn_wifi_storage_stats_t before, after;
+    XN_ASSERT_OK(xn_wifi_storage_get_stats(&before));
+    mark_str("a");
+    XN_ASSERT_OK(xn_wifi_storage_get_stats(&after));
+    XN_ASSERT_EQ(after.commits - before.commits, 1);
+
+    // 反复连接同一网络：排序不变，累计16次才写一次
+    for (int i = 0; i < 15; i++) {
+        mark_str("a");
+    }
+    XN_ASSERT_OK(xn_wifi_storage_get_stats(&before));
+    XN_ASSERT_EQ(before.commits, after.commits);
+    mark_str("a");
+    XN_ASSERT_OK(xn_wifi_storage_get_stats(&after));
+    XN_ASSERT_EQ(after.commits - before.commits, 1);
+
+    xn_wifi_config_t configs[2];
+    uint8_t count = 0;
+    XN_ASSERT_OK(xn_wifi_storage_init());
+    XN_ASSERT_OK(xn_wifi_storage_load_all(configs, &count, 2));
+    XN_ASSERT_EQ(configs[0].success_count, 17);
+}
+
+/* 保存一次，返回统计和NVS写操作数的增量 */
+static uint32_t save_delta(const xn_wifi_cred_t *cred, xn_wifi_storage_stats_t *delta)
+{
+    xn_wifi_storage_stats_t before, after;
+    XN_ASSERT_OK(xn_wifi_storage_get_stats(&before));
+    uint32_t ops = sim_nvs_write_ops();
+    XN_ASSERT_OK(xn_wifi_storage_save_cred(cred));
+    XN_ASSERT_OK(xn_wifi_storage_get_stats(&after));
+    delta->save_requests = after.save_requests - before.save_requests;
+    delta->save_skipped = after.save_skipped - before.save_skipped;
+    delta->key_writes = after.key_writes - before.key_writes;
+    delta->commits = after.commits - before.commits;
+    return sim_nvs_write_ops() - ops;
+}
+
+XN_TEST(unchanged_save_skips_flash)
+{
+    storage_start();
+    xn_wifi_cred_t cred;
+    XN_ASSERT_OK(xn_wifi_cred_from_str(&cred, "a", PASSWORD));
+    xn_wifi_storage_stats_t delta;
+
+    // 新配置：写入并提交一次，统计的键写入和提交与NVS实际写操作一致
+    uint32_t ops = save_delta(&cred, &delta);
+    XN_ASSERT_EQ(delta.save_requests, 1);
+    XN_ASSERT_EQ(delta.save_skipped, 0);
+    XN_ASSERT_EQ(delta.commits, 1);
+    XN_ASSERT(delta.key_writes > 0);
+    XN_ASSERT_EQ(ops, delta.key_writes + delta.commits);
+
+    // 重连后再次保存相同的凭据：不写Flash
+    ops = save_delta(&cred, &delta);
+    XN_ASSERT_EQ(delta.save_requests, 1);
+    XN_ASSERT_EQ(delta.save_skipped, 1);
+    XN_ASSERT_EQ(delta.key_writes, 0);
+    XN_ASSERT_EQ(delta.commits, 0);
+    XN_ASSERT_EQ(ops, 0);
+
+    // 首次带上PMK：需要补写；同一PMK再次保存则跳过
+    memset(cred.pmk, 0x5A, sizeof(cred.pmk));
+    cred.pmk_valid = true;
+    ops = save_delta(&cred, &delta);
+    XN_ASSERT_EQ(delta.save_skipped, 0);
+    XN_ASSERT_EQ(delta.commits, 1);
+    XN_ASSERT_EQ(ops, delta.key_writes + delta.commits);
+    ops = save_delta(&cred, &delta);
+    XN_ASSERT_EQ(delta.save_skipped, 1);
+    XN_ASSERT_EQ(ops, 0);
+
+    // 不带PMK保存同一密码不会丢掉已存的PMK，也不写Flash
+    cred.pmk_valid = false;
+    ops = save_delta(&cred, &delta);
+    XN_ASSERT_EQ(delta.save_skipped, 1);
+    XN_ASSERT_EQ(ops, 0);
+
+    // 密码变化：写入，旧PMK作废
+    XN_ASSERT_OK(xn_wifi_cred_from_str(&cred, "a", "new-password"));
+    ops = save_delta(&cred, &delta);
+    XN_ASSERT_EQ(delta.save_skipped, 0);
+    XN_ASSERT_EQ(delta.commits, 1);
+    XN_ASSERT(ops > 0);
+
+    xn_wifi_config_t configs[1];
+    uint8_t count = 0;
+    XN_ASSERT_OK(xn_wifi_storage_init());
+    XN_ASSERT_OK(xn_wifi_storage_load_all(configs, &count, 1));
+    XN_ASSERT_EQ(count, 1);
+    XN_ASSERT(strcmp(configs[0].password, "new-password") == 0);
+    XN_ASSERT(!configs[0].pmk_valid);
+}
+
+XN_TEST(save_counters_track_requests)
+{
+    storage_start();
+    xn_wifi_storage_stats_t stats;
+    XN_ASSERT_OK(xn_wifi_storage_get_stats(&stats));
+    XN_ASSERT_EQ(stats.save_requests, 0);
+    XN_ASSERT_EQ(stats.save_skipped, 0);
+
+    // 每次请求都计数，无效参数不计数；跳过比例即写放大的节省
+    save_str("a");
+    save_str("b");
+    save_str("a");
+    save_str("a");
+    XN_ASSERT_EQ(xn_wifi_storage_save_cred(NULL), ESP_ERR_INVALID_ARG);
+    XN_ASSERT_OK(xn_wifi_storage_get_stats(&stats));
+    XN_ASSERT_EQ(stats.save_requests, 4);
+    XN_ASSERT_EQ(stats.save_skipped, 2);
+    XN_ASSERT_EQ(stats.commits, 2);
+    XN_ASSERT_EQ(xn_wifi_storage_get_stats(NULL), ESP_ERR_INVALID_ARG);
+}
+
+/* ==================== 写入中途失败（掉电/Flash故障） ==================== */
+
+/* 存储内容的快照：按连接优先顺序的全部配置 */
+typedef struct {
+    uint8_t count;
+    xn_wifi_config_t configs[10];
+} list_snapshot_t;
+
+/* 父子进程共享的故障注入状态 */
+typedef struct {
+    esp_err_t (*op)(void);
+    uint32_t fail_at;               // 第几次写操作起失败，0为不注入
+    uint32_t op_writes;             // 无故障时操作的写次数
+    list_snapshot_t before;         // 操作前
+    list_snapshot_t after;          // 操作成功后
+} fault_run_t;
+
+static fault_run_t *s_fault;
+
+static void take_snapshot(list_snapshot_t *snapshot)
+{
+    memset(snapshot, 0, sizeof(*snapshot));
+    XN_ASSERT_OK(xn_wifi_storage_load_all(snapshot->configs, &snapshot->count, 10));
+}
+
+static bool snapshot_equal(const list_snapshot_t *a, const list_snapshot_t *b)
+{
+    if (a->count != b->count) {
+        return false;
+    }
+    for (int i = 0; i < a->count; i++) {
+        const xn_wifi_config_t *x = &a->configs[i];
+        const xn_wifi_config_t *y = &b->configs[i];
+        if (x->ssid_len != y->ssid_len || memcmp(x->ssid, y->ssid, x->ssid_len) != 0 ||
+            x->password_len != y->password_len || memcmp(x->password, y->password, x->password_len) != 0 ||
+            x->priority != y->priority || x->last_connected != y->last_connected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* 三次写入后两个槽位都有数据：当前槽位slot0为[b(150),a]，slot1是上一版[b,a] */
+static void fault_seed(void)
+{
+    storage_start();
+    save_raw((const uint8_t *)"net-a", 5);
+    save_raw((const uint8_t *)"net-b", 5);
+    XN_ASSERT_OK(xn_wifi_storage_set_priority((const uint8_t *)"net-b", 5, 150));
+}
+
+/* 无故障运行一次，记录操作前后的内容和写次数 */
+static void fault_reference(void)
+{
+    fault_seed();
+    take_snapshot(&s_fault->before);
+    uint32_t writes = sim_nvs_write_ops();
+    XN_ASSERT_OK(s_fault->op());
+    s_fault->op_writes = sim_nvs_write_ops() - writes;
+    take_snapshot(&s_fault->after);
+    XN_ASSERT(!snapshot_equal(&s_fault->before, &s_fault->after));
+}
+
+/* 第fail_at次写起失败：缓存与Flash一致，重新初始化后恢复为完整的操作前或操作后内容 */
+static void fault_inject(void)
+{
+    fault_seed();
+    sim_nvs_fail_after(s_fault->fail_at);
+    esp_err_t ret = s_fault->op();
+    sim_nvs_fail_after(0);
+
+    list_snapshot_t cached, loaded;
+    take_snapshot(&cached);
+    XN_ASSERT_OK(xn_wifi_storage_init());
+    take_snapshot(&loaded);
+
+    bool is_before = snapshot_equal(&loaded, &s_fault->before);
+    bool is_after = snapshot_equal(&loaded, &s_fault->after);
+    if (!is_before && !is_after) {
+        XN_FAIL("write %u failed: reloaded list (%u entries) is neither the old nor the new one",
+                s_fault->fail_at, loaded.count);
+    }
+    XN_ASSERT(snapshot_equal(&cached, &loaded));
+    if (ret == ESP_OK) {
+        XN_ASSERT(is_after);
+    }
+}
+
+/* 对操作的每一次写分别注入故障 */
+static void fault_run_all(esp_err_t (*op)(void))
+{
+    s_fault = mmap(NULL, sizeof(*s_fault), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    XN_ASSERT(s_fault != MAP_FAILED);
+    memset(s_fault, 0, sizeof(*s_fault));
+    s_fault->op = op;
+    XN_ASSERT(xn_test_run_child(fault_reference));
+    XN_ASSERT(s_fault->op_writes > 0);
+    for (uint32_t n = 1; n <= s_fault->op_writes; n++) {
+        s_fault->fail_at = n;
+        XN_ASSERT(xn_test_run_child(fault_inject));
+    }
+}
+
+static esp_err_t op_save_new(void)
+{
+    xn_wifi_cred_t cred;
+    XN_ASSERT_OK(xn_wifi_cred_from_str(&cred, "net-d", PASSWORD));
+    return xn_wifi_storage_save_cred(&cred);
+}
+
+static esp_err_t op_save_update(void)
+{
+    xn_wifi_cred_t cred;
+    XN_ASSERT_OK(xn_wifi_cred_from_str(&cred, "net-a", "new-password"));
+    return xn_wifi_storage_save_cred(&cred);
+}
+
+static esp_err_t op_delete_one(void)
+{
+    return xn_wifi_storage_delete_by_index(0);
+}
+
+static esp_err_t op_delete_all(void)
+{
+    return xn_wifi_storage_delete();
+}
+
+XN_TEST_RAW(write_failure_during_save_new)
+{
+    fault_run_all(op_save_new);
+}
+
+XN_TEST_RAW(write_failure_during_save_update)
+{
+    fault_run_all(op_save_update);
+}
+
+XN_TEST_RAW(write_failure_during_delete_one)
+{
+    fault_run_all(op_delete_one);
+}
+
+XN_TEST_RAW(write_failure_during_delete_all)
+{
+    fault_run_all(op_delete_all);
+}
@@ -0,0 +1,120 @@
+/*
+ * @Description: 场景测试的公共步骤
+ */
+
+#include "xn_steps.h"
+#include "app_blufi.h"
+#include "nvs_flash.h"
+
+int xn_steps_add_ap(const char *ssid, const char *password, int8_t rssi)
+{
+    static uint8_t next = 1;
+    sim_ap_t ap = {
+        .ssid = ssid,
+        .password = password,
+        .authmode = password[0] ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN,
+        .bssid = { 0x02, 0x11, 0x22, 0x33, 0x44, next++ },
+        .channel = 6,
+        .rssi = rssi,
+        .lease_s = 7200,
+        .online = true,
+    };
+    return sim_wifi_add_ap(&ap);
+}
+
+static bool ble_ready(void *arg)
+{
+    sim_ble_state_t state;
+    sim_ble_get_state(&state);
+    return state.blufi_ready && state.adv_active;
+}
+
+void xn_steps_boot(void)
+{
+    XN_ASSERT_OK(app_blufi_init());
+    XN_ASSERT(sim_run_until(ble_ready, NULL, 2000));
+}
+
+xn_blufi_t *xn_steps_boot_component(void)
+{
+    xn_blufi_t *blufi = xn_blufi_create("xn-test");
+    XN_ASSERT(blufi != NULL);
+    XN_ASSERT_OK(xn_blufi_init(blufi));
+    XN_ASSERT(sim_run_until(ble_ready, NULL, 2000));
+    return blufi;
+}
+
+void xn_steps_phone_open(void)
+{
+    sim_phone_connect();
+    sim_ble_state_t state;
+    sim_ble_get_state(&state);
+    XN_ASSERT(state.connected);
+#if CONFIG_XN_BLUFI_SECURITY
+    XN_ASSERT(sim_phone_negotiate());
+#endif
+}
+
+void xn_steps_provision(const char *ssid, const char *password)
+{
+    sim_phone_send_ssid(ssid, strlen(ssid));
+    sim_phone_send_password(password, strlen(password));
+    sim_phone_send_connect();
+}
+
+bool xn_steps_wait_report(esp_blufi_sta_conn_state_t state, sim_msg_t *msg, uint32_t timeout_ms)
+{
+    int64_t deadline = sim_now_us() + (int64_t)timeout_ms * 1000;
+    while (sim_now_us() <= deadline) {
+        uint32_t left = (uint32_t)((deadline - sim_now_us()) / 1000);
+        if (!sim_phone_wait(SIM_MSG_CONN_REPORT, msg, left)) {
+            return false;
+        }
+        if (msg->state == state) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool has_ip(void *arg)
+{
+    return sim_wifi_has_ip();
+}
+
+bool xn_steps_wait_ip(uint32_t timeout_ms)
+{
+    return sim_run_until(has_ip, NULL, timeout_ms);
+}
+
+xn_wifi_manager_t *xn_steps_manager_start(void)
+{
+    XN_ASSERT_OK(nvs_flash_init());
+    xn_wifi_manager_t *manager = xn_wifi_manager_create();
+    XN_ASSERT(manager != NULL);
+    XN_ASSERT_OK(xn_wifi_manager_init(manager));
+    return manager;
+}
+
+static bool manager_got_ip(void *arg)
+{
+    xn_wifi_snapshot_t snapshot;
+    xn_wifi_manager_get_snapshot((xn_wifi_manager_t *)arg, &snapshot);
+    return snapshot.status == XN_WIFI_GOT_IP;
+}
+
+bool xn_steps_manager_wait_ip(xn_wifi_manager_t *manager, uint32_t timeout_ms)
+{
+    sim_run_ms(1);  // 让工作任务先处理命令，状态离开旧连接的GOT_IP
+    return sim_run_until(manager_got_ip, manager, timeout_ms);
+}
+
+uint32_t xn_steps_manager_connect(xn_wifi_manager_t *manager, const char *ssid, const char *password)
+{
+    xn_wifi_cred_t cred;
+    XN_ASSERT_OK(xn_wifi_cred_from_str(&cred, ssid, password));
+    int64_t start = sim_now_us();
+    XN_ASSERT_OK(xn_wifi_manager_connect_cred(manager, &cred));
+    XN_ASSERT(xn_steps_manager_wait_ip(manager, 20000));
+    return (uint32_t)((sim_now_us() - start) / 1000);
+}
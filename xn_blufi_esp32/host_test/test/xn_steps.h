@@ -0,0 +1,39 @@
+/*
+ * @Description: 场景测试的公共步骤 - 启动应用、手机连接协商、下发配网信息、等待上报
+ */
+
+#pragma once
+
+#include "xn_test.h"
+#include "xn_wifi_manager.h"
+#include "xn_blufi.h"
+
+/* 添加一个WPA2-PSK热点（信道6，BSSID按下标生成），返回下标 */
+int xn_steps_add_ap(const char *ssid, const char *password, int8_t rssi);
+
+/* app_blufi_init()并运行到BluFi就绪、开始广播 */
+void xn_steps_boot(void);
+
+/* 不经过应用层，直接创建并初始化组件，运行到BluFi就绪、开始广播，返回实例 */
+xn_blufi_t *xn_steps_boot_component(void);
+
+/* 手机连接并完成DH协商（开启安全层时），之后的帧加密传输 */
+void xn_steps_phone_open(void);
+
+/* 手机下发SSID、密码和连接命令 */
+void xn_steps_provision(const char *ssid, const char *password);
+
+/* 等待指定状态的连接报告（跳过其他状态的报告和其他消息） */
+bool xn_steps_wait_report(esp_blufi_sta_conn_state_t state, sim_msg_t *msg, uint32_t timeout_ms);
+
+/* 运行到已获取IP（仿真层），返回是否满足 */
+bool xn_steps_wait_ip(uint32_t timeout_ms);
+
+/* 初始化NVS，创建并初始化WiFi管理器（不经过应用层） */
+xn_wifi_manager_t *xn_steps_manager_start(void);
+
+/* 运行到管理器进入GOT_IP状态，返回是否满足 */
+bool xn_steps_manager_wait_ip(xn_wifi_manager_t *manager, uint32_t timeout_ms);
+
+/* 经管理器连接并等待获取IP，返回从发起连接到获取IP的耗时（毫秒） */
+uint32_t xn_steps_manager_connect(xn_wifi_manager_t *manager, const char *ssid, const char *password);
@@ -0,0 +1,85 @@
+/*
+ * @Description: 主机测试框架 - 用例注册和子进程运行
+ */
+
+#include "xn_test.h"
+#include <signal.h>
+#include <sys/wait.h>
+
+#define XN_TEST_MAX         64
+#define XN_TEST_TIMEOUT_S   60      // 单个用例的真实时间上限（虚拟时间不受限）
+
+typedef struct {
+    const char *name;
+    xn_test_fn_t fn;
+    bool sim;
+} xn_test_case_t;
+
+static xn_test_case_t s_cases[XN_TEST_MAX];
+static int s_case_count;
+
+void xn_test_register(const char *name, xn_test_fn_t fn, bool sim)
+{
+    if (s_case_count >= XN_TEST_MAX) {
+        fprintf(stderr, "too many test cases\n");
+        abort();
+    }
+    s_cases[s_case_count++] = (xn_test_case_t){ name, fn, sim };
+}
+
+static bool run_forked(xn_test_fn_t fn, bool sim)
+{
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        alarm(XN_TEST_TIMEOUT_S);
+        if (sim) {
+            sim_start();
+        }
+        fn();
+        fflush(NULL);
+        _exit(0);
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+    }
+    if (WIFSIGNALED(status)) {
+        fprintf(stderr, "  killed by signal %d%s\n", WTERMSIG(status),
+                WTERMSIG(status) == SIGALRM ? " (timeout)" : "");
+        return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool xn_test_run_child(xn_test_fn_t fn)
+{
+    return run_forked(fn, true);
+}
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+    int ran = 0;
+    for (int i = 0; i < s_case_count; i++) {
+        if (argc > 1 && strcmp(argv[1], s_cases[i].name) != 0) {
+            continue;
+        }
+        printf("[ RUN  ] %s\n", s_cases[i].name);
+        bool ok = run_forked(s_cases[i].fn, s_cases[i].sim);
+        printf("[ %s ] %s\n", ok ? " OK " : "FAIL", s_cases[i].name);
+        ran++;
+        if (!ok) {
+            failed++;
+        }
+    }
+    if (ran == 0) {
+        fprintf(stderr, "no test case matched\n");
+        return 1;
+    }
+    printf("%d/%d passed\n", ran - failed, ran);
+    return failed ? 1 : 0;
+}
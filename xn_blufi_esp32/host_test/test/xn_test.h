@@ -0,0 +1,74 @@
+/*
+ * @Description: 主机测试框架 - 用例注册、断言和按用例隔离运行
+ *
+ * 每个用例在独立的子进程中运行（组件使用大量静态状态，进程隔离保证用例互不影响），
+ * XN_TEST用例在子进程中先启动仿真再执行；XN_TEST_RAW不启动仿真，
+ * 由用例自己fork模拟重启（例如把NVS分区导出给"重启后"的进程）。
+ * 命令行参数为用例名时只运行该用例。
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim.h"
+
+typedef void (*xn_test_fn_t)(void);
+
+void xn_test_register(const char *name, xn_test_fn_t fn, bool sim);
+
+/* 在子进程中运行fn（已启动仿真），返回是否通过；用于模拟重启的多阶段用例 */
+bool xn_test_run_child(xn_test_fn_t fn);
+
+#define XN_TEST_DEFINE(name, sim)                                                   \
+    static void name(void);                                                         \
+    __attribute__((constructor)) static void xn_test_reg_##name(void)               \
+    {                                                                               \
+        xn_test_register(#name, name, sim);                                         \
+    }                                                                               \
+    static void name(void)
+
+#define XN_TEST(name) XN_TEST_DEFINE(name, true)
+#define XN_TEST_RAW(name) XN_TEST_DEFINE(name, false)
+
+#define XN_FAIL(...)                                                                \
+    do {                                                                            \
+        fprintf(stderr, "%s:%d: ", __FILE__, __LINE__);                             \
+        fprintf(stderr, __VA_ARGS__);                                               \
+        fprintf(stderr, "\n");                                                      \
+        fflush(NULL);                                                               \
+        _exit(1);                                                                   \
+    } while (0)
+
+#define XN_ASSERT(cond)                                                             \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            XN_FAIL("assertion failed: %s", #cond);                                 \
+        }                                                                           \
+    } while (0)
+
+#define XN_ASSERT_EQ(a, b)                                                          \
+    do {                                                                            \
+        long long xn_a_ = (long long)(a);                                           \
+        long long xn_b_ = (long long)(b);                                           \
+        if (xn_a_ != xn_b_) {                                                       \
+            XN_FAIL("expected %s == %s (%lld vs %lld)", #a, #b, xn_a_, xn_b_);      \
+        }                                                                           \
+    } while (0)
+
+/* 数值在[lo, hi]之间（时序断言） */
+#define XN_ASSERT_RANGE(v, lo, hi)                                                  \
+    do {                                                                            \
+        long long xn_v_ = (long long)(v);                                           \
+        if (xn_v_ < (long long)(lo) || xn_v_ > (long long)(hi)) {                   \
+            XN_FAIL("expected %s in [%lld, %lld], got %lld", #v, (long long)(lo),   \
+                    (long long)(hi), xn_v_);                                        \
+        }                                                                           \
+    } while (0)
+
+#define XN_ASSERT_OK(expr) XN_ASSERT_EQ((expr), ESP_OK)
+
@@ -9,29 +9,65 @@
 #include "esp_log.h"
 #include "esp_blufi_api.h"
 #include "esp_wifi.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#define APP_EVENT_QUEUE_LEN     8       // WiFi事件队列长度
+#define APP_EVENT_TASK_STACK    4096    // 事件处理任务栈大小（字节）
+#define APP_EVENT_TASK_PRIORITY 2       // 低于WiFi工作任务，保存配置、计算PMK不拖慢连接状态机
+#define APP_EVENT_EXIT          ((xn_wifi_event_t)-1)  // 通知事件处理任务退出
 
 static const char *TAG = "APP_BLUFI"; // 日志标签
 static xn_blufi_t *g_blufi = NULL;    // BluFi实例
+static int64_t s_connect_start = 0;   // 开机自动连接的发起时间（启动耗时分析用）
+static bool s_fast_wake = false;      // 本次为深度睡眠快速唤醒，尚未获取IP
+static QueueHandle_t s_event_queue;   // WiFi事件队列
+static SemaphoreHandle_t s_event_task_done; // 事件处理任务已退出
+static TaskHandle_t s_event_task;     // 事件处理任务
+static int s_event_sub_id = -1;       // WiFi事件订阅ID
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+static StaticQueue_t s_event_queue_buf;
+static uint8_t s_event_queue_storage[APP_EVENT_QUEUE_LEN * sizeof(xn_wifi_event_t)];
+static StaticSemaphore_t s_event_task_done_buf;
+static StaticTask_t s_event_task_tcb;
+static StackType_t s_event_task_stack[APP_EVENT_TASK_STACK];
+#endif
 
-/* WiFi状态变化回调函数 */
-static void wifi_status_callback(xn_wifi_status_t status)
+/* 处理WiFi事件（在事件处理任务中调用，可以阻塞） */
+static void handle_wifi_event(xn_blufi_t *blufi, xn_wifi_event_t event)
 {
     wifi_mode_t mode;
     esp_wifi_get_mode(&mode);
     
     // 检查蓝牙是否已连接
-    bool ble_connected = xn_blufi_is_ble_connected(g_blufi);
+    bool ble_connected = xn_blufi_is_ble_connected(blufi);
     
-    switch(status) {
-        case XN_WIFI_DISCONNECTED:
+    switch(event) {
+        case XN_WIFI_EVENT_DISCONNECTED:
             ESP_LOGW(TAG, "❌ WiFi未连接");
+            // 快速重连失败（AP、口令或网络环境已变化），丢弃RTC状态，重启走完整启动流程。
+            // 事件经队列异步到达，以当前快照为准：管理器仍在重试时不重启，重试用尽才重启
+            if (s_fast_wake) {
+                xn_wifi_snapshot_t snapshot;
+                if (xn_blufi_wifi_get_snapshot(blufi, &snapshot) == ESP_OK &&
+                    snapshot.status == XN_WIFI_DISCONNECTED && !snapshot.is_connecting) {
+                    ESP_LOGW(TAG, "快速唤醒重连失败，重启后按正常流程连接");
+                    xn_blufi_fast_wake_clear();
+                    esp_restart();
+                }
+                break;  // 快速唤醒没有初始化蓝牙，无需上报
+            }
             // 只在蓝牙已连接时发送状态
             if (ble_connected) {
                 esp_blufi_send_wifi_conn_report(mode, ESP_BLUFI_STA_CONN_FAIL, 0, NULL);
             }
             break;
             
-        case XN_WIFI_CONNECTING:
+        case XN_WIFI_EVENT_CONNECTING:
             ESP_LOGI(TAG, "🔄 WiFi连接中...");
             // 只在蓝牙已连接时发送状态
             if (ble_connected) {
@@ -39,43 +75,164 @@ static void wifi_status_callback(xn_wifi_status_t status)
             }
             break;
             
-        case XN_WIFI_CONNECTED:
+        case XN_WIFI_EVENT_CONNECTED:
             ESP_LOGI(TAG, "📶 WiFi已连接");
             break;
             
-        case XN_WIFI_GOT_IP: {
+        case XN_WIFI_EVENT_LINK_DEGRADED:
+        case XN_WIFI_EVENT_LINK_RECOVERED: {
+            // 链路变差时可暂缓大数据上传，恢复后再继续
+            xn_wifi_snapshot_t snapshot;
+            if (xn_blufi_wifi_get_snapshot(blufi, &snapshot) == ESP_OK) {
+                ESP_LOGW(TAG, "📉 WiFi链路%s，信号%d dBm", snapshot.link_degraded ? "变差" : "恢复", snapshot.rssi);
+            }
+            break;
+        }
+        
+        case XN_WIFI_EVENT_GOT_IP: {
             ESP_LOGI(TAG, "✅ WiFi配网成功，已获取IP地址！");
             
-            // 获取当前连接的WiFi配置
-            wifi_config_t wifi_config;
-            if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config) == ESP_OK) {
-                const char *ssid = (const char *)wifi_config.sta.ssid;
-                const char *password = (const char *)wifi_config.sta.password;
+            xn_wifi_snapshot_t snapshot;
+            if (xn_blufi_wifi_get_snapshot(blufi, &snapshot) == ESP_OK && snapshot.time_to_ip_ms) {
+                ESP_LOGI(TAG, "⏱️ 获取IP耗时: %lu ms%s", (unsigned long)snapshot.time_to_ip_ms,
+                         snapshot.ip_from_lease ? "（缓存的地址）" : "");
+            }
+            xn_wifi_profile_info_t profile;
+            if (xn_blufi_wifi_get_profile_info(blufi, &profile) == ESP_OK) {
+                ESP_LOGI(TAG, "📶 档位%d: 省电模式%d, 带宽HT%d, 发射功率%.2f dBm, RSSI %d dBm",
+                         profile.id, profile.ps_type, profile.bandwidth == WIFI_BW_HT40 ? 40 : 20,
+                         profile.tx_power * 0.25, profile.rssi);
+            }
+            
+            // 开机自动连接成功，启动过程到此结束
+            if (s_connect_start) {
+                xn_boot_profile_record("first_connect", s_connect_start);
+                s_connect_start = 0;
+                xn_boot_profile_finish();
+            }
+            
+            // 快速唤醒：凭据来自RTC内存，没有蓝牙和存储层，无需上报和保存
+            if (s_fast_wake) {
+                s_fast_wake = false;
+                ESP_LOGI(TAG, "⚡ 快速唤醒，从启动到获取IP: %lu ms", (unsigned long)(esp_timer_get_time() / 1000));
+                break;
+            }
+            
+            // 获取当前连接的凭据（口令形式；WPA2-PSK网络上附带PMK，保存后下次连接跳过PBKDF2）
+            xn_wifi_cred_t cred;
+            if (xn_blufi_wifi_get_connected_cred(blufi, &cred) == ESP_OK) {
+                const char *ssid = (const char *)cred.ssid;
                 
                 // 只在蓝牙已连接时发送状态
                 if (ble_connected) {
                     // 发送连接成功状态（包含SSID）
                     esp_blufi_extra_info_t info = {0};
-                    info.sta_ssid = wifi_config.sta.ssid;
-                    info.sta_ssid_len = strlen(ssid);
+                    info.sta_ssid = cred.ssid;
+                    info.sta_ssid_len = cred.ssid_len;
                     esp_blufi_send_wifi_conn_report(mode, ESP_BLUFI_STA_CONN_SUCCESS, 0, &info);
                     
                     ESP_LOGI(TAG, "📡 已发送WiFi状态到小程序: %s", ssid);
                 }
                 
                 // 保存到NVS
-                esp_err_t ret = xn_blufi_wifi_save(g_blufi, ssid, password);
+                esp_err_t ret = xn_blufi_wifi_save_cred(blufi, &cred);
                 if (ret == ESP_OK) {
                     ESP_LOGI(TAG, "💾 WiFi配置已保存到NVS: %s", ssid);
                 } else {
                     ESP_LOGE(TAG, "保存WiFi配置失败: %s", esp_err_to_name(ret));
                 }
+                
+                // 记录连接成功，下次开机优先尝试最常用的网络
+                xn_blufi_wifi_mark_connected(blufi, cred.ssid, cred.ssid_len);
+                memset(&cred, 0, sizeof(cred));
             }
             break;
         }
+        
+        default:
+            break;
     }
 }
 
+/* WiFi事件处理任务：按顺序处理队列中的事件，收到退出通知后结束 */
+static void app_event_task(void *arg)
+{
+    xn_blufi_t *blufi = (xn_blufi_t *)arg;
+    xn_wifi_event_t event;
+    
+    while (xQueueReceive(s_event_queue, &event, portMAX_DELAY) == pdTRUE) {
+        if (event == APP_EVENT_EXIT) {
+            break;
+        }
+        handle_wifi_event(blufi, event);
+    }
+    
+    xSemaphoreGive(s_event_task_done);
+    vTaskDelete(NULL);
+}
+
+/* 取消订阅，等待事件处理任务退出并释放队列（也用于清理启动失败时的部分资源） */
+static void app_event_stop(xn_blufi_t *blufi)
+{
+    if (s_event_sub_id >= 0) {
+        xn_blufi_wifi_unsubscribe(blufi, s_event_sub_id);
+        s_event_sub_id = -1;
+    }
+    if (s_event_task) {
+        xn_wifi_event_t event = APP_EVENT_EXIT;
+        xQueueSend(s_event_queue, &event, portMAX_DELAY);
+        xSemaphoreTake(s_event_task_done, portMAX_DELAY);
+        s_event_task = NULL;
+    }
+    if (s_event_queue) {
+        vQueueDelete(s_event_queue);
+        s_event_queue = NULL;
+    }
+    if (s_event_task_done) {
+        vSemaphoreDelete(s_event_task_done);
+        s_event_task_done = NULL;
+    }
+}
+
+/* 创建事件处理任务，以队列方式订阅WiFi事件，在本任务中集中处理 */
+static esp_err_t app_event_start(xn_blufi_t *blufi)
+{
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    s_event_queue = xQueueCreateStatic(APP_EVENT_QUEUE_LEN, sizeof(xn_wifi_event_t),
+                                       s_event_queue_storage, &s_event_queue_buf);
+    s_event_task_done = xSemaphoreCreateBinaryStatic(&s_event_task_done_buf);
+#else
+    s_event_queue = xQueueCreate(APP_EVENT_QUEUE_LEN, sizeof(xn_wifi_event_t));
+    s_event_task_done = xSemaphoreCreateBinary();
+#endif
+    if (s_event_queue == NULL || s_event_task_done == NULL) {
+        app_event_stop(blufi);
+        return ESP_ERR_NO_MEM;
+    }
+    
+#if CONFIG_XN_BLUFI_STATIC_ALLOC
+    s_event_task = xTaskCreateStatic(app_event_task, "app_blufi_evt", APP_EVENT_TASK_STACK, blufi,
+                                     APP_EVENT_TASK_PRIORITY, s_event_task_stack, &s_event_task_tcb);
+#else
+    if (xTaskCreate(app_event_task, "app_blufi_evt", APP_EVENT_TASK_STACK, blufi,
+                    APP_EVENT_TASK_PRIORITY, &s_event_task) != pdPASS) {
+        s_event_task = NULL;
+    }
+#endif
+    if (s_event_task == NULL) {
+        app_event_stop(blufi);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    esp_err_t ret = xn_blufi_wifi_subscribe_queue(blufi, s_event_queue,
+                                                  XN_WIFI_EVENT_MASK_STATUS | XN_WIFI_EVENT_MASK_LINK,
+                                                  &s_event_sub_id);
+    if (ret != ESP_OK) {
+        app_event_stop(blufi);
+    }
+    return ret;
+}
+
 /* 初始化蓝牙配网应用 */
 esp_err_t app_blufi_init(void)
 {
@@ -84,6 +241,7 @@ esp_err_t app_blufi_init(void)
     ESP_LOGI(TAG, "========================================");
     
     // 创建BluFi配网组件实例
+    int64_t stage_start = esp_timer_get_time();
     g_blufi = xn_blufi_create("ESP32_星年");
     if (g_blufi == NULL) {
         ESP_LOGE(TAG, "创建BluFi实例失败");
@@ -91,14 +249,32 @@ esp_err_t app_blufi_init(void)
     }
     ESP_LOGI(TAG, "✓ BluFi实例创建成功");
     
-    // 注册WiFi状态变化回调
-    xn_blufi_wifi_register_status_cb(g_blufi, wifi_status_callback);
-    ESP_LOGI(TAG, "✓ 状态回调已注册");
+    // 订阅WiFi状态和链路质量事件，在应用层自己的低优先级任务中处理
+    esp_err_t ret = app_event_start(g_blufi);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "启动WiFi事件处理任务失败: %s", esp_err_to_name(ret));
+        xn_blufi_destroy(g_blufi);
+        g_blufi = NULL;
+        return ret;
+    }
+    ESP_LOGI(TAG, "✓ WiFi事件订阅成功");
+    xn_boot_profile_record("app_create", stage_start);
+    
+    // 从深度睡眠唤醒且保存过连接状态时，跳过配置读取和蓝牙，直接重连
+    s_fast_wake = true;
+    ret = xn_blufi_init_fast_wake(g_blufi);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "⚡ 快速唤醒，正在重连...");
+        ESP_LOGI(TAG, "========================================");
+        return ESP_OK;
+    }
+    s_fast_wake = false;
     
     // 初始化BluFi组件
-    esp_err_t ret = xn_blufi_init(g_blufi);
+    ret = xn_blufi_init(g_blufi);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "初始化失败: %s", esp_err_to_name(ret));
+        app_event_stop(g_blufi);
         xn_blufi_destroy(g_blufi);
         g_blufi = NULL;
         return ret;
@@ -107,14 +283,30 @@ esp_err_t app_blufi_init(void)
     
     // 尝试加载之前保存的WiFi配置
     xn_wifi_config_t config;
+    stage_start = esp_timer_get_time();
     if (xn_blufi_wifi_load(g_blufi, &config) == ESP_OK) {
+        xn_boot_profile_record("load_config", stage_start);
         ESP_LOGI(TAG, "📱 发现保存的WiFi配置: %s", config.ssid);
+#if CONFIG_XN_BLUFI_AUTO_CONNECT
+        // 组件在WiFi就绪时已发起连接
+        ESP_LOGI(TAG, "🔄 正在自动连接...");
+#else
         ESP_LOGI(TAG, "🔄 尝试自动连接...");
-        xn_blufi_wifi_connect(g_blufi, config.ssid, config.password);
+        xn_wifi_cred_t cred;
+        xn_wifi_config_to_cred(&config, &cred);
+        s_connect_start = esp_timer_get_time();
+        if (xn_blufi_wifi_connect_cred(g_blufi, &cred) != ESP_OK) {
+            s_connect_start = 0;
+            xn_boot_profile_finish();
+        }
+        memset(&cred, 0, sizeof(cred));
+#endif
+        memset(&config, 0, sizeof(config));
     } else {
+        // 没有保存的网络，启动过程到等待配网为止
+        xn_boot_profile_finish();
         ESP_LOGI(TAG, "📱 未找到保存的WiFi配置");
         ESP_LOGI(TAG, "🔵 蓝牙广播已开启，等待小程序配网...");
-        ESP_LOGI(TAG, "");
         ESP_LOGI(TAG, "配网步骤：");
         ESP_LOGI(TAG, "  1. 打开微信小程序（搜索EspBlufi）");
         ESP_LOGI(TAG, "  2. 搜索并连接设备：ESP32_星年");
@@ -136,6 +328,9 @@ esp_err_t app_blufi_deinit(void)
     
     ESP_LOGI(TAG, "反初始化蓝牙配网应用");
     
+    // 先停止事件处理，之后不再访问BluFi实例
+    app_event_stop(g_blufi);
+    
     // 反初始化BluFi组件
     xn_blufi_deinit(g_blufi);
     
@@ -147,3 +342,30 @@ esp_err_t app_blufi_deinit(void)
     
     return ESP_OK;
 }
+
+/* 等待WiFi获取IP */
+esp_err_t app_blufi_wait_for_ip(TickType_t timeout)
+{
+    if (g_blufi == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return xn_blufi_wifi_wait_for_ip(g_blufi, timeout);
+}
+
+/* 等待WiFi断开 */
+esp_err_t app_blufi_wait_for_disconnect(TickType_t timeout)
+{
+    if (g_blufi == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return xn_blufi_wifi_wait_for_disconnect(g_blufi, timeout);
+}
+
+/* 进入深度睡眠前保存连接状态 */
+esp_err_t app_blufi_prepare_deep_sleep(void)
+{
+    if (g_blufi == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return xn_blufi_fast_wake_save(g_blufi);
+}
@@ -8,6 +8,7 @@
 #define APP_BLUFI_H
 
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,6 +26,29 @@ esp_err_t app_blufi_init(void);
  */
 esp_err_t app_blufi_deinit(void);
 
+/**
+ * @brief 阻塞等待WiFi获取IP
+ * @param timeout 超时时间（tick），portMAX_DELAY表示一直等待
+ * @return ESP_OK已获取IP，ESP_ERR_TIMEOUT超时，其他值失败
+ */
+esp_err_t app_blufi_wait_for_ip(TickType_t timeout);
+
+/**
+ * @brief 阻塞等待WiFi断开
+ * @param timeout 超时时间（tick），portMAX_DELAY表示一直等待
+ * @return ESP_OK已断开，ESP_ERR_TIMEOUT超时，其他值失败
+ */
+esp_err_t app_blufi_wait_for_disconnect(TickType_t timeout);
+
+/**
+ * @brief 进入深度睡眠前保存连接状态，唤醒后跳过配置读取和蓝牙初始化直接重连
+ * 
+ * 需开启CONFIG_XN_BLUFI_FAST_WAKE，在esp_deep_sleep_start()之前调用。
+ * 
+ * @return ESP_OK成功，ESP_ERR_INVALID_STATE未获取IP，其他值失败
+ */
+esp_err_t app_blufi_prepare_deep_sleep(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -25,11 +25,19 @@ void app_main(void)
         return;
     }
     
-    // 主循环 - 可以在这里添加其他业务逻辑
+    // 主循环 - 连接状态变化时唤醒，无需轮询
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(1000)); // 延时1秒
+        // 等待WiFi获取IP
+        app_blufi_wait_for_ip(portMAX_DELAY);
+        ESP_LOGI(TAG, "网络已就绪");
         
         // TODO: 添加你的业务逻辑
         // 例如：连接MQTT服务器、上传数据等
+        // 电池供电产品上报完成后可调用app_blufi_prepare_deep_sleep()再esp_deep_sleep_start()，
+        // 唤醒时跳过配置读取和蓝牙初始化直接重连（需开启CONFIG_XN_BLUFI_FAST_WAKE）
+        
+        // 等待WiFi断开，之后重新等待联网
+        app_blufi_wait_for_disconnect(portMAX_DELAY);
+        ESP_LOGW(TAG, "网络已断开");
     }
 }